@@ -314,7 +314,7 @@ typedef size_t dbof_container_size;
  * @param type The object type
  * @return Nonzero if such is the case, zero otherwise
  */
-int dbof_is_value_type(dbof_type type)
+inline int dbof_is_value_type(dbof_type type)
 {
     switch (type)
     {
@@ -346,7 +346,7 @@ int dbof_is_value_type(dbof_type type)
  * @param type The object type
  * @return Nonzero if such is the case, zero otherwise
  */
-int dbof_is_container_type(dbof_type type)
+inline int dbof_is_container_type(dbof_type type)
 {
     switch (type)
     {
@@ -411,7 +411,7 @@ inline int dbof_same_type(dbof_object a, dbof_object b)
  * @param b The second object
  * @return Nonzero if such is the case, zero otherwise
  */
-int dbof_same_category(dbof_object a, dbof_object b)
+inline int dbof_same_category(dbof_object a, dbof_object b)
 {
     dbof_type type_a = dbof_typeof(a);
     dbof_type type_b = dbof_typeof(b);
@@ -437,16 +437,44 @@ int dbof_same_category(dbof_object a, dbof_object b)
  */
 typedef void* dbof_hooks;
 
+/**
+ * A region of memory from which whole object trees can be allocated and then released all at once.
+ *
+ * Objects allocated from an arena are not freed individually. Calling dbof_delete() on them is allowed (it still
+ * deletes any heap-allocated children that were added to them later), but not required, as releasing the arena with
+ * dbof_arena_delete() or dbof_arena_reset() reclaims all of their memory in one go. Memory that an arena object
+ * acquires after its creation (e.g. a new string value or a grown array) may come from the heap and is then only
+ * reclaimed by dbof_delete(). Arenas are not thread-safe.
+ */
+typedef void* dbof_arena;
+
+/**
+ * The default size of the blocks in which arenas allocate their memory.
+ */
+#define DBOF_ARENA_DEFAULT_BLOCK_SIZE 65536
+
 /**
  * Parameters for new object creation.
  */
 typedef struct
 {
     dbof_hooks hooks;
+
+    /**
+     * The arena to allocate the object from, or NULL to allocate it from the heap.
+     */
+    dbof_arena arena;
+
+    /**
+     * For containers, the number of children (arrays) or entries (maps) to make room for up front. Zero leaves the
+     * storage to be allocated on first use. Ignored for value objects.
+     */
+    dbof_container_size initial_capacity;
 } dbof_new_ex_params;
 
 /**
- * Create a new DBOF object of the given type.
+ * Create a new DBOF object of the given type. The object is always allocated, never an immediate value (see
+ * DBOF_TAGGED_VALUES), so value objects can be set afterwards.
  *
  * @param type The object type
  * @return The object
@@ -454,16 +482,229 @@ typedef struct
 extern dbof_object dbof_new(dbof_type type);
 
 /**
- * Create a new DBOF object of the given type with the given parameters.
+ * Create a new DBOF object of the given type with the given parameters. Hooks are not supported, so parameters that
+ * carry any are refused.
  *
  * @param type The object type
  * @param params Object creation parameters
- * @return The object
+ * @return The object, or NULL if out of memory or if the parameters carry hooks
  */
 extern dbof_object dbof_new_ex(dbof_type type, dbof_new_ex_params* params);
 
 /**
- * Delete a DBOF object.
+ * Create a deep copy of a DBOF object. The copy is mutable and independent of the original, even if the original is
+ * frozen or shared. Immediate values are returned as they are.
+ *
+ * Calling dbof_clone(NULL) will return NULL.
+ *
+ * @param object The object
+ * @return The copy, or NULL if out of memory
+ */
+extern dbof_object dbof_clone(dbof_object object);
+
+/**
+ * Create a deep copy of a DBOF object with the given parameters. If an arena is given, the memory the copy is going to
+ * take is added up first and set aside in one block of the arena, so the copy is laid out contiguously. The initial
+ * capacity is ignored, as every container of the copy is sized after its original. Hooks are not supported, so
+ * parameters that carry any are refused.
+ *
+ * @param object The object
+ * @param params Object creation parameters
+ * @return The copy, or NULL if out of memory or if the parameters carry hooks
+ */
+extern dbof_object dbof_clone_ex(dbof_object object, dbof_new_ex_params* params);
+
+/**
+ * A policy for the capacity of arrays. It decides how far an array grows when it is full and whether it gives memory
+ * back after children are removed. Maps size their tables by their load factor instead.
+ */
+typedef struct dbof_capacity_policy
+{
+    /**
+     * Get the capacity to grow an array to when there is no room for another child.
+     *
+     * @param capacity The current capacity (zero if nothing is allocated yet)
+     * @param needed The capacity needed
+     * @return The new capacity, or anything less than needed to grow to exactly needed
+     */
+    dbof_container_size (* grow)(dbof_container_size capacity, dbof_container_size needed);
+
+    /**
+     * Get the capacity to shrink an array to after a child is removed.
+     *
+     * @param capacity The current capacity
+     * @param size The number of children left
+     * @return The new capacity, or the current capacity to keep it (results below size also keep it)
+     */
+    dbof_container_size (* shrink)(dbof_container_size capacity, dbof_container_size size);
+} dbof_capacity_policy;
+
+/**
+ * A shrink function for capacity policies that keeps all capacity an array has grown to. It suits arrays that are
+ * drained and filled again repeatedly.
+ *
+ * @param capacity The current capacity
+ * @param size The number of children left
+ * @return The current capacity
+ */
+extern dbof_container_size dbof_capacity_never_shrink(dbof_container_size capacity, dbof_container_size size);
+
+/**
+ * Set the capacity policy for all arrays. A NULL function (or a NULL policy) means the default for it: growing to four
+ * children at first and doubling from there, and halving when no more than a quarter of the capacity is in use, but
+ * never below sixteen children.
+ *
+ * The policy is read without synchronization, so it is meant to be set once, while the program starts up and before
+ * any other thread works with arrays. Setting it again later is only safe while no other thread does.
+ *
+ * @param policy The policy
+ */
+extern void dbof_set_capacity_policy(const dbof_capacity_policy* policy);
+
+/**
+ * Create a new signed byte object with the given value.
+ *
+ * If the library is built with DBOF_TAGGED_VALUES, the object may be an immediate value, which occupies no memory but
+ * cannot be changed by dbof_set_value_signed_byte().
+ *
+ * @param value The value
+ * @return The object
+ */
+extern dbof_object_signed_byte dbof_new_signed_byte(dbof_signed_byte value);
+
+/** Alias for <code>dbof_new_signed_byte(value)</code>. */
+inline dbof_object_byte dbof_new_byte(dbof_byte value)
+{ return dbof_new_signed_byte(value); }
+
+/**
+ * Create a new unsigned byte object with the given value.
+ *
+ * If the library is built with DBOF_TAGGED_VALUES, the object may be an immediate value, which occupies no memory but
+ * cannot be changed by dbof_set_value_unsigned_byte().
+ *
+ * @param value The value
+ * @return The object
+ */
+extern dbof_object_unsigned_byte dbof_new_unsigned_byte(dbof_unsigned_byte value);
+
+/** Alias for <code>dbof_new_unsigned_byte(value)</code>. */
+inline dbof_object_ubyte dbof_new_ubyte(dbof_ubyte value)
+{ return dbof_new_unsigned_byte(value); }
+
+/**
+ * Create a new signed integer object with the given value.
+ *
+ * If the library is built with DBOF_TAGGED_VALUES, the object may be an immediate value, which occupies no memory but
+ * cannot be changed by dbof_set_value_signed_integer().
+ *
+ * @param value The value
+ * @return The object
+ */
+extern dbof_object_signed_integer dbof_new_signed_integer(dbof_signed_integer value);
+
+/** Alias for <code>dbof_new_signed_integer(value)</code>. */
+inline dbof_object_int dbof_new_int(dbof_int value)
+{ return dbof_new_signed_integer(value); }
+
+/**
+ * Create a new unsigned integer object with the given value.
+ *
+ * If the library is built with DBOF_TAGGED_VALUES, the object may be an immediate value, which occupies no memory but
+ * cannot be changed by dbof_set_value_unsigned_integer().
+ *
+ * @param value The value
+ * @return The object
+ */
+extern dbof_object_unsigned_integer dbof_new_unsigned_integer(dbof_unsigned_integer value);
+
+/** Alias for <code>dbof_new_unsigned_integer(value)</code>. */
+inline dbof_object_uint dbof_new_uint(dbof_uint value)
+{ return dbof_new_unsigned_integer(value); }
+
+/**
+ * Create a new signed long integer object with the given value.
+ *
+ * @param value The value
+ * @return The object
+ */
+extern dbof_object_signed_long_integer dbof_new_signed_long_integer(dbof_signed_long_integer value);
+
+/** Alias for <code>dbof_new_signed_long_integer(value)</code>. */
+inline dbof_object_long dbof_new_long(dbof_long value)
+{ return dbof_new_signed_long_integer(value); }
+
+/**
+ * Create a new unsigned long integer object with the given value.
+ *
+ * @param value The value
+ * @return The object
+ */
+extern dbof_object_unsigned_long_integer dbof_new_unsigned_long_integer(dbof_unsigned_long_integer value);
+
+/** Alias for <code>dbof_new_unsigned_long_integer(value)</code>. */
+inline dbof_object_ulong dbof_new_ulong(dbof_ulong value)
+{ return dbof_new_unsigned_long_integer(value); }
+
+/**
+ * Create a new Boolean object with the given value.
+ *
+ * If the library is built with DBOF_TAGGED_VALUES, the object may be an immediate value, which occupies no memory but
+ * cannot be changed by dbof_set_value_boolean().
+ *
+ * @param value The value
+ * @return The object
+ */
+extern dbof_object_boolean dbof_new_boolean(dbof_boolean value);
+
+/** Alias for <code>dbof_new_boolean(value)</code>. */
+inline dbof_object_bool dbof_new_bool(dbof_bool value)
+{ return dbof_new_boolean(value); }
+
+/**
+ * Create a new single-precision float object with the given value.
+ *
+ * If the library is built with DBOF_TAGGED_VALUES, the object may be an immediate value, which occupies no memory but
+ * cannot be changed by dbof_set_value_single_float().
+ *
+ * @param value The value
+ * @return The object
+ */
+extern dbof_object_single_float dbof_new_single_float(dbof_single_float value);
+
+/** Alias for <code>dbof_new_single_float(value)</code>. */
+inline dbof_object_float dbof_new_float(dbof_float value)
+{ return dbof_new_single_float(value); }
+
+/**
+ * Create a new double-precision float object with the given value.
+ *
+ * @param value The value
+ * @return The object
+ */
+extern dbof_object_double_float dbof_new_double_float(dbof_double_float value);
+
+/** Alias for <code>dbof_new_double_float(value)</code>. */
+inline dbof_object_double dbof_new_double(dbof_double value)
+{ return dbof_new_double_float(value); }
+
+/**
+ * Create a new character object with the given value.
+ *
+ * If the library is built with DBOF_TAGGED_VALUES, the object may be an immediate value, which occupies no memory but
+ * cannot be changed by dbof_set_value_character().
+ *
+ * @param value The value
+ * @return The object
+ */
+extern dbof_object_character dbof_new_character(dbof_character value);
+
+/** Alias for <code>dbof_new_character(value)</code>. */
+inline dbof_object_char dbof_new_char(dbof_char value)
+{ return dbof_new_character(value); }
+
+/**
+ * Delete a DBOF object. If the object was retained, this only releases one reference, and the object is deleted along
+ * with the last one.
  *
  * Calling dbof_delete(NULL) has no effect.
  *
@@ -471,6 +712,174 @@ extern dbof_object dbof_new_ex(dbof_type type, dbof_new_ex_params* params);
  */
 extern void dbof_delete(dbof_object object);
 
+/**
+ * Take another reference to a DBOF object. Every reference, the first one included, is given up by dbof_release() (or
+ * dbof_delete(), which is the same), and the object is deleted along with the last one. Containers give up the
+ * references to their children when they are deleted, so a retained object may be put into another container (or the
+ * same one) once for every reference taken.
+ *
+ * Reference counts are atomic. An object held by more than one container must be frozen with dbof_freeze() before it
+ * is shared, as a mutable object keeps track of a single parent only.
+ *
+ * Views of packed values (as handed out by dbof_typed_array_get() and dbof_typed_map_get()) belong to their container
+ * and cannot be retained.
+ *
+ * @param object The object
+ * @return The object
+ */
+extern dbof_object dbof_retain(dbof_object object);
+
+/**
+ * Give up a reference to a DBOF object taken with dbof_retain() (or the one it was created with). The same as
+ * dbof_delete().
+ *
+ * @param object The object
+ */
+extern void dbof_release(dbof_object object);
+
+/**
+ * Make a DBOF object and all objects below it immutable. All functions that would change a frozen object leave it as
+ * it is (and report failure where they return a result). A frozen object may be attached to many containers (see
+ * dbof_retain()), and any number of threads may read it at once without locking: getting children and values,
+ * hashing, comparing and writing it out never modify it. Objects cannot be thawed, but dbof_clone() makes mutable
+ * copies of them.
+ *
+ * Freezing computes and caches the hash codes of all containers below, so it takes time proportional to the size of
+ * the tree. Objects that are already frozen are skipped.
+ *
+ * @param object The object
+ * @return Zero on success, otherwise nonzero (if out of memory, part of the tree may be left unfrozen)
+ */
+extern int dbof_freeze(dbof_object object);
+
+/**
+ * Determine if a DBOF object is frozen. Immediate values (see DBOF_TAGGED_VALUES) count as frozen.
+ *
+ * @param object The object
+ * @return Nonzero if the object is frozen, otherwise zero
+ */
+extern int dbof_is_frozen(dbof_object object);
+
+/**
+ * Create a new arena.
+ *
+ * @param block_size The size of each block of memory, or zero for DBOF_ARENA_DEFAULT_BLOCK_SIZE
+ * @return The arena or NULL if out of memory
+ */
+extern dbof_arena dbof_arena_new(size_t block_size);
+
+/**
+ * Delete an arena, releasing the memory of every object allocated from it.
+ *
+ * Calling dbof_arena_delete(NULL) has no effect.
+ *
+ * @param arena The arena
+ */
+extern void dbof_arena_delete(dbof_arena arena);
+
+/**
+ * Reset an arena, releasing the memory of every object allocated from it while keeping one block around for reuse.
+ *
+ * @param arena The arena
+ */
+extern void dbof_arena_reset(dbof_arena arena);
+
+/**
+ * A table of distinct string values that string objects can share instead of owning a copy each.
+ *
+ * Strings read through a reader with an intern pool point to the pool's copy of their value, so a value repeated many
+ * times is stored (and hashed) once, and equal interned strings compare equal by pointer. Values of up to 256 bytes
+ * are interned this way. Interned strings are otherwise ordinary string objects; setting a new value on one simply
+ * gives it its own copy again. The pool must outlive every string that refers to it. Intern pools are not thread-safe.
+ */
+typedef void* dbof_intern_pool;
+
+/**
+ * Create a new intern pool.
+ *
+ * @return The intern pool or NULL if out of memory
+ */
+extern dbof_intern_pool dbof_intern_pool_new();
+
+/**
+ * Delete an intern pool. Every string referring to it must have been deleted (or given a new value) beforehand.
+ *
+ * Calling dbof_intern_pool_delete(NULL) has no effect.
+ *
+ * @param pool The intern pool
+ */
+extern void dbof_intern_pool_delete(dbof_intern_pool pool);
+
+/**
+ * Get the number of distinct values in an intern pool.
+ *
+ * @param pool The intern pool
+ * @return The number of values
+ */
+extern size_t dbof_intern_pool_get_size(dbof_intern_pool pool);
+
+/**
+ * Create a new UTF-8 string object whose value is shared through an intern pool.
+ *
+ * @param pool The intern pool
+ * @param value The bytes of the value
+ * @param length The number of bytes
+ * @return The object or NULL if out of memory
+ */
+extern dbof_object_utf8_string dbof_new_interned_utf8_string(dbof_intern_pool pool, const char* value,
+        dbof_string_size length);
+
+/** Alias for <code>dbof_new_interned_utf8_string(pool, value, length)</code>. */
+inline dbof_object_string dbof_new_interned_string(dbof_intern_pool pool, const char* value, dbof_string_size length)
+{ return dbof_new_interned_utf8_string(pool, value, length); }
+
+/**
+ * Statistics of the object pool. The pool is only present if the library is built with DBOF_POOL, in which case heap
+ * objects are recycled through per-type free lists instead of being freed (see src/dbof.c for details).
+ */
+typedef struct
+{
+    /**
+     * The number of objects allocated from the heap by the pool.
+     */
+    uint64_t allocated;
+
+    /**
+     * The number of objects freed back to the heap by the pool.
+     */
+    uint64_t freed;
+
+    /**
+     * The number of times a thread cache was refilled from the global free list.
+     */
+    uint64_t refills;
+
+    /**
+     * The number of times a thread cache handed a batch of objects back to the global free list.
+     */
+    uint64_t spills;
+
+    /**
+     * The number of objects currently in the global free list (not counting those cached by threads).
+     */
+    uint64_t pooled;
+} dbof_pool_stats;
+
+/**
+ * Get the object pool statistics.
+ *
+ * @param stats The statistics to fill in
+ * @return Zero upon success, or nonzero if the library is built without DBOF_POOL
+ */
+extern int dbof_pool_get_stats(dbof_pool_stats* stats);
+
+/**
+ * Free all objects held by the object pool, except for those cached by threads other than the calling one.
+ *
+ * Has no effect if the library is built without DBOF_POOL.
+ */
+extern void dbof_pool_trim();
+
 /**
  * Calculate the hash code of a given object.
  *
@@ -486,14 +895,34 @@ extern void dbof_delete(dbof_object object);
  *
  * Calling dbof_hashcode(NULL) will return 0, but this is a valid hash code for non-null inputs as well.
  *
+ * Containers cache their hash codes, and the containers holding them drop theirs whenever they are changed through
+ * the container functions, so hashing again after a small change only revisits the path down to it. Changing a value
+ * object in place while it sits in a container, or writing through a pointer from dbof_typed_array_data() after the
+ * container was hashed, is not seen; call dbof_hash_invalidate(container) after doing so.
+ *
  * @param object The object
  * @return The hash code
  */
 extern int dbof_hash(dbof_object object);
 
+/**
+ * Drop the cached hash code of a container, along with those of the containers holding it. For a value object, drop
+ * those of the containers holding it.
+ *
+ * Changes made through the container functions and the value setters do this already. Has no effect on frozen
+ * objects.
+ *
+ * @param object The object
+ */
+extern void dbof_hash_invalidate(dbof_object object);
+
 /**
  * Test if two objects are equal.
  *
+ * Containers are equal if they are of the same type (and, for typed containers, of the same key and element types)
+ * and their contents are equal, compared deeply. Arrays must hold equal children in the same order, while maps must
+ * hold equal values for equal keys. The same goes for dbof_hash(object), which hashes containers deeply.
+ *
  * @param a The first object
  * @param b The second object
  * @return Nonzero if the objects are equal, zero otherwise
@@ -517,7 +946,8 @@ inline dbof_byte dbof_get_value_byte(dbof_object_byte object)
 { return dbof_get_value_signed_byte(object); }
 
 /**
- * Set the value of a signed byte object.
+ * Set the value of a signed byte object. Frozen objects keep their value, and so do immediate values (see
+ * DBOF_TAGGED_VALUES), which count as frozen.
  *
  * @param object The object
  * @param value The value
@@ -541,7 +971,8 @@ inline dbof_ubyte dbof_get_value_ubyte(dbof_object_ubyte object)
 { return dbof_get_value_unsigned_byte(object); }
 
 /**
- * Set the value of an unsigned byte object.
+ * Set the value of an unsigned byte object. Frozen objects keep their value, and so do immediate values (see
+ * DBOF_TAGGED_VALUES), which count as frozen.
  *
  * @param object The object
  * @param value The value
@@ -565,7 +996,8 @@ inline dbof_int dbof_get_value_int(dbof_object_int object)
 { return dbof_get_value_signed_integer(object); }
 
 /**
- * Set the value of a signed integer object.
+ * Set the value of a signed integer object. Frozen objects keep their value, and so do immediate values (see
+ * DBOF_TAGGED_VALUES), which count as frozen.
  *
  * @param object The object
  * @param value The value
@@ -589,7 +1021,8 @@ inline dbof_uint dbof_get_value_uint(dbof_object_uint object)
 { return dbof_get_value_unsigned_integer(object); }
 
 /**
- * Set the value of an unsigned integer object.
+ * Set the value of an unsigned integer object. Frozen objects keep their value, and so do immediate values (see
+ * DBOF_TAGGED_VALUES), which count as frozen.
  *
  * @param object The object
  * @param value The value
@@ -613,7 +1046,7 @@ inline dbof_long dbof_get_value_long(dbof_object_long object)
 { return dbof_get_value_signed_long_integer(object); }
 
 /**
- * Set the value of a signed long integer object.
+ * Set the value of a signed long integer object. Frozen objects keep their value.
  *
  * @param object The object
  * @param value The value
@@ -637,7 +1070,7 @@ inline dbof_ulong dbof_get_value_ulong(dbof_object_ulong object)
 { return dbof_get_value_unsigned_long_integer(object); }
 
 /**
- * Set the value of an unsigned long integer object.
+ * Set the value of an unsigned long integer object. Frozen objects keep their value.
  *
  * @param object The object
  * @param value The value
@@ -662,7 +1095,8 @@ inline dbof_bool dbof_get_value_bool(dbof_object_bool object)
 { return dbof_get_value_boolean(object); }
 
 /**
- * Set the value of a Boolean object.
+ * Set the value of a Boolean object. Frozen objects keep their value, and so do immediate values (see
+ * DBOF_TAGGED_VALUES), which count as frozen.
  *
  * @param object The object
  * @param value The value
@@ -686,7 +1120,8 @@ inline dbof_float dbof_get_value_float(dbof_object_float object)
 { return dbof_get_value_single_float(object); }
 
 /**
- * Set the value of a single float object.
+ * Set the value of a single float object. Frozen objects keep their value, and so do immediate values (see
+ * DBOF_TAGGED_VALUES), which count as frozen.
  *
  * @param object The object
  * @param value The value
@@ -710,7 +1145,7 @@ inline dbof_double dbof_get_value_double(dbof_object_double object)
 { return dbof_get_value_double_float(object); }
 
 /**
- * Set the value of a double float object.
+ * Set the value of a double float object. Frozen objects keep their value.
  *
  * @param object The object
  * @param value The value
@@ -734,7 +1169,8 @@ inline dbof_char dbof_get_value_char(dbof_object_char object)
 { return dbof_get_value_character(object); }
 
 /**
- * Set the value of a character object.
+ * Set the value of a character object. Frozen objects keep their value, and so do immediate values (see
+ * DBOF_TAGGED_VALUES), which count as frozen.
  *
  * @param object The object
  * @param value The value
@@ -757,6 +1193,31 @@ extern dbof_utf8_string dbof_get_value_utf8_string(dbof_object_utf8_string objec
 inline dbof_string dbof_get_value_string(dbof_object_string object)
 { return dbof_get_value_utf8_string(object); }
 
+/**
+ * Get the length of the value of a UTF-8 string object in bytes, not counting the null terminator.
+ *
+ * @param object The object
+ * @return The length
+ */
+extern dbof_string_size dbof_get_value_utf8_string_length(dbof_object_utf8_string object);
+
+/** Alias for <code>dbof_get_value_utf8_string_length(object)</code>. */
+inline dbof_string_size dbof_get_value_string_length(dbof_object_string object)
+{ return dbof_get_value_utf8_string_length(object); }
+
+/**
+ * Get the bytes of the value of a UTF-8 string object without copying them. Unlike dbof_get_value_utf8_string(), the
+ * returned bytes are not necessarily null-terminated (use dbof_get_value_utf8_string_length() to find their end).
+ *
+ * @param object The object
+ * @return The bytes
+ */
+extern const char* dbof_get_value_utf8_string_data(dbof_object_utf8_string object);
+
+/** Alias for <code>dbof_get_value_utf8_string_data(object)</code>. */
+inline const char* dbof_get_value_string_data(dbof_object_string object)
+{ return dbof_get_value_utf8_string_data(object); }
+
 /**
  * Set the value of a UTF-8 string object.
  *
@@ -769,6 +1230,33 @@ extern void dbof_set_value_utf8_string(dbof_object_utf8_string object, dbof_utf8
 inline void dbof_set_value_string(dbof_object_string object, const dbof_string value)
 { dbof_set_value_utf8_string(object, value); }
 
+/**
+ * Get the bytes and the length of the value of a UTF-8 string object without copying them. Like
+ * dbof_get_value_utf8_string_data(), the returned bytes are not necessarily null-terminated.
+ *
+ * @param object The object
+ * @param length The length of the value in bytes (output)
+ * @return The bytes
+ */
+extern const char* dbof_get_value_utf8_string_n(dbof_object_utf8_string object, dbof_string_size* length);
+
+/** Alias for <code>dbof_get_value_utf8_string_n(object, length)</code>. */
+inline const char* dbof_get_value_string_n(dbof_object_string object, dbof_string_size* length)
+{ return dbof_get_value_utf8_string_n(object, length); }
+
+/**
+ * Set the value of a UTF-8 string object from the given number of bytes. The value may contain null characters.
+ *
+ * @param object The object
+ * @param value The bytes
+ * @param length The number of bytes
+ */
+extern void dbof_set_value_utf8_string_n(dbof_object_utf8_string object, const char* value, dbof_string_size length);
+
+/** Alias for <code>dbof_set_value_utf8_string_n(object, value, length)</code>. */
+inline void dbof_set_value_string_n(dbof_object_string object, const char* value, dbof_string_size length)
+{ dbof_set_value_utf8_string_n(object, value, length); }
+
 /**
  * Get the capacity of a typed array.
  *
@@ -841,6 +1329,20 @@ extern void dbof_typed_array_shrink_to_fit(dbof_object_typed_array array);
 inline void dbof_array_shrink_to_fit(dbof_object_array array)
 { dbof_typed_array_shrink_to_fit(array); }
 
+/**
+ * Make room in a typed array for at least the given number of elements, so that it does not reallocate until it
+ * holds more. Room made before the type is set carries over.
+ *
+ * @param array The typed array
+ * @param capacity The number of elements
+ * @return Zero upon success, or nonzero if out of memory
+ */
+extern int dbof_typed_array_reserve(dbof_object_typed_array array, dbof_container_size capacity);
+
+/** Alias for <code>dbof_typed_array_reserve(array, capacity)</code>. */
+inline int dbof_array_reserve(dbof_object_array array, dbof_container_size capacity)
+{ return dbof_typed_array_reserve(array, capacity); }
+
 /**
  * Get an element of a typed array.
  *
@@ -848,6 +1350,11 @@ inline void dbof_array_shrink_to_fit(dbof_object_array array)
  * <code>index</code> lies in the interval <code>[0, size)</code>, where <code>size > 0</code> is the current size of
  * the array.
  *
+ * Typed arrays of primitive types (byte through double float, or character) store their values packed, so the
+ * returned object is a view of the element owned by the array. Changes to the view's value show up in the array, and
+ * the view follows its element as other elements are added or removed. Do not delete the view; it stays valid until
+ * the array is deleted. Removing the element hands the view itself back, and the caller then owns it.
+ *
  * @param array The typed array
  * @param index The element index
  * @return The element
@@ -870,6 +1377,11 @@ inline dbof_object dbof_array_get(dbof_object_array array, dbof_container_size i
  * Warning: This function may overwrite a pointer to dynamically-allocated memory. It is your responsibility to know
  * what information is being overwritten. Use #dbof_typed_array_get(array, index) prior if this concerns you.
  *
+ * Typed arrays of primitive types copy the value and delete the object (unless it is a view), which avoids the above.
+ *
+ * The caller relinquishes ownership of the object's memory. If the array refuses the object (as it does when frozen,
+ * or when the object is not of its type), the object is deleted, unless it is a view.
+ *
  * @param array The typed array
  * @param index The element index
  * @param object The new element
@@ -883,7 +1395,8 @@ inline void dbof_array_set(dbof_object_array array, dbof_container_size index, d
 /**
  * Insert an element to a typed array.
  *
- * The caller relinquishes ownership of the object's memory.
+ * The caller relinquishes ownership of the object's memory. If the array refuses the object (as it does when frozen,
+ * or when the object is not of its type), the object is deleted, unless it is a view.
  *
  * @param array The typed array
  * @param index The target index
@@ -913,6 +1426,9 @@ inline dbof_object dbof_array_remove(dbof_object_array array, dbof_container_siz
 /**
  * Add an object to the back of a typed array.
  *
+ * The caller relinquishes ownership of the object's memory. If the array refuses the object (as it does when frozen,
+ * or when the object is not of its type), the object is deleted, unless it is a view.
+ *
  * @param array The typed array
  * @param object The new object
  */
@@ -935,12 +1451,445 @@ inline dbof_object dbof_array_pop(dbof_object_array array)
 { return dbof_typed_array_pop_back(array); }
 
 /**
- * Get the capacity of an untyped array.
+ * Get the packed values of a typed array of a primitive type (byte through double float, or character). The values
+ * are laid out contiguously as an array of the element type, valid until the array is next modified. Views of the
+ * elements pick up values written through the pointer on the next call that gets or reads the array.
  *
- * @param array The untyped array
- * @return Its capacity
+ * @param array The typed array
+ * @return The values or NULL if the array does not hold a primitive type
  */
-extern dbof_container_size dbof_untyped_array_get_capacity(dbof_object_untyped_array array);
+extern void* dbof_typed_array_data(dbof_object_typed_array array);
+
+/** Alias for <code>dbof_typed_array_data(array)</code>. */
+inline void* dbof_array_data(dbof_object_array array)
+{ return dbof_typed_array_data(array); }
+
+/**
+ * Get an element of a typed array of signed bytes without creating an object.
+ * Like #dbof_typed_array_get(array, index), this does not perform bounds checking.
+ *
+ * @param array The typed array
+ * @param index The element index
+ * @return The element value or zero if the array is not of type DBOF_TYPE_SIGNED_BYTE
+ */
+extern dbof_signed_byte dbof_typed_array_get_signed_byte_at(dbof_object_typed_array array, dbof_container_size index);
+
+/** Alias for <code>dbof_typed_array_get_signed_byte_at(array, index)</code>. */
+inline dbof_byte dbof_array_get_byte_at(dbof_object_array array, dbof_container_size index)
+{ return dbof_typed_array_get_signed_byte_at(array, index); }
+
+/**
+ * Set an element of a typed array of signed bytes without creating an object. Like
+ * #dbof_typed_array_set(array, index, object), this does not perform bounds checking.
+ *
+ * @param array The typed array
+ * @param index The element index
+ * @param value The new element value
+ */
+extern void dbof_typed_array_set_signed_byte_at(dbof_object_typed_array array, dbof_container_size index,
+        dbof_signed_byte value);
+
+/** Alias for <code>dbof_typed_array_set_signed_byte_at(array, index, value)</code>. */
+inline void dbof_array_set_byte_at(dbof_object_array array, dbof_container_size index, dbof_byte value)
+{ dbof_typed_array_set_signed_byte_at(array, index, value); }
+
+/**
+ * Add a signed byte to the back of a typed array without creating an object. An empty array takes on the type.
+ *
+ * @param array The typed array
+ * @param value The new element value
+ */
+extern void dbof_typed_array_push_back_signed_byte(dbof_object_typed_array array, dbof_signed_byte value);
+
+/** Alias for <code>dbof_typed_array_push_back_signed_byte(array, value)</code>. */
+inline void dbof_array_push_byte(dbof_object_array array, dbof_byte value)
+{ dbof_typed_array_push_back_signed_byte(array, value); }
+
+/**
+ * Get an element of a typed array of unsigned bytes without creating an object.
+ * Like #dbof_typed_array_get(array, index), this does not perform bounds checking.
+ *
+ * @param array The typed array
+ * @param index The element index
+ * @return The element value or zero if the array is not of type DBOF_TYPE_UNSIGNED_BYTE
+ */
+extern dbof_unsigned_byte dbof_typed_array_get_unsigned_byte_at(dbof_object_typed_array array,
+        dbof_container_size index);
+
+/** Alias for <code>dbof_typed_array_get_unsigned_byte_at(array, index)</code>. */
+inline dbof_ubyte dbof_array_get_ubyte_at(dbof_object_array array, dbof_container_size index)
+{ return dbof_typed_array_get_unsigned_byte_at(array, index); }
+
+/**
+ * Set an element of a typed array of unsigned bytes without creating an object. Like
+ * #dbof_typed_array_set(array, index, object), this does not perform bounds checking.
+ *
+ * @param array The typed array
+ * @param index The element index
+ * @param value The new element value
+ */
+extern void dbof_typed_array_set_unsigned_byte_at(dbof_object_typed_array array, dbof_container_size index,
+        dbof_unsigned_byte value);
+
+/** Alias for <code>dbof_typed_array_set_unsigned_byte_at(array, index, value)</code>. */
+inline void dbof_array_set_ubyte_at(dbof_object_array array, dbof_container_size index, dbof_ubyte value)
+{ dbof_typed_array_set_unsigned_byte_at(array, index, value); }
+
+/**
+ * Add an unsigned byte to the back of a typed array without creating an object. An empty array takes on the type.
+ *
+ * @param array The typed array
+ * @param value The new element value
+ */
+extern void dbof_typed_array_push_back_unsigned_byte(dbof_object_typed_array array, dbof_unsigned_byte value);
+
+/** Alias for <code>dbof_typed_array_push_back_unsigned_byte(array, value)</code>. */
+inline void dbof_array_push_ubyte(dbof_object_array array, dbof_ubyte value)
+{ dbof_typed_array_push_back_unsigned_byte(array, value); }
+
+/**
+ * Get an element of a typed array of signed integers without creating an object.
+ * Like #dbof_typed_array_get(array, index), this does not perform bounds checking.
+ *
+ * @param array The typed array
+ * @param index The element index
+ * @return The element value or zero if the array is not of type DBOF_TYPE_SIGNED_INTEGER
+ */
+extern dbof_signed_integer dbof_typed_array_get_signed_integer_at(dbof_object_typed_array array,
+        dbof_container_size index);
+
+/** Alias for <code>dbof_typed_array_get_signed_integer_at(array, index)</code>. */
+inline dbof_int dbof_array_get_int_at(dbof_object_array array, dbof_container_size index)
+{ return dbof_typed_array_get_signed_integer_at(array, index); }
+
+/**
+ * Set an element of a typed array of signed integers without creating an object. Like
+ * #dbof_typed_array_set(array, index, object), this does not perform bounds checking.
+ *
+ * @param array The typed array
+ * @param index The element index
+ * @param value The new element value
+ */
+extern void dbof_typed_array_set_signed_integer_at(dbof_object_typed_array array, dbof_container_size index,
+        dbof_signed_integer value);
+
+/** Alias for <code>dbof_typed_array_set_signed_integer_at(array, index, value)</code>. */
+inline void dbof_array_set_int_at(dbof_object_array array, dbof_container_size index, dbof_int value)
+{ dbof_typed_array_set_signed_integer_at(array, index, value); }
+
+/**
+ * Add a signed integer to the back of a typed array without creating an object. An empty array takes on the type.
+ *
+ * @param array The typed array
+ * @param value The new element value
+ */
+extern void dbof_typed_array_push_back_signed_integer(dbof_object_typed_array array, dbof_signed_integer value);
+
+/** Alias for <code>dbof_typed_array_push_back_signed_integer(array, value)</code>. */
+inline void dbof_array_push_int(dbof_object_array array, dbof_int value)
+{ dbof_typed_array_push_back_signed_integer(array, value); }
+
+/**
+ * Get an element of a typed array of unsigned integers without creating an object.
+ * Like #dbof_typed_array_get(array, index), this does not perform bounds checking.
+ *
+ * @param array The typed array
+ * @param index The element index
+ * @return The element value or zero if the array is not of type DBOF_TYPE_UNSIGNED_INTEGER
+ */
+extern dbof_unsigned_integer dbof_typed_array_get_unsigned_integer_at(dbof_object_typed_array array,
+        dbof_container_size index);
+
+/** Alias for <code>dbof_typed_array_get_unsigned_integer_at(array, index)</code>. */
+inline dbof_uint dbof_array_get_uint_at(dbof_object_array array, dbof_container_size index)
+{ return dbof_typed_array_get_unsigned_integer_at(array, index); }
+
+/**
+ * Set an element of a typed array of unsigned integers without creating an object. Like
+ * #dbof_typed_array_set(array, index, object), this does not perform bounds checking.
+ *
+ * @param array The typed array
+ * @param index The element index
+ * @param value The new element value
+ */
+extern void dbof_typed_array_set_unsigned_integer_at(dbof_object_typed_array array, dbof_container_size index,
+        dbof_unsigned_integer value);
+
+/** Alias for <code>dbof_typed_array_set_unsigned_integer_at(array, index, value)</code>. */
+inline void dbof_array_set_uint_at(dbof_object_array array, dbof_container_size index, dbof_uint value)
+{ dbof_typed_array_set_unsigned_integer_at(array, index, value); }
+
+/**
+ * Add an unsigned integer to the back of a typed array without creating an object. An empty array takes on the type.
+ *
+ * @param array The typed array
+ * @param value The new element value
+ */
+extern void dbof_typed_array_push_back_unsigned_integer(dbof_object_typed_array array, dbof_unsigned_integer value);
+
+/** Alias for <code>dbof_typed_array_push_back_unsigned_integer(array, value)</code>. */
+inline void dbof_array_push_uint(dbof_object_array array, dbof_uint value)
+{ dbof_typed_array_push_back_unsigned_integer(array, value); }
+
+/**
+ * Get an element of a typed array of signed long integers without creating an object.
+ * Like #dbof_typed_array_get(array, index), this does not perform bounds checking.
+ *
+ * @param array The typed array
+ * @param index The element index
+ * @return The element value or zero if the array is not of type DBOF_TYPE_SIGNED_LONG_INTEGER
+ */
+extern dbof_signed_long_integer dbof_typed_array_get_signed_long_integer_at(dbof_object_typed_array array,
+        dbof_container_size index);
+
+/** Alias for <code>dbof_typed_array_get_signed_long_integer_at(array, index)</code>. */
+inline dbof_long dbof_array_get_long_at(dbof_object_array array, dbof_container_size index)
+{ return dbof_typed_array_get_signed_long_integer_at(array, index); }
+
+/**
+ * Set an element of a typed array of signed long integers without creating an object. Like
+ * #dbof_typed_array_set(array, index, object), this does not perform bounds checking.
+ *
+ * @param array The typed array
+ * @param index The element index
+ * @param value The new element value
+ */
+extern void dbof_typed_array_set_signed_long_integer_at(dbof_object_typed_array array, dbof_container_size index,
+        dbof_signed_long_integer value);
+
+/** Alias for <code>dbof_typed_array_set_signed_long_integer_at(array, index, value)</code>. */
+inline void dbof_array_set_long_at(dbof_object_array array, dbof_container_size index, dbof_long value)
+{ dbof_typed_array_set_signed_long_integer_at(array, index, value); }
+
+/**
+ * Add a signed long integer to the back of a typed array without creating an object. An empty array takes on the type.
+ *
+ * @param array The typed array
+ * @param value The new element value
+ */
+extern void dbof_typed_array_push_back_signed_long_integer(dbof_object_typed_array array,
+        dbof_signed_long_integer value);
+
+/** Alias for <code>dbof_typed_array_push_back_signed_long_integer(array, value)</code>. */
+inline void dbof_array_push_long(dbof_object_array array, dbof_long value)
+{ dbof_typed_array_push_back_signed_long_integer(array, value); }
+
+/**
+ * Get an element of a typed array of unsigned long integers without creating an object.
+ * Like #dbof_typed_array_get(array, index), this does not perform bounds checking.
+ *
+ * @param array The typed array
+ * @param index The element index
+ * @return The element value or zero if the array is not of type DBOF_TYPE_UNSIGNED_LONG_INTEGER
+ */
+extern dbof_unsigned_long_integer dbof_typed_array_get_unsigned_long_integer_at(dbof_object_typed_array array,
+        dbof_container_size index);
+
+/** Alias for <code>dbof_typed_array_get_unsigned_long_integer_at(array, index)</code>. */
+inline dbof_ulong dbof_array_get_ulong_at(dbof_object_array array, dbof_container_size index)
+{ return dbof_typed_array_get_unsigned_long_integer_at(array, index); }
+
+/**
+ * Set an element of a typed array of unsigned long integers without creating an object. Like
+ * #dbof_typed_array_set(array, index, object), this does not perform bounds checking.
+ *
+ * @param array The typed array
+ * @param index The element index
+ * @param value The new element value
+ */
+extern void dbof_typed_array_set_unsigned_long_integer_at(dbof_object_typed_array array, dbof_container_size index,
+        dbof_unsigned_long_integer value);
+
+/** Alias for <code>dbof_typed_array_set_unsigned_long_integer_at(array, index, value)</code>. */
+inline void dbof_array_set_ulong_at(dbof_object_array array, dbof_container_size index, dbof_ulong value)
+{ dbof_typed_array_set_unsigned_long_integer_at(array, index, value); }
+
+/**
+ * Add an unsigned long integer to the back of a typed array without creating an object. An empty array takes on the
+ * type.
+ *
+ * @param array The typed array
+ * @param value The new element value
+ */
+extern void dbof_typed_array_push_back_unsigned_long_integer(dbof_object_typed_array array,
+        dbof_unsigned_long_integer value);
+
+/** Alias for <code>dbof_typed_array_push_back_unsigned_long_integer(array, value)</code>. */
+inline void dbof_array_push_ulong(dbof_object_array array, dbof_ulong value)
+{ dbof_typed_array_push_back_unsigned_long_integer(array, value); }
+
+/**
+ * Get an element of a typed array of booleans without creating an object.
+ * Like #dbof_typed_array_get(array, index), this does not perform bounds checking.
+ *
+ * @param array The typed array
+ * @param index The element index
+ * @return The element value or zero if the array is not of type DBOF_TYPE_BOOLEAN
+ */
+extern dbof_boolean dbof_typed_array_get_boolean_at(dbof_object_typed_array array, dbof_container_size index);
+
+/** Alias for <code>dbof_typed_array_get_boolean_at(array, index)</code>. */
+inline dbof_bool dbof_array_get_bool_at(dbof_object_array array, dbof_container_size index)
+{ return dbof_typed_array_get_boolean_at(array, index); }
+
+/**
+ * Set an element of a typed array of booleans without creating an object. Like
+ * #dbof_typed_array_set(array, index, object), this does not perform bounds checking.
+ *
+ * @param array The typed array
+ * @param index The element index
+ * @param value The new element value
+ */
+extern void dbof_typed_array_set_boolean_at(dbof_object_typed_array array, dbof_container_size index,
+        dbof_boolean value);
+
+/** Alias for <code>dbof_typed_array_set_boolean_at(array, index, value)</code>. */
+inline void dbof_array_set_bool_at(dbof_object_array array, dbof_container_size index, dbof_bool value)
+{ dbof_typed_array_set_boolean_at(array, index, value); }
+
+/**
+ * Add a boolean to the back of a typed array without creating an object. An empty array takes on the type.
+ *
+ * @param array The typed array
+ * @param value The new element value
+ */
+extern void dbof_typed_array_push_back_boolean(dbof_object_typed_array array, dbof_boolean value);
+
+/** Alias for <code>dbof_typed_array_push_back_boolean(array, value)</code>. */
+inline void dbof_array_push_bool(dbof_object_array array, dbof_bool value)
+{ dbof_typed_array_push_back_boolean(array, value); }
+
+/**
+ * Get an element of a typed array of single floats without creating an object.
+ * Like #dbof_typed_array_get(array, index), this does not perform bounds checking.
+ *
+ * @param array The typed array
+ * @param index The element index
+ * @return The element value or zero if the array is not of type DBOF_TYPE_SINGLE_FLOAT
+ */
+extern dbof_single_float dbof_typed_array_get_single_float_at(dbof_object_typed_array array, dbof_container_size index);
+
+/** Alias for <code>dbof_typed_array_get_single_float_at(array, index)</code>. */
+inline dbof_float dbof_array_get_float_at(dbof_object_array array, dbof_container_size index)
+{ return dbof_typed_array_get_single_float_at(array, index); }
+
+/**
+ * Set an element of a typed array of single floats without creating an object. Like
+ * #dbof_typed_array_set(array, index, object), this does not perform bounds checking.
+ *
+ * @param array The typed array
+ * @param index The element index
+ * @param value The new element value
+ */
+extern void dbof_typed_array_set_single_float_at(dbof_object_typed_array array, dbof_container_size index,
+        dbof_single_float value);
+
+/** Alias for <code>dbof_typed_array_set_single_float_at(array, index, value)</code>. */
+inline void dbof_array_set_float_at(dbof_object_array array, dbof_container_size index, dbof_float value)
+{ dbof_typed_array_set_single_float_at(array, index, value); }
+
+/**
+ * Add a single float to the back of a typed array without creating an object. An empty array takes on the type.
+ *
+ * @param array The typed array
+ * @param value The new element value
+ */
+extern void dbof_typed_array_push_back_single_float(dbof_object_typed_array array, dbof_single_float value);
+
+/** Alias for <code>dbof_typed_array_push_back_single_float(array, value)</code>. */
+inline void dbof_array_push_float(dbof_object_array array, dbof_float value)
+{ dbof_typed_array_push_back_single_float(array, value); }
+
+/**
+ * Get an element of a typed array of double floats without creating an object.
+ * Like #dbof_typed_array_get(array, index), this does not perform bounds checking.
+ *
+ * @param array The typed array
+ * @param index The element index
+ * @return The element value or zero if the array is not of type DBOF_TYPE_DOUBLE_FLOAT
+ */
+extern dbof_double_float dbof_typed_array_get_double_float_at(dbof_object_typed_array array, dbof_container_size index);
+
+/** Alias for <code>dbof_typed_array_get_double_float_at(array, index)</code>. */
+inline dbof_double dbof_array_get_double_at(dbof_object_array array, dbof_container_size index)
+{ return dbof_typed_array_get_double_float_at(array, index); }
+
+/**
+ * Set an element of a typed array of double floats without creating an object. Like
+ * #dbof_typed_array_set(array, index, object), this does not perform bounds checking.
+ *
+ * @param array The typed array
+ * @param index The element index
+ * @param value The new element value
+ */
+extern void dbof_typed_array_set_double_float_at(dbof_object_typed_array array, dbof_container_size index,
+        dbof_double_float value);
+
+/** Alias for <code>dbof_typed_array_set_double_float_at(array, index, value)</code>. */
+inline void dbof_array_set_double_at(dbof_object_array array, dbof_container_size index, dbof_double value)
+{ dbof_typed_array_set_double_float_at(array, index, value); }
+
+/**
+ * Add a double float to the back of a typed array without creating an object. An empty array takes on the type.
+ *
+ * @param array The typed array
+ * @param value The new element value
+ */
+extern void dbof_typed_array_push_back_double_float(dbof_object_typed_array array, dbof_double_float value);
+
+/** Alias for <code>dbof_typed_array_push_back_double_float(array, value)</code>. */
+inline void dbof_array_push_double(dbof_object_array array, dbof_double value)
+{ dbof_typed_array_push_back_double_float(array, value); }
+
+/**
+ * Get an element of a typed array of characters without creating an object.
+ * Like #dbof_typed_array_get(array, index), this does not perform bounds checking.
+ *
+ * @param array The typed array
+ * @param index The element index
+ * @return The element value or zero if the array is not of type DBOF_TYPE_CHARACTER
+ */
+extern dbof_character dbof_typed_array_get_character_at(dbof_object_typed_array array, dbof_container_size index);
+
+/** Alias for <code>dbof_typed_array_get_character_at(array, index)</code>. */
+inline dbof_char dbof_array_get_char_at(dbof_object_array array, dbof_container_size index)
+{ return dbof_typed_array_get_character_at(array, index); }
+
+/**
+ * Set an element of a typed array of characters without creating an object. Like
+ * #dbof_typed_array_set(array, index, object), this does not perform bounds checking.
+ *
+ * @param array The typed array
+ * @param index The element index
+ * @param value The new element value
+ */
+extern void dbof_typed_array_set_character_at(dbof_object_typed_array array, dbof_container_size index,
+        dbof_character value);
+
+/** Alias for <code>dbof_typed_array_set_character_at(array, index, value)</code>. */
+inline void dbof_array_set_char_at(dbof_object_array array, dbof_container_size index, dbof_char value)
+{ dbof_typed_array_set_character_at(array, index, value); }
+
+/**
+ * Add a character to the back of a typed array without creating an object. An empty array takes on the type.
+ *
+ * @param array The typed array
+ * @param value The new element value
+ */
+extern void dbof_typed_array_push_back_character(dbof_object_typed_array array, dbof_character value);
+
+/** Alias for <code>dbof_typed_array_push_back_character(array, value)</code>. */
+inline void dbof_array_push_char(dbof_object_array array, dbof_char value)
+{ dbof_typed_array_push_back_character(array, value); }
+
+/**
+ * Get the capacity of an untyped array. Arrays that were snapshotted grow a little at a time, so their capacity is
+ * their size (see dbof_untyped_array_snapshot()).
+ *
+ * @param array The untyped array
+ * @return Its capacity
+ */
+extern dbof_container_size dbof_untyped_array_get_capacity(dbof_object_untyped_array array);
 
 /** Alias for <code>dbof_untyped_array_get_capacity(array)</code>. */
 inline dbof_container_size dbof_uarray_get_capacity(dbof_object_uarray array)
@@ -982,6 +1931,20 @@ extern void dbof_untyped_array_shrink_to_fit(dbof_object_untyped_array array);
 inline void dbof_uarray_shrink_to_fit(dbof_object_uarray array)
 { dbof_untyped_array_shrink_to_fit(array); }
 
+/**
+ * Make room in an untyped array for at least the given number of elements, so that it does not reallocate until it
+ * holds more.
+ *
+ * @param array The untyped array
+ * @param capacity The number of elements
+ * @return Zero upon success, or nonzero if out of memory
+ */
+extern int dbof_untyped_array_reserve(dbof_object_untyped_array array, dbof_container_size capacity);
+
+/** Alias for <code>dbof_untyped_array_reserve(array, capacity)</code>. */
+inline int dbof_uarray_reserve(dbof_object_uarray array, dbof_container_size capacity)
+{ return dbof_untyped_array_reserve(array, capacity); }
+
 /**
  * Get an element of an untyped array.
  *
@@ -1009,6 +1972,9 @@ inline dbof_object dbof_uarray_get(dbof_object_uarray array, dbof_container_size
  * Warning: This function may overwrite a pointer to dynamically-allocated memory. It is your responsibility to know
  * what information is being overwritten. Use #dbof_untyped_array_get(array, index) prior if this concerns you.
  *
+ * The caller relinquishes ownership of the object's memory. If the array refuses the object (as it does when frozen),
+ * the object is deleted, unless it is a view.
+ *
  * @param array The untyped array
  * @param index The element index
  * @param object The new element
@@ -1022,7 +1988,8 @@ inline void dbof_uarray_set(dbof_object_uarray array, dbof_container_size index,
 /**
  * Insert an element to an untyped array.
  *
- * The caller relinquishes ownership of the object's memory.
+ * The caller relinquishes ownership of the object's memory. If the array refuses the object (as it does when frozen),
+ * the object is deleted, unless it is a view.
  *
  * @param array The untyped array
  * @param index The target index
@@ -1041,7 +2008,7 @@ inline void dbof_uarray_insert(dbof_object_uarray array, dbof_container_size ind
  *
  * @param array The untyped array
  * @param index The target index
- * @return The old object
+ * @return The old object, or NULL on failure (it then stays in the array)
  */
 extern dbof_object dbof_untyped_array_remove(dbof_object_untyped_array array, dbof_container_size index);
 
@@ -1052,6 +2019,9 @@ inline dbof_object dbof_uarray_remove(dbof_object_uarray array, dbof_container_s
 /**
  * Add an object to the back of an untyped array.
  *
+ * The caller relinquishes ownership of the object's memory. If the array refuses the object (as it does when frozen),
+ * the object is deleted, unless it is a view.
+ *
  * @param array The untyped array
  * @param object The new object
  */
@@ -1062,7 +2032,7 @@ inline void dbof_uarray_push(dbof_object_uarray array, dbof_object object)
 { dbof_untyped_array_push_back(array, object); }
 
 /**
- * Remove the last object from a untyped array.
+ * Remove the last object from an untyped array, like dbof_untyped_array_remove().
  *
  * @param array The untyped array
  * @return The removed object
@@ -1073,6 +2043,33 @@ extern dbof_object dbof_untyped_array_pop_back(dbof_object_untyped_array array);
 inline dbof_object dbof_uarray_pop(dbof_object_uarray array)
 { return dbof_untyped_array_pop_back(array); }
 
+/**
+ * Take a snapshot of an untyped array. The snapshot is a new untyped array with the same children, which it shares
+ * with the original rather than copying them. Setting, inserting, and removing elements of the array or any of its
+ * snapshots is independent of all the others, and copies only the part of the shared list of children on the way to
+ * the touched element, so it takes O(log n) time. Getting, writing, hashing, and comparing copy nothing. The first
+ * snapshot of an array moves its children into a form that can be shared, which takes O(n) time; all others take
+ * O(1). Snapshots of frozen arrays are mutable. The snapshot is allocated from the same arena as the array, if any.
+ *
+ * The children themselves are shared, so changing one in place (setting its value, or editing a nested container)
+ * changes it in every array holding it. To change a child in one array only, set a changed copy in its place (and
+ * delete the old child afterward): a snapshot for a nested untyped array, which keeps an edit at any depth to
+ * O(log n) per level, or dbof_clone() otherwise. Freezing an array copies the children it shares first, so the
+ * others keep theirs mutable.
+ *
+ * An array and its snapshots share their children behind the scenes, so unless the array is frozen, use them from
+ * one thread at a time. Until its first edit, an array shares the references to its children. Replace or remove a
+ * child first and delete it afterward, never the other way around.
+ *
+ * @param array The untyped array
+ * @return The snapshot, or NULL on failure
+ */
+extern dbof_object_untyped_array dbof_untyped_array_snapshot(dbof_object_untyped_array array);
+
+/** Alias for <code>dbof_untyped_array_snapshot(array)</code>. */
+inline dbof_object_uarray dbof_uarray_snapshot(dbof_object_uarray array)
+{ return dbof_untyped_array_snapshot(array); }
+
 /**
  * Get the capacity of a typed map. This is the pre-allocated space for non-colliding entries.
  *
@@ -1085,6 +2082,19 @@ extern dbof_container_size dbof_typed_map_get_capacity(dbof_object_typed_map map
 inline dbof_container_size dbof_map_get_capacity(dbof_object_map map)
 { return dbof_typed_map_get_capacity(map); }
 
+/**
+ * Make room in a typed map for at least the given number of entries, so that it does not rehash until it holds more.
+ *
+ * @param map The typed map
+ * @param size The number of entries
+ * @return Zero upon success, or nonzero if out of memory
+ */
+extern int dbof_typed_map_reserve(dbof_object_typed_map map, dbof_container_size size);
+
+/** Alias for <code>dbof_typed_map_reserve(map, size)</code>. */
+inline int dbof_map_reserve(dbof_object_map map, dbof_container_size size)
+{ return dbof_typed_map_reserve(map, size); }
+
 /**
  * Get the size of a typed map. This is the total number of entries currently in the map.
  *
@@ -1160,6 +2170,12 @@ inline void dbof_map_set_value_type(dbof_object_map map, dbof_type value_type)
 /**
  * Get a value from a typed map for the given key.
  *
+ * Typed maps of a primitive value type (byte through double float, or character) store their values packed, so the
+ * returned object is a view of the value owned by the map, just like the elements of packed typed arrays. Changes to
+ * the view's value show up in the map, and putting another value for the key shows up in the view. Do not delete the
+ * view; it stays valid until the map is deleted. Removing the key hands the view itself back, and the caller then owns
+ * it.
+ *
  * @param map The typed map
  * @param key The key
  * @return The value
@@ -1173,17 +2189,19 @@ inline dbof_object dbof_map_get(dbof_object_map map, dbof_object key)
 /**
  * Put a value into a typed map with the given key.
  *
- * The caller relinquishes ownership of the object's memory.
+ * The caller relinquishes ownership of the objects' memory, even on failure: a key or value not of the map's key or
+ * value type is refused and deleted.
  *
  * @param map The typed map
  * @param key The key
  * @param value The value
+ * @return Zero on success, otherwise nonzero
  */
-extern void dbof_typed_map_put(dbof_object_typed_map map, dbof_object key, dbof_object value);
+extern int dbof_typed_map_put(dbof_object_typed_map map, dbof_object key, dbof_object value);
 
 /** Alias for <code>dbof_typed_map_put(map, key, value)</code>. */
-inline void dbof_map_put(dbof_object_map map, dbof_object key, dbof_object value)
-{ dbof_typed_map_put(map, key, value); }
+inline int dbof_map_put(dbof_object_map map, dbof_object key, dbof_object value)
+{ return dbof_typed_map_put(map, key, value); }
 
 /**
  * Remove a value from a typed map for the given key.
@@ -1213,17 +2231,150 @@ extern int dbof_typed_map_has_key(dbof_object_typed_map map, dbof_object key);
 inline int dbof_map_has_key(dbof_object_map map, dbof_object key)
 { return dbof_typed_map_has_key(map, key); }
 
+/**
+ * Get a value from a typed map of primitive key and value types (byte through double float, or character) without
+ * creating any objects.
+ *
+ * @param map The typed map
+ * @param key The key, as a value of the key type
+ * @param value Where to store the value, as a value of the value type
+ * @return Nonzero if the map has an entry for the key, otherwise zero
+ */
+extern int dbof_typed_map_get_packed(dbof_object_typed_map map, const void* key, void* value);
+
+/** Alias for <code>dbof_typed_map_get_packed(map, key, value)</code>. */
+inline int dbof_map_get_packed(dbof_object_map map, const void* key, void* value)
+{ return dbof_typed_map_get_packed(map, key, value); }
+
+/**
+ * Put a value into a typed map of primitive key and value types (byte through double float, or character) without
+ * creating any objects. The key and value types must already be set.
+ *
+ * @param map The typed map
+ * @param key The key, as a value of the key type
+ * @param value The value, as a value of the value type
+ */
+extern void dbof_typed_map_put_packed(dbof_object_typed_map map, const void* key, const void* value);
+
+/** Alias for <code>dbof_typed_map_put_packed(map, key, value)</code>. */
+inline void dbof_map_put_packed(dbof_object_map map, const void* key, const void* value)
+{ dbof_typed_map_put_packed(map, key, value); }
+
+/**
+ * Get a value from a typed map of unsigned long integers to double floats without creating any objects.
+ *
+ * @param map The typed map
+ * @param key The key
+ * @param value Where to store the value
+ * @return Nonzero if the map is of those types and has an entry for the key, otherwise zero
+ */
+extern int dbof_typed_map_get_unsigned_long_integer_double_float(dbof_object_typed_map map,
+        dbof_unsigned_long_integer key, dbof_double_float* value);
+
+/** Alias for <code>dbof_typed_map_get_unsigned_long_integer_double_float(map, key, value)</code>. */
+inline int dbof_map_get_ulong_double(dbof_object_map map, dbof_ulong key, dbof_double* value)
+{ return dbof_typed_map_get_unsigned_long_integer_double_float(map, key, value); }
+
+/**
+ * Put a value into a typed map of unsigned long integers to double floats without creating any objects. An empty map
+ * takes on the types.
+ *
+ * @param map The typed map
+ * @param key The key
+ * @param value The value
+ */
+extern void dbof_typed_map_put_unsigned_long_integer_double_float(dbof_object_typed_map map,
+        dbof_unsigned_long_integer key, dbof_double_float value);
+
+/** Alias for <code>dbof_typed_map_put_unsigned_long_integer_double_float(map, key, value)</code>. */
+inline void dbof_map_put_ulong_double(dbof_object_map map, dbof_ulong key, dbof_double value)
+{ dbof_typed_map_put_unsigned_long_integer_double_float(map, key, value); }
+
+/**
+ * Get a value from a typed map of signed integers to signed integers without creating any objects.
+ *
+ * @param map The typed map
+ * @param key The key
+ * @param value Where to store the value
+ * @return Nonzero if the map is of those types and has an entry for the key, otherwise zero
+ */
+extern int dbof_typed_map_get_signed_integer_signed_integer(dbof_object_typed_map map, dbof_signed_integer key,
+        dbof_signed_integer* value);
+
+/** Alias for <code>dbof_typed_map_get_signed_integer_signed_integer(map, key, value)</code>. */
+inline int dbof_map_get_int_int(dbof_object_map map, dbof_int key, dbof_int* value)
+{ return dbof_typed_map_get_signed_integer_signed_integer(map, key, value); }
+
+/**
+ * Put a value into a typed map of signed integers to signed integers without creating any objects. An empty map takes
+ * on the types.
+ *
+ * @param map The typed map
+ * @param key The key
+ * @param value The value
+ */
+extern void dbof_typed_map_put_signed_integer_signed_integer(dbof_object_typed_map map, dbof_signed_integer key,
+        dbof_signed_integer value);
+
+/** Alias for <code>dbof_typed_map_put_signed_integer_signed_integer(map, key, value)</code>. */
+inline void dbof_map_put_int_int(dbof_object_map map, dbof_int key, dbof_int value)
+{ dbof_typed_map_put_signed_integer_signed_integer(map, key, value); }
+
+/**
+ * Get a value from a typed map of UTF-8 strings to unsigned long integers without creating any objects.
+ *
+ * @param map The typed map
+ * @param key The key (null-terminated)
+ * @param value Where to store the value
+ * @return Nonzero if the map is of those types and has an entry for the key, otherwise zero
+ */
+extern int dbof_typed_map_get_utf8_string_unsigned_long_integer(dbof_object_typed_map map, const char* key,
+        dbof_unsigned_long_integer* value);
+
+/** Alias for <code>dbof_typed_map_get_utf8_string_unsigned_long_integer(map, key, value)</code>. */
+inline int dbof_map_get_string_ulong(dbof_object_map map, const char* key, dbof_ulong* value)
+{ return dbof_typed_map_get_utf8_string_unsigned_long_integer(map, key, value); }
+
+/**
+ * Put a value into a typed map of UTF-8 strings to unsigned long integers. Only a new key costs an object (the key
+ * string is copied). An empty map takes on the types.
+ *
+ * @param map The typed map
+ * @param key The key (null-terminated)
+ * @param value The value
+ */
+extern void dbof_typed_map_put_utf8_string_unsigned_long_integer(dbof_object_typed_map map, const char* key,
+        dbof_unsigned_long_integer value);
+
+/** Alias for <code>dbof_typed_map_put_utf8_string_unsigned_long_integer(map, key, value)</code>. */
+inline void dbof_map_put_string_ulong(dbof_object_map map, const char* key, dbof_ulong value)
+{ dbof_typed_map_put_utf8_string_unsigned_long_integer(map, key, value); }
+
 /**
  * Get the capacity of an untyped map. This is the pre-allocated space for non-colliding entries.
  *
  * @param map The untyped map
  * @return Its capacity
  */
-extern dbof_container_size dbof_untyped_map_get_capacity(dbof_object_untyped_map map);
+extern dbof_container_size dbof_untyped_map_get_capacity(dbof_object_untyped_map map);
+
+/** Alias for <code>dbof_untyped_map_get_capacity(map)</code>. */
+inline dbof_container_size dbof_umap_get_capacity(dbof_object_umap map)
+{ return dbof_untyped_map_get_capacity(map); }
+
+/**
+ * Make room in an untyped map for at least the given number of entries, so that it does not rehash until it holds
+ * more.
+ *
+ * @param map The untyped map
+ * @param size The number of entries
+ * @return Zero upon success, or nonzero if out of memory
+ */
+extern int dbof_untyped_map_reserve(dbof_object_untyped_map map, dbof_container_size size);
 
-/** Alias for <code>dbof_untyped_map_get_capacity(map)</code>. */
-inline dbof_container_size dbof_umap_get_capacity(dbof_object_umap map)
-{ return dbof_untyped_map_get_capacity(map); }
+/** Alias for <code>dbof_untyped_map_reserve(map, size)</code>. */
+inline int dbof_umap_reserve(dbof_object_umap map, dbof_container_size size)
+{ return dbof_untyped_map_reserve(map, size); }
 
 /**
  * Get the size of an untyped map. This is the total number of entries currently in the map.
@@ -1482,8 +2633,16 @@ typedef struct
 /**
  * The default DBOF Serialization Format version for times when one isn't supplied. Usually the latest-and-greatest,
  * while most general version available for use.
+ *
+ * Version 2 stores the children of typed containers without a type ID each. Version 1, which does, is still read, and
+ * still written if asked for.
+ */
+#define DBOF_SER_DEFAULT 2
+
+/**
+ * The deepest nesting of containers that readers accept unless told otherwise (see the max_depth field of dbof_reader).
  */
-#define DBOF_SER_DEFAULT 1
+#define DBOF_DEFAULT_MAX_DEPTH 512
 
 /**
  * A configuration for reading (deserializing) DBOF objects. Implementations are expected to track position.
@@ -1500,6 +2659,16 @@ typedef struct dbof_reader
      */
     size_t (* read)(struct dbof_reader* reader, char* ptr, size_t size);
 
+    /**
+     * Give back data that was read ahead past the end of the serialized object, so it is read again next time, or NULL
+     * if the source cannot take data back. Called at most once, at the end of reading or parsing, with the number of
+     * bytes to give back, which are always the last ones delivered by read(). Seekable sources simply step back.
+     *
+     * @param reader A reference to the reader
+     * @param size The number of bytes to give back
+     */
+    void (* unread)(struct dbof_reader* reader, size_t size);
+
     /**
      * Force the serialized object to be read using this DBOF Serialization Format version. This value will be ignored
      * if set to 0.
@@ -1512,6 +2681,56 @@ typedef struct dbof_reader
      */
     int no_header;
 
+    /**
+     * The arena to allocate the read objects from, or NULL to allocate them from the heap.
+     */
+    dbof_arena arena;
+
+    /**
+     * The size of the internal read buffer, or zero for the default. The reader may request data up to this many bytes
+     * past the end of the serialized object, which is lost unless the source takes it back through unread(). Set this
+     * to 1 to disable buffering (and thus any reading ahead) where more data follows and unread() is not available.
+     */
+    size_t buffer_size;
+
+    /**
+     * The intern pool to share string values through, or NULL to give every string its own copy. Against an
+     * allocation limit, a value counts once, when it is added to the pool.
+     */
+    dbof_intern_pool intern_pool;
+
+    /**
+     * The deepest nesting of containers to accept, or zero for DBOF_DEFAULT_MAX_DEPTH. A top-level container sits at
+     * depth one. Reading or parsing a deeper object fails. Neither recurses, but deleting and writing objects do, one
+     * call per level, so the default keeps whatever is read safe to delete and write again on a thread with a modest
+     * stack. Raise it (UINT_MAX takes the limit away) only for trusted input and threads with the stack to match.
+     */
+    unsigned int max_depth;
+
+    /**
+     * The most memory to allocate for the read objects in bytes, or zero for no limit. Reading an object that would
+     * take more fails before the memory is allocated. The count follows the library's own object layout, so it is an
+     * estimate of what the allocator hands out.
+     */
+    size_t max_allocation;
+
+    /**
+     * The number of threads to read with (the calling thread included), or zero to read on the calling thread alone.
+     * Untyped containers with about a thousand children or more are cut into chunks, which are read on this many
+     * threads at once and added to the container in order. The result is the same either way. Only takes effect with
+     * dbof_read_buffer_ex() (which has the whole input at hand) and without an arena, an intern pool, or an allocation
+     * limit, and only if the library is built with DBOF_THREADS (on POSIX systems, the threads then come from
+     * pthreads).
+     */
+    unsigned int threads;
+
+    /**
+     * Set this to a nonzero value to read null, byte, integer, Boolean, single float and character objects as
+     * immediate values, which take no memory but count as frozen, so their values cannot be set. Only takes effect if
+     * the library is built with DBOF_TAGGED_VALUES. Otherwise, all read objects are allocated and mutable.
+     */
+    int immediate_values;
+
     /**
      * Just a thing for general-purpose use. Put what you want here.
      */
@@ -1535,7 +2754,7 @@ typedef struct dbof_writer
 
     /**
      * Force the serialized object to be written using this DBOF Serialization Format version. This value will be
-     * ignored if set to 0 and the object will be written using version DBOF_SER_LATEST by default.
+     * ignored if set to 0 and the object will be written using version DBOF_SER_DEFAULT by default.
      */
     unsigned short use_version;
 
@@ -1546,6 +2765,19 @@ typedef struct dbof_writer
      */
     int no_header;
 
+    /**
+     * The size of the internal write buffer, or zero for the default. Set this to 1 to disable buffering.
+     */
+    size_t buffer_size;
+
+    /**
+     * The number of threads to write with (the calling thread included), or zero to write on the calling thread alone.
+     * Untyped containers with about a thousand children or more are cut into chunks, which are encoded on this many
+     * threads at once and handed to write() in order on the calling thread. The output is the same either way. Only
+     * takes effect if the library is built with DBOF_THREADS (on POSIX systems, the threads then come from pthreads).
+     */
+    unsigned int threads;
+
     /**
      * Just a thing for general-purpose use. Put what you want here.
      */
@@ -1560,6 +2792,208 @@ typedef struct dbof_writer
  */
 extern dbof_object dbof_read(dbof_reader* reader);
 
+/**
+ * Flag for dbof_read_buffer(). Let the read objects reference the given buffer instead of copying out of it. The
+ * caller must then keep the buffer alive and unmodified until the objects are deleted.
+ */
+#define DBOF_READ_BORROW 0x01
+
+/**
+ * Read an object from a buffer in memory. The buffer must hold a serialized object with a header.
+ *
+ * With the DBOF_READ_BORROW flag, string values reference the buffer directly. Such a string is copied out on its
+ * first dbof_get_value_utf8_string() call (which needs a null terminator), but dbof_get_value_utf8_string_data() and
+ * dbof_get_value_utf8_string_length() never copy.
+ *
+ * Typed arrays of primitive types reference the buffer, too, if the host is little-endian and their values happen to
+ * be suitably aligned in it. They copy their values out the first time they are modified.
+ *
+ * @param data The buffer
+ * @param size The size of the buffer
+ * @param flags Zero or more DBOF_READ_* flags
+ * @return The read object or NULL if an error occurred
+ */
+extern dbof_object dbof_read_buffer(const void* data, size_t size, int flags);
+
+/**
+ * Read an object from a buffer in memory, like dbof_read_buffer(), with the settings of the given reader. The read
+ * function of the reader is not used.
+ *
+ * @param reader The reader
+ * @param data The buffer
+ * @param size The size of the buffer
+ * @param flags Zero or more DBOF_READ_* flags
+ * @return The read object or NULL if an error occurred
+ */
+extern dbof_object dbof_read_buffer_ex(dbof_reader* reader, const void* data, size_t size, int flags);
+
+/**
+ * The value of a primitive object, as passed to parse handlers. The member to use depends on the object type.
+ */
+typedef union dbof_value
+{
+    dbof_signed_byte signed_byte;
+    dbof_unsigned_byte unsigned_byte;
+    dbof_signed_integer signed_integer;
+    dbof_unsigned_integer unsigned_integer;
+    dbof_signed_long_integer signed_long_integer;
+    dbof_unsigned_long_integer unsigned_long_integer;
+    dbof_boolean boolean;
+    dbof_single_float single_float;
+    dbof_double_float double_float;
+    dbof_character character;
+} dbof_value;
+
+/**
+ * Handler return value. Keep parsing.
+ */
+#define DBOF_PARSE_CONTINUE 0
+
+/**
+ * Handler return value. When returned when beginning a container, skip its contents (and its end event). Elsewhere,
+ * this is the same as DBOF_PARSE_CONTINUE.
+ */
+#define DBOF_PARSE_SKIP 1
+
+/**
+ * A set of callbacks for parsing serialized objects as a stream of events, without building any objects. Any
+ * callback may be NULL to ignore its events. Each callback returns DBOF_PARSE_CONTINUE, DBOF_PARSE_SKIP, or any
+ * other value to abort the parse.
+ *
+ * Containers produce a begin event, the events of their contents, and an end event. In maps, the key callback is
+ * called before each key-value pair, and then the key's events are followed by the value's.
+ */
+typedef struct dbof_handler
+{
+    /**
+     * Handle a primitive object (null through character).
+     *
+     * @param handler A reference to the handler
+     * @param type The object type
+     * @param value The object value (unused for null objects)
+     * @return A DBOF_PARSE_* value or an abort code
+     */
+    int (* scalar)(struct dbof_handler* handler, dbof_type type, const dbof_value* value);
+
+    /**
+     * Handle a UTF-8 string object. The bytes are not null-terminated and are only valid during the call.
+     *
+     * @param handler A reference to the handler
+     * @param ptr The string bytes
+     * @param length The string length in bytes
+     * @return A DBOF_PARSE_* value or an abort code
+     */
+    int (* string)(struct dbof_handler* handler, const char* ptr, dbof_string_size length);
+
+    /**
+     * Handle a piece of a UTF-8 string object, for strings too large for the reader's buffer. The pieces come in
+     * order, as the buffer fills up, and only the last one has nothing remaining after it. Returning DBOF_PARSE_SKIP
+     * skips the rest of the string. If this is NULL, such strings are copied out and passed to the string callback
+     * whole instead. If the string callback is NULL, all strings are passed here (those that fit the buffer in one
+     * piece).
+     *
+     * @param handler A reference to the handler
+     * @param ptr The bytes of this piece, only valid during the call
+     * @param size The size of this piece in bytes
+     * @param remaining The number of bytes of the string still to come
+     * @return A DBOF_PARSE_* value or an abort code
+     */
+    int (* string_data)(struct dbof_handler* handler, const char* ptr, dbof_string_size size,
+            dbof_string_size remaining);
+
+    /**
+     * Handle the beginning of an array.
+     *
+     * @param handler A reference to the handler
+     * @param type The array type (DBOF_TYPE_TYPED_ARRAY or DBOF_TYPE_UNTYPED_ARRAY)
+     * @param size The number of elements
+     * @param element_type The element type (only meaningful for typed arrays)
+     * @return A DBOF_PARSE_* value or an abort code
+     */
+    int (* begin_array)(struct dbof_handler* handler, dbof_type type, dbof_container_size size,
+            dbof_type element_type);
+
+    /**
+     * Handle a chunk of values of a typed array of a primitive type (byte through double float, or character). If
+     * this is NULL, the values are passed to the scalar callback one by one instead.
+     *
+     * @param handler A reference to the handler
+     * @param element_type The element type
+     * @param values The values, laid out as an array of the element type and only valid during the call
+     * @param count The number of values
+     * @return A DBOF_PARSE_* value or an abort code
+     */
+    int (* array_data)(struct dbof_handler* handler, dbof_type element_type, const void* values,
+            dbof_container_size count);
+
+    /**
+     * Handle the end of an array.
+     *
+     * @param handler A reference to the handler
+     * @return A DBOF_PARSE_* value or an abort code
+     */
+    int (* end_array)(struct dbof_handler* handler);
+
+    /**
+     * Handle the beginning of a map.
+     *
+     * @param handler A reference to the handler
+     * @param type The map type (DBOF_TYPE_TYPED_MAP or DBOF_TYPE_UNTYPED_MAP)
+     * @param size The number of key-value pairs
+     * @param key_type The key type (only meaningful for typed maps)
+     * @param value_type The value type (only meaningful for typed maps)
+     * @return A DBOF_PARSE_* value or an abort code
+     */
+    int (* begin_map)(struct dbof_handler* handler, dbof_type type, dbof_container_size size, dbof_type key_type,
+            dbof_type value_type);
+
+    /**
+     * Handle the upcoming key of a key-value pair in a map.
+     *
+     * @param handler A reference to the handler
+     * @return A DBOF_PARSE_* value or an abort code
+     */
+    int (* key)(struct dbof_handler* handler);
+
+    /**
+     * Handle the end of a map.
+     *
+     * @param handler A reference to the handler
+     * @return A DBOF_PARSE_* value or an abort code
+     */
+    int (* end_map)(struct dbof_handler* handler);
+
+    /**
+     * Just a thing for general-purpose use. Put what you want here.
+     */
+    void* data;
+} dbof_handler;
+
+/**
+ * Parse an object with the given reader, passing its contents to the handler as events. Memory use does not depend on
+ * the size of the object, except that deeply nested containers need a stack of those still open, and strings larger
+ * than the reader's buffer are copied out temporarily unless the handler takes them in pieces (see the string_data
+ * callback). Such copies count against the reader's allocation limit while they exist, and they grow with the input
+ * actually read, so a corrupt length fails at the end of the input instead of allocating what it claims.
+ *
+ * @param reader The reader
+ * @param handler The handler
+ * @return Zero upon success, the abort code returned by a callback, or -1 if an error occurred
+ */
+extern int dbof_parse(dbof_reader* reader, dbof_handler* handler);
+
+/**
+ * Parse an object from a buffer in memory, passing its contents to the handler as events. The buffer must hold a
+ * serialized object with a header. Strings are handed out in place, and a length running past the end of the buffer
+ * fails the parse.
+ *
+ * @param data The buffer
+ * @param size The size of the buffer
+ * @param handler The handler
+ * @return Zero upon success, the abort code returned by a callback, or -1 if an error occurred
+ */
+extern int dbof_parse_buffer(const void* data, size_t size, dbof_handler* handler);
+
 /**
  * Write an object with the given writer.
  *
@@ -1569,6 +3003,268 @@ extern dbof_object dbof_read(dbof_reader* reader);
  */
 extern int dbof_write(dbof_object object, dbof_writer* writer);
 
+/**
+ * A handle to an encoder, which writes a serialized object piece by piece without building any objects. Containers
+ * are written by beginning them with their size, writing exactly that many children (keys and values alternating in
+ * maps), and ending them. Children of typed containers must be of the container's type(s).
+ *
+ * Any misuse or write failure fails the encoder: every later call returns nonzero, and so does dbof_encoder_finish().
+ */
+typedef void* dbof_encoder;
+
+/**
+ * Create an encoder writing to the given writer. The header is written right away. The writer must outlive the
+ * encoder.
+ *
+ * @param writer The writer
+ * @return The encoder or NULL if an error occurred
+ */
+extern dbof_encoder dbof_encoder_new(dbof_writer* writer);
+
+/**
+ * Finish encoding and delete the encoder. All buffered data is handed to the writer.
+ *
+ * @param encoder The encoder
+ * @return Zero if a complete object was written, otherwise nonzero
+ */
+extern int dbof_encoder_finish(dbof_encoder encoder);
+
+/**
+ * Begin writing a typed array.
+ *
+ * @param encoder The encoder
+ * @param size The number of elements to follow
+ * @param element_type The element type
+ * @return Zero upon success, otherwise nonzero
+ */
+extern int dbof_encoder_begin_typed_array(dbof_encoder encoder, dbof_container_size size, dbof_type element_type);
+
+/** Alias for <code>dbof_encoder_begin_typed_array(encoder, size, element_type)</code>. */
+inline int dbof_encoder_begin_array(dbof_encoder encoder, dbof_container_size size, dbof_type element_type)
+{ return dbof_encoder_begin_typed_array(encoder, size, element_type); }
+
+/**
+ * Begin writing an untyped array.
+ *
+ * @param encoder The encoder
+ * @param size The number of elements to follow
+ * @return Zero upon success, otherwise nonzero
+ */
+extern int dbof_encoder_begin_untyped_array(dbof_encoder encoder, dbof_container_size size);
+
+/** Alias for <code>dbof_encoder_begin_untyped_array(encoder, size)</code>. */
+inline int dbof_encoder_begin_uarray(dbof_encoder encoder, dbof_container_size size)
+{ return dbof_encoder_begin_untyped_array(encoder, size); }
+
+/**
+ * Begin writing a typed map.
+ *
+ * @param encoder The encoder
+ * @param size The number of key-value pairs to follow
+ * @param key_type The key type
+ * @param value_type The value type
+ * @return Zero upon success, otherwise nonzero
+ */
+extern int dbof_encoder_begin_typed_map(dbof_encoder encoder, dbof_container_size size, dbof_type key_type,
+        dbof_type value_type);
+
+/** Alias for <code>dbof_encoder_begin_typed_map(encoder, size, key_type, value_type)</code>. */
+inline int dbof_encoder_begin_map(dbof_encoder encoder, dbof_container_size size, dbof_type key_type,
+        dbof_type value_type)
+{ return dbof_encoder_begin_typed_map(encoder, size, key_type, value_type); }
+
+/**
+ * Begin writing an untyped map.
+ *
+ * @param encoder The encoder
+ * @param size The number of key-value pairs to follow
+ * @return Zero upon success, otherwise nonzero
+ */
+extern int dbof_encoder_begin_untyped_map(dbof_encoder encoder, dbof_container_size size);
+
+/** Alias for <code>dbof_encoder_begin_untyped_map(encoder, size)</code>. */
+inline int dbof_encoder_begin_umap(dbof_encoder encoder, dbof_container_size size)
+{ return dbof_encoder_begin_untyped_map(encoder, size); }
+
+/**
+ * End the innermost container. All of its children must have been written.
+ *
+ * @param encoder The encoder
+ * @return Zero upon success, otherwise nonzero
+ */
+extern int dbof_encoder_end(dbof_encoder encoder);
+
+/**
+ * Write a null object.
+ *
+ * @param encoder The encoder
+ * @return Zero upon success, otherwise nonzero
+ */
+extern int dbof_encoder_write_null(dbof_encoder encoder);
+
+/**
+ * Write a signed byte object.
+ *
+ * @param encoder The encoder
+ * @param value The value
+ * @return Zero upon success, otherwise nonzero
+ */
+extern int dbof_encoder_write_signed_byte(dbof_encoder encoder, dbof_signed_byte value);
+
+/** Alias for <code>dbof_encoder_write_signed_byte(encoder, value)</code>. */
+inline int dbof_encoder_write_byte(dbof_encoder encoder, dbof_byte value)
+{ return dbof_encoder_write_signed_byte(encoder, value); }
+
+/**
+ * Write an unsigned byte object.
+ *
+ * @param encoder The encoder
+ * @param value The value
+ * @return Zero upon success, otherwise nonzero
+ */
+extern int dbof_encoder_write_unsigned_byte(dbof_encoder encoder, dbof_unsigned_byte value);
+
+/** Alias for <code>dbof_encoder_write_unsigned_byte(encoder, value)</code>. */
+inline int dbof_encoder_write_ubyte(dbof_encoder encoder, dbof_ubyte value)
+{ return dbof_encoder_write_unsigned_byte(encoder, value); }
+
+/**
+ * Write a signed integer object.
+ *
+ * @param encoder The encoder
+ * @param value The value
+ * @return Zero upon success, otherwise nonzero
+ */
+extern int dbof_encoder_write_signed_integer(dbof_encoder encoder, dbof_signed_integer value);
+
+/** Alias for <code>dbof_encoder_write_signed_integer(encoder, value)</code>. */
+inline int dbof_encoder_write_int(dbof_encoder encoder, dbof_int value)
+{ return dbof_encoder_write_signed_integer(encoder, value); }
+
+/**
+ * Write an unsigned integer object.
+ *
+ * @param encoder The encoder
+ * @param value The value
+ * @return Zero upon success, otherwise nonzero
+ */
+extern int dbof_encoder_write_unsigned_integer(dbof_encoder encoder, dbof_unsigned_integer value);
+
+/** Alias for <code>dbof_encoder_write_unsigned_integer(encoder, value)</code>. */
+inline int dbof_encoder_write_uint(dbof_encoder encoder, dbof_uint value)
+{ return dbof_encoder_write_unsigned_integer(encoder, value); }
+
+/**
+ * Write a signed long integer object.
+ *
+ * @param encoder The encoder
+ * @param value The value
+ * @return Zero upon success, otherwise nonzero
+ */
+extern int dbof_encoder_write_signed_long_integer(dbof_encoder encoder, dbof_signed_long_integer value);
+
+/** Alias for <code>dbof_encoder_write_signed_long_integer(encoder, value)</code>. */
+inline int dbof_encoder_write_long(dbof_encoder encoder, dbof_long value)
+{ return dbof_encoder_write_signed_long_integer(encoder, value); }
+
+/**
+ * Write an unsigned long integer object.
+ *
+ * @param encoder The encoder
+ * @param value The value
+ * @return Zero upon success, otherwise nonzero
+ */
+extern int dbof_encoder_write_unsigned_long_integer(dbof_encoder encoder, dbof_unsigned_long_integer value);
+
+/** Alias for <code>dbof_encoder_write_unsigned_long_integer(encoder, value)</code>. */
+inline int dbof_encoder_write_ulong(dbof_encoder encoder, dbof_ulong value)
+{ return dbof_encoder_write_unsigned_long_integer(encoder, value); }
+
+/**
+ * Write a boolean object.
+ *
+ * @param encoder The encoder
+ * @param value The value
+ * @return Zero upon success, otherwise nonzero
+ */
+extern int dbof_encoder_write_boolean(dbof_encoder encoder, dbof_boolean value);
+
+/** Alias for <code>dbof_encoder_write_boolean(encoder, value)</code>. */
+inline int dbof_encoder_write_bool(dbof_encoder encoder, dbof_bool value)
+{ return dbof_encoder_write_boolean(encoder, value); }
+
+/**
+ * Write a single float object.
+ *
+ * @param encoder The encoder
+ * @param value The value
+ * @return Zero upon success, otherwise nonzero
+ */
+extern int dbof_encoder_write_single_float(dbof_encoder encoder, dbof_single_float value);
+
+/** Alias for <code>dbof_encoder_write_single_float(encoder, value)</code>. */
+inline int dbof_encoder_write_float(dbof_encoder encoder, dbof_float value)
+{ return dbof_encoder_write_single_float(encoder, value); }
+
+/**
+ * Write a double float object.
+ *
+ * @param encoder The encoder
+ * @param value The value
+ * @return Zero upon success, otherwise nonzero
+ */
+extern int dbof_encoder_write_double_float(dbof_encoder encoder, dbof_double_float value);
+
+/** Alias for <code>dbof_encoder_write_double_float(encoder, value)</code>. */
+inline int dbof_encoder_write_double(dbof_encoder encoder, dbof_double value)
+{ return dbof_encoder_write_double_float(encoder, value); }
+
+/**
+ * Write a character object.
+ *
+ * @param encoder The encoder
+ * @param value The value
+ * @return Zero upon success, otherwise nonzero
+ */
+extern int dbof_encoder_write_character(dbof_encoder encoder, dbof_character value);
+
+/** Alias for <code>dbof_encoder_write_character(encoder, value)</code>. */
+inline int dbof_encoder_write_char(dbof_encoder encoder, dbof_char value)
+{ return dbof_encoder_write_character(encoder, value); }
+
+/**
+ * Write a UTF-8 string object.
+ *
+ * @param encoder The encoder
+ * @param value The string bytes (which need not be null-terminated)
+ * @param length The string length in bytes
+ * @return Zero upon success, otherwise nonzero
+ */
+extern int dbof_encoder_write_utf8_string(dbof_encoder encoder, const char* value, dbof_string_size length);
+
+/** Alias for <code>dbof_encoder_write_utf8_string(encoder, value, length)</code>. */
+inline int dbof_encoder_write_string(dbof_encoder encoder, const char* value, dbof_string_size length)
+{ return dbof_encoder_write_utf8_string(encoder, value, length); }
+
+/**
+ * Write several elements of a typed array of a primitive type (byte through double float, or character) at once.
+ *
+ * @param encoder The encoder
+ * @param values The values, laid out as an array of the element type
+ * @param count The number of values
+ * @return Zero upon success, otherwise nonzero
+ */
+extern int dbof_encoder_write_array_data(dbof_encoder encoder, const void* values, dbof_container_size count);
+
+/**
+ * Write an existing object (and all of its children).
+ *
+ * @param encoder The encoder
+ * @param object The object
+ * @return Zero upon success, otherwise nonzero
+ */
+extern int dbof_encoder_write_object(dbof_encoder encoder, dbof_object object);
+
 #ifdef __cplusplus
 }
 #endif
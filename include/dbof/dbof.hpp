@@ -204,7 +204,12 @@ protected:
     {}
 
 public:
-    object(const object& other) = delete;
+    /**
+     * Make another wrapper for the same object, taking a reference to it with <code>dbof_retain()</code>. The object is
+     * not copied, so changes through either wrapper show in both; freeze it first to share it safely.
+     */
+    object(const object& other) : _type(other._type), _c_obj(dbof_retain(other._c_obj))
+    {}
 
     object(const object&& other) = delete;
 
@@ -554,6 +559,9 @@ struct utf8_string : public object
     dbof_utf8_string get() const
     { return dbof_get_value_utf8_string(_c_obj); }
 
+    dbof_string_size length() const
+    { return dbof_get_value_utf8_string_length(_c_obj); }
+
     void set(dbof_utf8_string value)
     { dbof_set_value_utf8_string(_c_obj, value); }
 };
@@ -7,8 +7,16 @@
 #define DBOF_FILE_H
 
 #include <stdio.h>
+#include <stdlib.h>
 #include "dbof.h"
 
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 #ifdef __cplusplus
 extern "C"
 {
@@ -20,6 +28,12 @@ size_t __dbof_file_reader_impl_read(struct dbof_reader* reader, char* ptr, size_
     return fread(ptr, 1, size, file);
 }
 
+void __dbof_file_reader_impl_unread(struct dbof_reader* reader, size_t size)
+{
+    FILE* file = (FILE*) reader->data;
+    fseek(file, -(long) size, SEEK_CUR);
+}
+
 /**
  * Read a DBOF object from the given file. Returns NULL on failure.
  *
@@ -28,11 +42,22 @@ size_t __dbof_file_reader_impl_read(struct dbof_reader* reader, char* ptr, size_
  */
 dbof_object dbof_file_read(FILE* file)
 {
+    // Seekable files get back what was read ahead past the object, others must not be read ahead at all
+    int seekable = fseek(file, 0, SEEK_CUR) == 0;
+
     // Set up the reader
     dbof_reader reader;
     reader.read = __dbof_file_reader_impl_read;
+    reader.unread = seekable ? __dbof_file_reader_impl_unread : NULL;
     reader.use_version = 0;
     reader.no_header = 0;
+    reader.arena = NULL;
+    reader.buffer_size = seekable ? 0 : 1;
+    reader.intern_pool = NULL;
+    reader.max_depth = 0;
+    reader.max_allocation = 0;
+    reader.threads = 0;
+    reader.immediate_values = 0;
     reader.data = file;
 
     // Perform the read
@@ -61,12 +86,135 @@ int dbof_file_write(dbof_object object, FILE* file)
     writer.write = __dbof_file_writer_impl_write;
     writer.use_version = 0; // Use latest version by default
     writer.no_header = 0;
+    writer.buffer_size = 0;
+    writer.threads = 0;
     writer.data = file;
 
     // Perform the write
     return dbof_write(object, &writer);
 }
 
+/**
+ * A DBOF file mapped into memory (read-only). Where memory mapping is not available, the file is read into memory as a
+ * whole instead.
+ */
+typedef struct dbof_file_map
+{
+    /**
+     * The file contents.
+     */
+    const void* data;
+
+    /**
+     * The size of the file contents.
+     */
+    size_t size;
+} dbof_file_map;
+
+/**
+ * Map a DBOF file into memory.
+ *
+ * @param map The map to set up
+ * @param path The path to the file
+ * @return Zero upon success, otherwise nonzero
+ */
+int dbof_file_map_open(dbof_file_map* map, const char* path)
+{
+    map->data = NULL;
+    map->size = 0;
+
+#ifndef _WIN32
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+        return -1;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0)
+    {
+        // ERROR: Cannot get the size or nothing to map
+        close(fd);
+        return -1;
+    }
+
+    void* data = mmap(NULL, (size_t) st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+    // The mapping keeps the file open on its own
+    close(fd);
+
+    if (data == MAP_FAILED)
+        return -1;
+
+#ifdef MADV_SEQUENTIAL
+    // Objects are decoded front to back, so let the kernel read ahead
+    madvise(data, (size_t) st.st_size, MADV_SEQUENTIAL);
+#endif
+
+    map->data = data;
+    map->size = (size_t) st.st_size;
+#else
+    FILE* file = fopen(path, "rb");
+    if (file == NULL)
+        return -1;
+
+    // Read the whole file into memory
+    long size = -1;
+    if (fseek(file, 0, SEEK_END) == 0)
+    {
+        size = ftell(file);
+        rewind(file);
+    }
+
+    char* data = size > 0 ? malloc((size_t) size) : NULL;
+    if (data == NULL || fread(data, 1, (size_t) size, file) < (size_t) size)
+    {
+        // ERROR: Empty, out of memory, or unable to read
+        free(data);
+        fclose(file);
+        return -1;
+    }
+
+    fclose(file);
+
+    map->data = data;
+    map->size = (size_t) size;
+#endif
+
+    return 0;
+}
+
+/**
+ * Unmap a DBOF file. Objects read from the map with DBOF_READ_BORROW must be deleted beforehand.
+ *
+ * @param map The map
+ */
+void dbof_file_map_close(dbof_file_map* map)
+{
+#ifndef _WIN32
+    if (map->data != NULL)
+    {
+        munmap((void*) map->data, map->size);
+    }
+#else
+    free((void*) map->data);
+#endif
+
+    map->data = NULL;
+    map->size = 0;
+}
+
+/**
+ * Read a DBOF object from a mapped file. Returns NULL on failure.
+ *
+ * With the DBOF_READ_BORROW flag, strings and typed arrays may point into the mapping instead of being copied (see
+ * dbof_read_buffer()), so the map must stay open until they are deleted.
+ *
+ * @param map The map
+ * @param flags Zero or more DBOF_READ_* flags
+ * @return The object or NULL
+ */
+dbof_object dbof_mmap_read(const dbof_file_map* map, int flags)
+{ return dbof_read_buffer(map->data, map->size, flags); }
+
 #ifdef __cplusplus
 }
 #endif
@@ -40,6 +40,14 @@ std::size_t read(dbof_reader* reader, char* ptr, std::size_t size)
     return static_cast<std::size_t>(in.gcount());
 }
 
+void unread(dbof_reader* reader, std::size_t size)
+{
+    // Reading ahead may have run into the end of the stream, which must not keep us from stepping back
+    std::istream& in = *static_cast<std::istream*>(reader->data);
+    in.clear(in.rdstate() & std::ios_base::badbit);
+    in.seekg(-static_cast<std::streamoff>(size), std::ios_base::cur);
+}
+
 std::size_t write(dbof_writer* writer, const char* ptr, std::size_t size)
 {
     // Unpack reference to output stream
@@ -79,11 +87,16 @@ std::size_t write(dbof_writer* writer, const char* ptr, std::size_t size)
  */
 dbof::object* read(std::istream& in)
 {
+    // Seekable streams get back what was read ahead past the object, others must not be read ahead at all
+    bool seekable = in.tellg() != std::istream::pos_type(-1);
+
     // Set up the reader
     dbof_reader reader {};
     reader.read = __impl::read;
+    reader.unread = seekable ? __impl::unread : nullptr;
     reader.use_version = 0;
     reader.no_header = 0;
+    reader.buffer_size = seekable ? 0 : 1;
     reader.data = &in;
 
     // Perform the read
@@ -8,6 +8,12 @@
 
 #include <dbof/dbof.h>
 
+#ifdef _WIN32
+#include <windows.h>
+#elif defined(DBOF_POOL) || defined(DBOF_THREADS)
+#include <pthread.h>
+#endif
+
 #ifndef DBOF_MALLOC
 /// malloc() override
 #define DBOF_MALLOC malloc
@@ -33,2437 +39,11922 @@
 #define realloc DBOF_REALLOC
 #define free    DBOF_FREE
 
+//
+// NOTICE
+// An arena is a chain of large blocks from which objects (and their storage) are carved out with a bump pointer.
+// Nothing allocated from an arena is ever freed individually. Instead, the whole arena is released (or reset) at once,
+// which makes tearing down a big object tree cost one free() per block rather than one per object.
+//
+
 /**
- * Common base header for every in-memory DBOF object.
+ * The alignment of every allocation made from an arena.
  */
-struct __object_impl
+#define __ARENA_ALIGNMENT 8
+
+/**
+ * Round a size up to the arena alignment.
+ */
+#define __ARENA_ALIGN(size) (((size) + __ARENA_ALIGNMENT - 1) & ~((size_t) __ARENA_ALIGNMENT - 1))
+
+struct __arena_block
 {
     /**
-     * The derived object type.
+     * The next (older) block in the chain.
      */
-    dbof_type type;
+    struct __arena_block* next;
+
+    /**
+     * The usable size of the block.
+     */
+    size_t size;
+
+    /**
+     * The number of bytes handed out so far.
+     */
+    size_t used;
+};
+
+/**
+ * Get the first usable byte of an arena block.
+ */
+#define __ARENA_BLOCK_DATA(block) ((char*) (block) + __ARENA_ALIGN(sizeof(struct __arena_block)))
+
+struct __arena
+{
+    /**
+     * The usable size of each regular block.
+     */
+    size_t block_size;
+
+    /**
+     * The block currently being carved up, followed by all older blocks.
+     */
+    struct __arena_block* head;
 };
 
-static void* __new_empty_object(dbof_type type, size_t size)
+static struct __arena_block* __arena_new_block(size_t size)
 {
-    struct __object_impl* object = calloc(1, size);
+    struct __arena_block* block = malloc(__ARENA_ALIGN(sizeof(struct __arena_block)) + size);
 
-    if (object == NULL)
+    if (block == NULL)
     {
         // ERROR: Out of memory
         return NULL;
     }
 
-    object->type = type;
-    return object;
+    block->next = NULL;
+    block->size = size;
+    block->used = 0;
+    return block;
 }
 
-/**
- * Implementation of a null object (type ID 0).
- */
-struct __object_null_impl
+static void* __arena_alloc(struct __arena* arena, size_t size)
 {
-    struct __object_impl base;
-};
+    size = __ARENA_ALIGN(size);
 
-static struct __object_null_impl* __new_object_null()
-{ return __new_empty_object(DBOF_TYPE_NULL, sizeof(struct __object_null_impl)); }
+    struct __arena_block* head = arena->head;
 
-static void __delete_object_null(struct __object_null_impl* object)
-{ free(object); }
+    // Fast path: bump the pointer within the current block
+    if (head != NULL && head->size - head->used >= size)
+    {
+        void* ptr = __ARENA_BLOCK_DATA(head) + head->used;
+        head->used += size;
+        return ptr;
+    }
 
-static int __hash_object_null(struct __object_null_impl* object)
-{ return 0; }
+    // Large requests get a dedicated block, which goes behind the head so the rest of the head is not wasted
+    if (size > arena->block_size / 2)
+    {
+        struct __arena_block* block = __arena_new_block(size);
+        if (block == NULL)
+            return NULL;
+
+        block->used = size;
+
+        if (head == NULL)
+        {
+            arena->head = block;
+        }
+        else
+        {
+            block->next = head->next;
+            head->next = block;
+        }
+
+        return __ARENA_BLOCK_DATA(block);
+    }
+
+    // Otherwise, start a new regular block
+    struct __arena_block* block = __arena_new_block(arena->block_size);
+    if (block == NULL)
+        return NULL;
+
+    block->next = head;
+    block->used = size;
+    arena->head = block;
+
+    return __ARENA_BLOCK_DATA(block);
+}
 
 /**
- * Implementation of a signed byte object (type ID 1).
+ * Internal. Make sure the block at the head of an arena has room for the given number of bytes, so that allocations
+ * adding up to no more than that land in one contiguous run. Returns zero on success, otherwise nonzero.
  */
-struct __object_signed_byte_impl
+static int __arena_reserve(struct __arena* arena, size_t size)
 {
-    struct __object_impl base;
-    dbof_signed_byte value;
-};
+    struct __arena_block* head = arena->head;
+    if (head != NULL && head->size - head->used >= size)
+        return 0;
 
-static struct __object_signed_byte_impl* __new_object_signed_byte()
-{ return __new_empty_object(DBOF_TYPE_SIGNED_BYTE, sizeof(struct __object_signed_byte_impl)); }
+    struct __arena_block* block = __arena_new_block(size > arena->block_size ? size : arena->block_size);
+    if (block == NULL)
+        return -1;
 
-static void __delete_object_signed_byte(struct __object_signed_byte_impl* object)
-{ free(object); }
+    block->next = head;
+    arena->head = block;
+    return 0;
+}
 
-static int __hash_object_signed_byte(struct __object_signed_byte_impl* object)
-{ return object->value; }
+static void* __arena_calloc(struct __arena* arena, size_t count, size_t size)
+{
+    void* ptr = __arena_alloc(arena, count * size);
 
-/**
- * Implementation of an unsigned byte object (type ID 2).
- */
-struct __object_unsigned_byte_impl
+    if (ptr != NULL)
+    {
+        memset(ptr, 0, count * size);
+    }
+
+    return ptr;
+}
+
+static void* __arena_realloc(struct __arena* arena, void* ptr, size_t old_size, size_t size)
 {
-    struct __object_impl base;
-    dbof_unsigned_byte value;
-};
+    struct __arena_block* head = arena->head;
 
-static struct __object_unsigned_byte_impl* __new_object_unsigned_byte()
-{ return __new_empty_object(DBOF_TYPE_UNSIGNED_BYTE, sizeof(struct __object_unsigned_byte_impl)); }
+    // If this was the most recent allocation, try to grow or shrink it in place
+    if (ptr != NULL && head != NULL
+            && (char*) ptr + __ARENA_ALIGN(old_size) == __ARENA_BLOCK_DATA(head) + head->used
+            && (char*) ptr - __ARENA_BLOCK_DATA(head) + __ARENA_ALIGN(size) <= head->size)
+    {
+        head->used = (size_t) ((char*) ptr - __ARENA_BLOCK_DATA(head)) + __ARENA_ALIGN(size);
+        return ptr;
+    }
 
-static void __delete_object_unsigned_byte(struct __object_unsigned_byte_impl* object)
-{ free(object); }
+    // Otherwise, copy into a fresh allocation and abandon the old one
+    void* new_ptr = __arena_alloc(arena, size);
+    if (new_ptr != NULL && ptr != NULL)
+    {
+        memcpy(new_ptr, ptr, old_size < size ? old_size : size);
+    }
 
-static int __hash_object_unsigned_byte(struct __object_unsigned_byte_impl* object)
-{ return object->value; }
+    return new_ptr;
+}
 
 /**
- * Implementation of a signed integer object (type ID 3).
+ * Internal. Allocate zeroed container storage, either from an arena (if not NULL) or from the heap.
  */
-struct __object_signed_integer_impl
+static void* __storage_calloc(struct __arena* arena, size_t count, size_t size)
+{ return arena != NULL ? __arena_calloc(arena, count, size) : calloc(count, size); }
+
+/**
+ * Internal. Reallocate container storage, either from an arena (if not NULL) or from the heap.
+ */
+static void* __storage_realloc(struct __arena* arena, void* ptr, size_t old_size, size_t size)
+{ return arena != NULL ? __arena_realloc(arena, ptr, old_size, size) : realloc(ptr, size); }
+
+/**
+ * Internal. Free container storage. Storage belonging to an arena is released along with the arena.
+ */
+static void __storage_free(struct __arena* arena, void* ptr)
 {
-    struct __object_impl base;
-    dbof_signed_integer value;
-};
+    if (arena == NULL)
+    {
+        free(ptr);
+    }
+}
 
-static struct __object_signed_integer_impl* __new_object_signed_integer()
-{ return __new_empty_object(DBOF_TYPE_SIGNED_INTEGER, sizeof(struct __object_signed_integer_impl)); }
+/**
+ * The object itself lives in an arena and must not be freed.
+ */
+#define __OBJECT_FLAG_ARENA 0x01
 
-static void __delete_object_signed_integer(struct __object_signed_integer_impl* object)
-{ free(object); }
+/**
+ * The object's out-of-line storage (string bytes or packed array elements) is not owned by the object and must not be
+ * freed or written to.
+ */
+#define __OBJECT_FLAG_BORROWED 0x02
 
-static int __hash_object_signed_integer(struct __object_signed_integer_impl* object)
-{ return object->value; }
+/**
+ * The object's string bytes are not null-terminated (they point into a buffer being read).
+ */
+#define __OBJECT_FLAG_UNTERMINATED 0x04
 
 /**
- * Implementation an unsigned integer object (type ID 4).
+ * The object is a view of an element of a packed typed array and is owned by that array.
  */
-struct __object_unsigned_integer_impl
-{
-    struct __object_impl base;
-    dbof_unsigned_integer value;
-};
+#define __OBJECT_FLAG_VIEW 0x08
 
-static struct __object_unsigned_integer_impl* __new_object_unsigned_integer()
-{ return __new_empty_object(DBOF_TYPE_UNSIGNED_INTEGER, sizeof(struct __object_unsigned_integer_impl)); }
+/**
+ * The object's cached hash code is valid.
+ */
+#define __OBJECT_FLAG_HASHED 0x10
 
-static void __delete_object_unsigned_integer(struct __object_unsigned_integer_impl* object)
-{ free(object); }
+/**
+ * The object and everything below it are immutable and may be shared (see dbof_freeze()).
+ */
+#define __OBJECT_FLAG_FROZEN 0x20
 
-static int __hash_object_unsigned_integer(struct __object_unsigned_integer_impl* object)
-{ return object->value; }
+//
+// NOTICE
+// With DBOF_TAGGED_VALUES defined (on 64-bit hosts only), small immutable values are not allocated at all. Their type
+// and value are packed into the object handle itself, which is told apart from a real pointer by its low bit (object
+// memory is always at least 2-byte aligned). The layout is: bit 0 set, bits 1-5 the type, bits 32-63 the value. Null,
+// byte, integer, Boolean, single float and character objects qualify. Such immediate values are created by the
+// dbof_new_*() value constructors, by readers that ask for them (see the immediate_values field of dbof_reader), and
+// for values taken out of packed containers. Deleting them is a no-op, and they cannot be changed in place. Objects
+// from dbof_new() are always allocated, so they stay mutable.
+//
 
+#if defined(DBOF_TAGGED_VALUES) && UINTPTR_MAX > 0xffffffffu
+#define __TAGGED_VALUES
+#endif
+
+#ifdef __TAGGED_VALUES
 /**
- * Implementation of a signed long integer object (type ID 5).
+ * Determine if an object handle is an immediate value.
  */
-struct __object_signed_long_integer_impl
-{
-    struct __object_impl base;
-    dbof_signed_long_integer value;
-};
+#define __IS_TAGGED(object) ((uintptr_t) (object) & 1)
+#else
+#define __IS_TAGGED(object) 0
+#endif
 
-static struct __object_signed_long_integer_impl* __new_object_signed_long_integer()
-{ return __new_empty_object(DBOF_TYPE_SIGNED_LONG_INTEGER, sizeof(struct __object_signed_long_integer_impl)); }
+/**
+ * Get the type of an immediate value.
+ */
+#define __TAGGED_TYPE(object) ((dbof_type) (((uintptr_t) (object) >> 1) & 0x1f))
 
-static void __delete_object_signed_long_integer(struct __object_signed_long_integer_impl* object)
-{ free(object); }
+/**
+ * Get the 32-bit payload of an immediate value.
+ */
+#define __TAGGED_PAYLOAD(object) ((uint32_t) ((uint64_t) (uintptr_t) (object) >> 32))
 
-static int __hash_object_signed_long_integer(struct __object_signed_long_integer_impl* object)
-{
-    // Return the lower half XOR'd with the upper half of its unsigned self
-    dbof_unsigned_long_integer un = (dbof_unsigned_long_integer) object->value;
-    return (int) (un ^ (un >> (sizeof(dbof_unsigned_long_integer) * 8 / 2)));
-}
+/**
+ * Make an immediate value from a type and a 32-bit payload.
+ */
+#define __TAG(type, payload) ((dbof_object) (uintptr_t) (((uint64_t) (payload) << 32) | ((uint64_t) (type) << 1) | 1))
 
 /**
- * Implementation of an unsigned long integer object (type ID 6).
+ * Common base header for every in-memory DBOF object.
  */
-struct __object_unsigned_long_integer_impl
+struct __object_impl
 {
-    struct __object_impl base;
-    dbof_unsigned_long_integer value;
+    /**
+     * The derived object type.
+     */
+    dbof_type type;
+
+    /**
+     * Storage flags (see __OBJECT_FLAG_*).
+     */
+    unsigned char flags;
+
+    /**
+     * The number of references to the object beyond the first (see dbof_retain()). Only accessed atomically.
+     */
+    uint32_t refs;
+
+    /**
+     * The container holding this object, or NULL if there is none. Only kept for mutable objects (see
+     * __container_adopt()).
+     */
+    dbof_object parent;
 };
 
-static struct __object_unsigned_long_integer_impl* __new_object_unsigned_long_integer()
-{ return __new_empty_object(DBOF_TYPE_UNSIGNED_LONG_INTEGER, sizeof(struct __object_unsigned_long_integer_impl)); }
+//
+// NOTICE
+// Objects are owned by exactly one reference until dbof_retain() is called on them. The reference count only counts
+// the references beyond the first, so an object that was never retained holds zero, and releasing it (dbof_delete())
+// takes a single load instead of an atomic read-modify-write. Retained objects are usually frozen as well, which makes
+// them safe to attach to many containers and to read from many threads at once. A frozen container rejects every
+// modification, keeps its hash code cached for good, and hands out views of packed values that are frozen themselves
+// and published with compare-and-swap, so concurrent readers never write to shared memory.
+//
 
-static void __delete_object_unsigned_long_integer(struct __object_unsigned_long_integer_impl* object)
-{ free(object); }
+#ifdef _WIN32
+static void __refs_increment(uint32_t* refs)
+{ InterlockedIncrement((volatile LONG*) refs); }
 
-static int __hash_object_unsigned_long_integer(struct __object_unsigned_long_integer_impl* object)
+static uint32_t __refs_decrement(uint32_t* refs)
+{ return (uint32_t) InterlockedDecrement((volatile LONG*) refs) + 1; }
+
+static uint32_t __refs_load(uint32_t* refs)
+{ return (uint32_t) InterlockedCompareExchange((volatile LONG*) refs, 0, 0); }
+
+static void* __atomic_load_pointer(void** slot)
+{ return InterlockedCompareExchangePointer(slot, NULL, NULL); }
+
+static void* __atomic_publish_pointer(void** slot, void* pointer)
 {
-    // Return the lower half of the value XOR'd with the upper half
-    return (int) (object->value ^ (object->value >> (sizeof(dbof_unsigned_long_integer) * 8 / 2)));
+    void* old = InterlockedCompareExchangePointer(slot, pointer, NULL);
+    return old == NULL ? pointer : old;
 }
+#else
+static void __refs_increment(uint32_t* refs)
+{ __atomic_fetch_add(refs, 1, __ATOMIC_RELAXED); }
 
 /**
- * Implementation of a Boolean value object (type ID 7).
+ * Internal. Drop a reference count by one. Returns the count before.
  */
-struct __object_boolean_impl
-{
-    struct __object_impl base;
-    dbof_boolean value;
-};
-
-static struct __object_boolean_impl* __new_object_boolean()
-{ return __new_empty_object(DBOF_TYPE_BOOLEAN, sizeof(struct __object_boolean_impl)); }
+static uint32_t __refs_decrement(uint32_t* refs)
+{ return __atomic_fetch_sub(refs, 1, __ATOMIC_ACQ_REL); }
 
-static void __delete_object_boolean(struct __object_boolean_impl* object)
-{ free(object); }
+static uint32_t __refs_load(uint32_t* refs)
+{ return __atomic_load_n(refs, __ATOMIC_ACQUIRE); }
 
-static int __hash_object_boolean(struct __object_boolean_impl* object)
-{ return object->value ? 1231 : 1237; } // Inspired by Java's hashing for booleans
+static void* __atomic_load_pointer(void** slot)
+{ return __atomic_load_n(slot, __ATOMIC_ACQUIRE); }
 
 /**
- * Implementation of a single-precision floating point number object (type ID 8).
+ * Internal. Store a pointer to a slot unless another thread got there first. Returns the pointer that ends up in the
+ * slot.
  */
-struct __object_single_float_impl
+static void* __atomic_publish_pointer(void** slot, void* pointer)
 {
-    struct __object_impl base;
-    dbof_single_float value;
-};
+    void* expected = NULL;
+    if (__atomic_compare_exchange_n(slot, &expected, pointer, 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+        return pointer;
 
-static struct __object_single_float_impl* __new_object_single_float()
-{ return __new_empty_object(DBOF_TYPE_SINGLE_FLOAT, sizeof(struct __object_single_float_impl)); }
+    return expected;
+}
+#endif
 
-static void __delete_object_single_float(struct __object_single_float_impl* object)
-{ free(object); }
+/**
+ * Internal. Determine if an allocated object is frozen.
+ */
+static int __is_frozen(void* object)
+{ return (((struct __object_impl*) object)->flags & __OBJECT_FLAG_FROZEN) != 0; }
 
-static int __hash_object_single_float(struct __object_single_float_impl* object)
-{
-    // We assume IEEE 754 binary32 format
-    union
-    {
-        dbof_single_float in;
-        uint32_t out;
-    } cvt = { object->value };
+/**
+ * Internal. Determine if an object may be changed in place (it is neither an immediate value nor frozen).
+ */
+static int __is_mutable(dbof_object object)
+{ return !__IS_TAGGED(object) && !__is_frozen(object); }
 
-    // Pull out the interesting parts
-    const uint32_t MASK_EXPONENT = 0x7f800000u;
-    const uint32_t MASK_MANTISSA = 0x007fffffu;
-    uint32_t exponent = cvt.out & MASK_EXPONENT;
-    uint32_t mantissa = cvt.out & MASK_MANTISSA;
+/**
+ * Internal. Determine if an object is a view into a packed array (and thus must not be consumed).
+ */
+static int __is_view(dbof_object object)
+{ return !__IS_TAGGED(object) && (((struct __object_impl*) object)->flags & __OBJECT_FLAG_VIEW); }
 
-    // By definition, NaNs have nonzero mantissas and have exponent fields full of ones
-    if (exponent == MASK_EXPONENT && mantissa != 0)
+/**
+ * Internal. Delete an object that was handed over to a container that refused it. Views are never handed over.
+ */
+static void __discard_object(dbof_object object)
+{
+    if (!__is_view(object))
     {
-        return 0x7fc00000u;
+        dbof_delete(object);
     }
-
-    return cvt.out;
 }
 
+#ifdef DBOF_POOL
+
+//
+// NOTICE
+// With DBOF_POOL defined, heap objects are recycled through free lists kept per object type instead of going back to
+// free() right away. The free lists are made of batches of __POOL_BATCH_SIZE objects. Every thread caches up to two
+// batches of each type (one being filled or drained, one spare), so allocating and deleting objects normally takes no
+// lock at all. Only whole batches move between a thread cache and the global free list, one pointer swap each. The
+// global free list is bounded by __POOL_GLOBAL_LIMIT objects per type; batches beyond that are freed. A thread's cache
+// is handed back when the thread exits (on Windows, it is simply leaked). On POSIX systems, the pool uses pthreads.
+//
+
 /**
- * Implementation of a double-precision floating point number object (type ID 9).
+ * The number of object types, each of which has its own free lists.
  */
-struct __object_double_float_impl
-{
-    struct __object_impl base;
-    dbof_double_float value;
-};
+#define __POOL_TYPES 16
 
-static struct __object_double_float_impl* __new_object_double_float()
-{ return __new_empty_object(DBOF_TYPE_DOUBLE_FLOAT, sizeof(struct __object_double_float_impl)); }
+/**
+ * The number of objects in a batch.
+ */
+#define __POOL_BATCH_SIZE 128
 
-static void __delete_object_double_float(struct __object_double_float_impl* object)
-{ free(object); }
-
-static int __hash_object_double_float(struct __object_double_float_impl* object)
-{
-    // We assume IEEE 754 binary64 format
-    union
-    {
-        dbof_double_float in;
-        uint64_t out;
-    } cvt = { object->value };
-
-    // Pull out the interesting parts
-    const uint64_t MASK_EXPONENT = 0x7ff0000000000000ul;
-    const uint64_t MASK_MANTISSA = 0x000ffffffffffffful;
-    uint64_t exponent = cvt.out & MASK_EXPONENT;
-    uint64_t mantissa = cvt.out & MASK_MANTISSA;
-
-    // By definition, NaNs have nonzero mantissas and exponent fields full of ones
-    if (exponent == MASK_EXPONENT && mantissa != 0)
-    {
-        uint64_t r = 0x7ff8000000000000ul;
-        return (int) (r ^ (r >> 32));
-    }
-
-    return (int) (cvt.out ^ (cvt.out >> 32));
-}
+/**
+ * The maximum number of objects of one type in the global free list.
+ */
+#define __POOL_GLOBAL_LIMIT 8192
 
 /**
- * Implementation of a Unicode character codepoint object (type ID 10).
+ * The size of the memory block for an object of the given size. Blocks hold at least a pool node and are rounded up to
+ * whole words, so they can be zeroed a word at a time.
  */
-struct __object_character_impl
-{
-    struct __object_impl base;
-
-    /**
-     * The character value.
-     */
-    dbof_character value;
-};
+#define __POOL_BLOCK_SIZE(size) ((size) < sizeof(struct __pool_node) ? sizeof(struct __pool_node) : ((size) + 7) & ~7)
 
-static struct __object_character_impl* __new_object_character()
-{ return __new_empty_object(DBOF_TYPE_CHARACTER, sizeof(struct __object_character_impl)); }
-
-static void __delete_object_character(struct __object_character_impl* object)
-{ free(object); }
-
-static int __hash_object_character(struct __object_character_impl* object)
-{ return object->value; }
+#ifdef _MSC_VER
+#define __POOL_THREAD_LOCAL __declspec(thread)
+#else
+#define __POOL_THREAD_LOCAL __thread
+#endif
 
 /**
- * Implementation of a UTF-8 string object (type ID 11).
+ * A free object, which is reused as a list link. Objects are never allocated smaller than this.
  */
-struct __object_utf8_string_impl
+struct __pool_node
 {
-    struct __object_impl base;
+    /**
+     * The next object in the batch.
+     */
+    struct __pool_node* next;
 
     /**
-     * The UTF-8 string value (as an array of bytes).
+     * The next batch in the global free list (only used by the first object of a batch).
      */
-    char* value;
+    struct __pool_node* next_batch;
 };
 
-static struct __object_utf8_string_impl* __new_object_utf8_string()
-{ return __new_empty_object(DBOF_TYPE_UTF8_STRING, sizeof(struct __object_utf8_string_impl)); }
-
-static void __delete_object_utf8_string(struct __object_utf8_string_impl* object)
-{
-    // Simply free the string memory
-    free((void*) object->value);
-    free(object);
-}
-
-static int __hash_object_utf8_string(struct __object_utf8_string_impl* object)
-{
-    // Maybe we'll eventually implement caching of hash codes? Will that really matter?
-    int hash = 0;
-
-    dbof_string_size i;
-    dbof_string_size length = strlen(object->value);
-    for (i = 0; i < length; ++i)
-    {
-        hash = object->value[i] + hash * 31;
-    }
-
-    return hash;
-}
-
-struct __internal_array_base
+struct __pool_cache
 {
-    struct __object_impl base;
-
     /**
-     * The allocated capacity. Do not serialize.
+     * The batch being filled or drained, and its size.
      */
-    dbof_container_size capacity;
+    struct __pool_node* current[__POOL_TYPES];
+    size_t count[__POOL_TYPES];
 
     /**
-     * The occupied size.
+     * A full batch or NULL.
      */
-    dbof_container_size size;
+    struct __pool_node* spare[__POOL_TYPES];
 
     /**
-     * The children objects.
+     * Nonzero once the cache has been registered to be handed back on thread exit.
      */
-    dbof_object* children;
+    int registered;
 };
 
-static void __internal_array_base_construct(struct __internal_array_base* array)
-{
-    // TODO: Allow user to specify initial capacity
-    dbof_container_size initial_capacity = 10;
+static __POOL_THREAD_LOCAL struct __pool_cache __pool_thread_cache;
 
-    array->capacity = initial_capacity;
-    array->size = 0;
+/**
+ * The global free lists (stacks of full batches) and their sizes in batches.
+ */
+static struct __pool_node* __pool_global[__POOL_TYPES];
+static size_t __pool_global_batches[__POOL_TYPES];
 
-    // Pre-allocate initial capacity
-    array->children = calloc(array->capacity, sizeof(dbof_object));
-}
+static dbof_pool_stats __pool_stats;
 
-static void __internal_array_base_destruct(struct __internal_array_base* array)
+#ifdef _WIN32
+static SRWLOCK __pool_lock_impl = SRWLOCK_INIT;
+
+static void __pool_lock()
+{ AcquireSRWLockExclusive(&__pool_lock_impl); }
+
+static void __pool_unlock()
+{ ReleaseSRWLockExclusive(&__pool_lock_impl); }
+#else
+static pthread_mutex_t __pool_lock_impl = PTHREAD_MUTEX_INITIALIZER;
+static pthread_once_t __pool_key_once = PTHREAD_ONCE_INIT;
+static pthread_key_t __pool_key;
+
+static void __pool_lock()
+{ pthread_mutex_lock(&__pool_lock_impl); }
+
+static void __pool_unlock()
+{ pthread_mutex_unlock(&__pool_lock_impl); }
+#endif
+
+/**
+ * Internal. Free a chain of objects.
+ */
+static void __pool_free_chain(struct __pool_node* node)
 {
-    // Delete each object individually
-    for (dbof_container_size i = 0; i < array->size; ++i)
+    while (node != NULL)
     {
-        dbof_delete(array->children[i]);
+        struct __pool_node* next = node->next;
+        free(node);
+        node = next;
     }
-
-    // Free the child array itself
-    free(array->children);
 }
 
-static dbof_container_size __internal_array_base_get_capacity(struct __internal_array_base* array)
-{ return array->capacity; }
+/**
+ * Internal. Hand a full batch of objects of a type to the global free list, or free it if the list is full.
+ */
+static void __pool_put_batch(int type, struct __pool_node* batch)
+{
+    __pool_lock();
 
-static dbof_container_size __internal_array_base_get_size(struct __internal_array_base* array)
-{ return array->size; }
+    int keep = (__pool_global_batches[type] + 1) * __POOL_BATCH_SIZE <= __POOL_GLOBAL_LIMIT;
 
-static int __internal_array_base_resize(struct __internal_array_base* array, dbof_container_size size)
-{
-    dbof_object* children = realloc(array->children, size * sizeof(dbof_object));
+    if (keep)
+    {
+        batch->next_batch = __pool_global[type];
+        __pool_global[type] = batch;
+        __pool_global_batches[type]++;
 
-    // If reallocation failed, the resize fails
-    if (children != NULL)
-        return -1;
+        __pool_stats.pooled += __POOL_BATCH_SIZE;
+        __pool_stats.spills++;
+    }
+    else
+    {
+        __pool_stats.freed += __POOL_BATCH_SIZE;
+    }
 
-    array->children = children;
-    array->capacity = size;
+    __pool_unlock();
 
-    return 0;
+    // Free outside of the lock
+    if (!keep)
+    {
+        __pool_free_chain(batch);
+    }
 }
 
-static void __internal_array_base_shrink_to_fit(struct __internal_array_base* array)
+/**
+ * Internal. Take a full batch of objects of a type from the global free list. Returns NULL if there is none.
+ */
+static struct __pool_node* __pool_get_batch(int type)
 {
-    if (array->size < array->capacity)
+    __pool_lock();
+
+    struct __pool_node* batch = __pool_global[type];
+
+    if (batch != NULL)
     {
-        __internal_array_base_resize(array, array->size);
+        __pool_global[type] = batch->next_batch;
+        __pool_global_batches[type]--;
+
+        __pool_stats.pooled -= __POOL_BATCH_SIZE;
+        __pool_stats.refills++;
     }
+
+    __pool_unlock();
+    return batch;
 }
 
-static int __internal_array_base_ensure_space(struct __internal_array_base* array)
+/**
+ * Internal. Hand a whole thread cache back. Partial batches are freed.
+ */
+static void __pool_flush(struct __pool_cache* cache)
 {
-    // If we're at capacity, double it (TODO: Let user provide algo)
-    if (array->size == array->capacity)
+    for (int type = 0; type < __POOL_TYPES; ++type)
     {
-        if (array->capacity == 0)
+        if (cache->spare[type] != NULL)
         {
-            if (__internal_array_base_resize(array, 1))
-                return -1;
+            __pool_put_batch(type, cache->spare[type]);
+            cache->spare[type] = NULL;
         }
 
-        if (__internal_array_base_resize(array, array->capacity * 2))
-            return -1;
-    }
+        if (cache->count[type] == __POOL_BATCH_SIZE)
+        {
+            __pool_put_batch(type, cache->current[type]);
+        }
+        else if (cache->current[type] != NULL)
+        {
+            __pool_lock();
+            __pool_stats.freed += cache->count[type];
+            __pool_unlock();
 
-    return 0;
-}
+            __pool_free_chain(cache->current[type]);
+        }
 
-static void __internal_array_base_maybe_downscale(struct __internal_array_base* array)
-{
-    // If we're using less than half of capacity, halve it (TODO: Let user provide algo)
-    if (array->size < array->capacity / 2)
-    {
-        __internal_array_base_resize(array, array->capacity / 2);
+        cache->current[type] = NULL;
+        cache->count[type] = 0;
     }
 }
 
-/**
- * Internal. Get the object at a specific index. Valid for <code>index</code> from <code>0</code> to
- * <code>array->size</code>, inclusive.
- */
-static dbof_object __internal_array_base_get(struct __internal_array_base* array, dbof_container_size index)
-{ return array->children[index]; }
+#ifndef _WIN32
+static void __pool_thread_exit(void* cache)
+{ __pool_flush(cache); }
+
+static void __pool_create_key()
+{ pthread_key_create(&__pool_key, __pool_thread_exit); }
+#endif
 
 /**
- * Internal. Set a specific index to the given object. Valid for <code>index</code> from <code>0</code> to
- * <code>array->size</code>, inclusive.
+ * Internal. Refill the empty current batch of a thread cache, from its spare batch, the global free list, or the heap
+ * (in that order).
  */
-static void __internal_array_base_set(struct __internal_array_base* array, dbof_container_size index,
-        dbof_object object)
-{ array->children[index] = object; }
-
-static int __internal_array_base_insert(struct __internal_array_base* array, dbof_container_size index,
-        dbof_object object)
+static void __pool_refill(struct __pool_cache* cache, int type, size_t size)
 {
-    // Restrict index to last index + 1
-    if (index > array->size)
-        return -1;
-
-    // Ensure we have enough capacity for another object or fail
-    if (__internal_array_base_ensure_space(array))
-        return -1;
-
-    // If inserting in the middle of things, move children over starting at index
-    if (index < array->size)
+#ifndef _WIN32
+    // Make sure the cache is handed back when the thread exits
+    if (!cache->registered)
     {
-        memmove(array->children + index + 1, array->children + index, (array->size - index) * sizeof(dbof_object));
+        pthread_once(&__pool_key_once, __pool_create_key);
+        pthread_setspecific(__pool_key, cache);
+        cache->registered = 1;
     }
+#endif
 
-    __internal_array_base_set(array, index, object);
-    array->size++;
+    struct __pool_node* batch = cache->spare[type];
+    cache->spare[type] = NULL;
 
-    return 0;
-}
+    if (batch == NULL)
+    {
+        batch = __pool_get_batch(type);
+    }
 
-static dbof_object __internal_array_base_remove(struct __internal_array_base* array, dbof_container_size index)
-{
-    // Restrict index to last index
-    if (index >= array->size)
-        return NULL;
+    if (batch != NULL)
+    {
+        cache->current[type] = batch;
+        cache->count[type] = __POOL_BATCH_SIZE;
+        return;
+    }
 
-    // Preserve the object
-    dbof_object object = __internal_array_base_get(array, index);
+    // Nothing to reuse, so allocate a fresh batch
+    size_t count;
+    for (count = 0; count < __POOL_BATCH_SIZE; ++count)
+    {
+        struct __pool_node* node = malloc(__POOL_BLOCK_SIZE(size));
+        if (node == NULL)
+            break;
 
-    // Move children over, covering up the old object
-    memmove(array->children + index, array->children + index + 1, (array->size - index) * sizeof(dbof_object));
-    array->size--;
+        node->next = cache->current[type];
+        cache->current[type] = node;
+    }
 
-    // Downscale capacity if needed
-    __internal_array_base_maybe_downscale(array);
+    cache->count[type] = count;
 
-    return object;
+    __pool_lock();
+    __pool_stats.allocated += count;
+    __pool_unlock();
 }
 
-static int __internal_array_base_push_back(struct __internal_array_base* array, dbof_object object)
+/**
+ * Internal. Zero a pool block. Objects are small, and a memset() of a size unknown at compile time tends to become a
+ * string instruction whose startup cost exceeds the rest of the allocation, so small blocks are cleared word by word.
+ */
+static void __pool_zero(void* block, size_t size)
 {
-    // Ensure we have enough capacity for another object or fail
-    if (__internal_array_base_ensure_space(array))
-        return -1;
+    uint64_t* words = block;
 
-    // We can bypass insertion and just set
-    __internal_array_base_set(array, array->size, object);
-    array->size++;
-
-    return 0;
+    switch (__POOL_BLOCK_SIZE(size) / 8)
+    {
+    case 8:
+        words[7] = 0;
+        /* fall through */
+    case 7:
+        words[6] = 0;
+        /* fall through */
+    case 6:
+        words[5] = 0;
+        /* fall through */
+    case 5:
+        words[4] = 0;
+        /* fall through */
+    case 4:
+        words[3] = 0;
+        /* fall through */
+    case 3:
+        words[2] = 0;
+        /* fall through */
+    case 2:
+        words[1] = 0;
+        words[0] = 0;
+        break;
+    default:
+        memset(block, 0, size);
+        break;
+    }
 }
 
-static dbof_object __internal_array_base_pop_back(struct __internal_array_base* array)
+/**
+ * Internal. Allocate a zeroed heap object of a type.
+ */
+static void* __pool_alloc(dbof_type type, size_t size)
 {
-    // Remove the last object
-    dbof_object object = __internal_array_base_remove(array, array->size - 1);
+    struct __pool_cache* cache = &__pool_thread_cache;
 
-    // Downscale capacity if needed
-    __internal_array_base_maybe_downscale(array);
+    if (cache->count[type] == 0)
+    {
+        __pool_refill(cache, type, size);
 
-    return object;
+        if (cache->count[type] == 0)
+        {
+            // ERROR: Out of memory
+            return NULL;
+        }
+    }
+
+    struct __pool_node* node = cache->current[type];
+    cache->current[type] = node->next;
+    cache->count[type]--;
+
+    __pool_zero(node, size);
+    return node;
 }
 
 /**
- * Implementation of a typed array object (type ID 128).
+ * Internal. Release a heap object.
  */
-struct __object_typed_array_impl
+static void __pool_free(void* object)
 {
-    struct __internal_array_base base;
-
-    /**
-     * The type for all children of the array.
-     */
-    dbof_type type;
-};
+    struct __pool_cache* cache = &__pool_thread_cache;
+    int type = ((struct __object_impl*) object)->type;
 
-static void __object_typed_array_impl_construct(struct __object_typed_array_impl* array)
-{ __internal_array_base_construct((struct __internal_array_base*) array); }
+    // Once the current batch is full, it becomes the spare, and the old spare goes to the global free list
+    if (cache->count[type] == __POOL_BATCH_SIZE)
+    {
+        if (cache->spare[type] != NULL)
+        {
+            __pool_put_batch(type, cache->spare[type]);
+        }
 
-static void __object_typed_array_impl_destruct(struct __object_typed_array_impl* array)
-{ __internal_array_base_destruct((struct __internal_array_base*) array); }
+        cache->spare[type] = cache->current[type];
+        cache->current[type] = NULL;
+        cache->count[type] = 0;
+    }
 
-static dbof_container_size __object_typed_array_impl_get_capacity(struct __object_typed_array_impl* array)
-{ return __internal_array_base_get_capacity((struct __internal_array_base*) array); }
+    struct __pool_node* node = object;
+    node->next = cache->current[type];
+    cache->current[type] = node;
+    cache->count[type]++;
+}
 
-static dbof_container_size __object_typed_array_impl_get_size(struct __object_typed_array_impl* array)
-{ return __internal_array_base_get_size((struct __internal_array_base*) array); }
+#else
 
-static void __object_typed_array_impl_resize(struct __object_typed_array_impl* array, dbof_container_size size)
-{ __internal_array_base_resize((struct __internal_array_base*) array, size); }
+static void* __pool_alloc(dbof_type type, size_t size)
+{
+    (void) type;
+    return calloc(1, size);
+}
 
-static int __object_typed_array_impl_is_empty(struct __object_typed_array_impl* array)
-{ return __object_typed_array_impl_get_size(array) == 0; }
+static void __pool_free(void* object)
+{ free(object); }
 
-static dbof_type __object_typed_array_impl_get_type(struct __object_typed_array_impl* array)
-{ return array->type; }
+#endif
 
-static void __object_typed_array_impl_set_type(struct __object_typed_array_impl* array, dbof_type type)
+static void* __new_empty_object(dbof_type type, size_t size, struct __arena* arena)
 {
-    // Only change the type if the array is empty
-    if (__object_typed_array_impl_is_empty(array))
+    struct __object_impl* object = arena != NULL ? __arena_calloc(arena, 1, size) : __pool_alloc(type, size);
+
+    if (object == NULL)
     {
-        array->type = type;
+        // ERROR: Out of memory
+        return NULL;
     }
-}
 
-static void __object_typed_array_impl_shrink_to_fit(struct __object_typed_array_impl* array)
-{ __internal_array_base_shrink_to_fit((struct __internal_array_base*) array); }
-
-static dbof_object __object_typed_array_impl_get(struct __object_typed_array_impl* array, dbof_container_size index)
-{ return __internal_array_base_get((struct __internal_array_base*) array, index); }
+    object->type = type;
+    object->flags = arena != NULL ? __OBJECT_FLAG_ARENA : 0;
+    object->refs = 0;
+    object->parent = NULL;
+    return object;
+}
 
-static void __object_typed_array_impl_set(struct __object_typed_array_impl* array, dbof_container_size index,
-        dbof_object object)
+static void __delete_empty_object(void* object)
 {
-    // Only valid for nonempty arrays, so always enforce matching types
-    if (dbof_typeof(object) == array->type)
+    // Arena objects are released along with their arena
+    if (!(((struct __object_impl*) object)->flags & __OBJECT_FLAG_ARENA))
     {
-        __internal_array_base_set((struct __internal_array_base*) array, index, object);
+        __pool_free(object);
     }
 }
 
-void __object_typed_array_impl_insert(struct __object_typed_array_impl* array, dbof_container_size index,
-        dbof_object object)
-{ __internal_array_base_insert((struct __internal_array_base*) array, index, object); }
+/**
+ * Implementation of a null object (type ID 0).
+ */
+struct __object_null_impl
+{
+    struct __object_impl base;
+};
 
-dbof_object __object_typed_array_impl_remove(struct __object_typed_array_impl* array, dbof_container_size index)
-{ return __internal_array_base_remove((struct __internal_array_base*) array, index); }
+static struct __object_null_impl* __new_object_null(struct __arena* arena)
+{ return __new_empty_object(DBOF_TYPE_NULL, sizeof(struct __object_null_impl), arena); }
 
-static void __object_typed_array_impl_push_back(struct __object_typed_array_impl* array, dbof_object object)
+static void __delete_object_null(struct __object_null_impl* object)
+{ __delete_empty_object(object); }
+
+static int __hash_object_null(struct __object_null_impl* object)
 {
-    dbof_type type = dbof_typeof(object);
+    (void) object;
+    return 0;
+}
 
-    // First child sets the type
-    if (__object_typed_array_impl_is_empty(array))
-    {
-        array->type = type;
-    }
-
-    // Subsequent children must match the type
-    if (type == array->type)
-    {
-        __internal_array_base_push_back((struct __internal_array_base*) array, object);
-    }
-}
-
-static dbof_object __object_typed_array_impl_pop_back(struct __object_typed_array_impl* array)
-{ return __internal_array_base_pop_back((struct __internal_array_base*) array); }
-
-static struct __object_typed_array_impl* __new_object_typed_array()
+static int __equals_object_null(struct __object_null_impl* a, struct __object_null_impl* b)
 {
-    struct __object_typed_array_impl* array = __new_empty_object(DBOF_TYPE_TYPED_ARRAY,
-            sizeof(struct __object_typed_array_impl));
-    __object_typed_array_impl_construct(array);
-    return array;
+    // All null objects are alike
+    (void) a;
+    (void) b;
+    return 1;
 }
 
-static void __delete_object_typed_array(struct __object_typed_array_impl* array)
+/**
+ * Implementation of a signed byte object (type ID 1).
+ */
+struct __object_signed_byte_impl
 {
-    __object_typed_array_impl_destruct(array);
-    free(array);
-}
+    struct __object_impl base;
+    dbof_signed_byte value;
+};
 
-static int __hash_object_typed_array(struct __object_typed_array_impl* array)
-{ return 0; } // TODO
+static struct __object_signed_byte_impl* __new_object_signed_byte(struct __arena* arena)
+{ return __new_empty_object(DBOF_TYPE_SIGNED_BYTE, sizeof(struct __object_signed_byte_impl), arena); }
+
+static void __delete_object_signed_byte(struct __object_signed_byte_impl* object)
+{ __delete_empty_object(object); }
+
+static int __hash_object_signed_byte(struct __object_signed_byte_impl* object)
+{ return object->value; }
+
+static int __equals_object_signed_byte(struct __object_signed_byte_impl* a, struct __object_signed_byte_impl* b)
+{ return a->value == b->value; }
 
 /**
- * Implementation of an untyped array object (type ID 129).
+ * Implementation of an unsigned byte object (type ID 2).
  */
-struct __object_untyped_array_impl
+struct __object_unsigned_byte_impl
 {
-    struct __internal_array_base base;
+    struct __object_impl base;
+    dbof_unsigned_byte value;
 };
 
-static void __object_untyped_array_impl_construct(struct __object_untyped_array_impl* array)
-{ __internal_array_base_construct((struct __internal_array_base*) array); }
+static struct __object_unsigned_byte_impl* __new_object_unsigned_byte(struct __arena* arena)
+{ return __new_empty_object(DBOF_TYPE_UNSIGNED_BYTE, sizeof(struct __object_unsigned_byte_impl), arena); }
 
-static void __object_untyped_array_impl_destruct(struct __object_untyped_array_impl* array)
-{ __internal_array_base_destruct((struct __internal_array_base*) array); }
+static void __delete_object_unsigned_byte(struct __object_unsigned_byte_impl* object)
+{ __delete_empty_object(object); }
 
-static dbof_container_size __object_untyped_array_impl_get_capacity(struct __object_untyped_array_impl* array)
-{ return __internal_array_base_get_capacity((struct __internal_array_base*) array); }
+static int __hash_object_unsigned_byte(struct __object_unsigned_byte_impl* object)
+{ return object->value; }
 
-static dbof_container_size __object_untyped_array_impl_get_size(struct __object_untyped_array_impl* array)
-{ return __internal_array_base_get_size((struct __internal_array_base*) array); }
+static int __equals_object_unsigned_byte(struct __object_unsigned_byte_impl* a, struct __object_unsigned_byte_impl* b)
+{ return a->value == b->value; }
 
-static void __object_untyped_array_impl_resize(struct __object_untyped_array_impl* array, dbof_container_size size)
-{ __internal_array_base_resize((struct __internal_array_base*) array, size); }
+/**
+ * Implementation of a signed integer object (type ID 3).
+ */
+struct __object_signed_integer_impl
+{
+    struct __object_impl base;
+    dbof_signed_integer value;
+};
 
-static int __object_untyped_array_impl_is_empty(struct __object_untyped_array_impl* array)
-{ return __object_untyped_array_impl_get_size(array) == 0; }
+static struct __object_signed_integer_impl* __new_object_signed_integer(struct __arena* arena)
+{ return __new_empty_object(DBOF_TYPE_SIGNED_INTEGER, sizeof(struct __object_signed_integer_impl), arena); }
 
-static void __object_untyped_array_impl_shrink_to_fit(struct __object_untyped_array_impl* array)
-{ __internal_array_base_shrink_to_fit((struct __internal_array_base*) array); }
+static void __delete_object_signed_integer(struct __object_signed_integer_impl* object)
+{ __delete_empty_object(object); }
 
-static dbof_object __object_untyped_array_impl_get(struct __object_untyped_array_impl* array, dbof_container_size index)
-{ return __internal_array_base_get((struct __internal_array_base*) array, index); }
+static int __hash_object_signed_integer(struct __object_signed_integer_impl* object)
+{ return object->value; }
 
-static void __object_untyped_array_impl_set(struct __object_untyped_array_impl* array, dbof_container_size index,
-        dbof_object object)
-{ __internal_array_base_set((struct __internal_array_base*) array, index, object); }
+static int __equals_object_signed_integer(struct __object_signed_integer_impl* a,
+        struct __object_signed_integer_impl* b)
+{ return a->value == b->value; }
 
-void __object_untyped_array_impl_insert(struct __object_untyped_array_impl* array, dbof_container_size index,
-        dbof_object object)
-{ __internal_array_base_insert((struct __internal_array_base*) array, index, object); }
+/**
+ * Implementation an unsigned integer object (type ID 4).
+ */
+struct __object_unsigned_integer_impl
+{
+    struct __object_impl base;
+    dbof_unsigned_integer value;
+};
 
-dbof_object __object_untyped_array_impl_remove(struct __object_untyped_array_impl* array, dbof_container_size index)
-{ return __internal_array_base_remove((struct __internal_array_base*) array, index); }
+static struct __object_unsigned_integer_impl* __new_object_unsigned_integer(struct __arena* arena)
+{ return __new_empty_object(DBOF_TYPE_UNSIGNED_INTEGER, sizeof(struct __object_unsigned_integer_impl), arena); }
 
-static void __object_untyped_array_impl_push_back(struct __object_untyped_array_impl* array, dbof_object object)
-{ __internal_array_base_push_back((struct __internal_array_base*) array, object); }
+static void __delete_object_unsigned_integer(struct __object_unsigned_integer_impl* object)
+{ __delete_empty_object(object); }
 
-static dbof_object __object_untyped_array_impl_pop_back(struct __object_untyped_array_impl* array)
-{ return __internal_array_base_pop_back((struct __internal_array_base*) array); }
+static int __hash_object_unsigned_integer(struct __object_unsigned_integer_impl* object)
+{ return object->value; }
+
+static int __equals_object_unsigned_integer(struct __object_unsigned_integer_impl* a,
+        struct __object_unsigned_integer_impl* b)
+{ return a->value == b->value; }
 
-static struct __object_untyped_array_impl* __new_object_untyped_array()
+/**
+ * Implementation of a signed long integer object (type ID 5).
+ */
+struct __object_signed_long_integer_impl
 {
-    struct __object_untyped_array_impl* array = __new_empty_object(DBOF_TYPE_UNTYPED_ARRAY,
-            sizeof(struct __object_untyped_array_impl));
-    __object_untyped_array_impl_construct(array);
-    return array;
-}
+    struct __object_impl base;
+    dbof_signed_long_integer value;
+};
 
-static void __delete_object_untyped_array(struct __object_untyped_array_impl* array)
+static struct __object_signed_long_integer_impl* __new_object_signed_long_integer(struct __arena* arena)
+{ return __new_empty_object(DBOF_TYPE_SIGNED_LONG_INTEGER, sizeof(struct __object_signed_long_integer_impl), arena); }
+
+static void __delete_object_signed_long_integer(struct __object_signed_long_integer_impl* object)
+{ __delete_empty_object(object); }
+
+static int __hash_object_signed_long_integer(struct __object_signed_long_integer_impl* object)
 {
-    __object_untyped_array_impl_destruct(array);
-    free(array);
+    // Return the lower half XOR'd with the upper half of its unsigned self
+    dbof_unsigned_long_integer un = (dbof_unsigned_long_integer) object->value;
+    return (int) (un ^ (un >> (sizeof(dbof_unsigned_long_integer) * 8 / 2)));
 }
 
-static int __hash_object_untyped_array(struct __object_untyped_array_impl* array)
-{ return 0; } // TODO
+static int __equals_object_signed_long_integer(struct __object_signed_long_integer_impl* a,
+        struct __object_signed_long_integer_impl* b)
+{ return a->value == b->value; }
 
-//
-// NOTICE
-// This map implementation uses a naive chaining hash table. An array of doubly-linked lists (chains) is allocated on
-// construction. These chains are composed of map nodes. Each map node can hold a pointer to a map entry (a key-value
-// pair) or NULL if it does not. Key hashing is used (of course) to place new entries into the table in a deterministic
-// manner, and hash collisions are resolved by a linear search through the chain in question.
-//
+/**
+ * Implementation of an unsigned long integer object (type ID 6).
+ */
+struct __object_unsigned_long_integer_impl
+{
+    struct __object_impl base;
+    dbof_unsigned_long_integer value;
+};
 
-struct __map_node
+static struct __object_unsigned_long_integer_impl* __new_object_unsigned_long_integer(struct __arena* arena)
 {
-    /**
-     * The key object, if applicable.
-     *
-     * NULL if this node does not carry an entry.
-     */
-    dbof_object entry_key;
+    return __new_empty_object(DBOF_TYPE_UNSIGNED_LONG_INTEGER, sizeof(struct __object_unsigned_long_integer_impl),
+            arena);
+}
 
-    /**
-     * The value object, if applicable.
-     *
-     * Undefined if this node does not carry an entry.
-     */
-    dbof_object entry_value;
+static void __delete_object_unsigned_long_integer(struct __object_unsigned_long_integer_impl* object)
+{ __delete_empty_object(object); }
 
-    /**
-     * The previous node in this chain.
-     *
-     * NULL if this node is first and/or the only in the chain.
-     */
-    struct __map_node* chain_prev;
+static int __hash_object_unsigned_long_integer(struct __object_unsigned_long_integer_impl* object)
+{
+    // Return the lower half of the value XOR'd with the upper half
+    return (int) (object->value ^ (object->value >> (sizeof(dbof_unsigned_long_integer) * 8 / 2)));
+}
 
-    /**
-     * The next node in this chain.
-     *
-     * NULL if this node is last and/or the only in the chain.
-     */
-    struct __map_node* chain_next;
-};
+static int __equals_object_unsigned_long_integer(struct __object_unsigned_long_integer_impl* a,
+        struct __object_unsigned_long_integer_impl* b)
+{ return a->value == b->value; }
 
-struct __internal_map_base
+/**
+ * Implementation of a Boolean value object (type ID 7).
+ */
+struct __object_boolean_impl
 {
     struct __object_impl base;
+    dbof_boolean value;
+};
 
-    /**
-     * The number of chains in the map.
-     */
-    dbof_container_size capacity;
+static struct __object_boolean_impl* __new_object_boolean(struct __arena* arena)
+{ return __new_empty_object(DBOF_TYPE_BOOLEAN, sizeof(struct __object_boolean_impl), arena); }
 
-    /**
-     * The total number of entries in the map.
-     */
-    dbof_container_size size;
+static void __delete_object_boolean(struct __object_boolean_impl* object)
+{ __delete_empty_object(object); }
 
-    /**
-     * The heads of the chains in the hash table.
-     */
-    struct __map_node** table_heads;
+static int __hash_object_boolean(struct __object_boolean_impl* object)
+{ return object->value ? 1231 : 1237; } // Inspired by Java's hashing for booleans
 
-    /**
-     * The tails of the chains in the hash table.
-     */
-    struct __map_node** table_tails;
-};
+static int __equals_object_boolean(struct __object_boolean_impl* a, struct __object_boolean_impl* b)
+{ return a->value == b->value; }
 
-static void __internal_map_base_construct(struct __internal_map_base* map)
+/**
+ * Implementation of a single-precision floating point number object (type ID 8).
+ */
+struct __object_single_float_impl
 {
-    // TODO: Allow user to specify the initial capacity
-    dbof_container_size initial_capacity = 16;
+    struct __object_impl base;
+    dbof_single_float value;
+};
 
-    map->capacity = initial_capacity;
-    map->size = 0;
+static struct __object_single_float_impl* __new_object_single_float(struct __arena* arena)
+{ return __new_empty_object(DBOF_TYPE_SINGLE_FLOAT, sizeof(struct __object_single_float_impl), arena); }
 
-    // Allocate array of chain head pointers (each NULL by default)
-    // We'll allocate more nodes as needed
-    map->table_heads = calloc(map->capacity, sizeof(struct __map_node*));
-    map->table_tails = map->table_heads;
-    for (dbof_container_size i = 0; i < map->capacity; ++i)
-    {
-        map->table_heads[i] = calloc(1, sizeof(struct __map_node));
-    }
-}
+static void __delete_object_single_float(struct __object_single_float_impl* object)
+{ __delete_empty_object(object); }
 
-static void __internal_map_base_destruct(struct __internal_map_base* map)
+static int __hash_object_single_float(struct __object_single_float_impl* object)
 {
-    // Iterate over chains and delete every node
-    struct __map_node* current;
-    struct __map_node* next;
-    for (dbof_container_size i = 0; i < map->capacity; ++i)
+    // We assume IEEE 754 binary32 format
+    union
     {
-        current = map->table_heads[i];
-        do
-        {
-            next = current->chain_next;
+        dbof_single_float in;
+        uint32_t out;
+    } cvt = { object->value };
 
-            // If node has an entry, delete key and value objects
-            // Here we rely on dbof_delete(NULL) being sane
-            if (current->entry_key != NULL)
-            {
-                dbof_delete(current->entry_key);
-                dbof_delete(current->entry_value);
-                current->entry_key = NULL;
-            }
+    // Pull out the interesting parts
+    const uint32_t MASK_EXPONENT = 0x7f800000u;
+    const uint32_t MASK_MANTISSA = 0x007fffffu;
+    uint32_t exponent = cvt.out & MASK_EXPONENT;
+    uint32_t mantissa = cvt.out & MASK_MANTISSA;
 
-            // Free the node
-            free(current);
-        } while ((current = next) != NULL);
+    // By definition, NaNs have nonzero mantissas and have exponent fields full of ones
+    if (exponent == MASK_EXPONENT && mantissa != 0)
+    {
+        return 0x7fc00000u;
     }
 
-    // Free the table itself
-    free(map->table_heads);
+    return cvt.out;
 }
 
-static dbof_container_size __internal_map_base_get_capacity(struct __internal_map_base* map)
-{ return map->capacity; }
-
-static dbof_container_size __internal_map_base_get_size(struct __internal_map_base* map)
-{ return map->size; }
-
-static int __internal_map_base_is_empty(struct __internal_map_base* map)
-{ return map->size == 0; }
-
-static dbof_object __internal_map_base_get(struct __internal_map_base* map, dbof_object key)
+static int __equals_object_single_float(struct __object_single_float_impl* a, struct __object_single_float_impl* b)
 {
-    // TODO: Get from the map
+    // Compare bit patterns, so this agrees with the hash function on signed zeros and NaNs
+    return __hash_object_single_float(a) == __hash_object_single_float(b);
 }
 
-static void __internal_map_base_put(struct __internal_map_base* map, dbof_object key, dbof_object value)
+/**
+ * Implementation of a double-precision floating point number object (type ID 9).
+ */
+struct __object_double_float_impl
 {
-    // TODO: Put to the map
-}
+    struct __object_impl base;
+    dbof_double_float value;
+};
 
-static dbof_object __internal_map_base_remove(struct __internal_map_base* map, dbof_object key)
+static struct __object_double_float_impl* __new_object_double_float(struct __arena* arena)
+{ return __new_empty_object(DBOF_TYPE_DOUBLE_FLOAT, sizeof(struct __object_double_float_impl), arena); }
+
+static void __delete_object_double_float(struct __object_double_float_impl* object)
+{ __delete_empty_object(object); }
+
+static int __hash_object_double_float(struct __object_double_float_impl* object)
 {
-    // TODO: Remove from the map
+    // We assume IEEE 754 binary64 format
+    union
+    {
+        dbof_double_float in;
+        uint64_t out;
+    } cvt = { object->value };
+
+    // Pull out the interesting parts
+    const uint64_t MASK_EXPONENT = 0x7ff0000000000000ul;
+    const uint64_t MASK_MANTISSA = 0x000ffffffffffffful;
+    uint64_t exponent = cvt.out & MASK_EXPONENT;
+    uint64_t mantissa = cvt.out & MASK_MANTISSA;
+
+    // By definition, NaNs have nonzero mantissas and exponent fields full of ones
+    if (exponent == MASK_EXPONENT && mantissa != 0)
+    {
+        uint64_t r = 0x7ff8000000000000ul;
+        return (int) (r ^ (r >> 32));
+    }
+
+    return (int) (cvt.out ^ (cvt.out >> 32));
 }
 
-static int __internal_map_base_has_key(struct __internal_map_base* map, dbof_object key)
+static int __equals_object_double_float(struct __object_double_float_impl* a, struct __object_double_float_impl* b)
 {
-    // TODO: Test for key
+    // All NaNs are equal to one another, as they all hash the same
+    if (a->value != a->value && b->value != b->value)
+        return 1;
+
+    // Otherwise, compare bit patterns, so this agrees with the hash function on signed zeros
+    union
+    {
+        dbof_double_float in;
+        uint64_t out;
+    } cvt_a = { a->value }, cvt_b = { b->value };
+
+    return cvt_a.out == cvt_b.out;
 }
 
 /**
- * Implementation of a typed map object (type ID 130).
+ * Implementation of a Unicode character codepoint object (type ID 10).
  */
-struct __object_typed_map_impl
+struct __object_character_impl
 {
-    struct __internal_map_base base;
+    struct __object_impl base;
 
     /**
-     * The type for all keys in the array.
+     * The character value.
      */
-    dbof_type key_type;
+    dbof_character value;
+};
 
-    /**
-     * The type for all values in the array.
-     */
+static struct __object_character_impl* __new_object_character(struct __arena* arena)
+{ return __new_empty_object(DBOF_TYPE_CHARACTER, sizeof(struct __object_character_impl), arena); }
+
+static void __delete_object_character(struct __object_character_impl* object)
+{ __delete_empty_object(object); }
+
+static int __hash_object_character(struct __object_character_impl* object)
+{ return object->value; }
+
+static int __equals_object_character(struct __object_character_impl* a, struct __object_character_impl* b)
+{ return a->value == b->value; }
+
+/**
+ * The maximum length of a string value kept inside the string object itself.
+ */
+#define __SMALL_STRING_CAPACITY 22
+
+/**
+ * Implementation of a UTF-8 string object (type ID 11).
+ */
+struct __object_utf8_string_impl
+{
+    struct __object_impl base;
+
+    /**
+     * The UTF-8 string value (as an array of bytes). This is null-terminated unless the object carries the
+     * __OBJECT_FLAG_UNTERMINATED flag, in which case it points straight into a buffer being read. Short values point to
+     * the small buffer below.
+     */
+    char* value;
+
+    /**
+     * The length of the value in bytes, not counting any null terminator.
+     */
+    dbof_string_size length;
+
+    /**
+     * The cached hash code. Only valid while the object carries the __OBJECT_FLAG_HASHED flag.
+     */
+    int hash;
+
+    /**
+     * Inline storage for values of up to __SMALL_STRING_CAPACITY bytes (plus null terminator).
+     */
+    char small[__SMALL_STRING_CAPACITY + 1];
+};
+
+static struct __object_utf8_string_impl* __new_object_utf8_string(struct __arena* arena)
+{ return __new_empty_object(DBOF_TYPE_UTF8_STRING, sizeof(struct __object_utf8_string_impl), arena); }
+
+static void __delete_object_utf8_string(struct __object_utf8_string_impl* object)
+{
+    // Simply free the string memory (unless it is borrowed or inline)
+    if (!(object->base.flags & __OBJECT_FLAG_BORROWED) && object->value != object->small)
+    {
+        free((void*) object->value);
+    }
+
+    __delete_empty_object(object);
+}
+
+static uint64_t __rotate_left_internal(uint64_t x, int r)
+{ return (x << r) | (x >> (64 - r)); }
+
+/**
+ * Internal. Mix the bits of a 64-bit value so that each bit of input affects each bit of output (the final avalanche
+ * of MurmurHash3).
+ */
+static uint64_t __hash_mix_internal(uint64_t h)
+{
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdull;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ull;
+    h ^= h >> 33;
+
+    return h;
+}
+
+/**
+ * Internal. Hash a run of bytes eight at a time. The mixing follows MurmurHash3's 64-bit steps, so every input bit
+ * affects every output bit, and keys that differ only slightly do not end up in neighboring map slots.
+ */
+static uint64_t __hash_bytes_internal(const char* data, size_t length)
+{
+    const uint64_t c1 = 0x87c37b91114253d5ull;
+    const uint64_t c2 = 0x4cf5ad432745937full;
+
+    uint64_t h = 0x9e3779b97f4a7c15ull ^ length;
+    uint64_t k;
+
+    // Whole words first (memcpy keeps unaligned loads well-defined and compiles down to a single load)
+    for (; length >= 8; data += 8, length -= 8)
+    {
+        memcpy(&k, data, 8);
+
+        k *= c1;
+        k = __rotate_left_internal(k, 31);
+        k *= c2;
+
+        h ^= k;
+        h = __rotate_left_internal(h, 27) * 5 + 0x52dce729;
+    }
+
+    // Then whatever bytes are left over
+    if (length > 0)
+    {
+        k = 0;
+        memcpy(&k, data, length);
+
+        k *= c1;
+        k = __rotate_left_internal(k, 31);
+        k *= c2;
+
+        h ^= k;
+    }
+
+    return __hash_mix_internal(h);
+}
+
+static int __hash_object_utf8_string(struct __object_utf8_string_impl* object)
+{
+    // String keys get hashed on every map lookup, so the hash code is computed once and kept until the value changes
+    if (!(object->base.flags & __OBJECT_FLAG_HASHED))
+    {
+        object->hash = (int) (unsigned int) __hash_bytes_internal(object->value, object->length);
+        object->base.flags |= __OBJECT_FLAG_HASHED;
+    }
+
+    return object->hash;
+}
+
+static int __equals_object_utf8_string(struct __object_utf8_string_impl* a, struct __object_utf8_string_impl* b)
+{
+    if (a->value == NULL || b->value == NULL)
+        return a->value == b->value;
+
+    // Interned strings share their bytes
+    if (a->value == b->value)
+        return a->length == b->length;
+
+    if (a->length != b->length)
+        return 0;
+
+    return memcmp(a->value, b->value, a->length) == 0;
+}
+
+//
+// NOTICE
+// An intern pool keeps one copy of each distinct string value, along with its hash code. Strings read with an intern
+// pool (and those made by dbof_new_interned_utf8_string()) point to the pool's copy instead of owning their bytes, so
+// repeated values take no memory beyond their objects, never need hashing again, and compare equal by pointer. The
+// copies live in an arena owned by the pool, and they are only released along with the pool. Setting a new value on
+// an interned string moves it off the pool like any other borrowed string.
+//
+
+/**
+ * The maximum length of a string value that the reader interns. Longer values are rarely repeated.
+ */
+#define __INTERN_MAX_LENGTH 256
+
+/**
+ * The initial number of slots of an intern pool.
+ */
+#define __INTERN_INITIAL_CAPACITY 256
+
+struct __intern_entry
+{
+    /**
+     * The full hash of the value.
+     */
+    uint64_t hash;
+
+    /**
+     * The length of the value in bytes.
+     */
+    dbof_string_size length;
+
+    /**
+     * The value (null-terminated).
+     */
+    char value[];
+};
+
+struct __intern_pool
+{
+    /**
+     * The slots of the hash table (open addressing with linear probing), each NULL or an entry.
+     */
+    struct __intern_entry** slots;
+
+    /**
+     * The number of slots (a power of two).
+     */
+    size_t capacity;
+
+    /**
+     * The number of entries.
+     */
+    size_t size;
+
+    /**
+     * The arena holding the entries.
+     */
+    struct __arena* arena;
+};
+
+/**
+ * Internal. Find the slot for a value in an intern pool: either the one holding it or the empty one it belongs in.
+ */
+static struct __intern_entry** __intern_pool_find(struct __intern_pool* pool, const char* value,
+        dbof_string_size length, uint64_t hash)
+{
+    size_t mask = pool->capacity - 1;
+    size_t i = (size_t) hash & mask;
+
+    for (;; i = (i + 1) & mask)
+    {
+        struct __intern_entry* entry = pool->slots[i];
+
+        if (entry == NULL || (entry->hash == hash && entry->length == length
+                && memcmp(entry->value, value, length) == 0))
+            return &pool->slots[i];
+    }
+}
+
+static int __intern_pool_grow(struct __intern_pool* pool)
+{
+    struct __intern_entry** old_slots = pool->slots;
+    size_t old_capacity = pool->capacity;
+
+    struct __intern_entry** slots = calloc(old_capacity * 2, sizeof(struct __intern_entry*));
+    if (slots == NULL)
+        return -1;
+
+    pool->slots = slots;
+    pool->capacity = old_capacity * 2;
+
+    // Entries are all distinct, so each one just goes in the first free slot (no entry has the length passed below, so
+    // none can match)
+    for (size_t i = 0; i < old_capacity; ++i)
+    {
+        if (old_slots[i] != NULL)
+        {
+            *__intern_pool_find(pool, NULL, (dbof_string_size) -1, old_slots[i]->hash) = old_slots[i];
+        }
+    }
+
+    free(old_slots);
+    return 0;
+}
+
+/**
+ * Internal. Get the memory an intern pool takes for a new entry of a given length.
+ */
+static size_t __intern_entry_size(dbof_string_size length)
+{ return sizeof(struct __intern_entry) + length + 1; }
+
+/**
+ * Internal. Add an entry for a value to an intern pool, given the slot __intern_pool_find() found empty for it.
+ * Returns NULL if out of memory.
+ */
+static struct __intern_entry* __intern_pool_add(struct __intern_pool* pool, struct __intern_entry** slot,
+        const char* value, dbof_string_size length, uint64_t hash)
+{
+    // Keep the table at most half full, so probe sequences stay short
+    if ((pool->size + 1) * 2 > pool->capacity)
+    {
+        if (__intern_pool_grow(pool))
+            return NULL;
+
+        slot = __intern_pool_find(pool, value, length, hash);
+    }
+
+    struct __intern_entry* entry = __arena_alloc(pool->arena, __intern_entry_size(length));
+    if (entry == NULL)
+        return NULL;
+
+    entry->hash = hash;
+    entry->length = length;
+
+    if (length > 0)
+    {
+        memcpy(entry->value, value, length);
+    }
+
+    entry->value[length] = '\0';
+
+    *slot = entry;
+    pool->size++;
+
+    return entry;
+}
+
+/**
+ * Internal. Get the entry for a value from an intern pool, adding it if it is not there yet. Returns NULL if out of
+ * memory.
+ */
+static struct __intern_entry* __intern_pool_intern(struct __intern_pool* pool, const char* value,
+        dbof_string_size length)
+{
+    uint64_t hash = __hash_bytes_internal(value, length);
+
+    struct __intern_entry** slot = __intern_pool_find(pool, value, length, hash);
+    if (*slot != NULL)
+        return *slot;
+
+    return __intern_pool_add(pool, slot, value, length, hash);
+}
+
+/**
+ * Internal. Point a string object at an intern pool entry.
+ */
+static void __intern_string(struct __object_utf8_string_impl* string, struct __intern_entry* entry)
+{
+    string->value = entry->value;
+    string->length = entry->length;
+    string->hash = (int) (unsigned int) entry->hash;
+    string->base.flags |= __OBJECT_FLAG_BORROWED | __OBJECT_FLAG_HASHED;
+}
+
+//
+// NOTICE
+// Containers cache the hash code of their contents, Merkle style: hashing a container leaves its hash code, and those
+// of all containers below it, in place, and each container knows the container holding it. Any change made through the
+// container functions clears the cached hash codes of the container and of every container above it, so hashing again
+// after a small edit only redoes the path from the edit up. A container can only have a cached hash code if all of the
+// containers below it do as well, which lets the clearing stop at the first container without one. Containers with
+// views are never cached, as views can be written at any time. Value objects know their container as well, so setting
+// the value of a child in place clears the cached hash codes above it just the same.
+//
+
+/**
+ * Common base header for every in-memory container object.
+ */
+struct __container_impl
+{
+    struct __object_impl base;
+
+    /**
+     * The cached hash code of the contents. Only valid while the object carries the __OBJECT_FLAG_HASHED flag.
+     */
+    uint64_t hash;
+};
+
+/**
+ * Internal. Clear the cached hash code of a container and those of the containers above it.
+ */
+static void __container_invalidate_hash(void* object)
+{
+    struct __container_impl* container = object;
+
+    // If a container has no cached hash code, neither do the containers above it
+    while (container != NULL && (container->base.flags & __OBJECT_FLAG_HASHED))
+    {
+        container->base.flags &= ~__OBJECT_FLAG_HASHED;
+        container = container->base.parent;
+    }
+}
+
+/**
+ * Internal. Clear the cached hash codes of the containers above a value object whose value was changed in place.
+ */
+static void __value_invalidate_hash(void* object)
+{ __container_invalidate_hash(((struct __object_impl*) object)->parent); }
+
+/**
+ * Internal. Make a container the parent of a child. A NULL parent detaches the child. Frozen children may have many
+ * parents and never pass on changes, so they keep whatever parent they have.
+ */
+static void __container_adopt(void* parent, dbof_object child)
+{
+    if (child != NULL && __is_mutable(child))
+    {
+        ((struct __object_impl*) child)->parent = parent;
+    }
+}
+
+/**
+ * Internal. Give up a container's reference to a child. A child that lives on through other references (see
+ * dbof_retain()) no longer points back to the container, which may be about to go away.
+ */
+static void __container_release(void* container, dbof_object child)
+{
+    if (child != NULL && __is_mutable(child) && ((struct __object_impl*) child)->parent == container)
+    {
+        ((struct __object_impl*) child)->parent = NULL;
+    }
+
+    dbof_delete(child);
+}
+
+/**
+ * The capacity an array grows to for its first element under the default capacity policy.
+ */
+#define __ARRAY_MIN_CAPACITY 4
+
+static dbof_container_size __capacity_policy_default_grow(dbof_container_size capacity, dbof_container_size needed)
+{
+    // Doubling always covers the one more element the arrays ask for
+    (void) needed;
+    return capacity == 0 ? __ARRAY_MIN_CAPACITY : capacity * 2;
+}
+
+/**
+ * The capacity below which an array is not shrunk under the default capacity policy.
+ */
+#define __ARRAY_SHRINK_FLOOR 16
+
+//
+// NOTICE
+// The default policy halves an array once it is down to a quarter of its capacity rather than half of it. After a
+// shrink the array is at most half full, so it must double in size before it grows again, and alternating pushes and
+// pops around one size do not reallocate every time.
+//
+
+static dbof_container_size __capacity_policy_default_shrink(dbof_container_size capacity, dbof_container_size size)
+{ return capacity > __ARRAY_SHRINK_FLOOR && size <= capacity / 4 ? capacity / 2 : capacity; }
+
+/**
+ * The capacity policy all arrays follow. Both functions are always set. It is only meant to change at startup (see
+ * dbof_set_capacity_policy()), so it is read without synchronization.
+ */
+static dbof_capacity_policy __capacity_policy = {
+        __capacity_policy_default_grow,
+        __capacity_policy_default_shrink,
+};
+
+//
+// NOTICE
+// Untyped arrays keep their children in one block of element storage until they are first snapshotted. From then on,
+// the array and its snapshots keep them in a tree of chunks instead: leaves hold up to __ARRAY_CHUNK_SIZE children, and
+// the chunks above them as many chunks each, along with the number of children below every one of those. A snapshot
+// takes another reference to the root chunk, which is O(1). Chunks are shared copy-on-write: an edit copies the shared
+// chunks on the path from the root down to the touched leaf (taking another reference to whatever they point to) and
+// nothing else, so it costs O(log n), and inserting or removing in the middle only moves entries within one chunk per
+// level. Reading never copies or changes anything, so a frozen array and its snapshots can be read from many threads.
+//
+
+/**
+ * The maximum number of entries in a chunk.
+ */
+#define __ARRAY_CHUNK_SIZE 64
+
+/**
+ * The maximum height of a chunk tree. Full chunks are split in half, so no tree that fits in memory comes close.
+ */
+#define __ARRAY_CHUNK_MAX_HEIGHT 16
+
+/**
+ * A chunk of a chunk tree.
+ */
+struct __array_chunk
+{
+    /**
+     * The number of arrays and chunks sharing the chunk beyond the first. Only accessed atomically.
+     */
+    uint32_t refs;
+
+    /**
+     * The number of entries in use. Only the root may be empty.
+     */
+    unsigned int count;
+
+    /**
+     * The number of levels below the chunk, or zero if it is a leaf.
+     */
+    unsigned int height;
+
+    /**
+     * The entries: children objects (dbof_object) in leaves, chunks one level down otherwise. A leaf holds one
+     * reference to each child.
+     */
+    void* entries[__ARRAY_CHUNK_SIZE];
+
+    /**
+     * The number of children below each entry. Leaves count their children directly, so they are allocated without
+     * this.
+     */
+    dbof_container_size sizes[__ARRAY_CHUNK_SIZE];
+};
+
+/**
+ * Internal. Allocate an empty chunk. Returns NULL if out of memory.
+ */
+static struct __array_chunk* __array_chunk_new(struct __arena* arena, unsigned int height)
+{
+    struct __array_chunk* chunk = __storage_calloc(arena, 1,
+            height == 0 ? offsetof(struct __array_chunk, sizes) : sizeof(struct __array_chunk));
+
+    if (chunk != NULL)
+    {
+        chunk->height = height;
+    }
+
+    return chunk;
+}
+
+/**
+ * Internal. Count the children below a chunk.
+ */
+static dbof_container_size __array_chunk_size(struct __array_chunk* chunk)
+{
+    if (chunk->height == 0)
+        return chunk->count;
+
+    dbof_container_size size = 0;
+    for (unsigned int i = 0; i < chunk->count; ++i)
+    {
+        size += chunk->sizes[i];
+    }
+
+    return size;
+}
+
+/**
+ * Internal. Give up a reference to a chunk. The last one deletes the chunk, and with it its references to the entries.
+ */
+static void __array_chunk_release(struct __array_chunk* chunk, struct __arena* arena)
+{
+    // A count of zero means no one else shares the chunk
+    if (__refs_load(&chunk->refs) != 0 && __refs_decrement(&chunk->refs) != 0)
+        return;
+
+    for (unsigned int i = 0; i < chunk->count; ++i)
+    {
+        if (chunk->height == 0)
+        {
+            dbof_delete(chunk->entries[i]);
+        }
+        else
+        {
+            __array_chunk_release(chunk->entries[i], arena);
+        }
+    }
+
+    __storage_free(arena, chunk);
+}
+
+/**
+ * Internal. Free the chunks of a tree that was never shared, leaving the children alone.
+ */
+static void __array_chunk_free(struct __array_chunk* chunk, struct __arena* arena)
+{
+    for (unsigned int i = 0; chunk->height > 0 && i < chunk->count; ++i)
+    {
+        __array_chunk_free(chunk->entries[i], arena);
+    }
+
+    __storage_free(arena, chunk);
+}
+
+/**
+ * Internal. Make the chunk in a slot one that may be changed, replacing it with a copy if it is shared. Returns the
+ * chunk, or NULL if out of memory.
+ */
+static struct __array_chunk* __array_chunk_own(struct __array_chunk** slot, struct __arena* arena)
+{
+    struct __array_chunk* chunk = *slot;
+    if (__refs_load(&chunk->refs) == 0)
+        return chunk;
+
+    struct __array_chunk* copy = __array_chunk_new(arena, chunk->height);
+
+    // ERROR: Out of memory
+    if (copy == NULL)
+        return NULL;
+
+    copy->count = chunk->count;
+    memcpy(copy->entries, chunk->entries, chunk->count * sizeof(void*));
+
+    for (unsigned int i = 0; i < chunk->count; ++i)
+    {
+        if (chunk->height == 0)
+        {
+            dbof_retain(chunk->entries[i]);
+        }
+        else
+        {
+            __refs_increment(&((struct __array_chunk*) chunk->entries[i])->refs);
+            copy->sizes[i] = chunk->sizes[i];
+        }
+    }
+
+    // The others may have let go in the meantime, in which case this deletes the original
+    __array_chunk_release(chunk, arena);
+
+    *slot = copy;
+    return copy;
+}
+
+/**
+ * Internal. Pick the entry of a chunk (not a leaf) that an index falls under, turning the index into one below that
+ * entry. An index one past the end falls under the last entry.
+ */
+static unsigned int __array_chunk_descend(struct __array_chunk* chunk, dbof_container_size* index)
+{
+    unsigned int i = 0;
+    while (i + 1 < chunk->count && *index >= chunk->sizes[i])
+    {
+        *index -= chunk->sizes[i];
+        ++i;
+    }
+
+    return i;
+}
+
+/**
+ * Internal. Find the leaf holding the child at a specific index below a chunk, turning the index into one within the
+ * leaf.
+ */
+static struct __array_chunk* __array_chunk_find(struct __array_chunk* chunk, dbof_container_size* index)
+{
+    while (chunk->height > 0)
+    {
+        chunk = chunk->entries[__array_chunk_descend(chunk, index)];
+    }
+
+    return chunk;
+}
+
+/**
+ * Internal. Build a chunk tree holding the given children in order, with every chunk but the last of each level full.
+ * The tree takes over the references to the children, unless retain is nonzero, in which case it takes references of
+ * its own. Returns the root, or NULL if out of memory.
+ */
+static struct __array_chunk* __array_chunk_build(struct __arena* arena, dbof_object* children,
+        dbof_container_size count, int retain)
+{
+    if (count == 0)
+        return __array_chunk_new(arena, 0);
+
+    // Each level is built over the one below it, in place
+    dbof_container_size width = (count + __ARRAY_CHUNK_SIZE - 1) / __ARRAY_CHUNK_SIZE;
+    struct __array_chunk** level = malloc(width * sizeof(struct __array_chunk*));
+    if (level == NULL)
+    {
+        // ERROR: Out of memory
+        return NULL;
+    }
+
+    for (dbof_container_size i = 0; i < width; ++i)
+    {
+        struct __array_chunk* leaf = __array_chunk_new(arena, 0);
+        if (leaf == NULL)
+        {
+            // ERROR: Out of memory
+            for (dbof_container_size j = 0; j < i; ++j)
+            {
+                __array_chunk_free(level[j], arena);
+            }
+
+            free(level);
+            return NULL;
+        }
+
+        dbof_container_size left = count - i * __ARRAY_CHUNK_SIZE;
+        leaf->count = left < __ARRAY_CHUNK_SIZE ? (unsigned int) left : __ARRAY_CHUNK_SIZE;
+        memcpy(leaf->entries, children + i * __ARRAY_CHUNK_SIZE, leaf->count * sizeof(dbof_object));
+        level[i] = leaf;
+    }
+
+    for (unsigned int height = 1; width > 1; ++height)
+    {
+        dbof_container_size parents = (width + __ARRAY_CHUNK_SIZE - 1) / __ARRAY_CHUNK_SIZE;
+
+        for (dbof_container_size i = 0; i < parents; ++i)
+        {
+            struct __array_chunk* chunk = __array_chunk_new(arena, height);
+            if (chunk == NULL)
+            {
+                // ERROR: Out of memory (the parents so far took the place of the chunks they took in)
+                for (dbof_container_size j = 0; j < i; ++j)
+                {
+                    __array_chunk_free(level[j], arena);
+                }
+                for (dbof_container_size j = i * __ARRAY_CHUNK_SIZE; j < width; ++j)
+                {
+                    __array_chunk_free(level[j], arena);
+                }
+
+                free(level);
+                return NULL;
+            }
+
+            dbof_container_size left = width - i * __ARRAY_CHUNK_SIZE;
+            chunk->count = left < __ARRAY_CHUNK_SIZE ? (unsigned int) left : __ARRAY_CHUNK_SIZE;
+
+            for (unsigned int j = 0; j < chunk->count; ++j)
+            {
+                chunk->entries[j] = level[i * __ARRAY_CHUNK_SIZE + j];
+                chunk->sizes[j] = __array_chunk_size(chunk->entries[j]);
+            }
+
+            level[i] = chunk;
+        }
+
+        width = parents;
+    }
+
+    struct __array_chunk* root = level[0];
+    free(level);
+
+    for (dbof_container_size i = 0; retain && i < count; ++i)
+    {
+        dbof_retain(children[i]);
+    }
+
+    return root;
+}
+
+/**
+ * Internal. Get the slot of the child at a specific index of a chunk tree, copying the shared chunks on the way down
+ * so the slot may be written. Returns NULL if out of memory.
+ */
+static dbof_object* __array_chunk_slot(struct __array_chunk** root, struct __arena* arena, dbof_container_size index)
+{
+    struct __array_chunk** slot = root;
+
+    for (;;)
+    {
+        struct __array_chunk* chunk = __array_chunk_own(slot, arena);
+        if (chunk == NULL)
+            return NULL;
+
+        if (chunk->height == 0)
+            return (dbof_object*) &chunk->entries[index];
+
+        slot = (struct __array_chunk**) &chunk->entries[__array_chunk_descend(chunk, &index)];
+    }
+}
+
+/**
+ * Internal. Split the upper half of a full chunk off into a new chunk. Returns the new chunk, or NULL if out of
+ * memory.
+ */
+static struct __array_chunk* __array_chunk_split(struct __array_chunk* chunk, struct __arena* arena)
+{
+    struct __array_chunk* upper = __array_chunk_new(arena, chunk->height);
+    if (upper == NULL)
+        return NULL;
+
+    unsigned int half = chunk->count / 2;
+    upper->count = chunk->count - half;
+    memcpy(upper->entries, chunk->entries + half, upper->count * sizeof(void*));
+
+    if (chunk->height > 0)
+    {
+        memcpy(upper->sizes, chunk->sizes + half, upper->count * sizeof(dbof_container_size));
+    }
+
+    chunk->count = half;
+    return upper;
+}
+
+/**
+ * Internal. Insert a child into a chunk tree at a specific index, which must be at most the number of children. The
+ * shared chunks on the way down are copied, and full ones split before they are entered, so there is always room in
+ * the one above. Returns zero on success, otherwise nonzero (which leaves the children as they were).
+ */
+static int __array_chunk_insert(struct __array_chunk** root, struct __arena* arena, dbof_container_size index,
+        dbof_object object)
+{
+    struct __array_chunk* chunk = __array_chunk_own(root, arena);
+    if (chunk == NULL)
+        return -1;
+
+    // A full root gets a new one above it
+    if (chunk->count == __ARRAY_CHUNK_SIZE)
+    {
+        if (chunk->height + 1 >= __ARRAY_CHUNK_MAX_HEIGHT)
+            return -1;
+
+        struct __array_chunk* top = __array_chunk_new(arena, chunk->height + 1);
+        if (top == NULL)
+            return -1;
+
+        top->count = 1;
+        top->entries[0] = chunk;
+        top->sizes[0] = __array_chunk_size(chunk);
+        *root = chunk = top;
+    }
+
+    // The chunks on the way only count the new child once nothing can fail anymore
+    struct __array_chunk* path[__ARRAY_CHUNK_MAX_HEIGHT];
+    unsigned int positions[__ARRAY_CHUNK_MAX_HEIGHT];
+    unsigned int depth = 0;
+
+    while (chunk->height > 0)
+    {
+        unsigned int i = __array_chunk_descend(chunk, &index);
+
+        struct __array_chunk* child = __array_chunk_own((struct __array_chunk**) &chunk->entries[i], arena);
+        if (child == NULL)
+            return -1;
+
+        if (child->count == __ARRAY_CHUNK_SIZE)
+        {
+            struct __array_chunk* upper = __array_chunk_split(child, arena);
+            if (upper == NULL)
+                return -1;
+
+            memmove(&chunk->entries[i + 2], &chunk->entries[i + 1], (chunk->count - i - 1) * sizeof(void*));
+            memmove(&chunk->sizes[i + 2], &chunk->sizes[i + 1], (chunk->count - i - 1) * sizeof(dbof_container_size));
+            chunk->entries[i + 1] = upper;
+            chunk->sizes[i] = __array_chunk_size(child);
+            chunk->sizes[i + 1] = __array_chunk_size(upper);
+            chunk->count++;
+
+            if (index > chunk->sizes[i])
+            {
+                index -= chunk->sizes[i];
+                child = upper;
+                ++i;
+            }
+        }
+
+        path[depth] = chunk;
+        positions[depth++] = i;
+        chunk = child;
+    }
+
+    memmove(&chunk->entries[index + 1], &chunk->entries[index], (chunk->count - index) * sizeof(void*));
+    chunk->entries[index] = object;
+    chunk->count++;
+
+    while (depth > 0)
+    {
+        --depth;
+        path[depth]->sizes[positions[depth]]++;
+    }
+
+    return 0;
+}
+
+/**
+ * Internal. Remove the child at a specific index from a chunk tree, copying the shared chunks on the way down. The
+ * tree's reference to the child goes to out_object. Returns zero on success, otherwise nonzero (which leaves the
+ * children as they were).
+ */
+static int __array_chunk_remove(struct __array_chunk** root, struct __arena* arena, dbof_container_size index,
+        dbof_object* out_object)
+{
+    struct __array_chunk* path[__ARRAY_CHUNK_MAX_HEIGHT];
+    unsigned int positions[__ARRAY_CHUNK_MAX_HEIGHT];
+    unsigned int depth = 0;
+
+    struct __array_chunk** slot = root;
+    struct __array_chunk* chunk;
+
+    for (;;)
+    {
+        chunk = __array_chunk_own(slot, arena);
+        if (chunk == NULL)
+            return -1;
+
+        if (chunk->height == 0)
+            break;
+
+        unsigned int i = __array_chunk_descend(chunk, &index);
+        path[depth] = chunk;
+        positions[depth++] = i;
+        slot = (struct __array_chunk**) &chunk->entries[i];
+    }
+
+    *out_object = chunk->entries[index];
+    memmove(&chunk->entries[index], &chunk->entries[index + 1], (chunk->count - index - 1) * sizeof(void*));
+    chunk->count--;
+
+    // Count the child out on the way back up, dropping chunks left with no children unless they are the only entry
+    while (depth > 0)
+    {
+        struct __array_chunk* parent = path[--depth];
+        unsigned int i = positions[depth];
+        parent->sizes[i]--;
+
+        if (parent->sizes[i] == 0 && parent->count > 1)
+        {
+            __array_chunk_free(chunk, arena);
+            memmove(&parent->entries[i], &parent->entries[i + 1], (parent->count - i - 1) * sizeof(void*));
+            memmove(&parent->sizes[i], &parent->sizes[i + 1], (parent->count - i - 1) * sizeof(dbof_container_size));
+            parent->count--;
+        }
+
+        chunk = parent;
+    }
+
+    // A root left with a single entry gives way to it (the chunks on the way down are all unshared by now)
+    while ((*root)->height > 0 && (*root)->count == 1)
+    {
+        chunk = *root;
+        *root = chunk->entries[0];
+        __storage_free(arena, chunk);
+    }
+
+    return 0;
+}
+
+struct __internal_array_base
+{
+    struct __container_impl base;
+
+    /**
+     * The allocated capacity. Do not serialize.
+     */
+    dbof_container_size capacity;
+
+    /**
+     * The occupied size.
+     */
+    dbof_container_size size;
+
+    /**
+     * The size of one element in bytes.
+     */
+    size_t element_size;
+
+    /**
+     * The elements. These are children objects (dbof_object) unless the array packs primitive values.
+     */
+    char* elements;
+
+    /**
+     * The arena the element storage comes from, or NULL if it comes from the heap.
+     */
+    struct __arena* arena;
+
+    /**
+     * The root of the chunk tree holding the children of an untyped array once it is snapshotted, otherwise NULL.
+     * Mutable arrays then have no element storage. Frozen arrays keep theirs for their readers, and the tree takes
+     * references of its own for the snapshots.
+     */
+    struct __array_chunk* chunks;
+};
+
+static void __internal_array_base_construct(struct __internal_array_base* array, size_t element_size,
+        struct __arena* arena)
+{
+    array->capacity = 0;
+    array->size = 0;
+    array->element_size = element_size;
+    array->arena = arena;
+
+    // The storage is allocated on first use (or by reserving), as many arrays stay small or empty
+    array->elements = NULL;
+    array->chunks = NULL;
+}
+
+static void __internal_array_base_destruct(struct __internal_array_base* array)
+{
+    // Free the element storage itself (unless it is borrowed)
+    if (!(array->base.base.flags & __OBJECT_FLAG_BORROWED))
+    {
+        __storage_free(array->arena, array->elements);
+    }
+}
+
+/**
+ * Internal. Determine if an array keeps its children in a chunk tree rather than in its element storage.
+ */
+static int __internal_array_base_is_chunked(struct __internal_array_base* array)
+{ return array->elements == NULL && array->chunks != NULL; }
+
+/**
+ * Internal. Make sure the array owns its element storage, copying borrowed elements out. Must be called before the
+ * storage is modified. Returns zero on success, otherwise nonzero (also if the array is frozen).
+ */
+static int __internal_array_base_own(struct __internal_array_base* array)
+{
+    // ERROR: A frozen array cannot be modified
+    if (__is_frozen(array))
+        return -1;
+
+    if (!(array->base.base.flags & __OBJECT_FLAG_BORROWED))
+        return 0;
+
+    char* elements = __storage_calloc(array->arena, array->capacity, array->element_size);
+    if (elements == NULL && array->capacity > 0)
+        return -1;
+
+    memcpy(elements, array->elements, array->size * array->element_size);
+
+    array->elements = elements;
+    array->base.base.flags &= ~__OBJECT_FLAG_BORROWED;
+
+    return 0;
+}
+
+/**
+ * Internal. Delete each child of an array of objects.
+ */
+static void __internal_array_base_delete_children(struct __internal_array_base* array)
+{
+    for (dbof_container_size i = 0; i < array->size; ++i)
+    {
+        __container_release(array, ((dbof_object*) array->elements)[i]);
+    }
+}
+
+static dbof_container_size __internal_array_base_get_capacity(struct __internal_array_base* array)
+{ return array->capacity; }
+
+static dbof_container_size __internal_array_base_get_size(struct __internal_array_base* array)
+{ return array->size; }
+
+static int __internal_array_base_resize(struct __internal_array_base* array, dbof_container_size size)
+{
+    if (__internal_array_base_own(array))
+        return -1;
+
+    char* elements = __storage_realloc(array->arena, array->elements, array->capacity * array->element_size,
+            size * array->element_size);
+
+    // If reallocation failed, the resize fails
+    if (elements == NULL && size > 0)
+        return -1;
+
+    array->elements = elements;
+    array->capacity = size;
+
+    return 0;
+}
+
+/**
+ * Internal. Change the element size of an empty array, keeping its capacity.
+ */
+static int __internal_array_base_set_element_size(struct __internal_array_base* array, size_t element_size)
+{
+    if (__internal_array_base_own(array))
+        return -1;
+
+    char* elements = __storage_realloc(array->arena, array->elements, array->capacity * array->element_size,
+            array->capacity * element_size);
+
+    // If reallocation failed, the element size stays
+    if (elements == NULL && array->capacity > 0)
+        return -1;
+
+    array->elements = elements;
+    array->element_size = element_size;
+
+    return 0;
+}
+
+static void __internal_array_base_shrink_to_fit(struct __internal_array_base* array)
+{
+    if (array->size < array->capacity)
+    {
+        __internal_array_base_resize(array, array->size);
+    }
+}
+
+/**
+ * Internal. Make room for at least the given number of elements. Returns zero on success, otherwise nonzero.
+ */
+static int __internal_array_base_reserve(struct __internal_array_base* array, dbof_container_size capacity)
+{
+    if (capacity <= array->capacity)
+        return 0;
+
+    // Make sure the storage size is representable
+    if (capacity > SIZE_MAX / array->element_size)
+        return -1;
+
+    return __internal_array_base_resize(array, capacity);
+}
+
+static int __internal_array_base_ensure_space(struct __internal_array_base* array)
+{
+    // If we're at capacity, ask the policy how far to grow
+    if (array->size == array->capacity)
+    {
+        dbof_container_size capacity = __capacity_policy.grow(array->capacity, array->size + 1);
+
+        // Whatever the policy says, there must be room for one more
+        if (capacity <= array->size)
+        {
+            capacity = array->size + 1;
+        }
+
+        if (__internal_array_base_reserve(array, capacity))
+            return -1;
+    }
+
+    return 0;
+}
+
+static void __internal_array_base_maybe_downscale(struct __internal_array_base* array)
+{
+    // Let the policy decide whether to give back memory
+    dbof_container_size capacity = __capacity_policy.shrink(array->capacity, array->size);
+
+    if (capacity < array->capacity && capacity >= array->size)
+    {
+        __internal_array_base_resize(array, capacity);
+    }
+}
+
+/**
+ * Internal. Get the address of the element at a specific index. Valid for <code>index</code> from <code>0</code> to
+ * <code>array->capacity</code>, exclusive.
+ */
+static void* __internal_array_base_at(struct __internal_array_base* array, dbof_container_size index)
+{ return array->elements + index * array->element_size; }
+
+/**
+ * Internal. Open up an uninitialized element at a specific index, moving later elements over. Returns its address or
+ * NULL on failure.
+ */
+static void* __internal_array_base_insert_slot(struct __internal_array_base* array, dbof_container_size index)
+{
+    // Restrict index to last index + 1
+    if (index > array->size)
+        return NULL;
+
+    // Ensure we have enough (owned) capacity for another element or fail
+    if (__internal_array_base_own(array) || __internal_array_base_ensure_space(array))
+        return NULL;
+
+    // If inserting in the middle of things, move elements over starting at index
+    if (index < array->size)
+    {
+        memmove(__internal_array_base_at(array, index + 1), __internal_array_base_at(array, index),
+                (array->size - index) * array->element_size);
+    }
+
+    array->size++;
+    __container_invalidate_hash(array);
+
+    return __internal_array_base_at(array, index);
+}
+
+/**
+ * Internal. Close up the element at a specific index, moving later elements over. The element must have been dealt
+ * with beforehand. Returns zero on success, otherwise nonzero.
+ */
+static int __internal_array_base_remove_slot(struct __internal_array_base* array, dbof_container_size index)
+{
+    if (__internal_array_base_own(array))
+        return -1;
+
+    // Move elements over, covering up the old one
+    memmove(__internal_array_base_at(array, index), __internal_array_base_at(array, index + 1),
+            (array->size - index - 1) * array->element_size);
+    array->size--;
+    __container_invalidate_hash(array);
+
+    // Downscale capacity if needed
+    __internal_array_base_maybe_downscale(array);
+
+    return 0;
+}
+
+/**
+ * Internal. Get the object at a specific index. Valid for <code>index</code> from <code>0</code> to
+ * <code>array->size</code>, inclusive.
+ */
+static dbof_object __internal_array_base_get(struct __internal_array_base* array, dbof_container_size index)
+{
+    if (__internal_array_base_is_chunked(array))
+    {
+        struct __array_chunk* leaf = __array_chunk_find(array->chunks, &index);
+        return leaf->entries[index];
+    }
+
+    return ((dbof_object*) array->elements)[index];
+}
+
+/**
+ * Internal. Set a specific index to the given object. Valid for <code>index</code> from <code>0</code> to
+ * <code>array->size</code>, inclusive. The array takes ownership of the object, even on failure.
+ */
+static void __internal_array_base_set(struct __internal_array_base* array, dbof_container_size index,
+        dbof_object object)
+{
+    if (__internal_array_base_own(array))
+    {
+        __discard_object(object);
+        return;
+    }
+
+    // The old object no longer belongs to us
+    if (index < array->size)
+    {
+        __container_adopt(NULL, ((dbof_object*) array->elements)[index]);
+    }
+
+    ((dbof_object*) array->elements)[index] = object;
+    __container_adopt(array, object);
+    __container_invalidate_hash(array);
+}
+
+/**
+ * Internal. Insert an object at a specific index. The array takes ownership of the object, even on failure.
+ */
+static int __internal_array_base_insert(struct __internal_array_base* array, dbof_container_size index,
+        dbof_object object)
+{
+    dbof_object* slot = __internal_array_base_insert_slot(array, index);
+    if (slot == NULL)
+    {
+        __discard_object(object);
+        return -1;
+    }
+
+    *slot = object;
+    __container_adopt(array, object);
+
+    return 0;
+}
+
+static dbof_object __internal_array_base_remove(struct __internal_array_base* array, dbof_container_size index)
+{
+    // Restrict index to last index
+    if (index >= array->size)
+        return NULL;
+
+    // Preserve the object
+    dbof_object object = __internal_array_base_get(array, index);
+
+    if (__internal_array_base_remove_slot(array, index))
+        return NULL;
+
+    __container_adopt(NULL, object);
+
+    return object;
+}
+
+//
+// NOTICE
+// Typed arrays of primitive types (byte through double, plus character) pack their values contiguously instead of
+// keeping an object per element. The typed accessors work on the packed values directly. For the object-based
+// functions, dbof_typed_array_get() hands out a view: an object owned by the array that mirrors one element. Views
+// are created on demand and cached per element, and their values are copied back into the array before the packed
+// values are used. A view moves along with its element, is handed over to the caller when its element is removed, and
+// is otherwise deleted only along with the array.
+//
+
+/**
+ * Internal. Get the packed size of values of the given type, or zero if values of the type are not packed.
+ */
+static size_t __packed_size_of(dbof_type type)
+{
+    switch (type)
+    {
+    case DBOF_TYPE_SIGNED_BYTE:
+        return sizeof(dbof_signed_byte);
+    case DBOF_TYPE_UNSIGNED_BYTE:
+        return sizeof(dbof_unsigned_byte);
+    case DBOF_TYPE_SIGNED_INTEGER:
+        return sizeof(dbof_signed_integer);
+    case DBOF_TYPE_UNSIGNED_INTEGER:
+        return sizeof(dbof_unsigned_integer);
+    case DBOF_TYPE_SIGNED_LONG_INTEGER:
+        return sizeof(dbof_signed_long_integer);
+    case DBOF_TYPE_UNSIGNED_LONG_INTEGER:
+        return sizeof(dbof_unsigned_long_integer);
+    case DBOF_TYPE_BOOLEAN:
+        return sizeof(dbof_boolean);
+    case DBOF_TYPE_SINGLE_FLOAT:
+        return sizeof(dbof_single_float);
+    case DBOF_TYPE_DOUBLE_FLOAT:
+        return sizeof(dbof_double_float);
+    case DBOF_TYPE_CHARACTER:
+        return sizeof(dbof_character);
+    default:
+        return 0;
+    }
+}
+
+/**
+ * Internal. Copy the value of a primitive object to packed storage.
+ */
+static void __unbox_value(dbof_object object, void* dst)
+{
+    switch (dbof_typeof(object))
+    {
+    case DBOF_TYPE_SIGNED_BYTE:
+        *(dbof_signed_byte*) dst = dbof_get_value_signed_byte(object);
+        break;
+    case DBOF_TYPE_UNSIGNED_BYTE:
+        *(dbof_unsigned_byte*) dst = dbof_get_value_unsigned_byte(object);
+        break;
+    case DBOF_TYPE_SIGNED_INTEGER:
+        *(dbof_signed_integer*) dst = dbof_get_value_signed_integer(object);
+        break;
+    case DBOF_TYPE_UNSIGNED_INTEGER:
+        *(dbof_unsigned_integer*) dst = dbof_get_value_unsigned_integer(object);
+        break;
+    case DBOF_TYPE_SIGNED_LONG_INTEGER:
+        *(dbof_signed_long_integer*) dst = dbof_get_value_signed_long_integer(object);
+        break;
+    case DBOF_TYPE_UNSIGNED_LONG_INTEGER:
+        *(dbof_unsigned_long_integer*) dst = dbof_get_value_unsigned_long_integer(object);
+        break;
+    case DBOF_TYPE_BOOLEAN:
+        *(dbof_boolean*) dst = dbof_get_value_boolean(object);
+        break;
+    case DBOF_TYPE_SINGLE_FLOAT:
+        *(dbof_single_float*) dst = dbof_get_value_single_float(object);
+        break;
+    case DBOF_TYPE_DOUBLE_FLOAT:
+        *(dbof_double_float*) dst = dbof_get_value_double_float(object);
+        break;
+    case DBOF_TYPE_CHARACTER:
+        *(dbof_character*) dst = dbof_get_value_character(object);
+        break;
+    default:
+        break;
+    }
+}
+
+static dbof_object __new_object(dbof_type type, struct __arena* arena);
+
+/**
+ * Internal. Store a value from packed storage in an allocated primitive object of the same type.
+ */
+static void __rebox_value(dbof_object object, const void* src)
+{
+    switch (dbof_typeof(object))
+    {
+    case DBOF_TYPE_SIGNED_BYTE:
+        dbof_set_value_signed_byte(object, *(const dbof_signed_byte*) src);
+        break;
+    case DBOF_TYPE_UNSIGNED_BYTE:
+        dbof_set_value_unsigned_byte(object, *(const dbof_unsigned_byte*) src);
+        break;
+    case DBOF_TYPE_SIGNED_INTEGER:
+        dbof_set_value_signed_integer(object, *(const dbof_signed_integer*) src);
+        break;
+    case DBOF_TYPE_UNSIGNED_INTEGER:
+        dbof_set_value_unsigned_integer(object, *(const dbof_unsigned_integer*) src);
+        break;
+    case DBOF_TYPE_SIGNED_LONG_INTEGER:
+        dbof_set_value_signed_long_integer(object, *(const dbof_signed_long_integer*) src);
+        break;
+    case DBOF_TYPE_UNSIGNED_LONG_INTEGER:
+        dbof_set_value_unsigned_long_integer(object, *(const dbof_unsigned_long_integer*) src);
+        break;
+    case DBOF_TYPE_BOOLEAN:
+        dbof_set_value_boolean(object, *(const dbof_boolean*) src);
+        break;
+    case DBOF_TYPE_SINGLE_FLOAT:
+        dbof_set_value_single_float(object, *(const dbof_single_float*) src);
+        break;
+    case DBOF_TYPE_DOUBLE_FLOAT:
+        dbof_set_value_double_float(object, *(const dbof_double_float*) src);
+        break;
+    case DBOF_TYPE_CHARACTER:
+        dbof_set_value_character(object, *(const dbof_character*) src);
+        break;
+    default:
+        break;
+    }
+}
+
+/**
+ * Internal. Create a new primitive object holding a value from packed storage. The object is always allocated.
+ */
+static dbof_object __box_value(dbof_type type, const void* src, struct __arena* arena)
+{
+    dbof_object object = __new_object(type, arena);
+    if (object != NULL)
+    {
+        __rebox_value(object, src);
+    }
+
+    return object;
+}
+
+/**
+ * Internal. Create a new primitive object holding a value from packed storage, as an immediate value if possible.
+ */
+static dbof_object __new_value(dbof_type type, const void* src, struct __arena* arena)
+{
+#ifdef __TAGGED_VALUES
+    uint32_t payload;
+
+    switch (type)
+    {
+    case DBOF_TYPE_NULL:
+        // All null objects are alike
+        payload = 0;
+        break;
+    case DBOF_TYPE_SIGNED_BYTE:
+        payload = (uint32_t) *(const dbof_signed_byte*) src;
+        break;
+    case DBOF_TYPE_UNSIGNED_BYTE:
+        payload = *(const dbof_unsigned_byte*) src;
+        break;
+    case DBOF_TYPE_SIGNED_INTEGER:
+        payload = (uint32_t) *(const dbof_signed_integer*) src;
+        break;
+    case DBOF_TYPE_UNSIGNED_INTEGER:
+        payload = *(const dbof_unsigned_integer*) src;
+        break;
+    case DBOF_TYPE_BOOLEAN:
+        payload = *(const dbof_boolean*) src;
+        break;
+    case DBOF_TYPE_SINGLE_FLOAT:
+        memcpy(&payload, src, sizeof(payload));
+        break;
+    case DBOF_TYPE_CHARACTER:
+        payload = *(const dbof_character*) src;
+        break;
+    default:
+        // Longs and doubles do not fit
+        return __box_value(type, src, arena);
+    }
+
+    return __TAG(type, payload);
+#else
+    return __box_value(type, src, arena);
+#endif
+}
+
+/**
+ * Implementation of a typed array object (type ID 128).
+ */
+struct __object_typed_array_impl
+{
+    struct __internal_array_base base;
+
+    /**
+     * The type for all children of the array.
+     */
+    dbof_type type;
+
+    /**
+     * Nonzero if the array packs primitive values instead of keeping children objects.
+     */
+    int packed;
+
+    /**
+     * The views of packed elements (NULL where there is none), or NULL if there are no views. Views move along with
+     * their elements and live until the array is deleted, or until their element is removed and handed out.
+     */
+    dbof_object* views;
+
+    /**
+     * The number of entries in the table of views.
+     */
+    dbof_container_size view_capacity;
+
+    /**
+     * Nonzero if the packed values may have been written through the pointer from dbof_typed_array_data(), so they
+     * must be copied to the views before the views are copied back.
+     */
+    int views_stale;
+};
+
+static void __object_typed_array_impl_construct(struct __object_typed_array_impl* array, struct __arena* arena)
+{ __internal_array_base_construct((struct __internal_array_base*) array, sizeof(dbof_object), arena); }
+
+/**
+ * Internal. Copy the values of all views back into the packed storage (or, if the storage was written directly, the
+ * other way around).
+ */
+static void __object_typed_array_impl_sync_views(struct __object_typed_array_impl* array)
+{
+    // Views of a frozen array cannot be written, so there is nothing to copy back
+    if (array->views == NULL || __is_frozen(array))
+        return;
+
+    // Elements added since the table was made have no views
+    dbof_container_size count = array->base.size < array->view_capacity ? array->base.size : array->view_capacity;
+
+    if (array->views_stale)
+    {
+        for (dbof_container_size i = 0; i < count; ++i)
+        {
+            if (array->views[i] != NULL)
+            {
+                __rebox_value(array->views[i], __internal_array_base_at((struct __internal_array_base*) array, i));
+            }
+        }
+
+        array->views_stale = 0;
+        return;
+    }
+
+    if (__internal_array_base_own((struct __internal_array_base*) array))
+        return;
+
+    for (dbof_container_size i = 0; i < count; ++i)
+    {
+        if (array->views[i] != NULL)
+        {
+            __unbox_value(array->views[i], __internal_array_base_at((struct __internal_array_base*) array, i));
+        }
+    }
+}
+
+/**
+ * Internal. Make the table of views (if any) hold at least the given number of entries. Returns zero on success,
+ * otherwise nonzero.
+ */
+static int __object_typed_array_impl_reserve_views(struct __object_typed_array_impl* array,
+        dbof_container_size count)
+{
+    if (array->views == NULL || count <= array->view_capacity)
+        return 0;
+
+    // Grow geometrically, as elements are often added one at a time
+    dbof_container_size capacity = array->view_capacity * 2 > count ? array->view_capacity * 2 : count;
+
+    dbof_object* views = realloc(array->views, capacity * sizeof(dbof_object));
+    if (views == NULL)
+    {
+        // ERROR: Out of memory
+        return -1;
+    }
+
+    memset(views + array->view_capacity, 0, (capacity - array->view_capacity) * sizeof(dbof_object));
+    array->views = views;
+    array->view_capacity = capacity;
+    return 0;
+}
+
+/**
+ * Internal. Delete all views. Only for arrays about to be deleted.
+ */
+static void __object_typed_array_impl_drop_views(struct __object_typed_array_impl* array)
+{
+    if (array->views == NULL)
+        return;
+
+    // Tables of views made after the array was frozen have an entry per element
+    dbof_container_size count = array->view_capacity;
+    if (__is_frozen(array) && count < array->base.size)
+    {
+        count = array->base.size;
+    }
+
+    for (dbof_container_size i = 0; i < count; ++i)
+    {
+        if (array->views[i] != NULL)
+        {
+            __delete_empty_object(array->views[i]);
+        }
+    }
+
+    free(array->views);
+    array->views = NULL;
+    array->view_capacity = 0;
+}
+
+/**
+ * Internal. Make the views of a packed array read-only along with the array. Returns zero on success, otherwise
+ * nonzero.
+ */
+static int __object_typed_array_impl_freeze_views(struct __object_typed_array_impl* array)
+{
+    __object_typed_array_impl_sync_views(array);
+
+    // Views of frozen arrays are looked up with the size of the array as the size of the table
+    if (__object_typed_array_impl_reserve_views(array, array->base.size))
+        return -1;
+
+    for (dbof_container_size i = 0; array->views != NULL && i < array->view_capacity; ++i)
+    {
+        if (array->views[i] != NULL)
+        {
+            ((struct __object_impl*) array->views[i])->flags |= __OBJECT_FLAG_FROZEN;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * Internal. Get the view of a packed value of a frozen container, creating it if needed. Many threads may ask at once,
+ * so the table of views and each view are published with compare-and-swap, and the losers of a race throw theirs away.
+ * Returns NULL if out of memory.
+ */
+static dbof_object __frozen_view(dbof_object** views, dbof_container_size count, dbof_container_size index,
+        dbof_type type, const void* value)
+{
+    dbof_object* table = __atomic_load_pointer((void**) views);
+    if (table == NULL)
+    {
+        dbof_object* new_table = calloc(count, sizeof(dbof_object));
+        if (new_table == NULL)
+        {
+            // ERROR: Out of memory
+            return NULL;
+        }
+
+        table = __atomic_publish_pointer((void**) views, new_table);
+        if (table != new_table)
+        {
+            free(new_table);
+        }
+    }
+
+    dbof_object view = __atomic_load_pointer(&table[index]);
+    if (view == NULL)
+    {
+        dbof_object new_view = __box_value(type, value, NULL);
+        if (new_view == NULL)
+        {
+            // ERROR: Out of memory
+            return NULL;
+        }
+
+        ((struct __object_impl*) new_view)->flags |= __OBJECT_FLAG_VIEW | __OBJECT_FLAG_FROZEN;
+
+        view = __atomic_publish_pointer(&table[index], new_view);
+        if (view != new_view)
+        {
+            __delete_empty_object(new_view);
+        }
+    }
+
+    return view;
+}
+
+/**
+ * Internal. Take the value of an object to be stored in the array. The object is consumed unless it is a view (which
+ * may well be one of this array's own views, so take the value before dropping views).
+ */
+static uint64_t __object_typed_array_impl_take_value(dbof_object object)
+{
+    uint64_t value = 0;
+    __unbox_value(object, &value);
+
+    if (!__is_view(object))
+    {
+        dbof_delete(object);
+    }
+
+    return value;
+}
+
+static void __object_typed_array_impl_destruct(struct __object_typed_array_impl* array)
+{
+    // The last reference is gone, so not even a frozen array has readers left
+    __object_typed_array_impl_drop_views(array);
+    array->base.base.base.flags &= ~__OBJECT_FLAG_FROZEN;
+
+    if (!array->packed)
+    {
+        __internal_array_base_delete_children((struct __internal_array_base*) array);
+    }
+
+    __internal_array_base_destruct((struct __internal_array_base*) array);
+}
+
+static dbof_container_size __object_typed_array_impl_get_capacity(struct __object_typed_array_impl* array)
+{ return __internal_array_base_get_capacity((struct __internal_array_base*) array); }
+
+static dbof_container_size __object_typed_array_impl_get_size(struct __object_typed_array_impl* array)
+{ return __internal_array_base_get_size((struct __internal_array_base*) array); }
+
+static int __object_typed_array_impl_reserve(struct __object_typed_array_impl* array, dbof_container_size capacity)
+{
+    if (capacity <= array->base.capacity)
+        return 0;
+
+    return __internal_array_base_reserve((struct __internal_array_base*) array, capacity);
+}
+
+static int __object_typed_array_impl_is_empty(struct __object_typed_array_impl* array)
+{ return __object_typed_array_impl_get_size(array) == 0; }
+
+static dbof_type __object_typed_array_impl_get_type(struct __object_typed_array_impl* array)
+{ return array->type; }
+
+static void __object_typed_array_impl_set_type(struct __object_typed_array_impl* array, dbof_type type)
+{
+    // Only change the type if the array is empty
+    if (!__object_typed_array_impl_is_empty(array))
+        return;
+
+    // Switch between packed values and children objects as needed
+    size_t packed_size = __packed_size_of(type);
+    size_t element_size = packed_size > 0 ? packed_size : sizeof(dbof_object);
+
+    if (__internal_array_base_set_element_size((struct __internal_array_base*) array, element_size))
+        return;
+
+    array->type = type;
+    array->packed = packed_size > 0;
+    __container_invalidate_hash(array);
+}
+
+static void __object_typed_array_impl_shrink_to_fit(struct __object_typed_array_impl* array)
+{ __internal_array_base_shrink_to_fit((struct __internal_array_base*) array); }
+
+static dbof_object __object_typed_array_impl_get(struct __object_typed_array_impl* array, dbof_container_size index)
+{
+    if (!array->packed)
+        return __internal_array_base_get((struct __internal_array_base*) array, index);
+
+    if (__is_frozen(array))
+        return __frozen_view(&array->views, array->base.size, index, array->type,
+                __internal_array_base_at((struct __internal_array_base*) array, index));
+
+    // Views are created lazily, and must catch up with any values written directly
+    if (array->views_stale)
+    {
+        __object_typed_array_impl_sync_views(array);
+    }
+
+    if (array->views == NULL)
+    {
+        array->views = calloc(array->base.size, sizeof(dbof_object));
+        if (array->views == NULL)
+        {
+            // ERROR: Out of memory
+            return NULL;
+        }
+
+        array->view_capacity = array->base.size;
+    }
+
+    // Elements may have been added without a view since the table was made
+    if (__object_typed_array_impl_reserve_views(array, index + 1))
+        return NULL;
+
+    if (array->views[index] == NULL)
+    {
+        dbof_object view = __box_value(array->type,
+                __internal_array_base_at((struct __internal_array_base*) array, index), NULL);
+        if (view == NULL)
+        {
+            // ERROR: Out of memory
+            return NULL;
+        }
+
+        ((struct __object_impl*) view)->flags |= __OBJECT_FLAG_VIEW;
+        array->views[index] = view;
+
+        // The view may be written at any time
+        __container_invalidate_hash(array);
+    }
+
+    return array->views[index];
+}
+
+/**
+ * Internal. Store a packed value in place of an element, and in its view (if any).
+ */
+static void __object_typed_array_impl_store(struct __object_typed_array_impl* array, dbof_container_size index,
+        const void* value)
+{
+    memcpy(__internal_array_base_at((struct __internal_array_base*) array, index), value, array->base.element_size);
+
+    if (array->views != NULL && index < array->view_capacity && array->views[index] != NULL)
+    {
+        __rebox_value(array->views[index], value);
+    }
+
+    __container_invalidate_hash(array);
+}
+
+static void __object_typed_array_impl_set(struct __object_typed_array_impl* array, dbof_container_size index,
+        dbof_object object)
+{
+    // Only valid for nonempty arrays, so always enforce matching types (the object goes away either way)
+    if (dbof_typeof(object) != array->type)
+    {
+        __discard_object(object);
+        return;
+    }
+
+    if (!array->packed)
+    {
+        __internal_array_base_set((struct __internal_array_base*) array, index, object);
+        return;
+    }
+
+    uint64_t value = __object_typed_array_impl_take_value(object);
+
+    if (__internal_array_base_own((struct __internal_array_base*) array))
+        return;
+
+    __object_typed_array_impl_store(array, index, &value);
+}
+
+void __object_typed_array_impl_insert(struct __object_typed_array_impl* array, dbof_container_size index,
+        dbof_object object)
+{
+    dbof_type type = dbof_typeof(object);
+
+    // First child sets the type
+    if (__object_typed_array_impl_is_empty(array))
+    {
+        __object_typed_array_impl_set_type(array, type);
+    }
+
+    // Subsequent children must match the type (the object goes away either way)
+    if (type != array->type)
+    {
+        __discard_object(object);
+        return;
+    }
+
+    if (!array->packed)
+    {
+        __internal_array_base_insert((struct __internal_array_base*) array, index, object);
+        return;
+    }
+
+    uint64_t value = __object_typed_array_impl_take_value(object);
+
+    // Restrict index to one past the last index
+    if (index > array->base.size)
+    {
+        index = array->base.size;
+    }
+
+    // The views after the new element move up along with their elements
+    if (__object_typed_array_impl_reserve_views(array, array->base.size + 1))
+        return;
+
+    void* slot = __internal_array_base_insert_slot((struct __internal_array_base*) array, index);
+    if (slot == NULL)
+        return;
+
+    memcpy(slot, &value, array->base.element_size);
+
+    if (array->views != NULL)
+    {
+        memmove(array->views + index + 1, array->views + index, (array->base.size - 1 - index) * sizeof(dbof_object));
+        array->views[index] = NULL;
+    }
+}
+
+dbof_object __object_typed_array_impl_remove(struct __object_typed_array_impl* array, dbof_container_size index)
+{
+    if (!array->packed)
+        return __internal_array_base_remove((struct __internal_array_base*) array, index);
+
+    // Restrict index to last index
+    if (index >= array->base.size)
+        return NULL;
+
+    // The removed value leaves as its view, if it has one (which the caller then owns), or else as a new object
+    void* element = __internal_array_base_at((struct __internal_array_base*) array, index);
+    dbof_object view = array->views != NULL && index < array->view_capacity ? array->views[index] : NULL;
+    dbof_object object = view != NULL ? view : __new_value(array->type, element, NULL);
+
+    if (view != NULL && array->views_stale)
+    {
+        __rebox_value(view, element);
+    }
+
+    if (__internal_array_base_remove_slot((struct __internal_array_base*) array, index))
+    {
+        if (view == NULL)
+        {
+            dbof_delete(object);
+        }
+        return NULL;
+    }
+
+    // The views after the removed element move down along with their elements
+    if (array->views != NULL && index < array->view_capacity)
+    {
+        memmove(array->views + index, array->views + index + 1, (array->view_capacity - 1 - index)
+                * sizeof(dbof_object));
+        array->views[array->view_capacity - 1] = NULL;
+    }
+
+    if (view != NULL)
+    {
+        ((struct __object_impl*) view)->flags &= ~__OBJECT_FLAG_VIEW;
+    }
+
+    return object;
+}
+
+static void __object_typed_array_impl_push_back(struct __object_typed_array_impl* array, dbof_object object)
+{ __object_typed_array_impl_insert(array, array->base.size, object); }
+
+static dbof_object __object_typed_array_impl_pop_back(struct __object_typed_array_impl* array)
+{
+    // Remove the last object
+    return __object_typed_array_impl_remove(array, array->base.size - 1);
+}
+
+/**
+ * Internal. Get the address of a packed element for reading, or NULL if the array does not pack the given type.
+ */
+static void* __object_typed_array_impl_read_at(struct __object_typed_array_impl* array, dbof_container_size index,
+        dbof_type type)
+{
+    if (array->type != type || !array->packed)
+        return NULL;
+
+    __object_typed_array_impl_sync_views(array);
+    return __internal_array_base_at((struct __internal_array_base*) array, index);
+}
+
+/**
+ * Internal. Store a value in place of a packed element, unless the array does not pack the given type.
+ */
+static void __object_typed_array_impl_write_at(struct __object_typed_array_impl* array, dbof_container_size index,
+        dbof_type type, const void* value)
+{
+    if (array->type != type || !array->packed)
+        return;
+
+    if (__internal_array_base_own((struct __internal_array_base*) array))
+        return;
+
+    __object_typed_array_impl_store(array, index, value);
+}
+
+/**
+ * Internal. Append an uninitialized packed element, or return NULL if the array does not pack the given type.
+ */
+static void* __object_typed_array_impl_push_back_value(struct __object_typed_array_impl* array, dbof_type type)
+{
+    // First element sets the type
+    if (__object_typed_array_impl_is_empty(array))
+    {
+        __object_typed_array_impl_set_type(array, type);
+    }
+
+    if (array->type != type || !array->packed)
+        return NULL;
+
+    // The new element has no view, so the table of views can stay as it is
+    return __internal_array_base_insert_slot((struct __internal_array_base*) array, array->base.size);
+}
+
+static void* __object_typed_array_impl_data(struct __object_typed_array_impl* array)
+{
+    if (!array->packed)
+        return NULL;
+
+    // The caller may write through the pointer, so the views pick up the values from the elements next time
+    __object_typed_array_impl_sync_views(array);
+
+    if (__internal_array_base_own((struct __internal_array_base*) array))
+        return NULL;
+
+    array->views_stale = array->views != NULL;
+    __container_invalidate_hash(array);
+    return array->base.elements;
+}
+
+static struct __object_typed_array_impl* __new_object_typed_array(struct __arena* arena)
+{
+    struct __object_typed_array_impl* array = __new_empty_object(DBOF_TYPE_TYPED_ARRAY,
+            sizeof(struct __object_typed_array_impl), arena);
+    __object_typed_array_impl_construct(array, arena);
+    return array;
+}
+
+static void __delete_object_typed_array(struct __object_typed_array_impl* array)
+{
+    __object_typed_array_impl_destruct(array);
+    __delete_empty_object(array);
+}
+
+/**
+ * Implementation of an untyped array object (type ID 129).
+ */
+struct __object_untyped_array_impl
+{
+    struct __internal_array_base base;
+};
+
+static void __object_untyped_array_impl_construct(struct __object_untyped_array_impl* array, struct __arena* arena)
+{ __internal_array_base_construct((struct __internal_array_base*) array, sizeof(dbof_object), arena); }
+
+static void __object_untyped_array_impl_destruct(struct __object_untyped_array_impl* array)
+{
+    struct __internal_array_base* base = (struct __internal_array_base*) array;
+
+    // A frozen array may have both element storage and a chunk tree, each with references of its own
+    if (base->elements != NULL)
+    {
+        __internal_array_base_delete_children(base);
+    }
+
+    if (base->chunks != NULL)
+    {
+        __array_chunk_release(base->chunks, base->arena);
+    }
+
+    __internal_array_base_destruct(base);
+}
+
+static dbof_container_size __object_untyped_array_impl_get_capacity(struct __object_untyped_array_impl* array)
+{
+    // Chunk trees grow a chunk at a time, so there is no room to speak of
+    if (__internal_array_base_is_chunked((struct __internal_array_base*) array))
+        return array->base.size;
+
+    return __internal_array_base_get_capacity((struct __internal_array_base*) array);
+}
+
+static dbof_container_size __object_untyped_array_impl_get_size(struct __object_untyped_array_impl* array)
+{ return __internal_array_base_get_size((struct __internal_array_base*) array); }
+
+static int __object_untyped_array_impl_reserve(struct __object_untyped_array_impl* array,
+        dbof_container_size capacity)
+{
+    if (__internal_array_base_is_chunked((struct __internal_array_base*) array))
+        return 0;
+
+    return __internal_array_base_reserve((struct __internal_array_base*) array, capacity);
+}
+
+static int __object_untyped_array_impl_is_empty(struct __object_untyped_array_impl* array)
+{ return __object_untyped_array_impl_get_size(array) == 0; }
+
+static void __object_untyped_array_impl_shrink_to_fit(struct __object_untyped_array_impl* array)
+{
+    if (__internal_array_base_is_chunked((struct __internal_array_base*) array))
+        return;
+
+    __internal_array_base_shrink_to_fit((struct __internal_array_base*) array);
+}
+
+static dbof_object __object_untyped_array_impl_get(struct __object_untyped_array_impl* array, dbof_container_size index)
+{ return __internal_array_base_get((struct __internal_array_base*) array, index); }
+
+static void __object_untyped_array_impl_set(struct __object_untyped_array_impl* array, dbof_container_size index,
+        dbof_object object)
+{
+    struct __internal_array_base* base = (struct __internal_array_base*) array;
+    if (!__internal_array_base_is_chunked(base))
+    {
+        __internal_array_base_set(base, index, object);
+        return;
+    }
+
+    dbof_object* slot = __is_frozen(array) ? NULL : __array_chunk_slot(&base->chunks, base->arena, index);
+    if (slot == NULL)
+    {
+        __discard_object(object);
+        return;
+    }
+
+    // The tree's reference to the old child goes to whoever got it, just like with element storage
+    *slot = object;
+    __container_adopt(NULL, object);
+}
+
+void __object_untyped_array_impl_insert(struct __object_untyped_array_impl* array, dbof_container_size index,
+        dbof_object object)
+{
+    struct __internal_array_base* base = (struct __internal_array_base*) array;
+    if (!__internal_array_base_is_chunked(base))
+    {
+        __internal_array_base_insert(base, index, object);
+        return;
+    }
+
+    if (index > base->size || __is_frozen(array) || __array_chunk_insert(&base->chunks, base->arena, index, object))
+    {
+        __discard_object(object);
+        return;
+    }
+
+    __container_adopt(NULL, object);
+    base->size++;
+}
+
+dbof_object __object_untyped_array_impl_remove(struct __object_untyped_array_impl* array, dbof_container_size index)
+{
+    struct __internal_array_base* base = (struct __internal_array_base*) array;
+    if (!__internal_array_base_is_chunked(base))
+        return __internal_array_base_remove(base, index);
+
+    dbof_object object;
+    if (index >= base->size || __is_frozen(array) || __array_chunk_remove(&base->chunks, base->arena, index, &object))
+        return NULL;
+
+    base->size--;
+    return object;
+}
+
+static void __object_untyped_array_impl_push_back(struct __object_untyped_array_impl* array, dbof_object object)
+{ __object_untyped_array_impl_insert(array, array->base.size, object); }
+
+static dbof_object __object_untyped_array_impl_pop_back(struct __object_untyped_array_impl* array)
+{
+    // Remove the last object
+    return __object_untyped_array_impl_remove(array, array->base.size - 1);
+}
+
+static struct __object_untyped_array_impl* __new_object_untyped_array(struct __arena* arena)
+{
+    struct __object_untyped_array_impl* array = __new_empty_object(DBOF_TYPE_UNTYPED_ARRAY,
+            sizeof(struct __object_untyped_array_impl), arena);
+    __object_untyped_array_impl_construct(array, arena);
+    return array;
+}
+
+static void __delete_object_untyped_array(struct __object_untyped_array_impl* array)
+{
+    __object_untyped_array_impl_destruct(array);
+    __delete_empty_object(array);
+}
+
+//
+// NOTICE
+// A snapshot shares the chunk tree of its array (see __array_chunk_own()), and with it the children themselves: they
+// are not copied, so changing a child in place (setting its value, or editing a nested container) shows in every array
+// holding it. To change a child in one array only, put a changed copy in its place. A snapshot makes that copy for a
+// nested untyped array, so an edit at any depth copies only the path down to it. As the children are shared, arrays
+// in chunk trees neither cache their hash codes unless they are frozen, nor are pointed back to by their children.
+// Freezing such an array gives it copies of the children it shares first, so the others keep theirs mutable.
+//
+
+static struct __object_untyped_array_impl* __object_untyped_array_impl_snapshot(
+        struct __object_untyped_array_impl* array)
+{
+    struct __internal_array_base* base = (struct __internal_array_base*) array;
+
+    struct __object_untyped_array_impl* snapshot = __new_object_untyped_array(base->arena);
+
+    // ERROR: Out of memory
+    if (snapshot == NULL)
+        return NULL;
+
+    // Frozen arrays may be snapshotted from many threads at once, so their tree is published atomically
+    struct __array_chunk* root = __atomic_load_pointer((void**) &base->chunks);
+
+    if (root == NULL)
+    {
+        int frozen = __is_frozen(array);
+
+        root = __array_chunk_build(base->arena, (dbof_object*) base->elements, base->size, frozen);
+        if (root == NULL)
+        {
+            // ERROR: Out of memory
+            __delete_object_untyped_array(snapshot);
+            return NULL;
+        }
+
+        if (frozen)
+        {
+            struct __array_chunk* published = __atomic_publish_pointer((void**) &base->chunks, root);
+            if (published != root)
+            {
+                __array_chunk_release(root, base->arena);
+                root = published;
+            }
+        }
+        else
+        {
+            // The tree takes over the children, which no longer point back to the array
+            for (dbof_container_size i = 0; i < base->size; ++i)
+            {
+                dbof_object child = ((dbof_object*) base->elements)[i];
+                if (child != NULL && __is_mutable(child) && ((struct __object_impl*) child)->parent == array)
+                {
+                    ((struct __object_impl*) child)->parent = NULL;
+                }
+            }
+
+            __internal_array_base_destruct(base);
+            base->elements = NULL;
+            base->capacity = 0;
+            base->chunks = root;
+            __container_invalidate_hash(array);
+        }
+    }
+
+    __refs_increment(&root->refs);
+
+    snapshot->base.size = base->size;
+    snapshot->base.chunks = root;
+
+    return snapshot;
+}
+
+/**
+ * Internal. Give an array in a chunk tree copies of the children it shares with other arrays, so that freezing it
+ * leaves theirs mutable. Returns zero on success, otherwise nonzero.
+ */
+static int __object_untyped_array_impl_own_children(struct __object_untyped_array_impl* array)
+{
+    struct __internal_array_base* base = (struct __internal_array_base*) array;
+    if (!__internal_array_base_is_chunked(base) || __is_frozen(array))
+        return 0;
+
+    for (dbof_container_size i = 0; i < base->size; ++i)
+    {
+        // Once the leaf is the array's own, a child someone else holds as well has references beyond the leaf's
+        dbof_object* slot = __array_chunk_slot(&base->chunks, base->arena, i);
+        if (slot == NULL)
+            return -1;
+
+        dbof_object child = *slot;
+        if (child == NULL || !__is_mutable(child) || __refs_load(&((struct __object_impl*) child)->refs) == 0)
+            continue;
+
+        dbof_object copy;
+        if (dbof_typeof(child) == DBOF_TYPE_UNTYPED_ARRAY)
+        {
+            copy = __object_untyped_array_impl_snapshot(child);
+        }
+        else
+        {
+            dbof_new_ex_params params = { NULL, base->arena, 0 };
+            copy = dbof_clone_ex(child, &params);
+        }
+
+        // ERROR: Out of memory
+        if (copy == NULL)
+            return -1;
+
+        *slot = copy;
+        dbof_delete(child);
+    }
+
+    return 0;
+}
+
+//
+// NOTICE
+// This map implementation uses an open addressing hash table with linear probing. All entries live in one contiguous
+// array of slots, each of which carries the key object, the value object, and the full hash code of the key. Keeping
+// the hash code alongside the key lets probing skip over most non-matching slots without touching the key objects at
+// all. The table size is always a power of two and the table is doubled once the load factor would exceed 3/4. Removal
+// uses backward shift deletion, so no tombstones are ever left behind and probe sequences stay short.
+//
+
+/**
+ * The maximum load factor of a map, expressed as a fraction.
+ */
+#define __MAP_MAX_LOAD_NUM 3
+#define __MAP_MAX_LOAD_DEN 4
+
+/**
+ * The capacity of the table a map allocates for its first entry. Always a power of two.
+ */
+#define __MAP_MIN_CAPACITY 4
+
+/**
+ * The largest capacity a container read from a stream is sized to up front. The size comes from the stream, so it is
+ * not trusted with more than this; bigger containers grow as usual.
+ */
+#define __READ_PRESIZE_LIMIT ((dbof_container_size) 1 << 20)
+
+struct __map_slot
+{
+    /**
+     * The key object.
+     *
+     * NULL if this slot does not carry an entry.
+     */
+    dbof_object key;
+
+    /**
+     * The value object.
+     *
+     * Undefined if this slot does not carry an entry.
+     */
+    dbof_object value;
+
+    /**
+     * The hash code of the key object.
+     *
+     * Undefined if this slot does not carry an entry.
+     */
+    unsigned int hash;
+};
+
+struct __internal_map_base
+{
+    struct __container_impl base;
+
+    /**
+     * The number of slots in the table. Always a power of two.
+     */
+    dbof_container_size capacity;
+
+    /**
+     * The total number of entries in the map.
+     */
+    dbof_container_size size;
+
+    /**
+     * The slots of the hash table.
+     */
+    struct __map_slot* slots;
+
+    /**
+     * The arena the table storage comes from, or NULL if it comes from the heap.
+     */
+    struct __arena* arena;
+};
+
+/**
+ * Internal. Get the ideal slot index for a hash code. The hash code is scrambled first, as many of the value object
+ * hash functions (the integer ones, in particular) are the identity function and would otherwise cluster badly.
+ */
+static dbof_container_size __internal_map_base_index_of(struct __internal_map_base* map, unsigned int hash)
+{
+    uint64_t h = hash * 0x9e3779b97f4a7c15ull;
+    return (dbof_container_size) (h ^ (h >> 32)) & (map->capacity - 1);
+}
+
+static void __internal_map_base_construct(struct __internal_map_base* map, struct __arena* arena)
+{
+    map->capacity = 0;
+    map->size = 0;
+    map->arena = arena;
+
+    // The table is allocated on first use (or by reserving), as many maps stay small or empty
+    map->slots = NULL;
+}
+
+static void __internal_map_base_destruct(struct __internal_map_base* map)
+{
+    // Delete the key and value objects of every occupied slot
+    for (dbof_container_size i = 0; i < map->capacity; ++i)
+    {
+        if (map->slots[i].key != NULL)
+        {
+            __container_release(map, map->slots[i].key);
+            __container_release(map, map->slots[i].value);
+        }
+    }
+
+    // Free the table itself
+    __storage_free(map->arena, map->slots);
+}
+
+static dbof_container_size __internal_map_base_get_capacity(struct __internal_map_base* map)
+{ return map->capacity; }
+
+static dbof_container_size __internal_map_base_get_size(struct __internal_map_base* map)
+{ return map->size; }
+
+static int __internal_map_base_is_empty(struct __internal_map_base* map)
+{ return map->size == 0; }
+
+/**
+ * Internal. Find the slot holding the given key. Returns NULL if the key is not in the map.
+ */
+static struct __map_slot* __internal_map_base_find(struct __internal_map_base* map, dbof_object key,
+        unsigned int hash)
+{
+    // Empty maps may not have a table at all
+    if (map->size == 0)
+        return NULL;
+
+    dbof_container_size mask = map->capacity - 1;
+    dbof_container_size i = __internal_map_base_index_of(map, hash);
+
+    // Probe until we hit an empty slot, which ends the run
+    // The load factor guarantees there is always at least one empty slot
+    while (map->slots[i].key != NULL)
+    {
+        struct __map_slot* slot = &map->slots[i];
+
+        // Only compare the keys themselves if the hash codes match
+        if (slot->hash == hash && (slot->key == key || dbof_equals(slot->key, key)))
+            return slot;
+
+        i = (i + 1) & mask;
+    }
+
+    return NULL;
+}
+
+/**
+ * Internal. Place an entry into the table without checking for an existing entry with the same key.
+ */
+static void __internal_map_base_place(struct __internal_map_base* map, dbof_object key, dbof_object value,
+        unsigned int hash)
+{
+    dbof_container_size mask = map->capacity - 1;
+    dbof_container_size i = __internal_map_base_index_of(map, hash);
+
+    while (map->slots[i].key != NULL)
+    {
+        i = (i + 1) & mask;
+    }
+
+    map->slots[i].key = key;
+    map->slots[i].value = value;
+    map->slots[i].hash = hash;
+}
+
+static int __internal_map_base_rehash(struct __internal_map_base* map, dbof_container_size capacity)
+{
+    // ERROR: A frozen map cannot be modified
+    if (__is_frozen(map))
+        return -1;
+
+    struct __map_slot* slots = __storage_calloc(map->arena, capacity, sizeof(struct __map_slot));
+
+    // If allocation failed, the rehash fails
+    if (slots == NULL)
+        return -1;
+
+    struct __map_slot* old_slots = map->slots;
+    dbof_container_size old_capacity = map->capacity;
+
+    map->slots = slots;
+    map->capacity = capacity;
+
+    // Move every entry over using its stored hash code (no need to hash the keys again)
+    for (dbof_container_size i = 0; i < old_capacity; ++i)
+    {
+        if (old_slots[i].key != NULL)
+        {
+            __internal_map_base_place(map, old_slots[i].key, old_slots[i].value, old_slots[i].hash);
+        }
+    }
+
+    __storage_free(map->arena, old_slots);
+    return 0;
+}
+
+/**
+ * Internal. Get the table capacity needed to hold the given number of entries.
+ */
+static dbof_container_size __map_capacity_for(dbof_container_size size)
+{
+    dbof_container_size capacity = __MAP_MIN_CAPACITY;
+    while (size * __MAP_MAX_LOAD_DEN > capacity * __MAP_MAX_LOAD_NUM)
+    {
+        capacity *= 2;
+    }
+
+    return capacity;
+}
+
+/**
+ * Internal. Make room for at least the given number of entries. Returns zero on success, otherwise nonzero.
+ */
+static int __internal_map_base_reserve(struct __internal_map_base* map, dbof_container_size size)
+{
+    // Make sure the table size is representable
+    if (size > SIZE_MAX / __MAP_MAX_LOAD_DEN / sizeof(struct __map_slot))
+        return -1;
+
+    dbof_container_size capacity = __map_capacity_for(size);
+    if (capacity <= map->capacity)
+        return 0;
+
+    return __internal_map_base_rehash(map, capacity);
+}
+
+static int __internal_map_base_ensure_space(struct __internal_map_base* map)
+{
+    // If another entry would push us over the maximum load factor, double the table (or make the first one)
+    if ((map->size + 1) * __MAP_MAX_LOAD_DEN > map->capacity * __MAP_MAX_LOAD_NUM)
+    {
+        if (__internal_map_base_rehash(map, map->capacity == 0 ? __MAP_MIN_CAPACITY : map->capacity * 2))
+            return -1;
+    }
+
+    return 0;
+}
+
+static dbof_object __internal_map_base_get(struct __internal_map_base* map, dbof_object key)
+{
+    struct __map_slot* slot = __internal_map_base_find(map, key, (unsigned int) dbof_hash(key));
+    return slot == NULL ? NULL : slot->value;
+}
+
+static int __internal_map_base_put(struct __internal_map_base* map, dbof_object key, dbof_object value)
+{
+    // ERROR: A frozen map cannot be modified
+    if (__is_frozen(map))
+        goto fail;
+
+    unsigned int hash = (unsigned int) dbof_hash(key);
+
+    // If the key is already present, replace the value in place
+    struct __map_slot* slot = __internal_map_base_find(map, key, hash);
+    if (slot != NULL)
+    {
+        // We own both the old value and the redundant key now, so delete them
+        if (slot->value != value)
+        {
+            __container_release(map, slot->value);
+        }
+        if (slot->key != key)
+        {
+            dbof_delete(key);
+        }
+
+        slot->value = value;
+        __container_adopt(map, value);
+        __container_invalidate_hash(map);
+        return 0;
+    }
+
+    // Ensure we have enough capacity for another entry or fail
+    if (__internal_map_base_ensure_space(map))
+        goto fail;
+
+    __internal_map_base_place(map, key, value, hash);
+    map->size++;
+
+    __container_adopt(map, key);
+    __container_adopt(map, value);
+    __container_invalidate_hash(map);
+    return 0;
+
+fail:
+    // The entry was handed over to us, so it goes away with the failure
+    dbof_delete(key);
+    dbof_delete(value);
+    return -1;
+}
+
+static dbof_object __internal_map_base_remove(struct __internal_map_base* map, dbof_object key)
+{
+    // ERROR: A frozen map cannot be modified
+    if (__is_frozen(map))
+        return NULL;
+
+    struct __map_slot* slot = __internal_map_base_find(map, key, (unsigned int) dbof_hash(key));
+    if (slot == NULL)
+        return NULL;
+
+    // Preserve the value, and delete the key (we owned it)
+    dbof_object value = slot->value;
+    __container_release(map, slot->key);
+
+    // Shift subsequent entries of the run backward to fill the hole
+    dbof_container_size mask = map->capacity - 1;
+    dbof_container_size hole = (dbof_container_size) (slot - map->slots);
+    dbof_container_size i = (hole + 1) & mask;
+    while (map->slots[i].key != NULL)
+    {
+        dbof_container_size ideal = __internal_map_base_index_of(map, map->slots[i].hash);
+
+        // Move the entry if its ideal slot does not lie cyclically within (hole, i]
+        if (((i - ideal) & mask) >= ((i - hole) & mask))
+        {
+            map->slots[hole] = map->slots[i];
+            hole = i;
+        }
+
+        i = (i + 1) & mask;
+    }
+
+    map->slots[hole].key = NULL;
+    map->size--;
+
+    __container_adopt(NULL, value);
+    __container_invalidate_hash(map);
+
+    return value;
+}
+
+static int __internal_map_base_has_key(struct __internal_map_base* map, dbof_object key)
+{ return __internal_map_base_find(map, key, (unsigned int) dbof_hash(key)) != NULL; }
+
+//
+// NOTICE
+// Typed maps with a primitive key type or value type (byte through double float, or character) keep that side unboxed
+// in a flat table of their own, so a lookup in a table such as ulong->double does not touch a single object. The other
+// side, if not primitive (a string key, say), is kept as an object in the same table. Packed values handed out as
+// objects are views, just like the elements of packed typed arrays: they are cached per slot and move along with their
+// entry when the table is rehashed or an entry before them is removed, their values are copied back before the packed
+// values are used, and removing an entry hands its view over to the caller. Packed keys are never handed out.
+//
+
+/**
+ * A key or value of a packed typed map. Primitive values are stored zero-extended, so cells compare as integers.
+ */
+union __map_cell
+{
+    /**
+     * The packed value.
+     */
+    uint64_t packed;
+
+    /**
+     * The object, if the key or value type is not primitive.
+     */
+    dbof_object object;
+};
+
+struct __packed_map_slot
+{
+    /**
+     * The key.
+     *
+     * Undefined if this slot does not carry an entry.
+     */
+    union __map_cell key;
+
+    /**
+     * The value.
+     *
+     * Undefined if this slot does not carry an entry.
+     */
+    union __map_cell value;
+
+    /**
+     * The hash code of the key.
+     *
+     * Undefined if this slot does not carry an entry.
+     */
+    unsigned int hash;
+
+    /**
+     * Nonzero if this slot carries an entry. Zero is a perfectly good packed key, so it cannot mark empty slots.
+     */
+    unsigned int used;
+};
+
+/**
+ * A key to look up in a packed typed map.
+ */
+struct __packed_map_key
+{
+    /**
+     * The key as it would be stored.
+     */
+    union __map_cell cell;
+
+    /**
+     * The bytes of a string key, if it is given as such instead of as an object. NULL otherwise.
+     */
+    const char* chars;
+
+    /**
+     * The length of the string key in bytes. Only valid if chars is not NULL.
+     */
+    dbof_string_size length;
+
+    /**
+     * The hash code of the key.
+     */
+    unsigned int hash;
+};
+
+/**
+ * Implementation of a typed map object (type ID 130).
+ */
+struct __object_typed_map_impl
+{
+    struct __internal_map_base base;
+
+    /**
+     * The type for all keys in the array.
+     */
+    dbof_type key_type;
+
+    /**
+     * The type for all values in the array.
+     */
+    dbof_type value_type;
+
+    /**
+     * Nonzero if the map packs primitive keys instead of keeping key objects.
+     */
+    int packed_keys;
+
+    /**
+     * Nonzero if the map packs primitive values instead of keeping value objects.
+     */
+    int packed_values;
+
+    /**
+     * The slots of the hash table if keys or values are packed, in which case the slots of the base are NULL.
+     */
+    struct __packed_map_slot* packed_slots;
+
+    /**
+     * The cached views of packed values by slot (NULL where there is none), or NULL if there are no views.
+     */
+    dbof_object* views;
+};
+
+static void __object_typed_map_impl_construct(struct __object_typed_map_impl* map, struct __arena* arena)
+{
+    __internal_map_base_construct((struct __internal_map_base*) map, arena);
+
+    map->packed_keys = 0;
+    map->packed_values = 0;
+    map->packed_slots = NULL;
+    map->views = NULL;
+}
+
+/**
+ * Internal. Determine if a typed map uses the packed table.
+ */
+static int __object_typed_map_impl_is_packed(struct __object_typed_map_impl* map)
+{ return map->packed_keys || map->packed_values; }
+
+/**
+ * Internal. Copy the value of the view of a slot (if any) back into the packed storage.
+ */
+static void __object_typed_map_impl_sync_view(struct __object_typed_map_impl* map, dbof_container_size index)
+{
+    // Views of a frozen map cannot be written, so there is nothing to copy back
+    if (map->views != NULL && !__is_frozen(map) && map->views[index] != NULL)
+    {
+        __unbox_value(map->views[index], &map->packed_slots[index].value.packed);
+    }
+}
+
+/**
+ * Internal. Delete all views. Only for maps about to be deleted (or emptied of their table).
+ */
+static void __object_typed_map_impl_drop_views(struct __object_typed_map_impl* map)
+{
+    if (map->views == NULL)
+        return;
+
+    for (dbof_container_size i = 0; i < map->base.capacity; ++i)
+    {
+        if (map->views[i] != NULL)
+        {
+            __delete_empty_object(map->views[i]);
+        }
+    }
+
+    free(map->views);
+    map->views = NULL;
+}
+
+/**
+ * Internal. Make the views of a packed map read-only along with the map.
+ */
+static void __object_typed_map_impl_freeze_views(struct __object_typed_map_impl* map)
+{
+    for (dbof_container_size i = 0; map->views != NULL && i < map->base.capacity; ++i)
+    {
+        if (map->views[i] != NULL)
+        {
+            __object_typed_map_impl_sync_view(map, i);
+            ((struct __object_impl*) map->views[i])->flags |= __OBJECT_FLAG_FROZEN;
+        }
+    }
+}
+
+/**
+ * Internal. Finish a packed key by making equal keys bitwise equal and computing its hash code.
+ */
+static void __object_typed_map_impl_finish_key(struct __object_typed_map_impl* map, struct __packed_map_key* key)
+{
+    // All NaNs are equal to one another (see __equals_object_single_float and __equals_object_double_float)
+    if (map->key_type == DBOF_TYPE_SINGLE_FLOAT)
+    {
+        dbof_single_float value;
+        memcpy(&value, &key->cell.packed, sizeof(value));
+
+        if (value != value)
+        {
+            key->cell.packed = 0x7fc00000ull;
+        }
+    }
+    else if (map->key_type == DBOF_TYPE_DOUBLE_FLOAT)
+    {
+        dbof_double_float value;
+        memcpy(&value, &key->cell.packed, sizeof(value));
+
+        if (value != value)
+        {
+            key->cell.packed = 0x7ff8000000000000ull;
+        }
+    }
+
+    key->chars = NULL;
+    key->hash = (unsigned int) (key->cell.packed ^ (key->cell.packed >> 32));
+}
+
+/**
+ * Internal. Describe a key object for lookup in the packed table. Returns nonzero if such a key cannot be in the map.
+ */
+static int __object_typed_map_impl_describe_key(struct __object_typed_map_impl* map, dbof_object object,
+        struct __packed_map_key* key)
+{
+    if (dbof_typeof(object) != map->key_type)
+        return -1;
+
+    if (map->packed_keys)
+    {
+        key->cell.packed = 0;
+        __unbox_value(object, &key->cell.packed);
+        __object_typed_map_impl_finish_key(map, key);
+    }
+    else
+    {
+        key->cell.object = object;
+        key->chars = NULL;
+        key->hash = (unsigned int) dbof_hash(object);
+    }
+
+    return 0;
+}
+
+/**
+ * Internal. Describe a key given in packed form (or as string bytes, for string keys) for lookup in the packed table.
+ * Returns nonzero if such a key cannot be in the map.
+ */
+static int __object_typed_map_impl_make_key(struct __object_typed_map_impl* map, const void* src,
+        dbof_string_size length, struct __packed_map_key* key)
+{
+    if (map->packed_keys)
+    {
+        key->cell.packed = 0;
+
+        // Spell out the common sizes, so lookups do not pay for a call to memcpy
+        switch (__packed_size_of(map->key_type))
+        {
+        case 1:
+            memcpy(&key->cell.packed, src, 1);
+            break;
+        case 4:
+            memcpy(&key->cell.packed, src, 4);
+            break;
+        case 8:
+            memcpy(&key->cell.packed, src, 8);
+            break;
+        default:
+            memcpy(&key->cell.packed, src, __packed_size_of(map->key_type));
+            break;
+        }
+
+        __object_typed_map_impl_finish_key(map, key);
+        return 0;
+    }
+
+    if (map->key_type == DBOF_TYPE_UTF8_STRING)
+    {
+        // Hash the same way as the string objects do
+        key->cell.object = NULL;
+        key->chars = src;
+        key->length = length;
+        key->hash = (unsigned int) __hash_bytes_internal(src, length);
+        return 0;
+    }
+
+    return -1;
+}
+
+/**
+ * Internal. Determine if the packed table slot carries the given key object or string key. Not for packed keys.
+ */
+static int __object_typed_map_impl_key_matches(struct __object_typed_map_impl* map, struct __packed_map_slot* slot,
+        const struct __packed_map_key* key)
+{
+    (void) map;
+
+    // Only compare the keys themselves if the hash codes match
+    if (slot->hash != key->hash)
+        return 0;
+
+    if (key->chars != NULL)
+    {
+        struct __object_utf8_string_impl* string = slot->key.object;
+        return string->length == key->length && (key->length == 0 || !memcmp(string->value, key->chars, key->length));
+    }
+
+    return slot->key.object == key->cell.object || dbof_equals(slot->key.object, key->cell.object);
+}
+
+/**
+ * Internal. Find the packed table slot holding the given key. Returns NULL if the key is not in the map.
+ */
+static struct __packed_map_slot* __object_typed_map_impl_find(struct __object_typed_map_impl* map,
+        const struct __packed_map_key* key)
+{
+    // Empty maps may not have a table at all
+    if (map->base.size == 0)
+        return NULL;
+
+    struct __packed_map_slot* slots = map->packed_slots;
+    dbof_container_size mask = map->base.capacity - 1;
+    dbof_container_size i = __internal_map_base_index_of((struct __internal_map_base*) map, key->hash);
+
+    // Packed keys are equal if and only if their cells are, so there is no need to look at the hash codes
+    if (map->packed_keys)
+    {
+        while (slots[i].used)
+        {
+            if (slots[i].key.packed == key->cell.packed)
+                return &slots[i];
+
+            i = (i + 1) & mask;
+        }
+
+        return NULL;
+    }
+
+    while (slots[i].used)
+    {
+        if (__object_typed_map_impl_key_matches(map, &slots[i], key))
+            return &slots[i];
+
+        i = (i + 1) & mask;
+    }
+
+    return NULL;
+}
+
+/**
+ * Internal. Place an entry into the packed table without checking for an existing entry with the same key.
+ */
+static struct __packed_map_slot* __object_typed_map_impl_place(struct __object_typed_map_impl* map,
+        union __map_cell key, union __map_cell value, unsigned int hash)
+{
+    dbof_container_size mask = map->base.capacity - 1;
+    dbof_container_size i = __internal_map_base_index_of((struct __internal_map_base*) map, hash);
+
+    while (map->packed_slots[i].used)
+    {
+        i = (i + 1) & mask;
+    }
+
+    map->packed_slots[i].key = key;
+    map->packed_slots[i].value = value;
+    map->packed_slots[i].hash = hash;
+    map->packed_slots[i].used = 1;
+    return &map->packed_slots[i];
+}
+
+/**
+ * Internal. Rehash the packed table, moving each view along with its entry.
+ */
+static int __object_typed_map_impl_rehash(struct __object_typed_map_impl* map, dbof_container_size capacity)
+{
+    // ERROR: A frozen map cannot be modified
+    if (__is_frozen(map))
+        return -1;
+
+    struct __packed_map_slot* slots = __storage_calloc(map->base.arena, capacity, sizeof(struct __packed_map_slot));
+
+    // If allocation failed, the rehash fails
+    if (slots == NULL)
+        return -1;
+
+    dbof_object* views = NULL;
+    if (map->views != NULL)
+    {
+        views = calloc(capacity, sizeof(dbof_object));
+        if (views == NULL)
+        {
+            // ERROR: Out of memory
+            __storage_free(map->base.arena, slots);
+            return -1;
+        }
+    }
+
+    struct __packed_map_slot* old_slots = map->packed_slots;
+    dbof_object* old_views = map->views;
+    dbof_container_size old_capacity = map->base.capacity;
+
+    map->packed_slots = slots;
+    map->views = views;
+    map->base.capacity = capacity;
+
+    // Move every entry over using its stored hash code
+    for (dbof_container_size i = 0; i < old_capacity; ++i)
+    {
+        if (old_slots[i].used)
+        {
+            struct __packed_map_slot* slot = __object_typed_map_impl_place(map, old_slots[i].key, old_slots[i].value,
+                    old_slots[i].hash);
+
+            if (old_views != NULL)
+            {
+                views[slot - slots] = old_views[i];
+            }
+        }
+    }
+
+    __storage_free(map->base.arena, old_slots);
+    free(old_views);
+    return 0;
+}
+
+/**
+ * Internal. Put an entry into the packed table, taking ownership of any objects in it. String keys given as bytes get
+ * a string object made for them if the key is new. Returns the slot of the entry or NULL on failure.
+ */
+static struct __packed_map_slot* __object_typed_map_impl_put_packed(struct __object_typed_map_impl* map,
+        const struct __packed_map_key* key, union __map_cell value)
+{
+    // ERROR: A frozen map cannot be modified
+    if (__is_frozen(map))
+        return NULL;
+
+    // If the key is already present, replace the value in place
+    struct __packed_map_slot* slot = __object_typed_map_impl_find(map, key);
+    if (slot != NULL)
+    {
+        // We own both the old value and the redundant key now, so delete them
+        if (!map->packed_values && slot->value.object != value.object)
+        {
+            __container_release(map, slot->value.object);
+        }
+        if (!map->packed_keys && key->chars == NULL && slot->key.object != key->cell.object)
+        {
+            dbof_delete(key->cell.object);
+        }
+
+        slot->value = value;
+        if (!map->packed_values)
+        {
+            __container_adopt(map, value.object);
+        }
+
+        // The view of the entry (if any) stays, and shows the new value
+        dbof_container_size index = (dbof_container_size) (slot - map->packed_slots);
+        if (map->packed_values && map->views != NULL && map->views[index] != NULL)
+        {
+            __rebox_value(map->views[index], &slot->value.packed);
+        }
+
+        __container_invalidate_hash(map);
+        return slot;
+    }
+
+    // If another entry would push us over the maximum load factor, double the table (or make the first one)
+    if ((map->base.size + 1) * __MAP_MAX_LOAD_DEN > map->base.capacity * __MAP_MAX_LOAD_NUM)
+    {
+        if (__object_typed_map_impl_rehash(map, map->base.capacity == 0 ? __MAP_MIN_CAPACITY
+                : map->base.capacity * 2))
+            return NULL;
+    }
+
+    union __map_cell key_cell = key->cell;
+    if (key->chars != NULL)
+    {
+        struct __object_utf8_string_impl* string = __new_object(DBOF_TYPE_UTF8_STRING, map->base.arena);
+        if (string == NULL)
+        {
+            // ERROR: Out of memory
+            return NULL;
+        }
+
+        dbof_set_value_utf8_string_n(string, key->chars, key->length);
+
+        // We already know its hash code
+        string->hash = (int) key->hash;
+        string->base.flags |= __OBJECT_FLAG_HASHED;
+
+        key_cell.object = string;
+    }
+
+    if (!map->packed_keys)
+    {
+        __container_adopt(map, key_cell.object);
+    }
+    if (!map->packed_values)
+    {
+        __container_adopt(map, value.object);
+    }
+
+    map->base.size++;
+    __container_invalidate_hash(map);
+
+    return __object_typed_map_impl_place(map, key_cell, value, key->hash);
+}
+
+/**
+ * Internal. Remove the entry of a packed table slot, deleting its key (unless packed). The caller takes care of the
+ * value and of the view of the slot (if any).
+ */
+static void __object_typed_map_impl_remove_slot(struct __object_typed_map_impl* map, struct __packed_map_slot* slot)
+{
+    if (!map->packed_keys)
+    {
+        __container_release(map, slot->key.object);
+    }
+
+    // Shift subsequent entries of the run backward to fill the hole
+    dbof_container_size mask = map->base.capacity - 1;
+    dbof_container_size hole = (dbof_container_size) (slot - map->packed_slots);
+    dbof_container_size i = (hole + 1) & mask;
+    while (map->packed_slots[i].used)
+    {
+        dbof_container_size ideal = __internal_map_base_index_of((struct __internal_map_base*) map,
+                map->packed_slots[i].hash);
+
+        // Move the entry (and its view) if its ideal slot does not lie cyclically within (hole, i]
+        if (((i - ideal) & mask) >= ((i - hole) & mask))
+        {
+            map->packed_slots[hole] = map->packed_slots[i];
+            if (map->views != NULL)
+            {
+                map->views[hole] = map->views[i];
+            }
+            hole = i;
+        }
+
+        i = (i + 1) & mask;
+    }
+
+    map->packed_slots[hole].used = 0;
+    if (map->views != NULL)
+    {
+        map->views[hole] = NULL;
+    }
+    map->base.size--;
+
+    __container_invalidate_hash(map);
+}
+
+/**
+ * Internal. Set both types of an empty map, switching between the packed table and the base table as needed.
+ */
+static void __object_typed_map_impl_set_types(struct __object_typed_map_impl* map, dbof_type key_type,
+        dbof_type value_type)
+{
+    // Only change the types if the map is empty (and not frozen)
+    if (map->base.size > 0 || __is_frozen(map))
+        return;
+
+    int packed_keys = __packed_size_of(key_type) > 0;
+    int packed_values = __packed_size_of(value_type) > 0;
+
+    // Swap out the (empty) table if the layout changes
+    if (__object_typed_map_impl_is_packed(map) != (packed_keys || packed_values))
+    {
+        if (packed_keys || packed_values)
+        {
+            map->packed_slots = __storage_calloc(map->base.arena, map->base.capacity, sizeof(struct __packed_map_slot));
+            if (map->packed_slots == NULL && map->base.capacity > 0)
+                return;
+
+            __storage_free(map->base.arena, map->base.slots);
+            map->base.slots = NULL;
+        }
+        else
+        {
+            map->base.slots = __storage_calloc(map->base.arena, map->base.capacity, sizeof(struct __map_slot));
+            if (map->base.slots == NULL && map->base.capacity > 0)
+                return;
+
+            __object_typed_map_impl_drop_views(map);
+            __storage_free(map->base.arena, map->packed_slots);
+            map->packed_slots = NULL;
+        }
+    }
+
+    map->key_type = key_type;
+    map->value_type = value_type;
+    map->packed_keys = packed_keys;
+    map->packed_values = packed_values;
+    __container_invalidate_hash(map);
+}
+
+static void __object_typed_map_impl_destruct(struct __object_typed_map_impl* map)
+{
+    if (!__object_typed_map_impl_is_packed(map))
+    {
+        __internal_map_base_destruct((struct __internal_map_base*) map);
+        return;
+    }
+
+    // The last reference is gone, so not even a frozen map has readers left
+    map->base.base.base.flags &= ~__OBJECT_FLAG_FROZEN;
+    __object_typed_map_impl_drop_views(map);
+
+    // Delete the key and value objects (if not packed) of every occupied slot
+    for (dbof_container_size i = 0; i < map->base.capacity; ++i)
+    {
+        if (!map->packed_slots[i].used)
+            continue;
+
+        if (!map->packed_keys)
+        {
+            __container_release(map, map->packed_slots[i].key.object);
+        }
+        if (!map->packed_values)
+        {
+            __container_release(map, map->packed_slots[i].value.object);
+        }
+    }
+
+    __storage_free(map->base.arena, map->packed_slots);
+}
+
+static dbof_container_size __object_typed_map_impl_get_capacity(struct __object_typed_map_impl* map)
+{ return __internal_map_base_get_capacity((struct __internal_map_base*) map); }
+
+static dbof_container_size __object_typed_map_impl_get_size(struct __object_typed_map_impl* map)
+{ return __internal_map_base_get_size((struct __internal_map_base*) map); }
+
+static int __object_typed_map_impl_reserve(struct __object_typed_map_impl* map, dbof_container_size size)
+{
+    if (!__object_typed_map_impl_is_packed(map))
+        return __internal_map_base_reserve((struct __internal_map_base*) map, size);
+
+    // Make sure the table size is representable
+    if (size > SIZE_MAX / __MAP_MAX_LOAD_DEN / sizeof(struct __packed_map_slot))
+        return -1;
+
+    dbof_container_size capacity = __map_capacity_for(size);
+    if (capacity <= map->base.capacity)
+        return 0;
+
+    return __object_typed_map_impl_rehash(map, capacity);
+}
+
+static int __object_typed_map_impl_is_empty(struct __object_typed_map_impl* map)
+{ return __internal_map_base_is_empty((struct __internal_map_base*) map); }
+
+static dbof_type __object_typed_map_impl_get_key_type(struct __object_typed_map_impl* map)
+{ return map->key_type; }
+
+static void __object_typed_map_impl_set_key_type(struct __object_typed_map_impl* map, dbof_type key_type)
+{ __object_typed_map_impl_set_types(map, key_type, map->value_type); }
+
+static dbof_type __object_typed_map_impl_get_value_type(struct __object_typed_map_impl* map)
+{ return map->value_type; }
+
+static void __object_typed_map_impl_set_key_value(struct __object_typed_map_impl* map, dbof_type value_type)
+{ __object_typed_map_impl_set_types(map, map->key_type, value_type); }
+
+static dbof_object __object_typed_map_impl_get(struct __object_typed_map_impl* map, dbof_object key)
+{
+    if (!__object_typed_map_impl_is_packed(map))
+        return __internal_map_base_get((struct __internal_map_base*) map, key);
+
+    struct __packed_map_key packed_key;
+    if (__object_typed_map_impl_describe_key(map, key, &packed_key))
+        return NULL;
+
+    struct __packed_map_slot* slot = __object_typed_map_impl_find(map, &packed_key);
+    if (slot == NULL)
+        return NULL;
+
+    if (!map->packed_values)
+        return slot->value.object;
+
+    if (__is_frozen(map))
+        return __frozen_view(&map->views, map->base.capacity, (dbof_container_size) (slot - map->packed_slots),
+                map->value_type, &slot->value.packed);
+
+    // Views are created lazily
+    if (map->views == NULL)
+    {
+        map->views = calloc(map->base.capacity, sizeof(dbof_object));
+        if (map->views == NULL)
+        {
+            // ERROR: Out of memory
+            return NULL;
+        }
+    }
+
+    dbof_container_size index = (dbof_container_size) (slot - map->packed_slots);
+    if (map->views[index] == NULL)
+    {
+        dbof_object view = __box_value(map->value_type, &slot->value.packed, NULL);
+        if (view == NULL)
+        {
+            // ERROR: Out of memory
+            return NULL;
+        }
+
+        ((struct __object_impl*) view)->flags |= __OBJECT_FLAG_VIEW;
+        map->views[index] = view;
+
+        // The view may be written at any time
+        __container_invalidate_hash(map);
+    }
+
+    return map->views[index];
+}
+
+static int __object_typed_map_impl_put(struct __object_typed_map_impl* map, dbof_object key, dbof_object value)
+{
+    dbof_type key_type = dbof_typeof(key);
+    dbof_type value_type = dbof_typeof(value);
+
+    // First entry sets the types
+    __object_typed_map_impl_set_types(map, key_type, value_type);
+
+    // ERROR: Subsequent entries must match the types
+    if (key_type != map->key_type || value_type != map->value_type)
+    {
+        __discard_object(key);
+        __discard_object(value);
+        return -1;
+    }
+
+    if (!__object_typed_map_impl_is_packed(map))
+        return __internal_map_base_put((struct __internal_map_base*) map, key, value);
+
+    // Take the packed values first, as either object may be one of our own views
+    struct __packed_map_key packed_key;
+    union __map_cell value_cell;
+
+    if (map->packed_keys)
+    {
+        packed_key.cell.packed = __object_typed_array_impl_take_value(key);
+        __object_typed_map_impl_finish_key(map, &packed_key);
+    }
+    else
+    {
+        __object_typed_map_impl_describe_key(map, key, &packed_key);
+    }
+
+    if (map->packed_values)
+    {
+        value_cell.packed = __object_typed_array_impl_take_value(value);
+    }
+    else
+    {
+        value_cell.object = value;
+    }
+
+    if (__object_typed_map_impl_put_packed(map, &packed_key, value_cell) == NULL)
+    {
+        // Whatever objects the entry still had go away with the failure
+        if (!map->packed_keys)
+        {
+            dbof_delete(packed_key.cell.object);
+        }
+        if (!map->packed_values)
+        {
+            dbof_delete(value_cell.object);
+        }
+        return -1;
+    }
+
+    return 0;
+}
+
+static dbof_object __object_typed_map_impl_remove(struct __object_typed_map_impl* map, dbof_object key)
+{
+    if (!__object_typed_map_impl_is_packed(map))
+        return __internal_map_base_remove((struct __internal_map_base*) map, key);
+
+    struct __packed_map_key packed_key;
+    if (__object_typed_map_impl_describe_key(map, key, &packed_key))
+        return NULL;
+
+    struct __packed_map_slot* slot = __object_typed_map_impl_find(map, &packed_key);
+
+    // ERROR: A frozen map cannot be modified
+    if (slot == NULL || __is_frozen(map))
+        return NULL;
+
+    // The removed value leaves as its view, if it has one (which the caller then owns), or else as a new object
+    dbof_container_size index = (dbof_container_size) (slot - map->packed_slots);
+    dbof_object value = slot->value.object;
+    if (map->packed_values && map->views != NULL && map->views[index] != NULL)
+    {
+        value = map->views[index];
+        ((struct __object_impl*) value)->flags &= ~__OBJECT_FLAG_VIEW;
+    }
+    else if (map->packed_values)
+    {
+        value = __new_value(map->value_type, &slot->value.packed, NULL);
+        if (value == NULL)
+            return NULL;
+    }
+    else
+    {
+        __container_adopt(NULL, value);
+    }
+
+    __object_typed_map_impl_remove_slot(map, slot);
+    return value;
+}
+
+static int __object_typed_map_impl_has_key(struct __object_typed_map_impl* map, dbof_object key)
+{
+    if (!__object_typed_map_impl_is_packed(map))
+        return __internal_map_base_has_key((struct __internal_map_base*) map, key);
+
+    struct __packed_map_key packed_key;
+    if (__object_typed_map_impl_describe_key(map, key, &packed_key))
+        return 0;
+
+    return __object_typed_map_impl_find(map, &packed_key) != NULL;
+}
+
+/**
+ * Internal. Get the packed value for a key given in packed form (or as string bytes, for string keys) if the map has
+ * the given types and packs its values. Returns NULL if not so or if the key is not in the map.
+ */
+static void* __object_typed_map_impl_read(struct __object_typed_map_impl* map, dbof_type key_type, const void* key,
+        dbof_string_size length, dbof_type value_type)
+{
+    if (key_type != map->key_type || value_type != map->value_type || !map->packed_values)
+        return NULL;
+
+    struct __packed_map_key packed_key;
+    if (__object_typed_map_impl_make_key(map, key, length, &packed_key))
+        return NULL;
+
+    struct __packed_map_slot* slot = __object_typed_map_impl_find(map, &packed_key);
+    if (slot == NULL)
+        return NULL;
+
+    __object_typed_map_impl_sync_view(map, (dbof_container_size) (slot - map->packed_slots));
+    return &slot->value.packed;
+}
+
+/**
+ * Internal. Store a packed value for a key given in packed form (or as string bytes, for string keys), adding an entry
+ * for the key if needed, if the map has the given types and packs its values. An empty map takes on the types.
+ */
+static void __object_typed_map_impl_write(struct __object_typed_map_impl* map, dbof_type key_type, const void* key,
+        dbof_string_size length, dbof_type value_type, const void* value)
+{
+    // First entry sets the types
+    __object_typed_map_impl_set_types(map, key_type, value_type);
+
+    if (key_type != map->key_type || value_type != map->value_type || !map->packed_values)
+        return;
+
+    struct __packed_map_key packed_key;
+    if (__object_typed_map_impl_make_key(map, key, length, &packed_key))
+        return;
+
+    union __map_cell value_cell = { 0 };
+    memcpy(&value_cell.packed, value, __packed_size_of(value_type));
+
+    (void) __object_typed_map_impl_put_packed(map, &packed_key, value_cell);
+}
+
+static struct __object_typed_map_impl* __new_object_typed_map(struct __arena* arena)
+{
+    struct __object_typed_map_impl* map = __new_empty_object(DBOF_TYPE_TYPED_MAP,
+            sizeof(struct __object_typed_map_impl), arena);
+    __object_typed_map_impl_construct(map, arena);
+    return map;
+}
+
+static void __delete_object_typed_map(struct __object_typed_map_impl* map)
+{
+    __object_typed_map_impl_destruct(map);
+    __delete_empty_object(map);
+}
+
+/**
+ * Implementation of an untyped map object (type ID 131).
+ */
+struct __object_untyped_map_impl
+{
+    struct __internal_map_base base;
+};
+
+static void __object_untyped_map_impl_construct(struct __object_untyped_map_impl* map, struct __arena* arena)
+{ __internal_map_base_construct((struct __internal_map_base*) map, arena); }
+
+static void __object_untyped_map_impl_destruct(struct __object_untyped_map_impl* map)
+{ __internal_map_base_destruct((struct __internal_map_base*) map); }
+
+static dbof_container_size __object_untyped_map_impl_get_capacity(struct __object_untyped_map_impl* map)
+{ return __internal_map_base_get_capacity((struct __internal_map_base*) map); }
+
+static dbof_container_size __object_untyped_map_impl_get_size(struct __object_untyped_map_impl* map)
+{ return __internal_map_base_get_size((struct __internal_map_base*) map); }
+
+static int __object_untyped_map_impl_reserve(struct __object_untyped_map_impl* map, dbof_container_size size)
+{ return __internal_map_base_reserve((struct __internal_map_base*) map, size); }
+
+static int __object_untyped_map_impl_is_empty(struct __object_untyped_map_impl* map)
+{ return __internal_map_base_is_empty((struct __internal_map_base*) map); }
+
+static dbof_object __object_untyped_map_impl_get(struct __object_untyped_map_impl* map, dbof_object key)
+{ return __internal_map_base_get((struct __internal_map_base*) map, key); }
+
+static void __object_untyped_map_impl_put(struct __object_untyped_map_impl* map, dbof_object key, dbof_object value)
+{ (void) __internal_map_base_put((struct __internal_map_base*) map, key, value); }
+
+static dbof_object __object_untyped_map_impl_remove(struct __object_untyped_map_impl* map, dbof_object key)
+{ return __internal_map_base_remove((struct __internal_map_base*) map, key); }
+
+static int __object_untyped_map_impl_has_key(struct __object_untyped_map_impl* map, dbof_object key)
+{ return __internal_map_base_has_key((struct __internal_map_base*) map, key); }
+
+static struct __object_untyped_map_impl* __new_object_untyped_map(struct __arena* arena)
+{
+    struct __object_untyped_map_impl* map = __new_empty_object(DBOF_TYPE_UNTYPED_MAP,
+            sizeof(struct __object_untyped_map_impl), arena);
+    __object_untyped_map_impl_construct(map, arena);
+    return map;
+}
+
+static void __delete_object_untyped_map(struct __object_untyped_map_impl* map)
+{
+    __object_untyped_map_impl_destruct(map);
+    __delete_empty_object(map);
+}
+
+//
+// NOTICE
+// Containers hash and compare deeply. Both walk the object tree with an explicit stack rather than by recursion, so
+// documents of any depth are fine. Arrays hash their children in order. Maps add up the hash codes of their entries, so
+// the result does not depend on where the entries happen to sit in the table. Packed typed arrays never visit their
+// elements one by one: their values are hashed and compared in bulk, with the word-at-a-time byte hash and memcmp().
+// The values of packed typed maps are hashed and compared straight from the table. Equality never goes by cached hash
+// codes, though, as a value object changed in place leaves the codes of the containers above it stale.
+//
+
+/**
+ * The number of entries deep hashing and equality keep on the C stack before moving their stack to the heap.
+ */
+#define __DEEP_STACK_LOCAL 32
+
+/**
+ * A growable stack for walking object trees. It starts out in a buffer provided by the caller.
+ */
+struct __deep_stack
+{
+    /**
+     * The items.
+     */
+    char* items;
+
+    /**
+     * The number of items on the stack.
+     */
+    size_t count;
+
+    /**
+     * The number of items there is room for.
+     */
+    size_t capacity;
+
+    /**
+     * The size of one item in bytes.
+     */
+    size_t item_size;
+
+    /**
+     * The buffer provided by the caller. The items live here until the stack outgrows it.
+     */
+    char* local;
+};
+
+static void __deep_stack_init(struct __deep_stack* stack, void* local, size_t capacity, size_t item_size)
+{
+    stack->items = local;
+    stack->count = 0;
+    stack->capacity = capacity;
+    stack->item_size = item_size;
+    stack->local = local;
+}
+
+static void __deep_stack_free(struct __deep_stack* stack)
+{
+    if (stack->items != stack->local)
+    {
+        free(stack->items);
+    }
+}
+
+/**
+ * Internal. Push an uninitialized item onto the stack. Pointers to other items are invalidated. Returns the item or
+ * NULL if out of memory.
+ */
+static void* __deep_stack_push(struct __deep_stack* stack)
+{
+    if (stack->count == stack->capacity)
+    {
+        char* items = malloc(stack->capacity * 2 * stack->item_size);
+        if (items == NULL)
+        {
+            // ERROR: Out of memory
+            return NULL;
+        }
+
+        memcpy(items, stack->items, stack->count * stack->item_size);
+        __deep_stack_free(stack);
+
+        stack->items = items;
+        stack->capacity *= 2;
+    }
+
+    return stack->items + stack->count++ * stack->item_size;
+}
+
+static void* __deep_stack_top(struct __deep_stack* stack)
+{ return stack->items + (stack->count - 1) * stack->item_size; }
+
+/**
+ * Internal. Give all NaNs of packed single floats the same bit pattern (see __equals_object_single_float).
+ */
+static uint32_t __canonical_single_bits(uint32_t bits)
+{
+    if ((bits & 0x7f800000u) == 0x7f800000u && (bits & 0x007fffffu) != 0)
+        return 0x7fc00000u;
+
+    return bits;
+}
+
+/**
+ * Internal. Give all NaNs of packed double floats the same bit pattern (see __equals_object_double_float).
+ */
+static uint64_t __canonical_double_bits(uint64_t bits)
+{
+    if ((bits & 0x7ff0000000000000ull) == 0x7ff0000000000000ull && (bits & 0x000fffffffffffffull) != 0)
+        return 0x7ff8000000000000ull;
+
+    return bits;
+}
+
+/**
+ * Internal. Hash a run of packed values of a primitive type.
+ */
+static uint64_t __hash_packed_internal(dbof_type type, const char* values, dbof_container_size count)
+{
+    // Every other type compares bit patterns, so the bytes hash as they are
+    if (type != DBOF_TYPE_SINGLE_FLOAT && type != DBOF_TYPE_DOUBLE_FLOAT)
+        return __hash_bytes_internal(values, count * __packed_size_of(type));
+
+    // Floats pass through a buffer in chunks to have their NaNs canonicalized
+    union
+    {
+        uint32_t singles[512];
+        uint64_t doubles[256];
+    } buffer;
+
+    size_t size = __packed_size_of(type);
+    size_t chunk_capacity = sizeof(buffer) / size;
+    uint64_t h = count;
+
+    while (count > 0)
+    {
+        size_t chunk_count = count < chunk_capacity ? count : chunk_capacity;
+        memcpy(&buffer, values, chunk_count * size);
+
+        for (size_t i = 0; i < chunk_count; ++i)
+        {
+            if (type == DBOF_TYPE_SINGLE_FLOAT)
+            {
+                buffer.singles[i] = __canonical_single_bits(buffer.singles[i]);
+            }
+            else
+            {
+                buffer.doubles[i] = __canonical_double_bits(buffer.doubles[i]);
+            }
+        }
+
+        h = __hash_mix_internal(h + __hash_bytes_internal((const char*) &buffer, chunk_count * size));
+
+        values += chunk_count * size;
+        count -= chunk_count;
+    }
+
+    return h;
+}
+
+/**
+ * Internal. Compare two runs of packed values of a primitive type.
+ */
+static int __equals_packed_internal(dbof_type type, const char* a, const char* b, dbof_container_size count)
+{
+    size_t size = count * __packed_size_of(type);
+    if (size == 0 || !memcmp(a, b, size))
+        return 1;
+
+    // Floats may still be equal if they differ in NaNs only
+    if (type == DBOF_TYPE_SINGLE_FLOAT)
+    {
+        for (dbof_container_size i = 0; i < count; ++i)
+        {
+            uint32_t bits_a;
+            uint32_t bits_b;
+            memcpy(&bits_a, a + i * sizeof(uint32_t), sizeof(uint32_t));
+            memcpy(&bits_b, b + i * sizeof(uint32_t), sizeof(uint32_t));
+
+            if (__canonical_single_bits(bits_a) != __canonical_single_bits(bits_b))
+                return 0;
+        }
+
+        return 1;
+    }
+
+    if (type != DBOF_TYPE_DOUBLE_FLOAT)
+        return 0;
+
+    for (dbof_container_size i = 0; i < count; ++i)
+    {
+        uint64_t bits_a;
+        uint64_t bits_b;
+        memcpy(&bits_a, a + i * sizeof(uint64_t), sizeof(uint64_t));
+        memcpy(&bits_b, b + i * sizeof(uint64_t), sizeof(uint64_t));
+
+        if (__canonical_double_bits(bits_a) != __canonical_double_bits(bits_b))
+            return 0;
+    }
+
+    return 1;
+}
+
+/**
+ * Internal. Hash a packed value of a primitive type held in a map cell.
+ */
+static uint64_t __hash_cell_internal(dbof_type type, uint64_t packed)
+{
+    if (type == DBOF_TYPE_SINGLE_FLOAT)
+    {
+        packed = __canonical_single_bits((uint32_t) packed);
+    }
+    else if (type == DBOF_TYPE_DOUBLE_FLOAT)
+    {
+        packed = __canonical_double_bits(packed);
+    }
+
+    return __hash_mix_internal(packed);
+}
+
+/**
+ * Internal. Compare two packed values of a primitive type held in map cells.
+ */
+static int __equals_cell_internal(dbof_type type, uint64_t a, uint64_t b)
+{
+    if (type == DBOF_TYPE_SINGLE_FLOAT)
+        return __canonical_single_bits((uint32_t) a) == __canonical_single_bits((uint32_t) b);
+
+    if (type == DBOF_TYPE_DOUBLE_FLOAT)
+        return __canonical_double_bits(a) == __canonical_double_bits(b);
+
+    return a == b;
+}
+
+/**
+ * A container being hashed.
+ */
+struct __hash_frame
+{
+    /**
+     * The container.
+     */
+    dbof_object object;
+
+    /**
+     * The index of the next child (arrays) or slot (maps) to visit.
+     */
+    dbof_container_size index;
+
+    /**
+     * The hash code of the key of the entry being visited (maps).
+     */
+    uint64_t key_hash;
+
+    /**
+     * The hash code accumulated so far.
+     */
+    uint64_t hash;
+
+    /**
+     * Nonzero if the hash code may be cached once done. Views of packed values and children without a cached hash code
+     * rule this out.
+     */
+    int cacheable;
+};
+
+/**
+ * Internal. Cache the final hash code of a container if allowed.
+ */
+static void __hash_frame_cache(struct __hash_frame* frame)
+{
+    struct __container_impl* container = frame->object;
+
+    if (frame->cacheable)
+    {
+        container->hash = frame->hash;
+        container->base.flags |= __OBJECT_FLAG_HASHED;
+    }
+}
+
+/**
+ * Internal. Start hashing a container. Returns nonzero if the container was hashed right away (packed typed arrays
+ * and containers with a cached hash code), in which case the frame holds the final hash code.
+ */
+static int __hash_frame_begin(struct __hash_frame* frame, dbof_object object)
+{
+    dbof_type type = dbof_typeof(object);
+    struct __container_impl* container = object;
+
+    frame->object = object;
+    frame->index = 0;
+    frame->key_hash = 0;
+    frame->hash = type;
+    frame->cacheable = 1;
+
+    // Nothing changed below the container since it was last hashed
+    if (container->base.flags & __OBJECT_FLAG_HASHED)
+    {
+        frame->hash = container->hash;
+        return 1;
+    }
+
+    if (type == DBOF_TYPE_TYPED_ARRAY)
+    {
+        struct __object_typed_array_impl* array = object;
+        frame->hash |= (uint64_t) array->type << 8;
+
+        if (array->packed)
+        {
+            __object_typed_array_impl_sync_views(array);
+            frame->hash = __hash_mix_internal(frame->hash ^ __hash_packed_internal(array->type, array->base.elements,
+                    array->base.size));
+            frame->cacheable = array->views == NULL || __is_frozen(array);
+
+            __hash_frame_cache(frame);
+            return 1;
+        }
+    }
+    else if (type == DBOF_TYPE_UNTYPED_ARRAY)
+    {
+        // Children shared with snapshots do not tell all their arrays when they change
+        frame->cacheable = !__internal_array_base_is_chunked(object) || __is_frozen(object);
+    }
+    else if (type == DBOF_TYPE_TYPED_MAP)
+    {
+        struct __object_typed_map_impl* map = object;
+        frame->hash |= (uint64_t) map->key_type << 8 | (uint64_t) map->value_type << 16;
+        frame->cacheable = map->views == NULL || __is_frozen(map);
+    }
+
+    return 0;
+}
+
+/**
+ * Internal. Visit the next child of a container being hashed. Returns zero if there are no more children, one if the
+ * child was hashed right away (value objects and packed values) with its hash code stored to hash, or two if the child
+ * is a container that needs a frame of its own, stored to child.
+ */
+static int __hash_frame_next(struct __hash_frame* frame, dbof_object* child, uint64_t* hash)
+{
+    switch (dbof_typeof(frame->object))
+    {
+    case DBOF_TYPE_TYPED_ARRAY:
+    case DBOF_TYPE_UNTYPED_ARRAY:
+    {
+        struct __internal_array_base* array = frame->object;
+        if (frame->index >= array->size)
+            return 0;
+
+        *child = __internal_array_base_get(array, frame->index++);
+        break;
+    }
+    case DBOF_TYPE_TYPED_MAP:
+    {
+        struct __object_typed_map_impl* map = frame->object;
+        if (__object_typed_map_impl_is_packed(map))
+        {
+            while (frame->index < map->base.capacity && !map->packed_slots[frame->index].used)
+            {
+                frame->index++;
+            }
+
+            if (frame->index >= map->base.capacity)
+                return 0;
+
+            dbof_container_size index = frame->index++;
+            struct __packed_map_slot* slot = &map->packed_slots[index];
+            frame->key_hash = slot->hash;
+
+            if (map->packed_values)
+            {
+                __object_typed_map_impl_sync_view(map, index);
+                *hash = __hash_cell_internal(map->value_type, slot->value.packed);
+                return 1;
+            }
+
+            *child = slot->value.object;
+            break;
+        }
+
+        // Typed maps of other types use the base table
+    }
+    /* fall through */
+    case DBOF_TYPE_UNTYPED_MAP:
+    {
+        struct __internal_map_base* map = frame->object;
+        while (frame->index < map->capacity && map->slots[frame->index].key == NULL)
+        {
+            frame->index++;
+        }
+
+        if (frame->index >= map->capacity)
+            return 0;
+
+        // The key hash codes are already in the table
+        struct __map_slot* slot = &map->slots[frame->index++];
+        frame->key_hash = slot->hash;
+        *child = slot->value;
+        break;
+    }
+    default:
+        return 0;
+    }
+
+    if (*child != NULL && dbof_is_container_type(dbof_typeof(*child)))
+        return 2;
+
+    *hash = (unsigned int) dbof_hash(*child);
+    return 1;
+}
+
+/**
+ * Internal. Add the hash code of a child to a container being hashed.
+ */
+static void __hash_frame_add(struct __hash_frame* frame, uint64_t hash)
+{
+    switch (dbof_typeof(frame->object))
+    {
+    case DBOF_TYPE_TYPED_ARRAY:
+    case DBOF_TYPE_UNTYPED_ARRAY:
+        // Mixing after each child makes the result depend on the order of the children
+        frame->hash = __hash_mix_internal(frame->hash + hash);
+        break;
+    default:
+        // Addition makes the result independent of the order of the entries
+        frame->hash += __hash_mix_internal(frame->key_hash * 0x9e3779b97f4a7c15ull + hash);
+        break;
+    }
+}
+
+/**
+ * Internal. Finish hashing a container, caching the hash code if allowed.
+ */
+static uint64_t __hash_frame_end(struct __hash_frame* frame)
+{
+    dbof_type type = dbof_typeof(frame->object);
+    dbof_container_size size = type == DBOF_TYPE_TYPED_ARRAY || type == DBOF_TYPE_UNTYPED_ARRAY
+            ? ((struct __internal_array_base*) frame->object)->size
+            : ((struct __internal_map_base*) frame->object)->size;
+
+    frame->hash = __hash_mix_internal(frame->hash ^ size);
+    __hash_frame_cache(frame);
+
+    return frame->hash;
+}
+
+/**
+ * Internal. Add the hash code of a finished container child to its parent being hashed.
+ */
+static void __hash_frame_add_child(struct __hash_frame* frame, dbof_object child, uint64_t hash)
+{
+    // A parent may only keep its hash code while every container below it keeps its own
+    if (!(((struct __object_impl*) child)->flags & __OBJECT_FLAG_HASHED))
+    {
+        frame->cacheable = 0;
+    }
+
+    __hash_frame_add(frame, hash);
+}
+
+/**
+ * Internal. Hash a container deeply.
+ */
+static int __hash_container_internal(dbof_object object)
+{
+    struct __hash_frame local[__DEEP_STACK_LOCAL];
+    struct __deep_stack stack;
+    __deep_stack_init(&stack, local, __DEEP_STACK_LOCAL, sizeof(struct __hash_frame));
+
+    uint64_t hash = 0;
+
+    struct __hash_frame* root = __deep_stack_push(&stack);
+    if (__hash_frame_begin(root, object))
+        return (int) (unsigned int) root->hash;
+
+    while (stack.count > 0)
+    {
+        struct __hash_frame* frame = __deep_stack_top(&stack);
+        dbof_object child;
+
+        switch (__hash_frame_next(frame, &child, &hash))
+        {
+        case 0:
+            // The container is done, so hand its hash code up to its parent (unless it is the root)
+            child = frame->object;
+            hash = __hash_frame_end(frame);
+            stack.count--;
+
+            if (stack.count > 0)
+            {
+                __hash_frame_add_child(__deep_stack_top(&stack), child, hash);
+            }
+            break;
+        case 1:
+            __hash_frame_add(frame, hash);
+            break;
+        default:
+        {
+            struct __hash_frame* child_frame = __deep_stack_push(&stack);
+            if (child_frame == NULL)
+            {
+                // ERROR: Out of memory
+                hash = 0;
+                stack.count = 0;
+                break;
+            }
+
+            // Containers that are hashed right away are done at once
+            if (__hash_frame_begin(child_frame, child))
+            {
+                hash = child_frame->hash;
+                stack.count--;
+                __hash_frame_add_child(__deep_stack_top(&stack), child, hash);
+            }
+            break;
+        }
+        }
+    }
+
+    __deep_stack_free(&stack);
+    return (int) (unsigned int) hash;
+}
+
+/**
+ * A pair of containers waiting to be compared.
+ */
+struct __equals_pair
+{
+    dbof_object a;
+    dbof_object b;
+};
+
+/**
+ * Internal. Compare two children of containers being compared. Value objects are compared right away, and containers
+ * are pushed to be compared later. Returns zero if the children are known to differ (or if out of memory).
+ */
+static int __equals_children(struct __deep_stack* stack, dbof_object a, dbof_object b)
+{
+    if (a == b)
+        return 1;
+
+    if (a == NULL || b == NULL)
+        return 0;
+
+    if (!dbof_is_container_type(dbof_typeof(a)))
+        return dbof_equals(a, b);
+
+    struct __equals_pair* pair = __deep_stack_push(stack);
+    if (pair == NULL)
+        return 0;
+
+    pair->a = a;
+    pair->b = b;
+    return 1;
+}
+
+/**
+ * Internal. Compare two containers, pushing their container children to be compared later. Returns zero if the
+ * containers are known to differ.
+ */
+static int __equals_container_shallow(struct __deep_stack* stack, dbof_object a, dbof_object b)
+{
+    if (a == b)
+        return 1;
+
+    dbof_type type = dbof_typeof(a);
+    if (type != dbof_typeof(b))
+        return 0;
+
+    switch (type)
+    {
+    case DBOF_TYPE_TYPED_ARRAY:
+    {
+        struct __object_typed_array_impl* array_a = a;
+        struct __object_typed_array_impl* array_b = b;
+
+        if (array_a->type != array_b->type || array_a->base.size != array_b->base.size)
+            return 0;
+
+        if (array_a->packed)
+        {
+            __object_typed_array_impl_sync_views(array_a);
+            __object_typed_array_impl_sync_views(array_b);
+
+            return __equals_packed_internal(array_a->type, array_a->base.elements, array_b->base.elements,
+                    array_a->base.size);
+        }
+
+        // Typed arrays of other types hold children objects
+    }
+    /* fall through */
+    case DBOF_TYPE_UNTYPED_ARRAY:
+    {
+        struct __internal_array_base* array_a = a;
+        struct __internal_array_base* array_b = b;
+
+        if (array_a->size != array_b->size)
+            return 0;
+
+        for (dbof_container_size i = 0; i < array_a->size; ++i)
+        {
+            if (!__equals_children(stack, __internal_array_base_get(array_a, i), __internal_array_base_get(array_b, i)))
+                return 0;
+        }
+
+        return 1;
+    }
+    case DBOF_TYPE_TYPED_MAP:
+    {
+        struct __object_typed_map_impl* map_a = a;
+        struct __object_typed_map_impl* map_b = b;
+
+        if (map_a->key_type != map_b->key_type || map_a->value_type != map_b->value_type
+                || map_a->base.size != map_b->base.size)
+            return 0;
+
+        if (__object_typed_map_impl_is_packed(map_a))
+        {
+            for (dbof_container_size i = 0; i < map_a->base.capacity; ++i)
+            {
+                struct __packed_map_slot* slot_a = &map_a->packed_slots[i];
+                if (!slot_a->used)
+                    continue;
+
+                // Look up the key just as it is stored
+                struct __packed_map_key key;
+                key.cell = slot_a->key;
+                key.chars = NULL;
+                key.hash = slot_a->hash;
+
+                struct __packed_map_slot* slot_b = __object_typed_map_impl_find(map_b, &key);
+                if (slot_b == NULL)
+                    return 0;
+
+                if (map_a->packed_values)
+                {
+                    __object_typed_map_impl_sync_view(map_a, i);
+                    __object_typed_map_impl_sync_view(map_b, (dbof_container_size) (slot_b - map_b->packed_slots));
+
+                    if (!__equals_cell_internal(map_a->value_type, slot_a->value.packed, slot_b->value.packed))
+                        return 0;
+                }
+                else if (!__equals_children(stack, slot_a->value.object, slot_b->value.object))
+                {
+                    return 0;
+                }
+            }
+
+            return 1;
+        }
+
+        // Typed maps of other types use the base table
+    }
+    /* fall through */
+    case DBOF_TYPE_UNTYPED_MAP:
+    {
+        struct __internal_map_base* map_a = a;
+        struct __internal_map_base* map_b = b;
+
+        if (map_a->size != map_b->size)
+            return 0;
+
+        // With the sizes equal, every key of a being in b means the key sets are equal
+        for (dbof_container_size i = 0; i < map_a->capacity; ++i)
+        {
+            struct __map_slot* slot_a = &map_a->slots[i];
+            if (slot_a->key == NULL)
+                continue;
+
+            struct __map_slot* slot_b = __internal_map_base_find(map_b, slot_a->key, slot_a->hash);
+            if (slot_b == NULL || !__equals_children(stack, slot_a->value, slot_b->value))
+                return 0;
+        }
+
+        return 1;
+    }
+    default:
+        return 0;
+    }
+}
+
+/**
+ * Internal. Compare two containers deeply.
+ */
+static int __equals_container_internal(dbof_object a, dbof_object b)
+{
+    struct __equals_pair local[__DEEP_STACK_LOCAL];
+    struct __deep_stack stack;
+    __deep_stack_init(&stack, local, __DEEP_STACK_LOCAL, sizeof(struct __equals_pair));
+
+    int equal = __equals_container_shallow(&stack, a, b);
+
+    while (equal && stack.count > 0)
+    {
+        struct __equals_pair pair = *(struct __equals_pair*) __deep_stack_top(&stack);
+        stack.count--;
+
+        equal = __equals_container_shallow(&stack, pair.a, pair.b);
+    }
+
+    __deep_stack_free(&stack);
+    return equal;
+}
+
+static int __hash_object_typed_array(struct __object_typed_array_impl* array)
+{ return __hash_container_internal(array); }
+
+static int __hash_object_untyped_array(struct __object_untyped_array_impl* array)
+{ return __hash_container_internal(array); }
+
+static int __hash_object_typed_map(struct __object_typed_map_impl* map)
+{ return __hash_container_internal(map); }
+
+static int __hash_object_untyped_map(struct __object_untyped_map_impl* map)
+{ return __hash_container_internal(map); }
+
+//
+// NOTICE
+// The type functions are defined inline in the header. Declaring them extern here makes this the one translation unit
+// that emits their external definitions, which calls that are not inlined link against.
+//
+
+extern int dbof_is_value_type(dbof_type type);
+
+extern int dbof_is_container_type(dbof_type type);
+
+extern int dbof_same_category(dbof_object a, dbof_object b);
+
+dbof_type dbof_typeof(dbof_object object)
+{
+    if (__IS_TAGGED(object))
+        return __TAGGED_TYPE(object);
+
+    return ((struct __object_impl*) object)->type;
+}
+
+#ifdef __TAGGED_VALUES
+/**
+ * Internal. Room for any kind of value object that can be an immediate value.
+ */
+union __tagged_value_storage
+{
+    struct __object_impl base;
+    struct __object_null_impl null;
+    struct __object_signed_byte_impl signed_byte;
+    struct __object_unsigned_byte_impl unsigned_byte;
+    struct __object_signed_integer_impl signed_integer;
+    struct __object_unsigned_integer_impl unsigned_integer;
+    struct __object_boolean_impl boolean;
+    struct __object_single_float_impl single_float;
+    struct __object_character_impl character;
+};
+
+/**
+ * Internal. Unpack an immediate value into a temporary object, so the per-type hash and equality functions can be used
+ * on it as they are. Other objects are returned as-is.
+ */
+static dbof_object __untag_value(dbof_object object, union __tagged_value_storage* storage)
+{
+    if (!__IS_TAGGED(object))
+        return object;
+
+    storage->base.type = __TAGGED_TYPE(object);
+    storage->base.flags = 0;
+
+    switch (storage->base.type)
+    {
+    case DBOF_TYPE_SIGNED_BYTE:
+        storage->signed_byte.value = dbof_get_value_signed_byte(object);
+        break;
+    case DBOF_TYPE_UNSIGNED_BYTE:
+        storage->unsigned_byte.value = dbof_get_value_unsigned_byte(object);
+        break;
+    case DBOF_TYPE_SIGNED_INTEGER:
+        storage->signed_integer.value = dbof_get_value_signed_integer(object);
+        break;
+    case DBOF_TYPE_UNSIGNED_INTEGER:
+        storage->unsigned_integer.value = dbof_get_value_unsigned_integer(object);
+        break;
+    case DBOF_TYPE_BOOLEAN:
+        storage->boolean.value = dbof_get_value_boolean(object);
+        break;
+    case DBOF_TYPE_SINGLE_FLOAT:
+        storage->single_float.value = dbof_get_value_single_float(object);
+        break;
+    case DBOF_TYPE_CHARACTER:
+        storage->character.value = dbof_get_value_character(object);
+        break;
+    default:
+        break;
+    }
+
+    return storage;
+}
+#endif
+
+/**
+ * Internal. Create a new object of the given type, allocating it from the given arena (or the heap if NULL).
+ */
+static dbof_object __new_object(dbof_type type, struct __arena* arena)
+{
+    dbof_object object = NULL;
+
+    switch (type)
+    {
+    case DBOF_TYPE_NULL:
+        object = __new_object_null(arena);
+        break;
+    case DBOF_TYPE_SIGNED_BYTE:
+        object = __new_object_signed_byte(arena);
+        break;
+    case DBOF_TYPE_UNSIGNED_BYTE:
+        object = __new_object_unsigned_byte(arena);
+        break;
+    case DBOF_TYPE_SIGNED_INTEGER:
+        object = __new_object_signed_integer(arena);
+        break;
+    case DBOF_TYPE_UNSIGNED_INTEGER:
+        object = __new_object_unsigned_integer(arena);
+        break;
+    case DBOF_TYPE_SIGNED_LONG_INTEGER:
+        object = __new_object_signed_long_integer(arena);
+        break;
+    case DBOF_TYPE_UNSIGNED_LONG_INTEGER:
+        object = __new_object_unsigned_long_integer(arena);
+        break;
+    case DBOF_TYPE_BOOLEAN:
+        object = __new_object_boolean(arena);
+        break;
+    case DBOF_TYPE_SINGLE_FLOAT:
+        object = __new_object_single_float(arena);
+        break;
+    case DBOF_TYPE_DOUBLE_FLOAT:
+        object = __new_object_double_float(arena);
+        break;
+    case DBOF_TYPE_CHARACTER:
+        object = __new_object_character(arena);
+        break;
+    case DBOF_TYPE_UTF8_STRING:
+        object = __new_object_utf8_string(arena);
+        break;
+    case DBOF_TYPE_TYPED_ARRAY:
+        object = __new_object_typed_array(arena);
+        break;
+    case DBOF_TYPE_UNTYPED_ARRAY:
+        object = __new_object_untyped_array(arena);
+        break;
+    case DBOF_TYPE_TYPED_MAP:
+        object = __new_object_typed_map(arena);
+        break;
+    case DBOF_TYPE_UNTYPED_MAP:
+        object = __new_object_untyped_map(arena);
+        break;
+    }
+
+    if (object == NULL)
+    {
+        object = __new_object_null(arena);
+    }
+
+    return object;
+}
+
+/**
+ * Internal. Get the size of an object of the given type, not counting any storage it points to. Returns zero for
+ * unrecognized types.
+ */
+static size_t __object_size_of(dbof_type type)
+{
+    switch (type)
+    {
+    case DBOF_TYPE_NULL:
+        return sizeof(struct __object_null_impl);
+    case DBOF_TYPE_SIGNED_BYTE:
+        return sizeof(struct __object_signed_byte_impl);
+    case DBOF_TYPE_UNSIGNED_BYTE:
+        return sizeof(struct __object_unsigned_byte_impl);
+    case DBOF_TYPE_SIGNED_INTEGER:
+        return sizeof(struct __object_signed_integer_impl);
+    case DBOF_TYPE_UNSIGNED_INTEGER:
+        return sizeof(struct __object_unsigned_integer_impl);
+    case DBOF_TYPE_SIGNED_LONG_INTEGER:
+        return sizeof(struct __object_signed_long_integer_impl);
+    case DBOF_TYPE_UNSIGNED_LONG_INTEGER:
+        return sizeof(struct __object_unsigned_long_integer_impl);
+    case DBOF_TYPE_BOOLEAN:
+        return sizeof(struct __object_boolean_impl);
+    case DBOF_TYPE_SINGLE_FLOAT:
+        return sizeof(struct __object_single_float_impl);
+    case DBOF_TYPE_DOUBLE_FLOAT:
+        return sizeof(struct __object_double_float_impl);
+    case DBOF_TYPE_CHARACTER:
+        return sizeof(struct __object_character_impl);
+    case DBOF_TYPE_UTF8_STRING:
+        return sizeof(struct __object_utf8_string_impl);
+    case DBOF_TYPE_TYPED_ARRAY:
+        return sizeof(struct __object_typed_array_impl);
+    case DBOF_TYPE_UNTYPED_ARRAY:
+        return sizeof(struct __object_untyped_array_impl);
+    case DBOF_TYPE_TYPED_MAP:
+        return sizeof(struct __object_typed_map_impl);
+    case DBOF_TYPE_UNTYPED_MAP:
+        return sizeof(struct __object_untyped_map_impl);
+    default:
+        return 0;
+    }
+}
+
+dbof_object dbof_new(dbof_type type)
+{ return __new_object(type, NULL); }
+
+dbof_object dbof_new_ex(dbof_type type, dbof_new_ex_params* params)
+{
+    // Objects that quietly ignored their hooks would not behave as asked, so refuse them
+    if (params != NULL && params->hooks != NULL)
+    {
+        // ERROR: Hooks are not supported
+        return NULL;
+    }
+
+    struct __arena* arena = params == NULL ? NULL : params->arena;
+
+    dbof_object object = __new_object(type, arena);
+    if (params == NULL || params->initial_capacity == 0)
+        return object;
+
+    // Make room for the children up front (a failure just leaves it to first use)
+    switch (dbof_typeof(object))
+    {
+    case DBOF_TYPE_TYPED_ARRAY:
+        __object_typed_array_impl_reserve(object, params->initial_capacity);
+        break;
+    case DBOF_TYPE_UNTYPED_ARRAY:
+        __object_untyped_array_impl_reserve(object, params->initial_capacity);
+        break;
+    case DBOF_TYPE_TYPED_MAP:
+        __object_typed_map_impl_reserve(object, params->initial_capacity);
+        break;
+    case DBOF_TYPE_UNTYPED_MAP:
+        __object_untyped_map_impl_reserve(object, params->initial_capacity);
+        break;
+    default:
+        break;
+    }
+
+    return object;
+}
+
+dbof_container_size dbof_capacity_never_shrink(dbof_container_size capacity, dbof_container_size size)
+{
+    (void) size;
+    return capacity;
+}
+
+void dbof_set_capacity_policy(const dbof_capacity_policy* policy)
+{
+    __capacity_policy.grow = policy != NULL && policy->grow != NULL ? policy->grow : __capacity_policy_default_grow;
+    __capacity_policy.shrink = policy != NULL && policy->shrink != NULL ? policy->shrink
+            : __capacity_policy_default_shrink;
+}
+
+//
+// NOTICE
+// Cloning copies object trees natively rather than writing them out and reading them back. Every container is sized
+// once, from its source: arrays get room for exactly their children, and maps get a table of the same capacity, into
+// which the entries go at the very same slots (the stored hash codes of the keys carry over, so no key is hashed or
+// compared). Packed values and string bytes are copied with memcpy(), and cached hash codes carry over as well. The
+// tree is walked with an explicit stack, so documents of any depth are fine. When cloning into an arena, a first pass
+// adds up the memory the copy is going to take, and the arena sets aside a single block for all of it.
+//
+
+/**
+ * A container whose children are being cloned.
+ */
+struct __clone_frame
+{
+    /**
+     * The source container.
+     */
+    dbof_object source;
+
+    /**
+     * The copy of the container.
+     */
+    dbof_object copy;
+
+    /**
+     * The index of the next child (arrays) or slot (maps) to copy.
+     */
+    dbof_container_size index;
+};
+
+/**
+ * Internal. Push an object onto the stack of objects to plan for. Returns zero on success, otherwise nonzero.
+ */
+static int __clone_plan_push(struct __deep_stack* stack, dbof_object object)
+{
+    if (object == NULL || __IS_TAGGED(object))
+        return 0;
+
+    dbof_object* item = __deep_stack_push(stack);
+    if (item == NULL)
+        return -1;
+
+    *item = object;
+    return 0;
+}
+
+/**
+ * Internal. Add up the arena memory a copy of an object tree is going to take. Returns zero on success, otherwise
+ * nonzero.
+ */
+static int __clone_plan(dbof_object object, size_t* out_size)
+{
+    dbof_object local[__DEEP_STACK_LOCAL];
+    struct __deep_stack stack;
+    __deep_stack_init(&stack, local, __DEEP_STACK_LOCAL, sizeof(dbof_object));
+
+    size_t size = 0;
+    int result = __clone_plan_push(&stack, object);
+
+    while (result == 0 && stack.count > 0)
+    {
+        dbof_object next = *(dbof_object*) __deep_stack_top(&stack);
+        stack.count--;
+
+        dbof_type type = dbof_typeof(next);
+        size += __ARENA_ALIGN(__object_size_of(type));
+
+        switch (type)
+        {
+        case DBOF_TYPE_UTF8_STRING:
+        {
+            struct __object_utf8_string_impl* string = next;
+            if (string->value != NULL && string->length > __SMALL_STRING_CAPACITY)
+            {
+                size += __ARENA_ALIGN((size_t) string->length + 1);
+            }
+            break;
+        }
+        case DBOF_TYPE_TYPED_ARRAY:
+        case DBOF_TYPE_UNTYPED_ARRAY:
+        {
+            struct __internal_array_base* array = next;
+            size += __ARENA_ALIGN(array->size * array->element_size);
+
+            if (type == DBOF_TYPE_TYPED_ARRAY && ((struct __object_typed_array_impl*) next)->packed)
+                break;
+
+            for (dbof_container_size i = 0; i < array->size; ++i)
+            {
+                result |= __clone_plan_push(&stack, __internal_array_base_get(array, i));
+            }
+            break;
+        }
+        case DBOF_TYPE_TYPED_MAP:
+        {
+            struct __object_typed_map_impl* map = next;
+            if (__object_typed_map_impl_is_packed(map))
+            {
+                size += __ARENA_ALIGN(map->base.capacity * sizeof(struct __packed_map_slot));
+
+                for (dbof_container_size i = 0; i < map->base.capacity; ++i)
+                {
+                    if (!map->packed_slots[i].used)
+                        continue;
+
+                    if (!map->packed_keys)
+                    {
+                        result |= __clone_plan_push(&stack, map->packed_slots[i].key.object);
+                    }
+                    if (!map->packed_values)
+                    {
+                        result |= __clone_plan_push(&stack, map->packed_slots[i].value.object);
+                    }
+                }
+                break;
+            }
+
+            // Typed maps of other types use the base table
+        }
+        /* fall through */
+        case DBOF_TYPE_UNTYPED_MAP:
+        {
+            struct __internal_map_base* map = next;
+            size += __ARENA_ALIGN(map->capacity * sizeof(struct __map_slot));
+
+            for (dbof_container_size i = 0; i < map->capacity; ++i)
+            {
+                if (map->slots[i].key != NULL)
+                {
+                    result |= __clone_plan_push(&stack, map->slots[i].key);
+                    result |= __clone_plan_push(&stack, map->slots[i].value);
+                }
+            }
+            break;
+        }
+        default:
+            break;
+        }
+    }
+
+    __deep_stack_free(&stack);
+
+    *out_size = size;
+    return result;
+}
+
+/**
+ * Internal. Copy the value of a string into a copy of its object (whose other fields are already copied). Returns zero
+ * on success, otherwise nonzero.
+ */
+static int __clone_string(struct __object_utf8_string_impl* source, struct __object_utf8_string_impl* copy,
+        struct __arena* arena)
+{
+    if (source->value == NULL)
+        return 0;
+
+    if (source->length <= __SMALL_STRING_CAPACITY)
+    {
+        copy->value = copy->small;
+    }
+    else
+    {
+        // Bytes in an arena belong to the arena, so they are borrowed as far as the string is concerned
+        copy->value = arena != NULL ? __arena_alloc(arena, (size_t) source->length + 1)
+                : malloc((size_t) source->length + 1);
+        if (copy->value == NULL)
+        {
+            // ERROR: Out of memory
+            return -1;
+        }
+
+        if (arena != NULL)
+        {
+            copy->base.flags |= __OBJECT_FLAG_BORROWED;
+        }
+    }
+
+    memcpy(copy->value, source->value, source->length);
+    copy->value[source->length] = '\0';
+
+    return 0;
+}
+
+/**
+ * Internal. Give an empty copy of a container the same types and storage as its source, and copy any packed contents.
+ * Objects in the storage are left to the caller. Returns zero on success, otherwise nonzero.
+ */
+static int __clone_container(dbof_object source, dbof_object copy)
+{
+    switch (dbof_typeof(source))
+    {
+    case DBOF_TYPE_TYPED_ARRAY:
+    {
+        struct __object_typed_array_impl* source_array = source;
+        struct __object_typed_array_impl* copy_array = copy;
+
+        __object_typed_array_impl_set_type(copy_array, source_array->type);
+        if (copy_array->type != source_array->type
+                || __internal_array_base_reserve((struct __internal_array_base*) copy_array, source_array->base.size))
+            return -1;
+
+        if (source_array->packed && source_array->base.size > 0)
+        {
+            __object_typed_array_impl_sync_views(source_array);
+            memcpy(copy_array->base.elements, source_array->base.elements,
+                    source_array->base.size * source_array->base.element_size);
+            copy_array->base.size = source_array->base.size;
+        }
+        break;
+    }
+    case DBOF_TYPE_UNTYPED_ARRAY:
+        return __internal_array_base_reserve(copy, ((struct __internal_array_base*) source)->size);
+    case DBOF_TYPE_TYPED_MAP:
+    {
+        struct __object_typed_map_impl* source_map = source;
+        struct __object_typed_map_impl* copy_map = copy;
+
+        __object_typed_map_impl_set_types(copy_map, source_map->key_type, source_map->value_type);
+        if (copy_map->key_type != source_map->key_type || copy_map->value_type != source_map->value_type)
+            return -1;
+
+        if (!__object_typed_map_impl_is_packed(source_map))
+            return source_map->base.capacity > 0
+                    ? __internal_map_base_rehash(copy, source_map->base.capacity) : 0;
+
+        if (source_map->base.capacity == 0)
+            break;
+
+        if (__object_typed_map_impl_rehash(copy_map, source_map->base.capacity))
+            return -1;
+
+        if (source_map->views != NULL)
+        {
+            for (dbof_container_size i = 0; i < source_map->base.capacity; ++i)
+            {
+                __object_typed_map_impl_sync_view(source_map, i);
+            }
+        }
+
+        // The whole table goes over as is, but the objects in it are copied one by one afterward
+        memcpy(copy_map->packed_slots, source_map->packed_slots,
+                source_map->base.capacity * sizeof(struct __packed_map_slot));
+        copy_map->base.size = source_map->base.size;
+
+        for (dbof_container_size i = 0; i < copy_map->base.capacity; ++i)
+        {
+            if (!copy_map->packed_keys)
+            {
+                copy_map->packed_slots[i].key.object = NULL;
+            }
+            if (!copy_map->packed_values)
+            {
+                copy_map->packed_slots[i].value.object = NULL;
+            }
+        }
+        break;
+    }
+    case DBOF_TYPE_UNTYPED_MAP:
+    {
+        struct __internal_map_base* source_map = source;
+        return source_map->capacity > 0 ? __internal_map_base_rehash(copy, source_map->capacity) : 0;
+    }
+    default:
+        break;
+    }
+
+    return 0;
+}
+
+/**
+ * Internal. Determine if a container holds children objects (as opposed to nothing or just packed values).
+ */
+static int __clone_has_children(dbof_object container)
+{
+    switch (dbof_typeof(container))
+    {
+    case DBOF_TYPE_TYPED_ARRAY:
+        if (((struct __object_typed_array_impl*) container)->packed)
+            return 0;
+
+        // Arrays of objects hold children like untyped arrays
+        /* fall through */
+    case DBOF_TYPE_UNTYPED_ARRAY:
+        return ((struct __internal_array_base*) container)->size > 0;
+    case DBOF_TYPE_TYPED_MAP:
+    {
+        struct __object_typed_map_impl* map = container;
+        if (map->packed_keys && map->packed_values)
+            return 0;
+
+        // Other typed maps hold children like untyped maps
+    }
+    /* fall through */
+    case DBOF_TYPE_UNTYPED_MAP:
+        return ((struct __internal_map_base*) container)->size > 0;
+    default:
+        return 0;
+    }
+}
+
+/**
+ * Internal. Copy an object. Containers are copied without their children, and a frame is pushed for copying those.
+ * Returns the copy, or NULL on failure.
+ */
+static dbof_object __clone_shallow(dbof_object source, struct __arena* arena, struct __deep_stack* stack)
+{
+    // Immediate values are their own copies
+    if (source == NULL || __IS_TAGGED(source))
+        return source;
+
+    dbof_type type = dbof_typeof(source);
+
+    if (!dbof_is_container_type(type))
+    {
+        // Take over everything but the common header
+        size_t size = __object_size_of(type);
+        struct __object_impl* copy = __new_empty_object(type, size, arena);
+        if (copy == NULL)
+        {
+            // ERROR: Out of memory
+            return NULL;
+        }
+
+        memcpy((char*) copy + sizeof(struct __object_impl), (char*) source + sizeof(struct __object_impl),
+                size - sizeof(struct __object_impl));
+        copy->flags |= ((struct __object_impl*) source)->flags & __OBJECT_FLAG_HASHED;
+
+        if (type == DBOF_TYPE_UTF8_STRING && __clone_string(source, (struct __object_utf8_string_impl*) copy, arena))
+        {
+            __delete_empty_object(copy);
+            return NULL;
+        }
+
+        return copy;
+    }
+
+    struct __container_impl* copy = __new_object(type, arena);
+    if (copy == NULL || dbof_typeof(copy) != type || __clone_container(source, copy))
+    {
+        // ERROR: Out of memory
+        dbof_delete(copy);
+        return NULL;
+    }
+
+    // The copy will hold the same contents, so the cached hash code is still good
+    if (((struct __object_impl*) source)->flags & __OBJECT_FLAG_HASHED)
+    {
+        copy->hash = ((struct __container_impl*) source)->hash;
+        copy->base.flags |= __OBJECT_FLAG_HASHED;
+    }
+
+    if (__clone_has_children(source))
+    {
+        struct __clone_frame* frame = __deep_stack_push(stack);
+        if (frame == NULL)
+        {
+            dbof_delete(copy);
+            return NULL;
+        }
+
+        frame->source = source;
+        frame->copy = copy;
+        frame->index = 0;
+    }
+
+    return copy;
+}
+
+/**
+ * Internal. Copy the next child of the container on top of the stack, popping it once all are copied. The children
+ * go straight into the storage of the copy, which was set up to take them at the same places. Returns zero on
+ * success, otherwise nonzero.
+ */
+static int __clone_step(struct __deep_stack* stack, struct __arena* arena)
+{
+    // Copying a child may push a frame, so take what we need from this one first
+    struct __clone_frame* frame = __deep_stack_top(stack);
+    dbof_object source = frame->source;
+    dbof_object copy = frame->copy;
+
+    switch (dbof_typeof(source))
+    {
+    case DBOF_TYPE_TYPED_ARRAY:
+    case DBOF_TYPE_UNTYPED_ARRAY:
+    {
+        struct __internal_array_base* source_array = source;
+        struct __internal_array_base* copy_array = copy;
+
+        if (frame->index >= source_array->size)
+            break;
+
+        dbof_container_size index = frame->index++;
+        dbof_object child = __internal_array_base_get(source_array, index);
+
+        dbof_object child_copy = __clone_shallow(child, arena, stack);
+        if (child_copy == NULL && child != NULL)
+            return -1;
+
+        ((dbof_object*) copy_array->elements)[index] = child_copy;
+        copy_array->size = index + 1;
+        __container_adopt(copy_array, child_copy);
+        return 0;
+    }
+    case DBOF_TYPE_TYPED_MAP:
+    {
+        struct __object_typed_map_impl* source_map = source;
+        struct __object_typed_map_impl* copy_map = copy;
+
+        if (__object_typed_map_impl_is_packed(source_map))
+        {
+            while (frame->index < source_map->base.capacity && !source_map->packed_slots[frame->index].used)
+            {
+                frame->index++;
+            }
+
+            if (frame->index >= source_map->base.capacity)
+                break;
+
+            dbof_container_size index = frame->index++;
+
+            if (!source_map->packed_keys)
+            {
+                dbof_object key = __clone_shallow(source_map->packed_slots[index].key.object, arena, stack);
+                if (key == NULL)
+                    return -1;
+
+                copy_map->packed_slots[index].key.object = key;
+                __container_adopt(copy_map, key);
+            }
+            if (!source_map->packed_values)
+            {
+                dbof_object value = __clone_shallow(source_map->packed_slots[index].value.object, arena, stack);
+                if (value == NULL)
+                    return -1;
+
+                copy_map->packed_slots[index].value.object = value;
+                __container_adopt(copy_map, value);
+            }
+            return 0;
+        }
+
+        // Typed maps of other types use the base table
+    }
+    /* fall through */
+    case DBOF_TYPE_UNTYPED_MAP:
+    {
+        struct __internal_map_base* source_map = source;
+        struct __internal_map_base* copy_map = copy;
+
+        while (frame->index < source_map->capacity && source_map->slots[frame->index].key == NULL)
+        {
+            frame->index++;
+        }
+
+        if (frame->index >= source_map->capacity)
+            break;
+
+        dbof_container_size index = frame->index++;
+        struct __map_slot* slot = &source_map->slots[index];
+
+        dbof_object key = __clone_shallow(slot->key, arena, stack);
+        if (key == NULL)
+            return -1;
+
+        dbof_object value = __clone_shallow(slot->value, arena, stack);
+        if (value == NULL && slot->value != NULL)
+        {
+            dbof_delete(key);
+            return -1;
+        }
+
+        copy_map->slots[index].key = key;
+        copy_map->slots[index].value = value;
+        copy_map->slots[index].hash = slot->hash;
+        copy_map->size++;
+
+        __container_adopt(copy_map, key);
+        __container_adopt(copy_map, value);
+        return 0;
+    }
+    default:
+        break;
+    }
+
+    // All children are copied
+    stack->count--;
+    return 0;
+}
+
+dbof_object dbof_clone(dbof_object object)
+{ return dbof_clone_ex(object, NULL); }
+
+dbof_object dbof_clone_ex(dbof_object object, dbof_new_ex_params* params)
+{
+    if (params != NULL && params->hooks != NULL)
+    {
+        // ERROR: Hooks are not supported
+        return NULL;
+    }
+
+    struct __arena* arena = params == NULL ? NULL : params->arena;
+
+    // Set aside one block for the whole copy (if this fails, the copy just spreads over more blocks)
+    size_t size;
+    if (arena != NULL && __clone_plan(object, &size) == 0)
+    {
+        __arena_reserve(arena, size);
+    }
+
+    struct __clone_frame local[__DEEP_STACK_LOCAL];
+    struct __deep_stack stack;
+    __deep_stack_init(&stack, local, __DEEP_STACK_LOCAL, sizeof(struct __clone_frame));
+
+    dbof_object copy = __clone_shallow(object, arena, &stack);
+    int result = copy == NULL && object != NULL;
+
+    while (result == 0 && stack.count > 0)
+    {
+        result = __clone_step(&stack, arena);
+    }
+
+    __deep_stack_free(&stack);
+
+    if (result != 0)
+    {
+        // ERROR: Out of memory
+        dbof_delete(copy);
+        return NULL;
+    }
+
+    return copy;
+}
+
+dbof_object_signed_byte dbof_new_signed_byte(dbof_signed_byte value)
+{ return __new_value(DBOF_TYPE_SIGNED_BYTE, &value, NULL); }
+
+dbof_object_unsigned_byte dbof_new_unsigned_byte(dbof_unsigned_byte value)
+{ return __new_value(DBOF_TYPE_UNSIGNED_BYTE, &value, NULL); }
+
+dbof_object_signed_integer dbof_new_signed_integer(dbof_signed_integer value)
+{ return __new_value(DBOF_TYPE_SIGNED_INTEGER, &value, NULL); }
+
+dbof_object_unsigned_integer dbof_new_unsigned_integer(dbof_unsigned_integer value)
+{ return __new_value(DBOF_TYPE_UNSIGNED_INTEGER, &value, NULL); }
+
+dbof_object_signed_long_integer dbof_new_signed_long_integer(dbof_signed_long_integer value)
+{ return __new_value(DBOF_TYPE_SIGNED_LONG_INTEGER, &value, NULL); }
+
+dbof_object_unsigned_long_integer dbof_new_unsigned_long_integer(dbof_unsigned_long_integer value)
+{ return __new_value(DBOF_TYPE_UNSIGNED_LONG_INTEGER, &value, NULL); }
+
+dbof_object_boolean dbof_new_boolean(dbof_boolean value)
+{ return __new_value(DBOF_TYPE_BOOLEAN, &value, NULL); }
+
+dbof_object_single_float dbof_new_single_float(dbof_single_float value)
+{ return __new_value(DBOF_TYPE_SINGLE_FLOAT, &value, NULL); }
+
+dbof_object_double_float dbof_new_double_float(dbof_double_float value)
+{ return __new_value(DBOF_TYPE_DOUBLE_FLOAT, &value, NULL); }
+
+dbof_object_character dbof_new_character(dbof_character value)
+{ return __new_value(DBOF_TYPE_CHARACTER, &value, NULL); }
+
+dbof_arena dbof_arena_new(size_t block_size)
+{
+    struct __arena* arena = malloc(sizeof(struct __arena));
+
+    if (arena == NULL)
+    {
+        // ERROR: Out of memory
+        return NULL;
+    }
+
+    arena->block_size = block_size == 0 ? DBOF_ARENA_DEFAULT_BLOCK_SIZE : block_size;
+    arena->head = NULL;
+    return arena;
+}
+
+void dbof_arena_delete(dbof_arena arena)
+{
+    if (arena == NULL)
+    {
+        return;
+    }
+
+    dbof_arena_reset(arena);
+
+    // Free the one block kept around by the reset
+    free(((struct __arena*) arena)->head);
+    free(arena);
+}
+
+int dbof_pool_get_stats(dbof_pool_stats* stats)
+{
+#ifdef DBOF_POOL
+    __pool_lock();
+    *stats = __pool_stats;
+    __pool_unlock();
+
+    return 0;
+#else
+    memset(stats, 0, sizeof(dbof_pool_stats));
+    return -1;
+#endif
+}
+
+void dbof_pool_trim()
+{
+#ifdef DBOF_POOL
+    __pool_flush(&__pool_thread_cache);
+
+    // Take the global free lists out of the pool, then free them outside of the lock
+    struct __pool_node* batches[__POOL_TYPES];
+
+    __pool_lock();
+
+    for (int type = 0; type < __POOL_TYPES; ++type)
+    {
+        batches[type] = __pool_global[type];
+
+        __pool_stats.freed += __pool_global_batches[type] * __POOL_BATCH_SIZE;
+        __pool_stats.pooled -= __pool_global_batches[type] * __POOL_BATCH_SIZE;
+
+        __pool_global[type] = NULL;
+        __pool_global_batches[type] = 0;
+    }
+
+    __pool_unlock();
+
+    for (int type = 0; type < __POOL_TYPES; ++type)
+    {
+        while (batches[type] != NULL)
+        {
+            struct __pool_node* next = batches[type]->next_batch;
+            __pool_free_chain(batches[type]);
+            batches[type] = next;
+        }
+    }
+#endif
+}
+
+dbof_intern_pool dbof_intern_pool_new()
+{
+    struct __intern_pool* pool = malloc(sizeof(struct __intern_pool));
+    if (pool == NULL)
+        goto fail;
+
+    pool->capacity = __INTERN_INITIAL_CAPACITY;
+    pool->size = 0;
+    pool->slots = calloc(pool->capacity, sizeof(struct __intern_entry*));
+    pool->arena = dbof_arena_new(0);
+
+    if (pool->slots == NULL || pool->arena == NULL)
+        goto fail_slots;
+
+    return pool;
+
+fail_slots:
+    free(pool->slots);
+    dbof_arena_delete(pool->arena);
+    free(pool);
+
+fail:
+    // ERROR: Out of memory
+    return NULL;
+}
+
+void dbof_intern_pool_delete(dbof_intern_pool pool)
+{
+    struct __intern_pool* pool_impl = (struct __intern_pool*) pool;
+
+    if (pool_impl == NULL)
+    {
+        return;
+    }
+
+    free(pool_impl->slots);
+    dbof_arena_delete(pool_impl->arena);
+    free(pool_impl);
+}
+
+size_t dbof_intern_pool_get_size(dbof_intern_pool pool)
+{ return ((struct __intern_pool*) pool)->size; }
+
+dbof_object_utf8_string dbof_new_interned_utf8_string(dbof_intern_pool pool, const char* value,
+        dbof_string_size length)
+{
+    struct __intern_entry* entry = __intern_pool_intern(pool, value, length);
+    if (entry == NULL)
+    {
+        // ERROR: Out of memory
+        return NULL;
+    }
+
+    struct __object_utf8_string_impl* string = __new_object_utf8_string(NULL);
+    if (string == NULL)
+    {
+        // ERROR: Out of memory
+        return NULL;
+    }
+
+    __intern_string(string, entry);
+    return string;
+}
+
+void dbof_arena_reset(dbof_arena arena)
+{
+    struct __arena* arena_impl = (struct __arena*) arena;
+
+    if (arena_impl->head == NULL)
+    {
+        return;
+    }
+
+    // Free every block but the head, which we keep for reuse
+    struct __arena_block* block = arena_impl->head->next;
+    while (block != NULL)
+    {
+        struct __arena_block* next = block->next;
+        free(block);
+        block = next;
+    }
+
+    arena_impl->head->next = NULL;
+    arena_impl->head->used = 0;
+}
+
+void dbof_delete(dbof_object object)
+{
+    // Immediate values own no memory
+    if (object == NULL || __IS_TAGGED(object))
+    {
+        return;
+    }
+
+    // Only the last reference deletes the object (a count of zero means this is the only one)
+    uint32_t* refs = &((struct __object_impl*) object)->refs;
+    if (__refs_load(refs) != 0 && __refs_decrement(refs) != 0)
+    {
+        return;
+    }
+
+    switch (dbof_typeof(object))
+    {
+    case DBOF_TYPE_NULL:
+        __delete_object_null(object);
+        break;
+    case DBOF_TYPE_SIGNED_BYTE:
+        __delete_object_signed_byte(object);
+        break;
+    case DBOF_TYPE_UNSIGNED_BYTE:
+        __delete_object_unsigned_byte(object);
+        break;
+    case DBOF_TYPE_SIGNED_INTEGER:
+        __delete_object_signed_integer(object);
+        break;
+    case DBOF_TYPE_UNSIGNED_INTEGER:
+        __delete_object_unsigned_integer(object);
+        break;
+    case DBOF_TYPE_SIGNED_LONG_INTEGER:
+        __delete_object_signed_long_integer(object);
+        break;
+    case DBOF_TYPE_UNSIGNED_LONG_INTEGER:
+        __delete_object_unsigned_long_integer(object);
+        break;
+    case DBOF_TYPE_BOOLEAN:
+        __delete_object_boolean(object);
+        break;
+    case DBOF_TYPE_SINGLE_FLOAT:
+        __delete_object_single_float(object);
+        break;
+    case DBOF_TYPE_DOUBLE_FLOAT:
+        __delete_object_double_float(object);
+        break;
+    case DBOF_TYPE_CHARACTER:
+        __delete_object_character(object);
+        break;
+    case DBOF_TYPE_UTF8_STRING:
+        __delete_object_utf8_string(object);
+        break;
+    case DBOF_TYPE_TYPED_ARRAY:
+        __delete_object_typed_array(object);
+        break;
+    case DBOF_TYPE_UNTYPED_ARRAY:
+        __delete_object_untyped_array(object);
+        break;
+    case DBOF_TYPE_TYPED_MAP:
+        __delete_object_typed_map(object);
+        break;
+    case DBOF_TYPE_UNTYPED_MAP:
+        __delete_object_untyped_map(object);
+        break;
+    }
+}
+
+dbof_object dbof_retain(dbof_object object)
+{
+    if (object != NULL && !__IS_TAGGED(object))
+    {
+        __refs_increment(&((struct __object_impl*) object)->refs);
+    }
+
+    return object;
+}
+
+void dbof_release(dbof_object object)
+{ dbof_delete(object); }
+
+/**
+ * Internal. Push an object onto the stack of objects to freeze, unless it needs no freezing. Returns zero on success,
+ * otherwise nonzero.
+ */
+static int __freeze_push(struct __deep_stack* stack, dbof_object object)
+{
+    if (object == NULL || !__is_mutable(object))
+        return 0;
+
+    dbof_object* item = __deep_stack_push(stack);
+    if (item == NULL)
+        return -1;
+
+    *item = object;
+    return 0;
+}
+
+/**
+ * Internal. Freeze a single object and push its children. Container keys are also pushed to the keys stack, as the
+ * hash codes of map keys are not part of the hash code of the map. Returns zero on success, otherwise nonzero.
+ */
+static int __freeze_one(struct __deep_stack* stack, struct __deep_stack* keys, dbof_object object)
+{
+    int result = 0;
+
+    switch (dbof_typeof(object))
+    {
+    case DBOF_TYPE_UTF8_STRING:
+        // Do the lazy work of strings now, as frozen strings must never be written
+        dbof_get_value_utf8_string(object);
+        __hash_object_utf8_string(object);
+        break;
+    case DBOF_TYPE_TYPED_ARRAY:
+        if (((struct __object_typed_array_impl*) object)->packed)
+        {
+            result |= __object_typed_array_impl_freeze_views(object);
+            break;
+        }
+
+        // Arrays of objects are frozen like untyped arrays
+        /* fall through */
+    case DBOF_TYPE_UNTYPED_ARRAY:
+    {
+        struct __internal_array_base* array = object;
+
+        // Children shared with snapshots are copied first, so the snapshots keep theirs mutable
+        if (dbof_typeof(object) == DBOF_TYPE_UNTYPED_ARRAY && __object_untyped_array_impl_own_children(object))
+        {
+            result = -1;
+        }
+
+        for (dbof_container_size i = 0; i < array->size; ++i)
+        {
+            result |= __freeze_push(stack, __internal_array_base_get(array, i));
+        }
+        break;
+    }
+    case DBOF_TYPE_TYPED_MAP:
+    {
+        struct __object_typed_map_impl* map = object;
+        __object_typed_map_impl_freeze_views(map);
+
+        if (__object_typed_map_impl_is_packed(map))
+        {
+            for (dbof_container_size i = 0; i < map->base.capacity; ++i)
+            {
+                if (!map->packed_slots[i].used)
+                    continue;
+
+                if (!map->packed_keys)
+                {
+                    result |= __freeze_push(stack, map->packed_slots[i].key.object);
+                }
+                if (!map->packed_values)
+                {
+                    result |= __freeze_push(stack, map->packed_slots[i].value.object);
+                }
+            }
+            break;
+        }
+
+        // Typed maps of other types use the base table
+    }
+    /* fall through */
+    case DBOF_TYPE_UNTYPED_MAP:
+    {
+        struct __internal_map_base* map = object;
+        for (dbof_container_size i = 0; i < map->capacity; ++i)
+        {
+            dbof_object key = map->slots[i].key;
+            if (key == NULL)
+                continue;
+
+            if (__is_mutable(key) && dbof_is_container_type(dbof_typeof(key)))
+            {
+                result |= __freeze_push(keys, key);
+            }
+
+            result |= __freeze_push(stack, key);
+            result |= __freeze_push(stack, map->slots[i].value);
+        }
+        break;
+    }
+    default:
+        break;
+    }
+
+    ((struct __object_impl*) object)->flags |= __OBJECT_FLAG_FROZEN;
+    return result;
+}
+
+int dbof_freeze(dbof_object object)
+{
+    dbof_object local[__DEEP_STACK_LOCAL];
+    struct __deep_stack stack;
+    __deep_stack_init(&stack, local, __DEEP_STACK_LOCAL, sizeof(dbof_object));
+
+    dbof_object keys_local[__DEEP_STACK_LOCAL];
+    struct __deep_stack keys;
+    __deep_stack_init(&keys, keys_local, __DEEP_STACK_LOCAL, sizeof(dbof_object));
+
+    int result = __freeze_push(&stack, object);
+
+    while (stack.count > 0)
+    {
+        dbof_object next = *(dbof_object*) __deep_stack_top(&stack);
+        stack.count--;
+
+        // The same object may be reached twice through objects shared below
+        if (__is_mutable(next))
+        {
+            result |= __freeze_one(&stack, &keys, next);
+        }
+    }
+
+    // Cache the hash codes of all containers for good (hashing the root reaches all but those of container keys)
+    if (object != NULL && !__IS_TAGGED(object) && dbof_is_container_type(dbof_typeof(object)))
+    {
+        dbof_hash(object);
+    }
+
+    for (size_t i = 0; i < keys.count; ++i)
+    {
+        dbof_hash(((dbof_object*) keys.items)[i]);
+    }
+
+    __deep_stack_free(&stack);
+    __deep_stack_free(&keys);
+
+    // ERROR: Out of memory (part of the tree may be left unfrozen)
+    return result;
+}
+
+int dbof_is_frozen(dbof_object object)
+{ return object != NULL && !__is_mutable(object); }
+
+int dbof_hash(dbof_object object)
+{
+    // Return zero for null inputs
+    if (object == NULL)
+    {
+        return 0;
+    }
+
+#ifdef __TAGGED_VALUES
+    union __tagged_value_storage storage;
+    object = __untag_value(object, &storage);
+#endif
+
+    switch (dbof_typeof(object))
+    {
+    case DBOF_TYPE_NULL:
+        return __hash_object_null(object);
+    case DBOF_TYPE_SIGNED_BYTE:
+        return __hash_object_signed_byte(object);
+    case DBOF_TYPE_UNSIGNED_BYTE:
+        return __hash_object_unsigned_byte(object);
+    case DBOF_TYPE_SIGNED_INTEGER:
+        return __hash_object_signed_integer(object);
+    case DBOF_TYPE_UNSIGNED_INTEGER:
+        return __hash_object_unsigned_integer(object);
+    case DBOF_TYPE_SIGNED_LONG_INTEGER:
+        return __hash_object_signed_long_integer(object);
+    case DBOF_TYPE_UNSIGNED_LONG_INTEGER:
+        return __hash_object_unsigned_long_integer(object);
+    case DBOF_TYPE_BOOLEAN:
+        return __hash_object_boolean(object);
+    case DBOF_TYPE_SINGLE_FLOAT:
+        return __hash_object_single_float(object);
+    case DBOF_TYPE_DOUBLE_FLOAT:
+        return __hash_object_double_float(object);
+    case DBOF_TYPE_CHARACTER:
+        return __hash_object_character(object);
+    case DBOF_TYPE_UTF8_STRING:
+        return __hash_object_utf8_string(object);
+    case DBOF_TYPE_TYPED_ARRAY:
+        return __hash_object_typed_array(object);
+    case DBOF_TYPE_UNTYPED_ARRAY:
+        return __hash_object_untyped_array(object);
+    case DBOF_TYPE_TYPED_MAP:
+        return __hash_object_typed_map(object);
+    case DBOF_TYPE_UNTYPED_MAP:
+        return __hash_object_untyped_map(object);
+    default:
+        return 0;
+    }
+}
+
+void dbof_hash_invalidate(dbof_object object)
+{
+    // Frozen objects never change, so the cached hash codes above them stay valid
+    if (object == NULL || !__is_mutable(object))
+        return;
+
+    // Only containers cache their own hash codes, but values are part of those of the containers above them
+    if (dbof_is_container_type(dbof_typeof(object)))
+    {
+        __container_invalidate_hash(object);
+    }
+    else
+    {
+        __value_invalidate_hash(object);
+    }
+}
+
+int dbof_equals(dbof_object a, dbof_object b)
+{
+    // If at least one is null, they can only be equal if the other is also null
+    // This is not defined in the specification
+    if (a == NULL || b == NULL)
+    {
+        return a == b;
+    }
+
+    // Value types and container types can never be equal
+    if (!dbof_same_category(a, b))
+    {
+        return 0;
+    }
+
+    dbof_type type_a = dbof_typeof(a);
+    dbof_type type_b = dbof_typeof(b);
+
+    // If a and b are different types of containers, they cannot be equal
+    // We only need to test one type, as we know both types must be of the same category by now
+    if (dbof_is_container_type(type_a))
+    {
+        if (type_a != type_b)
+        {
+            return 0;
+        }
+
+        // Both are the same type of container, so compare their contents
+        return __equals_container_internal(a, b);
+    }
+
+    // At this stage, we know that a and b are both value objects
+
+    // Value objects of different types are never equal
+    if (type_a != type_b)
+    {
+        return 0;
+    }
+
+#ifdef __TAGGED_VALUES
+    union __tagged_value_storage storage_a;
+    union __tagged_value_storage storage_b;
+    a = __untag_value(a, &storage_a);
+    b = __untag_value(b, &storage_b);
+#endif
+
+    switch (type_a)
+    {
+    case DBOF_TYPE_NULL:
+        return __equals_object_null(a, b);
+    case DBOF_TYPE_SIGNED_BYTE:
+        return __equals_object_signed_byte(a, b);
+    case DBOF_TYPE_UNSIGNED_BYTE:
+        return __equals_object_unsigned_byte(a, b);
+    case DBOF_TYPE_SIGNED_INTEGER:
+        return __equals_object_signed_integer(a, b);
+    case DBOF_TYPE_UNSIGNED_INTEGER:
+        return __equals_object_unsigned_integer(a, b);
+    case DBOF_TYPE_SIGNED_LONG_INTEGER:
+        return __equals_object_signed_long_integer(a, b);
+    case DBOF_TYPE_UNSIGNED_LONG_INTEGER:
+        return __equals_object_unsigned_long_integer(a, b);
+    case DBOF_TYPE_BOOLEAN:
+        return __equals_object_boolean(a, b);
+    case DBOF_TYPE_SINGLE_FLOAT:
+        return __equals_object_single_float(a, b);
+    case DBOF_TYPE_DOUBLE_FLOAT:
+        return __equals_object_double_float(a, b);
+    case DBOF_TYPE_CHARACTER:
+        return __equals_object_character(a, b);
+    case DBOF_TYPE_UTF8_STRING:
+        return __equals_object_utf8_string(a, b);
+    default:
+        // Containers are handled above
+        return 0;
+    }
+}
+
+dbof_signed_byte dbof_get_value_signed_byte(dbof_object_signed_byte object)
+{
+    if (__IS_TAGGED(object))
+        return (dbof_signed_byte) __TAGGED_PAYLOAD(object);
+
+    return ((struct __object_signed_byte_impl*) object)->value;
+}
+
+void dbof_set_value_signed_byte(dbof_object_signed_byte object, dbof_signed_byte value)
+{
+    // Neither immediate values nor frozen objects can be changed in place
+    if (__is_mutable(object))
+    {
+        ((struct __object_signed_byte_impl*) object)->value = value;
+        __value_invalidate_hash(object);
+    }
+}
+
+dbof_unsigned_byte dbof_get_value_unsigned_byte(dbof_object_unsigned_byte object)
+{
+    if (__IS_TAGGED(object))
+        return (dbof_unsigned_byte) __TAGGED_PAYLOAD(object);
+
+    return ((struct __object_unsigned_byte_impl*) object)->value;
+}
+
+void dbof_set_value_unsigned_byte(dbof_object_unsigned_byte object, dbof_unsigned_byte value)
+{
+    if (__is_mutable(object))
+    {
+        ((struct __object_unsigned_byte_impl*) object)->value = value;
+        __value_invalidate_hash(object);
+    }
+}
+
+dbof_signed_integer dbof_get_value_signed_integer(dbof_object_signed_integer object)
+{
+    if (__IS_TAGGED(object))
+        return (dbof_signed_integer) __TAGGED_PAYLOAD(object);
+
+    return ((struct __object_signed_integer_impl*) object)->value;
+}
+
+void dbof_set_value_signed_integer(dbof_object_signed_integer object, dbof_signed_integer value)
+{
+    if (__is_mutable(object))
+    {
+        ((struct __object_signed_integer_impl*) object)->value = value;
+        __value_invalidate_hash(object);
+    }
+}
+
+dbof_unsigned_integer dbof_get_value_unsigned_integer(dbof_object_unsigned_integer object)
+{
+    if (__IS_TAGGED(object))
+        return __TAGGED_PAYLOAD(object);
+
+    return ((struct __object_unsigned_integer_impl*) object)->value;
+}
+
+void dbof_set_value_unsigned_integer(dbof_object_unsigned_integer object, dbof_unsigned_integer value)
+{
+    if (__is_mutable(object))
+    {
+        ((struct __object_unsigned_integer_impl*) object)->value = value;
+        __value_invalidate_hash(object);
+    }
+}
+
+dbof_signed_long_integer dbof_get_value_signed_long_integer(dbof_object_signed_long_integer object)
+{ return ((struct __object_signed_long_integer_impl*) object)->value; }
+
+void dbof_set_value_signed_long_integer(dbof_object_signed_long_integer object, dbof_signed_long_integer value)
+{
+    if (__is_mutable(object))
+    {
+        ((struct __object_signed_long_integer_impl*) object)->value = value;
+        __value_invalidate_hash(object);
+    }
+}
+
+dbof_unsigned_long_integer dbof_get_value_unsigned_long_integer(dbof_object_unsigned_long_integer object)
+{ return ((struct __object_unsigned_long_integer_impl*) object)->value; }
+
+void dbof_set_value_unsigned_long_integer(dbof_object_unsigned_long_integer object, dbof_unsigned_long_integer value)
+{
+    if (__is_mutable(object))
+    {
+        ((struct __object_unsigned_long_integer_impl*) object)->value = value;
+        __value_invalidate_hash(object);
+    }
+}
+
+dbof_boolean dbof_get_value_boolean(dbof_object_boolean object)
+{
+    if (__IS_TAGGED(object))
+        return (dbof_boolean) __TAGGED_PAYLOAD(object);
+
+    return ((struct __object_boolean_impl*) object)->value;
+}
+
+void dbof_set_value_boolean(dbof_object_boolean object, dbof_boolean value)
+{
+    if (__is_mutable(object))
+    {
+        ((struct __object_boolean_impl*) object)->value = value;
+        __value_invalidate_hash(object);
+    }
+}
+
+dbof_single_float dbof_get_value_single_float(dbof_object_single_float object)
+{
+    if (__IS_TAGGED(object))
+    {
+        uint32_t payload = __TAGGED_PAYLOAD(object);
+
+        dbof_single_float value;
+        memcpy(&value, &payload, sizeof(value));
+        return value;
+    }
+
+    return ((struct __object_single_float_impl*) object)->value;
+}
+
+void dbof_set_value_single_float(dbof_object_single_float object, dbof_single_float value)
+{
+    if (__is_mutable(object))
+    {
+        ((struct __object_single_float_impl*) object)->value = value;
+        __value_invalidate_hash(object);
+    }
+}
+
+dbof_double_float dbof_get_value_double_float(dbof_object_double_float object)
+{ return ((struct __object_double_float_impl*) object)->value; }
+
+void dbof_set_value_double_float(dbof_object_double_float object, dbof_double_float value)
+{
+    if (__is_mutable(object))
+    {
+        ((struct __object_double_float_impl*) object)->value = value;
+        __value_invalidate_hash(object);
+    }
+}
+
+dbof_character dbof_get_value_character(dbof_object_character object)
+{
+    if (__IS_TAGGED(object))
+        return __TAGGED_PAYLOAD(object);
+
+    return ((struct __object_character_impl*) object)->value;
+}
+
+void dbof_set_value_character(dbof_object_character object, dbof_character value)
+{
+    if (__is_mutable(object))
+    {
+        ((struct __object_character_impl*) object)->value = value;
+        __value_invalidate_hash(object);
+    }
+}
+
+dbof_utf8_string dbof_get_value_utf8_string(dbof_object_utf8_string object)
+{
+    struct __object_utf8_string_impl* string = (struct __object_utf8_string_impl*) object;
+
+    // A view into a read buffer has no null terminator, so it gets copied out the first time someone wants a C string
+    if (string->base.flags & __OBJECT_FLAG_UNTERMINATED)
+    {
+        char* val = string->length <= __SMALL_STRING_CAPACITY ? string->small : malloc(string->length + 1);
+        if (val == NULL)
+        {
+            // ERROR: Out of memory
+            return NULL;
+        }
+
+        memcpy(val, string->value, string->length);
+        val[string->length] = '\0';
+
+        string->value = val;
+        string->base.flags &= ~(__OBJECT_FLAG_BORROWED | __OBJECT_FLAG_UNTERMINATED);
+    }
+
+    return string->value;
+}
+
+dbof_string_size dbof_get_value_utf8_string_length(dbof_object_utf8_string object)
+{ return ((struct __object_utf8_string_impl*) object)->length; }
+
+const char* dbof_get_value_utf8_string_data(dbof_object_utf8_string object)
+{ return ((struct __object_utf8_string_impl*) object)->value; }
+
+const char* dbof_get_value_utf8_string_n(dbof_object_utf8_string object, dbof_string_size* length)
+{
+    struct __object_utf8_string_impl* string = (struct __object_utf8_string_impl*) object;
+
+    *length = string->length;
+    return string->value;
+}
+
+void dbof_set_value_utf8_string(dbof_object_utf8_string object, dbof_utf8_string value)
+{ dbof_set_value_utf8_string_n(object, value, value == NULL ? 0 : strlen(value)); }
+
+void dbof_set_value_utf8_string_n(dbof_object_utf8_string object, const char* value, dbof_string_size length)
+{
+    struct __object_utf8_string_impl* string = (struct __object_utf8_string_impl*) object;
+
+    // ERROR: A frozen string cannot be changed
+    if (__is_frozen(string))
+        return;
+
+    // Only the small buffer and heap memory of our own may be written to (borrowed bytes must be moved out first)
+    int small = string->value == string->small;
+    int owned = string->value != NULL && !small && !(string->base.flags & __OBJECT_FLAG_BORROWED);
+
+    // The new value may well be (part of) the old one, so all copies below use memmove()
+
+    // If new and old lengths are equal, just copy the new value in
+    if (length == string->length && (small || owned))
+    {
+        // The null terminator will be preserved
+        memmove(string->value, value, length);
+        string->base.flags &= ~__OBJECT_FLAG_HASHED;
+        __value_invalidate_hash(string);
+        return;
+    }
+
+    // Short values go inline, longer ones to the heap
+    // NONE OF WHAT FOLLOWS IS ATOMIC. ONE THREAD AT A TIME, PLEASE.
+    char* val = length <= __SMALL_STRING_CAPACITY ? string->small : malloc(length + 1);
+    if (val == NULL)
+    {
+        // ERROR: Allocation failed. Out of memory?
+        // Failure state: The original string has not been modified
+        return;
+    }
+
+    // Copy in the new value
+    if (length > 0)
+    {
+        memmove(val, value, length);
+    }
+
+    val[length] = '\0';
+
+    // Only now that the new value is copied can the old memory go
+    if (owned)
+    {
+        free(string->value);
+    }
+
+    string->value = val;
+    string->length = length;
+    string->base.flags &= ~(__OBJECT_FLAG_BORROWED | __OBJECT_FLAG_UNTERMINATED | __OBJECT_FLAG_HASHED);
+    __value_invalidate_hash(string);
+}
+
+// The aliases are defined inline in the header, too (see the notice on the type functions)
+
+extern const char* dbof_get_value_string_n(dbof_object_string object, dbof_string_size* length);
+
+extern void dbof_set_value_string_n(dbof_object_string object, const char* value, dbof_string_size length);
+
+dbof_container_size dbof_typed_array_get_capacity(dbof_object_typed_array array)
+{ return __object_typed_array_impl_get_capacity(array); }
+
+dbof_container_size dbof_typed_array_get_size(dbof_object_typed_array array)
+{ return __object_typed_array_impl_get_size(array); }
+
+int dbof_typed_array_is_empty(dbof_object_typed_array array)
+{ return __object_typed_array_impl_is_empty(array); }
+
+dbof_type dbof_typed_array_get_type(dbof_object_typed_array array)
+{ return __object_typed_array_impl_get_type(array); }
+
+void dbof_typed_array_set_type(dbof_object_typed_array array, dbof_type type)
+{ __object_typed_array_impl_set_type(array, type); }
+
+void dbof_typed_array_shrink_to_fit(dbof_object_typed_array array)
+{ __object_typed_array_impl_shrink_to_fit(array); }
+
+int dbof_typed_array_reserve(dbof_object_typed_array array, dbof_container_size capacity)
+{ return __object_typed_array_impl_reserve(array, capacity); }
+
+dbof_object dbof_typed_array_get(dbof_object_typed_array array, dbof_container_size index)
+{ return __object_typed_array_impl_get(array, index); }
+
+void dbof_typed_array_set(dbof_object_typed_array array, dbof_container_size index, dbof_object object)
+{ return __object_typed_array_impl_set(array, index, object); }
+
+void dbof_typed_array_insert(dbof_object_typed_array array, dbof_container_size index, dbof_object object)
+{ __object_typed_array_impl_insert(array, index, object); }
+
+dbof_object dbof_typed_array_remove(dbof_object_typed_array array, dbof_container_size index)
+{ return __object_typed_array_impl_remove(array, index); }
+
+void dbof_typed_array_push_back(dbof_object_typed_array array, dbof_object object)
+{ __object_typed_array_impl_push_back(array, object); }
+
+dbof_object dbof_typed_array_pop_back(dbof_object_typed_array array)
+{ return __object_typed_array_impl_pop_back(array); }
+
+void* dbof_typed_array_data(dbof_object_typed_array array)
+{ return __object_typed_array_impl_data(array); }
+
+dbof_signed_byte dbof_typed_array_get_signed_byte_at(dbof_object_typed_array array, dbof_container_size index)
+{
+    dbof_signed_byte* value = __object_typed_array_impl_read_at(array, index, DBOF_TYPE_SIGNED_BYTE);
+    return value == NULL ? 0 : *value;
+}
+
+void dbof_typed_array_set_signed_byte_at(dbof_object_typed_array array, dbof_container_size index,
+        dbof_signed_byte value)
+{ __object_typed_array_impl_write_at(array, index, DBOF_TYPE_SIGNED_BYTE, &value); }
+
+void dbof_typed_array_push_back_signed_byte(dbof_object_typed_array array, dbof_signed_byte value)
+{
+    dbof_signed_byte* slot = __object_typed_array_impl_push_back_value(array, DBOF_TYPE_SIGNED_BYTE);
+    if (slot != NULL)
+    {
+        *slot = value;
+    }
+}
+
+dbof_unsigned_byte dbof_typed_array_get_unsigned_byte_at(dbof_object_typed_array array, dbof_container_size index)
+{
+    dbof_unsigned_byte* value = __object_typed_array_impl_read_at(array, index, DBOF_TYPE_UNSIGNED_BYTE);
+    return value == NULL ? 0 : *value;
+}
+
+void dbof_typed_array_set_unsigned_byte_at(dbof_object_typed_array array, dbof_container_size index,
+        dbof_unsigned_byte value)
+{ __object_typed_array_impl_write_at(array, index, DBOF_TYPE_UNSIGNED_BYTE, &value); }
+
+void dbof_typed_array_push_back_unsigned_byte(dbof_object_typed_array array, dbof_unsigned_byte value)
+{
+    dbof_unsigned_byte* slot = __object_typed_array_impl_push_back_value(array, DBOF_TYPE_UNSIGNED_BYTE);
+    if (slot != NULL)
+    {
+        *slot = value;
+    }
+}
+
+dbof_signed_integer dbof_typed_array_get_signed_integer_at(dbof_object_typed_array array, dbof_container_size index)
+{
+    dbof_signed_integer* value = __object_typed_array_impl_read_at(array, index, DBOF_TYPE_SIGNED_INTEGER);
+    return value == NULL ? 0 : *value;
+}
+
+void dbof_typed_array_set_signed_integer_at(dbof_object_typed_array array, dbof_container_size index,
+        dbof_signed_integer value)
+{ __object_typed_array_impl_write_at(array, index, DBOF_TYPE_SIGNED_INTEGER, &value); }
+
+void dbof_typed_array_push_back_signed_integer(dbof_object_typed_array array, dbof_signed_integer value)
+{
+    dbof_signed_integer* slot = __object_typed_array_impl_push_back_value(array, DBOF_TYPE_SIGNED_INTEGER);
+    if (slot != NULL)
+    {
+        *slot = value;
+    }
+}
+
+dbof_unsigned_integer dbof_typed_array_get_unsigned_integer_at(dbof_object_typed_array array, dbof_container_size index)
+{
+    dbof_unsigned_integer* value = __object_typed_array_impl_read_at(array, index, DBOF_TYPE_UNSIGNED_INTEGER);
+    return value == NULL ? 0 : *value;
+}
+
+void dbof_typed_array_set_unsigned_integer_at(dbof_object_typed_array array, dbof_container_size index,
+        dbof_unsigned_integer value)
+{ __object_typed_array_impl_write_at(array, index, DBOF_TYPE_UNSIGNED_INTEGER, &value); }
+
+void dbof_typed_array_push_back_unsigned_integer(dbof_object_typed_array array, dbof_unsigned_integer value)
+{
+    dbof_unsigned_integer* slot = __object_typed_array_impl_push_back_value(array, DBOF_TYPE_UNSIGNED_INTEGER);
+    if (slot != NULL)
+    {
+        *slot = value;
+    }
+}
+
+dbof_signed_long_integer dbof_typed_array_get_signed_long_integer_at(dbof_object_typed_array array,
+        dbof_container_size index)
+{
+    dbof_signed_long_integer* value = __object_typed_array_impl_read_at(array, index, DBOF_TYPE_SIGNED_LONG_INTEGER);
+    return value == NULL ? 0 : *value;
+}
+
+void dbof_typed_array_set_signed_long_integer_at(dbof_object_typed_array array, dbof_container_size index,
+        dbof_signed_long_integer value)
+{ __object_typed_array_impl_write_at(array, index, DBOF_TYPE_SIGNED_LONG_INTEGER, &value); }
+
+void dbof_typed_array_push_back_signed_long_integer(dbof_object_typed_array array, dbof_signed_long_integer value)
+{
+    dbof_signed_long_integer* slot = __object_typed_array_impl_push_back_value(array, DBOF_TYPE_SIGNED_LONG_INTEGER);
+    if (slot != NULL)
+    {
+        *slot = value;
+    }
+}
+
+dbof_unsigned_long_integer dbof_typed_array_get_unsigned_long_integer_at(dbof_object_typed_array array,
+        dbof_container_size index)
+{
+    dbof_unsigned_long_integer* value = __object_typed_array_impl_read_at(array, index,
+            DBOF_TYPE_UNSIGNED_LONG_INTEGER);
+    return value == NULL ? 0 : *value;
+}
+
+void dbof_typed_array_set_unsigned_long_integer_at(dbof_object_typed_array array, dbof_container_size index,
+        dbof_unsigned_long_integer value)
+{ __object_typed_array_impl_write_at(array, index, DBOF_TYPE_UNSIGNED_LONG_INTEGER, &value); }
+
+void dbof_typed_array_push_back_unsigned_long_integer(dbof_object_typed_array array, dbof_unsigned_long_integer value)
+{
+    dbof_unsigned_long_integer* slot = __object_typed_array_impl_push_back_value(array,
+            DBOF_TYPE_UNSIGNED_LONG_INTEGER);
+    if (slot != NULL)
+    {
+        *slot = value;
+    }
+}
+
+dbof_boolean dbof_typed_array_get_boolean_at(dbof_object_typed_array array, dbof_container_size index)
+{
+    dbof_boolean* value = __object_typed_array_impl_read_at(array, index, DBOF_TYPE_BOOLEAN);
+    return value == NULL ? 0 : *value;
+}
+
+void dbof_typed_array_set_boolean_at(dbof_object_typed_array array, dbof_container_size index, dbof_boolean value)
+{ __object_typed_array_impl_write_at(array, index, DBOF_TYPE_BOOLEAN, &value); }
+
+void dbof_typed_array_push_back_boolean(dbof_object_typed_array array, dbof_boolean value)
+{
+    dbof_boolean* slot = __object_typed_array_impl_push_back_value(array, DBOF_TYPE_BOOLEAN);
+    if (slot != NULL)
+    {
+        *slot = value;
+    }
+}
+
+dbof_single_float dbof_typed_array_get_single_float_at(dbof_object_typed_array array, dbof_container_size index)
+{
+    dbof_single_float* value = __object_typed_array_impl_read_at(array, index, DBOF_TYPE_SINGLE_FLOAT);
+    return value == NULL ? 0 : *value;
+}
+
+void dbof_typed_array_set_single_float_at(dbof_object_typed_array array, dbof_container_size index,
+        dbof_single_float value)
+{ __object_typed_array_impl_write_at(array, index, DBOF_TYPE_SINGLE_FLOAT, &value); }
+
+void dbof_typed_array_push_back_single_float(dbof_object_typed_array array, dbof_single_float value)
+{
+    dbof_single_float* slot = __object_typed_array_impl_push_back_value(array, DBOF_TYPE_SINGLE_FLOAT);
+    if (slot != NULL)
+    {
+        *slot = value;
+    }
+}
+
+dbof_double_float dbof_typed_array_get_double_float_at(dbof_object_typed_array array, dbof_container_size index)
+{
+    dbof_double_float* value = __object_typed_array_impl_read_at(array, index, DBOF_TYPE_DOUBLE_FLOAT);
+    return value == NULL ? 0 : *value;
+}
+
+void dbof_typed_array_set_double_float_at(dbof_object_typed_array array, dbof_container_size index,
+        dbof_double_float value)
+{ __object_typed_array_impl_write_at(array, index, DBOF_TYPE_DOUBLE_FLOAT, &value); }
+
+void dbof_typed_array_push_back_double_float(dbof_object_typed_array array, dbof_double_float value)
+{
+    dbof_double_float* slot = __object_typed_array_impl_push_back_value(array, DBOF_TYPE_DOUBLE_FLOAT);
+    if (slot != NULL)
+    {
+        *slot = value;
+    }
+}
+
+dbof_character dbof_typed_array_get_character_at(dbof_object_typed_array array, dbof_container_size index)
+{
+    dbof_character* value = __object_typed_array_impl_read_at(array, index, DBOF_TYPE_CHARACTER);
+    return value == NULL ? 0 : *value;
+}
+
+void dbof_typed_array_set_character_at(dbof_object_typed_array array, dbof_container_size index, dbof_character value)
+{ __object_typed_array_impl_write_at(array, index, DBOF_TYPE_CHARACTER, &value); }
+
+void dbof_typed_array_push_back_character(dbof_object_typed_array array, dbof_character value)
+{
+    dbof_character* slot = __object_typed_array_impl_push_back_value(array, DBOF_TYPE_CHARACTER);
+    if (slot != NULL)
+    {
+        *slot = value;
+    }
+}
+
+dbof_container_size dbof_untyped_array_get_capacity(dbof_object_untyped_array array)
+{ return __object_untyped_array_impl_get_capacity(array); }
+
+dbof_container_size dbof_untyped_array_get_size(dbof_object_untyped_array array)
+{ return __object_untyped_array_impl_get_size(array); }
+
+int dbof_untyped_array_is_empty(dbof_object_untyped_array map)
+{ return __object_untyped_array_impl_is_empty(map); }
+
+void dbof_untyped_array_shrink_to_fit(dbof_object_untyped_array array)
+{ __object_untyped_array_impl_shrink_to_fit(array); }
+
+int dbof_untyped_array_reserve(dbof_object_untyped_array array, dbof_container_size capacity)
+{ return __object_untyped_array_impl_reserve(array, capacity); }
+
+dbof_object dbof_untyped_array_get(dbof_object_untyped_array array, dbof_container_size index)
+{ return __object_untyped_array_impl_get(array, index); }
+
+void dbof_untyped_array_set(dbof_object_untyped_array array, dbof_container_size index, dbof_object object)
+{ return __object_untyped_array_impl_set(array, index, object); }
+
+void dbof_untyped_array_insert(dbof_object_untyped_array array, dbof_container_size index, dbof_object object)
+{ __object_untyped_array_impl_insert(array, index, object); }
+
+dbof_object dbof_untyped_array_remove(dbof_object_untyped_array array, dbof_container_size index)
+{ return __object_untyped_array_impl_remove(array, index); }
+
+void dbof_untyped_array_push_back(dbof_object_untyped_array array, dbof_object object)
+{ __object_untyped_array_impl_push_back(array, object); }
+
+dbof_object_untyped_array dbof_untyped_array_snapshot(dbof_object_untyped_array array)
+{ return __object_untyped_array_impl_snapshot(array); }
+
+dbof_object dbof_untyped_array_pop_back(dbof_object_untyped_array array)
+{ return __object_untyped_array_impl_pop_back(array); }
+
+dbof_container_size dbof_typed_map_get_capacity(dbof_object_typed_map map)
+{ return __object_typed_map_impl_get_capacity(map); }
+
+int dbof_typed_map_reserve(dbof_object_typed_map map, dbof_container_size size)
+{ return __object_typed_map_impl_reserve(map, size); }
+
+dbof_container_size dbof_typed_map_get_size(dbof_object_typed_map map)
+{ return __object_typed_map_impl_get_size(map); }
+
+int dbof_typed_map_is_empty(dbof_object_typed_map map)
+{ return __object_typed_map_impl_is_empty(map); }
+
+dbof_type dbof_typed_map_get_key_type(dbof_object_typed_map map)
+{ return __object_typed_map_impl_get_key_type(map); }
+
+void dbof_typed_map_set_key_type(dbof_object_typed_map map, dbof_type key_type)
+{ __object_typed_map_impl_set_key_type(map, key_type); }
+
+dbof_type dbof_typed_map_get_value_type(dbof_object_typed_map map)
+{ return __object_typed_map_impl_get_value_type(map); }
+
+void dbof_typed_map_set_value_type(dbof_object_typed_map map, dbof_type value_type)
+{ __object_typed_map_impl_set_key_value(map, value_type); }
+
+dbof_object dbof_typed_map_get(dbof_object_typed_map map, dbof_object key)
+{ return __object_typed_map_impl_get(map, key); }
+
+int dbof_typed_map_put(dbof_object_typed_map map, dbof_object key, dbof_object value)
+{ return __object_typed_map_impl_put(map, key, value); }
+
+dbof_object dbof_typed_map_remove(dbof_object_typed_map map, dbof_object key)
+{ return __object_typed_map_impl_remove(map, key); }
+
+int dbof_typed_map_has_key(dbof_object_typed_map map, dbof_object key)
+{ return __object_typed_map_impl_has_key(map, key); }
+
+int dbof_typed_map_get_packed(dbof_object_typed_map map, const void* key, void* value)
+{
+    struct __object_typed_map_impl* map_impl = (struct __object_typed_map_impl*) map;
+
+    if (!map_impl->packed_keys)
+        return 0;
+
+    void* src = __object_typed_map_impl_read(map_impl, map_impl->key_type, key, 0, map_impl->value_type);
+    if (src == NULL)
+        return 0;
+
+    memcpy(value, src, __packed_size_of(map_impl->value_type));
+    return 1;
+}
+
+void dbof_typed_map_put_packed(dbof_object_typed_map map, const void* key, const void* value)
+{
+    struct __object_typed_map_impl* map_impl = (struct __object_typed_map_impl*) map;
+
+    if (!map_impl->packed_keys)
+        return;
+
+    __object_typed_map_impl_write(map_impl, map_impl->key_type, key, 0, map_impl->value_type, value);
+}
+
+int dbof_typed_map_get_unsigned_long_integer_double_float(dbof_object_typed_map map, dbof_unsigned_long_integer key,
+        dbof_double_float* value)
+{
+    dbof_double_float* src = __object_typed_map_impl_read(map, DBOF_TYPE_UNSIGNED_LONG_INTEGER, &key, 0,
+            DBOF_TYPE_DOUBLE_FLOAT);
+    if (src == NULL)
+        return 0;
+
+    *value = *src;
+    return 1;
+}
+
+void dbof_typed_map_put_unsigned_long_integer_double_float(dbof_object_typed_map map, dbof_unsigned_long_integer key,
+        dbof_double_float value)
+{
+    __object_typed_map_impl_write(map, DBOF_TYPE_UNSIGNED_LONG_INTEGER, &key, 0, DBOF_TYPE_DOUBLE_FLOAT, &value);
+}
+
+int dbof_typed_map_get_signed_integer_signed_integer(dbof_object_typed_map map, dbof_signed_integer key,
+        dbof_signed_integer* value)
+{
+    dbof_signed_integer* src = __object_typed_map_impl_read(map, DBOF_TYPE_SIGNED_INTEGER, &key, 0,
+            DBOF_TYPE_SIGNED_INTEGER);
+    if (src == NULL)
+        return 0;
+
+    *value = *src;
+    return 1;
+}
+
+void dbof_typed_map_put_signed_integer_signed_integer(dbof_object_typed_map map, dbof_signed_integer key,
+        dbof_signed_integer value)
+{
+    __object_typed_map_impl_write(map, DBOF_TYPE_SIGNED_INTEGER, &key, 0, DBOF_TYPE_SIGNED_INTEGER, &value);
+}
+
+int dbof_typed_map_get_utf8_string_unsigned_long_integer(dbof_object_typed_map map, const char* key,
+        dbof_unsigned_long_integer* value)
+{
+    dbof_unsigned_long_integer* src = __object_typed_map_impl_read(map, DBOF_TYPE_UTF8_STRING, key, strlen(key),
+            DBOF_TYPE_UNSIGNED_LONG_INTEGER);
+    if (src == NULL)
+        return 0;
+
+    *value = *src;
+    return 1;
+}
+
+void dbof_typed_map_put_utf8_string_unsigned_long_integer(dbof_object_typed_map map, const char* key,
+        dbof_unsigned_long_integer value)
+{
+    __object_typed_map_impl_write(map, DBOF_TYPE_UTF8_STRING, key, strlen(key),
+            DBOF_TYPE_UNSIGNED_LONG_INTEGER, &value);
+}
+
+dbof_container_size dbof_untyped_map_get_capacity(dbof_object_untyped_map map)
+{ return __object_untyped_map_impl_get_capacity(map); }
+
+int dbof_untyped_map_reserve(dbof_object_untyped_map map, dbof_container_size size)
+{ return __object_untyped_map_impl_reserve(map, size); }
+
+dbof_container_size dbof_untyped_map_get_size(dbof_object_untyped_map map)
+{ return __object_untyped_map_impl_get_size(map); }
+
+int dbof_untyped_map_is_empty(dbof_object_untyped_map map)
+{ return __object_untyped_map_impl_is_empty(map); }
+
+dbof_object dbof_untyped_map_get(dbof_object_untyped_map map, dbof_object key)
+{ return __object_untyped_map_impl_get(map, key); }
+
+void dbof_untyped_map_put(dbof_object_untyped_map map, dbof_object key, dbof_object value)
+{ __object_untyped_map_impl_put(map, key, value); }
+
+dbof_object dbof_untyped_map_remove(dbof_object_untyped_map map, dbof_object key)
+{ return __object_untyped_map_impl_remove(map, key); }
+
+int dbof_untyped_map_has_key(dbof_object_untyped_map map, dbof_object key)
+{ return __object_untyped_map_impl_has_key(map, key); }
+
+//
+// Object Serialization and Deserialization
+//
+
+/* Buffered I/O */
+
+//
+// NOTICE
+// The codec pulls and pushes data a few bytes at a time (a type ID here, a flex length there). Rather than calling the
+// user's read/write callback for each of those, the codec goes through these buffers, which batch the callback calls
+// into large blocks. Requests at least as large as the buffer bypass it entirely.
+//
+
+/**
+ * The buffer size used when the reader or writer does not specify one. Buffers of this size live on the stack.
+ */
+#define __DEFAULT_BUFFER_SIZE 8192
+
+struct __buffered_reader
+{
+    /**
+     * The user's reader.
+     */
+    dbof_reader* source;
+
+    /**
+     * The arena to allocate objects from, or NULL to allocate them from the heap.
+     */
+    struct __arena* arena;
+
+    /**
+     * The buffer.
+     */
+    char* buffer;
+
+    /**
+     * The size of the buffer.
+     */
+    size_t capacity;
+
+    /**
+     * The position of the next unread byte in the buffer.
+     */
+    size_t position;
+
+    /**
+     * The number of valid bytes in the buffer.
+     */
+    size_t limit;
+
+    /**
+     * Nonzero if decoded objects may point into the buffer. Only set when the buffer is the caller's own memory.
+     */
+    int borrow;
+
+    /**
+     * The intern pool for string values, or NULL.
+     */
+    struct __intern_pool* intern_pool;
+
+    /**
+     * The deepest nesting of containers allowed, or zero for no limit.
+     */
+    unsigned int max_depth;
+
+    /**
+     * The nesting depth of the container being parsed.
+     */
+    unsigned int depth;
+
+    /**
+     * The number of bytes left to allocate for decoded objects.
+     */
+    uint64_t budget;
+
+    /**
+     * The version of the serialization format being read.
+     */
+    unsigned short version;
+
+    /**
+     * Nonzero if small values may be read as immediate values.
+     */
+    int immediate;
+};
+
+static void __buffered_reader_init(struct __buffered_reader* reader, dbof_reader* source, char* buffer,
+        size_t capacity)
+{
+    reader->source = source;
+    reader->arena = source->arena;
+    reader->buffer = buffer;
+    reader->capacity = capacity;
+    reader->position = 0;
+    reader->limit = 0;
+    reader->borrow = 0;
+    reader->intern_pool = source->intern_pool;
+    reader->max_depth = source->max_depth == 0 ? DBOF_DEFAULT_MAX_DEPTH : source->max_depth;
+    reader->depth = 0;
+    reader->budget = source->max_allocation == 0 ? UINT64_MAX : source->max_allocation;
+    reader->version = DBOF_SER_DEFAULT;
+    reader->immediate = source->immediate_values;
+}
+
+/**
+ * Internal. Set up a reader over a complete buffer in memory. The buffer becomes the read buffer, already full, with
+ * no source behind it.
+ */
+static void __buffered_reader_init_memory(struct __buffered_reader* reader, const void* data, size_t size)
+{
+    reader->source = NULL;
+    reader->arena = NULL;
+    reader->buffer = (char*) data;
+    reader->capacity = size;
+    reader->position = 0;
+    reader->limit = size;
+    reader->borrow = 0;
+    reader->intern_pool = NULL;
+    reader->max_depth = DBOF_DEFAULT_MAX_DEPTH;
+    reader->depth = 0;
+    reader->budget = UINT64_MAX;
+    reader->version = DBOF_SER_DEFAULT;
+    reader->immediate = 0;
+}
+
+/**
+ * Internal. Call the source until the requested size has been read or it stops delivering. Returns the size read.
+ */
+static size_t __buffered_reader_fill(dbof_reader* source, char* ptr, size_t min_size, size_t size)
+{
+    size_t total = 0;
+
+    // Sources may deliver less than requested (pipes, sockets), so keep asking until we have the minimum
+    while (total < min_size)
+    {
+        size_t count = source->read(source, ptr + total, size - total);
+        if (count == 0)
+            break;
+
+        total += count;
+    }
+
+    return total;
+}
+
+static size_t __buffered_reader_read_slow(struct __buffered_reader* reader, char* ptr, size_t size)
+{
+    // Drain what is left in the buffer
+    size_t available = reader->limit - reader->position;
+    memcpy(ptr, reader->buffer + reader->position, available);
+
+    // A reader over an in-memory buffer has nothing more to give
+    if (reader->source == NULL)
+    {
+        reader->position = reader->limit;
+        return available;
+    }
+
+    reader->position = reader->limit = 0;
+
+    size_t remaining = size - available;
+
+    // Large requests go straight to the source
+    if (remaining >= reader->capacity)
+        return available + __buffered_reader_fill(reader->source, ptr + available, remaining, remaining);
+
+    // Otherwise, refill the buffer (reading ahead as far as the source allows)
+    reader->limit = __buffered_reader_fill(reader->source, reader->buffer, remaining, reader->capacity);
+
+    size_t count = remaining < reader->limit ? remaining : reader->limit;
+    memcpy(ptr + available, reader->buffer, count);
+    reader->position = count;
+
+    return available + count;
+}
+
+/**
+ * Internal. Read data through the buffer. Returns the size actually read.
+ */
+static size_t __buffered_reader_read(struct __buffered_reader* reader, char* ptr, size_t size)
+{
+    // Fast path: everything requested is already buffered
+    if (size <= reader->limit - reader->position)
+    {
+        memcpy(ptr, reader->buffer + reader->position, size);
+        reader->position += size;
+        return size;
+    }
+
+    return __buffered_reader_read_slow(reader, ptr, size);
+}
+
+/**
+ * Internal. Get the next data in place without consuming it, or NULL if it is not available in one piece (because
+ * it does not fit the buffer or the source ends early).
+ */
+static const char* __buffered_reader_peek(struct __buffered_reader* reader, size_t size)
+{
+    size_t available = reader->limit - reader->position;
+
+    if (size <= available)
+        return reader->buffer + reader->position;
+
+    if (reader->source == NULL || size > reader->capacity)
+        return NULL;
+
+    // Move what is left to the front and top up the rest of the buffer
+    memmove(reader->buffer, reader->buffer + reader->position, available);
+    reader->position = 0;
+    reader->limit = available + __buffered_reader_fill(reader->source, reader->buffer + available, size - available,
+            reader->capacity - available);
+
+    return size <= reader->limit ? reader->buffer : NULL;
+}
+
+/**
+ * Internal. Give the data read ahead past the end of the object back to the source, if it takes data back. Done once
+ * the object is read or parsed.
+ */
+static void __buffered_reader_give_back(struct __buffered_reader* reader)
+{
+    if (reader->source != NULL && reader->source->unread != NULL && reader->position < reader->limit)
+    {
+        reader->source->unread(reader->source, reader->limit - reader->position);
+        reader->position = reader->limit;
+    }
+}
+
+/**
+ * Internal. Take memory about to be allocated for decoded objects out of the budget. Returns zero on success, or
+ * nonzero if that would exceed the budget.
+ */
+static int __buffered_reader_charge(struct __buffered_reader* reader, uint64_t count, size_t size)
+{
+    // An unlimited budget is never drawn down
+    if (reader->budget == UINT64_MAX)
+        return 0;
+
+    if (size > 0 && count > reader->budget / size)
+    {
+        // ERROR: Allocation budget exceeded
+        reader->budget = 0;
+        return -1;
+    }
+
+    reader->budget -= count * size;
+    return 0;
+}
+
+/**
+ * Internal. Get the number of children to make room for up front in a container read from the stream. The size is
+ * exact if it was charged against a budget, and not trusted beyond __READ_PRESIZE_LIMIT otherwise.
+ */
+static dbof_container_size __buffered_reader_presize(struct __buffered_reader* reader, uint64_t size)
+{
+    if (reader->budget != UINT64_MAX || size < __READ_PRESIZE_LIMIT)
+        return (dbof_container_size) size;
+
+    return __READ_PRESIZE_LIMIT;
+}
+
+/**
+ * Internal. Enter a container while parsing or skipping. Returns zero on success, or nonzero if that would exceed the
+ * depth limit. Every successful call is paired with decrementing the depth once the container is done.
+ */
+static int __buffered_reader_enter(struct __buffered_reader* reader)
+{
+    if (reader->max_depth != 0 && reader->depth >= reader->max_depth)
+    {
+        // ERROR: Nesting too deep
+        return -1;
+    }
+
+    reader->depth++;
+    return 0;
+}
+
+/**
+ * Internal. Consume data without copying it anywhere. Returns zero on success, otherwise nonzero.
+ */
+static int __buffered_reader_skip(struct __buffered_reader* reader, uint64_t size)
+{
+    for (;;)
+    {
+        size_t available = reader->limit - reader->position;
+
+        if (size <= available)
+        {
+            reader->position += size;
+            return 0;
+        }
+
+        size -= available;
+
+        // Refill the buffer and keep going
+        if (reader->source == NULL)
+            return -1;
+
+        reader->position = 0;
+        reader->limit = __buffered_reader_fill(reader->source, reader->buffer, 1, reader->capacity);
+        if (reader->limit == 0)
+        {
+            // ERROR: End of file
+            return -1;
+        }
+    }
+}
+
+/**
+ * Internal. Read data of a size taken from the input into new heap memory, followed by a null terminator. The memory
+ * grows with the data actually read, from the size of the read buffer up, so a corrupt size fails at the end of the
+ * input instead of allocating all it claims. Returns NULL if the input ends early or if out of memory.
+ */
+static char* __buffered_reader_read_alloc(struct __buffered_reader* reader, uint64_t size)
+{
+    // An in-memory source holds everything there is
+    if (size >= SIZE_MAX || (reader->source == NULL && size > reader->limit - reader->position))
+        return NULL;
+
+    char* data = NULL;
+    size_t count = 0;
+    size_t capacity = 0;
+
+    do
+    {
+        capacity = capacity < reader->capacity ? reader->capacity : capacity * 2;
+        if (capacity > size)
+        {
+            capacity = (size_t) size;
+        }
+
+        char* grown = realloc(data, capacity + 1);
+        if (grown == NULL)
+        {
+            // ERROR: Out of memory
+            free(data);
+            return NULL;
+        }
+
+        data = grown;
+
+        size_t read = __buffered_reader_read(reader, data + count, capacity - count);
+        count += read;
+
+        if (count < capacity)
+        {
+            // ERROR: End of file
+            free(data);
+            return NULL;
+        }
+    } while (count < size);
+
+    data[count] = '\0';
+    return data;
+}
+
+struct __buffered_writer
+{
+    /**
+     * The user's writer, or NULL to collect everything in the buffer (which then grows as needed).
+     */
+    dbof_writer* sink;
+
+    /**
+     * The buffer.
+     */
+    char* buffer;
+
+    /**
+     * The size of the buffer.
+     */
+    size_t capacity;
+
+    /**
+     * The number of buffered bytes not yet handed to the sink.
+     */
+    size_t used;
+
+    /**
+     * Nonzero once the sink has failed to accept data.
+     */
+    int failed;
+
+    /**
+     * The version of the serialization format being written.
+     */
+    unsigned short version;
+};
+
+static void __buffered_writer_init(struct __buffered_writer* writer, dbof_writer* sink, char* buffer,
+        size_t capacity)
+{
+    writer->sink = sink;
+    writer->buffer = buffer;
+    writer->capacity = capacity;
+    writer->used = 0;
+    writer->failed = 0;
+    writer->version = DBOF_SER_DEFAULT;
+}
+
+/**
+ * Internal. Hand data straight to the sink. Returns zero on success, otherwise nonzero.
+ */
+static int __buffered_writer_drain(struct __buffered_writer* writer, const char* ptr, size_t size)
+{
+    while (size > 0)
+    {
+        size_t count = writer->sink->write(writer->sink, ptr, size);
+        if (count == 0)
+        {
+            // ERROR: End of file or out of space
+            writer->failed = 1;
+            return -1;
+        }
+
+        ptr += count;
+        size -= count;
+    }
+
+    return 0;
+}
+
+/**
+ * Internal. Hand all buffered data to the sink. Returns zero on success, otherwise nonzero.
+ */
+static int __buffered_writer_flush(struct __buffered_writer* writer)
+{
+    if (writer->failed)
+        return -1;
+
+    int result = __buffered_writer_drain(writer, writer->buffer, writer->used);
+    writer->used = 0;
+
+    return result;
+}
+
+/**
+ * Internal. Grow the buffer of a writer without a sink so it takes the given data, too. Returns the size accepted.
+ */
+static size_t __buffered_writer_grow(struct __buffered_writer* writer, const char* ptr, size_t size)
+{
+    if (writer->failed)
+        return 0;
+
+    size_t capacity = writer->capacity * 2;
+    if (capacity < writer->used + size)
+    {
+        capacity = writer->used + size;
+    }
+
+    char* buffer = realloc(writer->buffer, capacity);
+    if (buffer == NULL)
+    {
+        // ERROR: Out of memory
+        writer->failed = 1;
+        return 0;
+    }
+
+    memcpy(buffer + writer->used, ptr, size);
+    writer->buffer = buffer;
+    writer->capacity = capacity;
+    writer->used += size;
+
+    return size;
+}
+
+static size_t __buffered_writer_write_slow(struct __buffered_writer* writer, const char* ptr, size_t size)
+{
+    if (writer->sink == NULL)
+        return __buffered_writer_grow(writer, ptr, size);
+
+    if (__buffered_writer_flush(writer))
+        return 0;
+
+    // Large requests go straight to the sink
+    if (size >= writer->capacity)
+        return __buffered_writer_drain(writer, ptr, size) ? 0 : size;
+
+    memcpy(writer->buffer, ptr, size);
+    writer->used = size;
+
+    return size;
+}
+
+/**
+ * Internal. Write data through the buffer. Returns the size accepted, which is less than requested only on failure.
+ */
+static size_t __buffered_writer_write(struct __buffered_writer* writer, const char* ptr, size_t size)
+{
+    // Fast path: there is room in the buffer
+    if (size <= writer->capacity - writer->used)
+    {
+        memcpy(writer->buffer + writer->used, ptr, size);
+        writer->used += size;
+        return size;
+    }
+
+    return __buffered_writer_write_slow(writer, ptr, size);
+}
+
+/* DBOF Serialization Format 1 */
+
+/**
+ * Internal. Create a new primitive object holding a value that was read, as an immediate value if the reader allows it.
+ */
+static dbof_object __dbof_1_new_value(struct __buffered_reader* reader, dbof_type type, const void* src)
+{ return reader->immediate ? __new_value(type, src, reader->arena) : __box_value(type, src, reader->arena); }
+
+static dbof_object_null __dbof_1_read_object_null(struct __buffered_reader* reader)
+{
+    // Null objects have no contents
+    return __dbof_1_new_value(reader, DBOF_TYPE_NULL, NULL);
+}
+
+static int __dbof_1_write_object_null(dbof_object_null object, struct __buffered_writer* writer)
+{
+    // Null objects have no contents
+    (void) object;
+    (void) writer;
+    return 0;
+}
+
+static dbof_object_signed_byte __dbof_1_read_object_signed_byte(struct __buffered_reader* reader)
+{
+    dbof_signed_byte value;
+
+    // Read 1 byte
+    if (__buffered_reader_read(reader, (char*) &value, 1) < 1)
+    {
+        // ERROR: End of file
+        return NULL;
+    }
+
+    // Set value
+    return __dbof_1_new_value(reader, DBOF_TYPE_SIGNED_BYTE, &value);
+}
+
+static int __dbof_1_write_object_signed_byte(dbof_object_signed_byte object, struct __buffered_writer* writer)
+{
+    // Get value
+    dbof_signed_byte value = dbof_get_value_signed_byte(object);
+
+    if (__buffered_writer_write(writer, (char*) &value, 1) < 1)
+    {
+        // ERROR: End of file or out of space
+        return -1;
+    }
+
+    return 0;
+}
+
+static dbof_object_unsigned_byte __dbof_1_read_object_unsigned_byte(struct __buffered_reader* reader)
+{
+    dbof_unsigned_byte value = 0;
+
+    // Read 1 byte
+    if (__buffered_reader_read(reader, (char*) &value, 1) < 1)
+    {
+        // ERROR: End of file
+        return NULL;
+    }
+
+    // Set value
+    return __dbof_1_new_value(reader, DBOF_TYPE_UNSIGNED_BYTE, &value);
+}
+
+static int __dbof_1_write_object_unsigned_byte(dbof_object_unsigned_byte object, struct __buffered_writer* writer)
+{
+    // Get value
+    dbof_unsigned_byte value = dbof_get_value_unsigned_byte(object);
+
+    // Write 1 byte
+    if (__buffered_writer_write(writer, (char*) &value, 1) < 1)
+    {
+        // ERROR: End of file or out of space
+        return -1;
+    }
+
+    return 0;
+}
+
+static dbof_object_signed_integer __dbof_1_read_object_signed_integer(struct __buffered_reader* reader)
+{
+    dbof_signed_integer value = 0;
+
+    // Read 4 bytes
+    char value_buf[4];
+    if (__buffered_reader_read(reader, value_buf, 4) < 4)
+    {
+        // ERROR: End of file
+        return NULL;
+    }
+
+    // Unpack little-endian 32-bit integer (LSB stored first)
+    value |= ((uint32_t) (uint8_t) value_buf[0]) << 0;
+    value |= ((uint32_t) (uint8_t) value_buf[1]) << 8;
+    value |= ((uint32_t) (uint8_t) value_buf[2]) << 16;
+    value |= ((uint32_t) (uint8_t) value_buf[3]) << 24;
+
+    // Set value
+    return __dbof_1_new_value(reader, DBOF_TYPE_SIGNED_INTEGER, &value);
+}
+
+static int __dbof_1_write_object_signed_integer(dbof_object_signed_integer object, struct __buffered_writer* writer)
+{
+    // Get value
+    dbof_signed_integer value = dbof_get_value_signed_integer(object);
+
+    // Pack little-endian 32-bit integer (LSB stored first)
+    char value_buf[4];
+    value_buf[0] = (uint8_t) ((value & 0x000000ffu) >> 0);
+    value_buf[1] = (uint8_t) ((value & 0x0000ff00u) >> 8);
+    value_buf[2] = (uint8_t) ((value & 0x00ff0000u) >> 16);
+    value_buf[3] = (uint8_t) ((value & 0xff000000u) >> 24);
+
+    // Write 4 bytes
+    if (__buffered_writer_write(writer, value_buf, 4) < 4)
+    {
+        // ERROR: End of file or out of space
+        return -1;
+    }
+
+    return 0;
+}
+
+static dbof_object_unsigned_integer __dbof_1_read_object_unsigned_integer(struct __buffered_reader* reader)
+{
+    dbof_unsigned_integer value = 0;
+
+    // Read 4 bytes
+    char value_buf[4];
+    if (__buffered_reader_read(reader, value_buf, 4) < 4)
+    {
+        // ERROR: End of file
+        return NULL;
+    }
+
+    // Unpack little-endian 32-bit integer (LSB stored first)
+    value |= ((uint32_t) (uint8_t) value_buf[0]) << 0;
+    value |= ((uint32_t) (uint8_t) value_buf[1]) << 8;
+    value |= ((uint32_t) (uint8_t) value_buf[2]) << 16;
+    value |= ((uint32_t) (uint8_t) value_buf[3]) << 24;
+
+    // Get value
+    return __dbof_1_new_value(reader, DBOF_TYPE_UNSIGNED_INTEGER, &value);
+}
+
+static int __dbof_1_write_object_unsigned_integer(dbof_object_unsigned_integer object, struct __buffered_writer* writer)
+{
+    // Get value
+    dbof_unsigned_integer value = dbof_get_value_unsigned_integer(object);
+
+    // Pack little-endian 32-bit integer (LSB stored first)
+    char value_buf[4];
+    value_buf[0] = (uint8_t) ((value & 0x000000ffu) >> 0);
+    value_buf[1] = (uint8_t) ((value & 0x0000ff00u) >> 8);
+    value_buf[2] = (uint8_t) ((value & 0x00ff0000u) >> 16);
+    value_buf[3] = (uint8_t) ((value & 0xff000000u) >> 24);
+
+    // Write 4 bytes
+    if (__buffered_writer_write(writer, value_buf, 4) < 4)
+    {
+        // ERROR: End of file or out of space
+        return -1;
+    }
+
+    return 0;
+}
+
+static dbof_object_signed_long_integer __dbof_1_read_object_signed_long_integer(struct __buffered_reader* reader)
+{
+    dbof_signed_long_integer value = 0;
+
+    // Read 8 bytes
+    char value_buf[8];
+    if (__buffered_reader_read(reader, value_buf, 8) < 8)
+    {
+        // ERROR: End of file
+        return NULL;
+    }
+
+    // Unpack little-endian 64-bit integer (LSB stored first)
+    value |= ((uint64_t) (uint8_t) value_buf[0]) << 0;
+    value |= ((uint64_t) (uint8_t) value_buf[1]) << 8;
+    value |= ((uint64_t) (uint8_t) value_buf[2]) << 16;
+    value |= ((uint64_t) (uint8_t) value_buf[3]) << 24;
+    value |= ((uint64_t) (uint8_t) value_buf[4]) << 32;
+    value |= ((uint64_t) (uint8_t) value_buf[5]) << 40;
+    value |= ((uint64_t) (uint8_t) value_buf[6]) << 48;
+    value |= ((uint64_t) (uint8_t) value_buf[7]) << 56;
+
+    // Set value
+    dbof_object_signed_long_integer object = __new_object_signed_long_integer(reader->arena);
+    dbof_set_value_signed_long_integer(object, value);
+    return object;
+}
+
+static int __dbof_1_write_object_signed_long_integer(dbof_object_signed_long_integer object,
+        struct __buffered_writer* writer)
+{
+    // Get value
+    dbof_signed_long_integer value = dbof_get_value_signed_long_integer(object);
+
+    // Pack little-endian 64-bit integer (LSB stored first)
+    char value_buf[8];
+    value_buf[0] = (uint8_t) ((value & 0x00000000000000fful) >> 0);
+    value_buf[1] = (uint8_t) ((value & 0x000000000000ff00ul) >> 8);
+    value_buf[2] = (uint8_t) ((value & 0x0000000000ff0000ul) >> 16);
+    value_buf[3] = (uint8_t) ((value & 0x00000000ff000000ul) >> 24);
+    value_buf[4] = (uint8_t) ((value & 0x000000ff00000000ul) >> 32);
+    value_buf[5] = (uint8_t) ((value & 0x0000ff0000000000ul) >> 40);
+    value_buf[6] = (uint8_t) ((value & 0x00ff000000000000ul) >> 48);
+    value_buf[7] = (uint8_t) ((value & 0xff00000000000000ul) >> 56);
+
+    // Write 8 bytes
+    if (__buffered_writer_write(writer, value_buf, 8) < 8)
+    {
+        // ERROR: End of file or out of space
+        return -1;
+    }
+
+    return 0;
+}
+
+static dbof_object_unsigned_long_integer __dbof_1_read_object_unsigned_long_integer(struct __buffered_reader* reader)
+{
+    dbof_unsigned_long_integer value = 0;
+
+    // Read 8 bytes
+    char value_buf[8];
+    if (__buffered_reader_read(reader, value_buf, 8) < 8)
+    {
+        // ERROR: End of file
+        return NULL;
+    }
+
+    // Unpack little-endian 64-bit integer (LSB stored first)
+    value |= ((uint64_t) (uint8_t) value_buf[0]) << 0;
+    value |= ((uint64_t) (uint8_t) value_buf[1]) << 8;
+    value |= ((uint64_t) (uint8_t) value_buf[2]) << 16;
+    value |= ((uint64_t) (uint8_t) value_buf[3]) << 24;
+    value |= ((uint64_t) (uint8_t) value_buf[4]) << 32;
+    value |= ((uint64_t) (uint8_t) value_buf[5]) << 40;
+    value |= ((uint64_t) (uint8_t) value_buf[6]) << 48;
+    value |= ((uint64_t) (uint8_t) value_buf[7]) << 56;
+
+    // Set value
+    dbof_object_unsigned_long_integer object = __new_object_unsigned_long_integer(reader->arena);
+    dbof_set_value_unsigned_long_integer(object, value);
+    return object;
+}
+
+static int __dbof_1_write_object_unsigned_long_integer(dbof_object_unsigned_long_integer object,
+        struct __buffered_writer* writer)
+{
+    // Get value
+    dbof_unsigned_long_integer value = dbof_get_value_unsigned_long_integer(object);
+
+    // Pack little-endian 64-bit integer (LSB stored first)
+    char value_buf[8];
+    value_buf[0] = (uint8_t) ((value & 0x00000000000000fful) >> 0);
+    value_buf[1] = (uint8_t) ((value & 0x000000000000ff00ul) >> 8);
+    value_buf[2] = (uint8_t) ((value & 0x0000000000ff0000ul) >> 16);
+    value_buf[3] = (uint8_t) ((value & 0x00000000ff000000ul) >> 24);
+    value_buf[4] = (uint8_t) ((value & 0x000000ff00000000ul) >> 32);
+    value_buf[5] = (uint8_t) ((value & 0x0000ff0000000000ul) >> 40);
+    value_buf[6] = (uint8_t) ((value & 0x00ff000000000000ul) >> 48);
+    value_buf[7] = (uint8_t) ((value & 0xff00000000000000ul) >> 56);
+
+    // Write 8 bytes
+    if (__buffered_writer_write(writer, value_buf, 8) < 8)
+    {
+        // ERROR: End of file or out of space
+        return -1;
+    }
+
+    return 0;
+}
+
+static dbof_object_boolean __dbof_1_read_object_boolean(struct __buffered_reader* reader)
+{
+    dbof_boolean value = 0;
+
+    // Read 1 byte
+    if (__buffered_reader_read(reader, (char*) &value, 1) < 1)
+    {
+        // ERROR: End of file
+        return NULL;
+    }
+
+    // Set value
+    return __dbof_1_new_value(reader, DBOF_TYPE_BOOLEAN, &value);
+}
+
+static int __dbof_1_write_object_boolean(dbof_object_boolean object, struct __buffered_writer* writer)
+{
+    // Get value
+    dbof_boolean value = dbof_get_value_boolean(object);
+
+    // Write 1 byte
+    if (__buffered_writer_write(writer, (char*) &value, 1) < 1)
+    {
+        // ERROR: End of file or out of space
+        return -1;
+    }
+
+    return 0;
+}
+
+//
+// IMPORTANT
+//
+// We are assuming the architecture stores single- and double-precision floating-point numbers in memory as the common
+// IEEE 754 binary32 and binary64 representations. We don't require fully-conforming float *operations* from the
+// compiler, but memory representation is a necessity. Using an architecture with another representation will result in
+// ill-formed serialized objects.
+//
+
+static dbof_object_single_float __dbof_1_read_object_single_float(struct __buffered_reader* reader)
+{
+    // Read 4 bytes
+    char value_buf[4];
+    if (__buffered_reader_read(reader, value_buf, 4) < 4)
+    {
+        // ERROR: End of file
+        return NULL;
+    }
+
+    // Unpack little-endian IEEE 754 binary32 float (LSB stored first)
+    uint32_t value_tmp = 0;
+    value_tmp |= ((uint32_t) (uint8_t) value_buf[0]) << 0;
+    value_tmp |= ((uint32_t) (uint8_t) value_buf[1]) << 8;
+    value_tmp |= ((uint32_t) (uint8_t) value_buf[2]) << 16;
+    value_tmp |= ((uint32_t) (uint8_t) value_buf[3]) << 24;
+
+    // Convert to single float value
+    union
+    {
+        uint32_t in;
+        dbof_single_float out;
+    } cvt = { value_tmp };
+
+    // Set value
+    return __dbof_1_new_value(reader, DBOF_TYPE_SINGLE_FLOAT, &cvt.out);
+}
+
+static int __dbof_1_write_object_single_float(dbof_object_single_float object, struct __buffered_writer* writer)
+{
+    // Get value
+    dbof_single_float value = dbof_get_value_single_float(object);
+
+    // Convert to unsigned integer
+    union
+    {
+        dbof_single_float in;
+        uint32_t out;
+    } cvt = { value };
+
+    // Pack little-endian IEEE 754 binary32 float (LSB stored first)
+    char value_buf[4];
+    value_buf[0] = (uint8_t) ((cvt.out & 0x000000ffu) >> 0);
+    value_buf[1] = (uint8_t) ((cvt.out & 0x0000ff00u) >> 8);
+    value_buf[2] = (uint8_t) ((cvt.out & 0x00ff0000u) >> 16);
+    value_buf[3] = (uint8_t) ((cvt.out & 0xff000000u) >> 24);
+
+    // Write 4 bytes
+    if (__buffered_writer_write(writer, value_buf, 4) < 4)
+    {
+        // ERROR: End of file or out of space
+        return -1;
+    }
+
+    return 0;
+}
+
+static dbof_object_double_float __dbof_1_read_object_double_float(struct __buffered_reader* reader)
+{
+    // Read 8 bytes
+    char value_buf[8];
+    if (__buffered_reader_read(reader, value_buf, 8) < 8)
+    {
+        // ERROR: End of file
+        return NULL;
+    }
+
+    // Unpack little-endian IEEE 754 binary64 float (LSB stored first)
+    uint64_t value_tmp = 0;
+    value_tmp |= ((uint64_t) (uint8_t) value_buf[0]) << 0;
+    value_tmp |= ((uint64_t) (uint8_t) value_buf[1]) << 8;
+    value_tmp |= ((uint64_t) (uint8_t) value_buf[2]) << 16;
+    value_tmp |= ((uint64_t) (uint8_t) value_buf[3]) << 24;
+    value_tmp |= ((uint64_t) (uint8_t) value_buf[4]) << 32;
+    value_tmp |= ((uint64_t) (uint8_t) value_buf[5]) << 40;
+    value_tmp |= ((uint64_t) (uint8_t) value_buf[6]) << 48;
+    value_tmp |= ((uint64_t) (uint8_t) value_buf[7]) << 56;
+
+    // Convert to double float value
+    union
+    {
+        uint64_t in;
+        dbof_double_float out;
+    } cvt = { value_tmp };
+
+    // Set value
+    dbof_object_double_float object = __new_object_double_float(reader->arena);
+    dbof_set_value_double_float(object, cvt.out);
+    return object;
+}
+
+static int __dbof_1_write_object_double_float(dbof_object_double_float object, struct __buffered_writer* writer)
+{
+    // Get value
+    dbof_double_float value = dbof_get_value_double_float(object);
+
+    // Convert to unsigned integer
+    union
+    {
+        dbof_double_float in;
+        uint64_t out;
+    } cvt = { value };
+
+    // Pack little-endian IEEE 754 binary64 float (LSB stored first)
+    char value_buf[8];
+    value_buf[0] = (uint8_t) ((cvt.out & 0x00000000000000fful) >> 0);
+    value_buf[1] = (uint8_t) ((cvt.out & 0x000000000000ff00ul) >> 8);
+    value_buf[2] = (uint8_t) ((cvt.out & 0x0000000000ff0000ul) >> 16);
+    value_buf[3] = (uint8_t) ((cvt.out & 0x00000000ff000000ul) >> 24);
+    value_buf[4] = (uint8_t) ((cvt.out & 0x000000ff00000000ul) >> 32);
+    value_buf[5] = (uint8_t) ((cvt.out & 0x0000ff0000000000ul) >> 40);
+    value_buf[6] = (uint8_t) ((cvt.out & 0x00ff000000000000ul) >> 48);
+    value_buf[7] = (uint8_t) ((cvt.out & 0xff00000000000000ul) >> 56);
+
+    // Write 8 bytes
+    if (__buffered_writer_write(writer, value_buf, 8) < 8)
+    {
+        // ERROR: End of file or out of space
+        return -1;
+    }
+
+    return 0;
+}
+
+static dbof_object_character __dbof_1_read_object_character(struct __buffered_reader* reader)
+{
+    dbof_character value = 0;
+
+    // Read 4 bytes
+    char value_buf[4];
+    if (__buffered_reader_read(reader, value_buf, 4) < 4)
+    {
+        // ERROR: End of file
+        return NULL;
+    }
+
+    // Unpack little-endian character (LSB stored first)
+    value |= ((uint32_t) (uint8_t) value_buf[0]) << 0;
+    value |= ((uint32_t) (uint8_t) value_buf[1]) << 8;
+    value |= ((uint32_t) (uint8_t) value_buf[2]) << 16;
+    value |= ((uint32_t) (uint8_t) value_buf[3]) << 24;
+
+    // Get value
+    return __dbof_1_new_value(reader, DBOF_TYPE_CHARACTER, &value);
+}
+
+static int __dbof_1_write_object_character(dbof_object_character object, struct __buffered_writer* writer)
+{
+    // Get value
+    dbof_character value = dbof_get_value_unsigned_integer(object);
+
+    // Pack little-endian character (LSB stored first)
+    char value_buf[4];
+    value_buf[0] = (uint8_t) ((value & 0x000000ffu) >> 0);
+    value_buf[1] = (uint8_t) ((value & 0x0000ff00u) >> 8);
+    value_buf[2] = (uint8_t) ((value & 0x00ff0000u) >> 16);
+    value_buf[3] = (uint8_t) ((value & 0xff000000u) >> 24);
+
+    // Write 4 bytes
+    if (__buffered_writer_write(writer, value_buf, 4) < 4)
+    {
+        // ERROR: End of file or out of space
+        return -1;
+    }
+
+    return 0;
+}
+
+/**
+ * Internal algorithm to calculate the minimum number of 8-bit bytes necessary to represent up to a 64-bit integer
+ * without loss of information.
+ *
+ * @param value The value in question
+ * @return The required number of bytes
+ */
+static int __count_min_bytes_internal(uint64_t value)
+{
+    if ((value & 0x00000000000000fful) == value)
+        return 1;
+    if ((value & 0x000000000000fffful) == value)
+        return 2;
+    if ((value & 0x0000000000fffffful) == value)
+        return 3;
+    if ((value & 0x00000000fffffffful) == value)
+        return 4;
+    if ((value & 0x000000fffffffffful) == value)
+        return 5;
+    if ((value & 0x0000fffffffffffful) == value)
+        return 6;
+    if ((value & 0x00fffffffffffffful) == value)
+        return 7;
+
+    return 8;
+}
+
+/**
+ * Internal procedure for reading flex lengths as defined in DBOF-1.
+ *
+ * @param       reader The reader
+ * @param [out] out_length The length
+ * @return Zero on success, otherwise nonzero
+ */
+static int __dbof_1_read_flex_length_internal(struct __buffered_reader* reader, uint64_t* out_length)
+{
+    unsigned char length_size;
+    char length_buf[8] = {};
+    uint64_t length = 0;
+
+    // Read size of flex length data
+    if (__buffered_reader_read(reader, (char*) &length_size, 1) < 1)
+        goto fail_eof;
+
+    // Limited by DBOF-1 spec to a max of 8
+    if (length_size > 8)
+        goto fail_out_of_spec;
+
+    // Read flex length data
+    if (__buffered_reader_read(reader, length_buf, (size_t) length_size) < length_size)
+        goto fail_eof;
+
+    // Unpack flex length (little-endian, LSB stored first)
+    for (int i = 0; i < length_size; ++i)
+    {
+        length |= ((uint64_t) (uint8_t) length_buf[i]) << i * 8;
+    }
+
+    *out_length = length;
+    return 0;
+
+fail_eof:
+fail_out_of_spec:
+    return -1;
+}
+
+/**
+ * Internal procedure for writing flex lengths as defined in DBOF-1.
+ *
+ * @param writer The writer
+ * @param length The length
+ * @return Zero on success, otherwise nonzero
+ */
+static int __dbof_1_write_flex_length_internal(struct __buffered_writer* writer, uint64_t length)
+{
+    char length_buf[8];
+
+    // Calculate size of flex length data
+    char length_size = (char) __count_min_bytes_internal(length);
+
+    // Write length size
+    if (__buffered_writer_write(writer, &length_size, 1) < 1)
+        goto fail_eof;
+
+    // Pack flex length (little-endian, LSB stored first)
+    for (int i = 0; i < length_size; ++i)
+    {
+        length_buf[i] = (uint8_t) ((length & (0x00000000000000fful << i * 8)) >> i * 8);
+    }
+
+    // Write length data
+    if (__buffered_writer_write(writer, length_buf, (size_t) length_size) < (size_t) length_size)
+        goto fail_eof;
+
+    return 0;
+
+fail_eof:
+    return -1;
+}
+
+static dbof_object_utf8_string __dbof_1_read_object_utf8_string(struct __buffered_reader* reader)
+{
+    struct __object_utf8_string_impl* string = __new_object_utf8_string(reader->arena);
+    if (string == NULL)
+    {
+        // ERROR: Out of memory
+        return NULL;
+    }
+
+    dbof_string_size length;
+    char* value = NULL; // free(NULL) is well-defined
+
+    // Read string length as flex length
+    if (__dbof_1_read_flex_length_internal(reader, &length))
+        goto fail;
+
+    // An in-memory source holds everything there is, so a longer string is truncated input
+    if (reader->source == NULL && length > reader->limit - reader->position)
+        goto fail_eof;
+
+    // When borrowing from an in-memory buffer, point the string straight at its bytes
+    if (reader->borrow)
+    {
+        string->value = reader->buffer + reader->position;
+        string->length = length;
+        string->base.flags |= __OBJECT_FLAG_BORROWED | __OBJECT_FLAG_UNTERMINATED;
+
+        reader->position += length;
+        return string;
+    }
+
+    // With an intern pool, point the string at the pool's copy of its value (if it is buffered in one piece), which
+    // counts against the budget when the pool has to add it
+    if (reader->intern_pool != NULL && length <= __INTERN_MAX_LENGTH)
+    {
+        const char* bytes = __buffered_reader_peek(reader, length);
+        if (bytes != NULL)
+        {
+            uint64_t hash = __hash_bytes_internal(bytes, length);
+            struct __intern_entry** slot = __intern_pool_find(reader->intern_pool, bytes, length, hash);
+            struct __intern_entry* entry = *slot;
+
+            if (entry == NULL)
+            {
+                if (__buffered_reader_charge(reader, 1, __intern_entry_size(length)))
+                    goto fail;
+
+                entry = __intern_pool_add(reader->intern_pool, slot, bytes, length, hash);
+                if (entry == NULL)
+                    goto fail;
+            }
+
+            __intern_string(string, entry);
+
+            reader->position += length;
+            return string;
+        }
+    }
+
+    // Short values go inline, so they need no allocation at all
+    if (length <= __SMALL_STRING_CAPACITY)
+    {
+        if (__buffered_reader_read(reader, string->small, length) < length)
+            goto fail_eof;
+
+        string->small[length] = '\0';
+        string->value = string->small;
+        string->length = length;
+        return string;
+    }
+
+    // Allocate memory for string value (plus null terminator)
+    if (__buffered_reader_charge(reader, length + 1, 1))
+        goto fail;
+
+    // Arena strings keep their bytes in the arena, so they are borrowed as far as the object is concerned (values not
+    // known to be in the input yet are read to the heap first, so a corrupt length cannot take the arena with it)
+    if (reader->arena != NULL && (reader->source == NULL || length < reader->capacity))
+    {
+        value = __arena_alloc(reader->arena, length + 1);
+        if (value == NULL)
+            goto fail;
+
+        string->base.flags |= __OBJECT_FLAG_BORROWED;
+
+        if (__buffered_reader_read(reader, value, length) < length)
+            goto fail_eof;
+
+        value[length] = '\0';
+    }
+    else
+    {
+        value = __buffered_reader_read_alloc(reader, length);
+        if (value == NULL)
+            goto fail;
+
+        if (reader->arena != NULL)
+        {
+            char* copy = __arena_alloc(reader->arena, length + 1);
+            if (copy == NULL)
+                goto fail;
+
+            memcpy(copy, value, length + 1);
+            free(value);
+
+            value = copy;
+            string->base.flags |= __OBJECT_FLAG_BORROWED;
+        }
+    }
+
+    string->value = value;
+    string->length = length;
+    return string;
+
+fail:
+fail_eof:
+    if (!(string->base.flags & __OBJECT_FLAG_BORROWED))
+    {
+        free(value);
+    }
+
+    __delete_object_utf8_string(string);
+    return NULL;
+}
+
+static int __dbof_1_write_object_string(dbof_object_string object, struct __buffered_writer* writer)
+{
+    struct __object_utf8_string_impl* string = (struct __object_utf8_string_impl*) object;
+
+    const char* value = string->value;
+    dbof_string_size length = string->length;
+
+    // Write string length as flex length
+    if (__dbof_1_write_flex_length_internal(writer, length))
+        goto fail;
+
+    // Write string value
+    if (__buffered_writer_write(writer, value, length) < length)
+        goto fail_eof;
+
+    return 0;
+
+fail:
+fail_eof:
+    return -1;
+}
+
+/**
+ * Internal function to read an object in DBOF-1 format.
+ *
+ * @param reader The reader
+ * @param read_type Whether to read the object type (nonzero) or not (zero)
+ * @param type The object type if it is not read
+ * @return The read object or NULL if an error occurred
+ */
+static dbof_object __dbof_1_read_object(struct __buffered_reader* reader, int read_type, dbof_type type);
+
+/**
+ * Internal function to write an object in DBOF-1 format.
+ *
+ * @param object The object to write
+ * @param writer The writer
+ * @param write_type Whether to write the object type (nonzero) or not (zero)
+ * @return Zero upon success, otherwise nonzero
+ */
+static int __dbof_1_write_object(dbof_object object, struct __buffered_writer* writer, int write_type);
+
+/**
+ * Internal. Determine if the host stores integers and floats little-endian (as DBOF-1 does). Compilers fold this.
+ */
+static int __host_is_little_endian()
+{
+    const union
+    {
+        uint16_t in;
+        uint8_t out[2];
+    } cvt = { 1 };
+
+    return cvt.out[0] == 1;
+}
+
+/**
+ * Internal. Reverse the byte order of packed values in place.
+ */
+static void __swap_bytes_internal(char* data, size_t count, size_t size)
+{
+    for (size_t i = 0; i < count; ++i, data += size)
+    {
+        for (size_t j = 0; j < size / 2; ++j)
+        {
+            char tmp = data[j];
+            data[j] = data[size - 1 - j];
+            data[size - 1 - j] = tmp;
+        }
+    }
+}
+
+/**
+ * Internal procedure for reading packed primitive values (integers, floats, or characters) into host byte order.
+ *
+ * @param reader The reader
+ * @param dst The packed values
+ * @param count The number of values
+ * @param size The size of one value
+ * @return Zero on success, otherwise nonzero
+ */
+static int __dbof_1_read_packed_values_internal(struct __buffered_reader* reader, void* dst, size_t count,
+        size_t size)
+{
+    // The values arrive little-endian (LSB stored first), so one block read does it on little-endian hosts
+    if (__buffered_reader_read(reader, dst, count * size) < count * size)
+    {
+        // ERROR: End of file
+        return -1;
+    }
+
+    if (!__host_is_little_endian())
+    {
+        __swap_bytes_internal(dst, count, size);
+    }
+
+    return 0;
+}
+
+/**
+ * Internal procedure for writing packed primitive values (integers, floats, or characters) from host byte order.
+ *
+ * @param writer The writer
+ * @param src The packed values
+ * @param count The number of values
+ * @param size The size of one value
+ * @return Zero on success, otherwise nonzero
+ */
+static int __dbof_1_write_packed_values_internal(struct __buffered_writer* writer, const void* src, size_t count,
+        size_t size)
+{
+    // The values leave little-endian (LSB stored first), so one block write does it on little-endian hosts
+    if (__host_is_little_endian())
+    {
+        if (__buffered_writer_write(writer, src, count * size) < count * size)
+        {
+            // ERROR: End of file or out of space
+            return -1;
+        }
+
+        return 0;
+    }
+
+    // Big-endian hosts swap chunks of values in a scratch buffer
+    char swap_buf[4096];
+    size_t chunk_count = sizeof(swap_buf) / size;
+
+    for (const char* values = src; count > 0;)
+    {
+        size_t n = count < chunk_count ? count : chunk_count;
+
+        memcpy(swap_buf, values, n * size);
+        __swap_bytes_internal(swap_buf, n, size);
+
+        if (__buffered_writer_write(writer, swap_buf, n * size) < n * size)
+        {
+            // ERROR: End of file or out of space
+            return -1;
+        }
+
+        values += n * size;
+        count -= n;
+    }
+
+    return 0;
+}
+
+/**
+ * Internal procedure for reading the type ID that version 1 puts before each child of a typed container. Later
+ * versions leave it out.
+ *
+ * @param reader The reader
+ * @param type The type the container records for the child
+ * @return Zero on success, otherwise nonzero
+ */
+static int __dbof_1_read_child_type_internal(struct __buffered_reader* reader, dbof_type type)
+{
+    if (reader->version != 1)
+        return 0;
+
+    char type_id;
+    if (__buffered_reader_read(reader, &type_id, 1) < 1)
+    {
+        // ERROR: End of file
+        return -1;
+    }
+
+    if ((dbof_type) type_id != type)
+    {
+        // ERROR: Child not of the type the container records
+        return -1;
+    }
+
+    return 0;
+}
+
+/**
+ * Internal procedure for writing the type ID that version 1 puts before each child of a typed container.
+ *
+ * @param writer The writer
+ * @param type The type of the child
+ * @return Zero on success, otherwise nonzero
+ */
+static int __dbof_1_write_child_type_internal(struct __buffered_writer* writer, dbof_type type)
+{
+    char type_id = type;
+    if (writer->version == 1 && __buffered_writer_write(writer, &type_id, 1) < 1)
+    {
+        // ERROR: End of file or out of space
+        return -1;
+    }
+
+    return 0;
+}
+
+static dbof_object_typed_array __dbof_1_read_object_typed_array(struct __buffered_reader* reader,
+        uint64_t* out_children)
+{
+    struct __object_typed_array_impl* array = __new_object_typed_array(reader->arena);
+
+    uint64_t size;
+    char element_type_id;
+
+    // Read array length as flex length
+    if (__dbof_1_read_flex_length_internal(reader, &size))
+        goto fail;
+
+    // Read element type ID
+    if (__buffered_reader_read(reader, &element_type_id, 1) < 1)
+        goto fail_eof;
+
+    // Set the type first, as it determines the storage layout
+    __object_typed_array_impl_set_type(array, (dbof_type) element_type_id);
+
+    struct __internal_array_base* array_base = (struct __internal_array_base*) array;
+    size_t element_size = array_base->element_size;
+
+    if (array->packed)
+    {
+        // Make sure the payload size is representable
+        if (size > SIZE_MAX / element_size)
+            goto fail_protocol;
+
+        size_t payload_size = size * element_size;
+
+        // Version 1 has a type ID before each element, so the elements are read one at a time
+        if (reader->version == 1)
+        {
+            if (__buffered_reader_charge(reader, size, element_size)
+                    || __internal_array_base_reserve(array_base, __buffered_reader_presize(reader, size)))
+                goto fail;
+
+            for (uint64_t i = 0; i < size; ++i)
+            {
+                void* slot = __internal_array_base_insert_slot(array_base, array_base->size);
+                if (slot == NULL)
+                    goto fail;
+
+                if (__dbof_1_read_child_type_internal(reader, array->type)
+                        || __dbof_1_read_packed_values_internal(reader, slot, 1, element_size))
+                    goto fail_eof;
+            }
+
+            *out_children = 0;
+            return array;
+        }
+
+        // When borrowing on a little-endian host, the elements can be used right where they are (if aligned)
+        char* payload = reader->buffer + reader->position;
+        if (reader->borrow && size > 0 && __host_is_little_endian() && payload_size <= reader->limit - reader->position
+                && (uintptr_t) payload % element_size == 0)
+        {
+            __storage_free(array_base->arena, array_base->elements);
+
+            array_base->elements = payload;
+            array_base->capacity = size;
+            array_base->size = size;
+            array->base.base.base.flags |= __OBJECT_FLAG_BORROWED;
+
+            reader->position += payload_size;
+            *out_children = 0;
+            return array;
+        }
+
+        // Otherwise, read the whole payload straight into the packed storage
+        if (__buffered_reader_charge(reader, size, element_size) || __internal_array_base_resize(array_base, size))
+            goto fail;
+
+        if (size > 0 && __dbof_1_read_packed_values_internal(reader, array_base->elements, size, element_size))
+            goto fail_eof;
+
+        array_base->size = size;
+        *out_children = 0;
+        return array;
+    }
+
+    // Pre-allocate the required storage space (the elements are read by the caller)
+    if (__buffered_reader_charge(reader, size, element_size))
+        goto fail;
+
+    if (__internal_array_base_reserve(array_base, __buffered_reader_presize(reader, size)))
+        goto fail;
+
+    *out_children = size;
+    return array;
+
+fail:
+fail_eof:
+fail_protocol:
+    __delete_object_typed_array(array);
+    return NULL;
+}
+
+static int __dbof_1_write_object_typed_array(dbof_object_typed_array array, struct __buffered_writer* writer)
+{
+    struct __object_typed_array_impl* array_impl = (struct __object_typed_array_impl*) array;
+
+    dbof_container_size size = __object_typed_array_impl_get_size(array_impl);
+    char element_type_id = array_impl->type;
+
+    // Write array length as flex length
+    if (__dbof_1_write_flex_length_internal(writer, size))
+        goto fail;
+
+    // Write element type ID
+    if (__buffered_writer_write(writer, &element_type_id, 1) < 1)
+        goto fail_eof;
+
+    if (array_impl->packed)
+    {
+        // Views may hold newer values than the packed storage
+        __object_typed_array_impl_sync_views(array_impl);
+
+        // Version 1 has a type ID before each element, so the elements are written one at a time
+        if (writer->version == 1)
+        {
+            const char* elements = array_impl->base.elements;
+            size_t element_size = array_impl->base.element_size;
+
+            for (dbof_container_size i = 0; i < size; ++i)
+            {
+                if (__dbof_1_write_child_type_internal(writer, array_impl->type)
+                        || __dbof_1_write_packed_values_internal(writer, elements + i * element_size, 1, element_size))
+                    goto fail_eof;
+            }
+
+            return 0;
+        }
+
+        // Write the whole payload straight from the packed storage (empty arrays may not have any)
+        if (size > 0 && __dbof_1_write_packed_values_internal(writer, array_impl->base.elements, size,
+                array_impl->base.element_size))
+            goto fail_eof;
+
+        return 0;
+    }
+
+    // Write each object individually (elements carry their type in version 1 only)
+    for (dbof_container_size i = 0; i < size; ++i)
+    {
+        if (__dbof_1_write_object(__object_typed_array_impl_get(array_impl, i), writer, writer->version == 1))
+            goto fail;
+    }
+
+    return 0;
+
+fail:
+fail_eof:
+    return -1;
+}
+
+static dbof_object_untyped_array __dbof_1_read_object_untyped_array(struct __buffered_reader* reader,
+        uint64_t* out_children)
+{
+    struct __object_untyped_array_impl* array = __new_object_untyped_array(reader->arena);
+
+    uint64_t size;
+
+    // Read array size as flex length
+    if (__dbof_1_read_flex_length_internal(reader, &size))
+        goto fail;
+
+    // Pre-allocate the required storage space (the elements are read by the caller)
+    if (__buffered_reader_charge(reader, size, sizeof(dbof_object)))
+        goto fail;
+
+    if (__object_untyped_array_impl_reserve(array, __buffered_reader_presize(reader, size)))
+        goto fail;
+
+    *out_children = size;
+    return array;
+
+fail:
+    __delete_object_untyped_array(array);
+    return NULL;
+}
+
+static int __dbof_1_write_object_untyped_array(dbof_object_untyped_array array, struct __buffered_writer* writer)
+{
+    struct __object_untyped_array_impl* array_impl = (struct __object_untyped_array_impl*) array;
+
+    dbof_container_size size = __object_untyped_array_impl_get_size(array_impl);
+
+    // Write array size as flex length
+    if (__dbof_1_write_flex_length_internal(writer, size))
+        goto fail;
+
+    // Write each object individually
+    for (dbof_container_size i = 0; i < size; ++i)
+    {
+        if (__dbof_1_write_object(__object_untyped_array_impl_get(array_impl, i), writer, 1))
+            goto fail_eof;
+    }
+
+    return 0;
+
+fail:
+fail_eof:
+    return -1;
+}
+
+
+/**
+ * Internal procedure for writing a key or value of a packed typed map.
+ *
+ * @param writer The writer
+ * @param type The key or value type
+ * @param cell The source cell
+ * @return Zero on success, otherwise nonzero
+ */
+static int __dbof_1_write_map_cell_internal(struct __buffered_writer* writer, dbof_type type,
+        const union __map_cell* cell)
+{
+    size_t packed_size = __packed_size_of(type);
+    if (packed_size > 0)
+        return __dbof_1_write_child_type_internal(writer, type)
+                || __dbof_1_write_packed_values_internal(writer, &cell->packed, 1, packed_size);
+
+    return __dbof_1_write_object(cell->object, writer, writer->version == 1);
+}
+
+/**
+ * Internal. Take the memory for the table of a map read from a stream out of the budget.
+ *
+ * @param reader The reader
+ * @param size The number of entries
+ * @param slot_size The size of one slot of the table
+ * @return Zero on success, otherwise nonzero
+ */
+static int __dbof_1_charge_map_internal(struct __buffered_reader* reader, uint64_t size, size_t slot_size)
+{
+    if (size > UINT64_MAX / __MAP_MAX_LOAD_DEN)
+        return -1;
+
+    // Tables are kept no fuller than the maximum load factor
+    return __buffered_reader_charge(reader, size * __MAP_MAX_LOAD_DEN / __MAP_MAX_LOAD_NUM + 1, slot_size);
+}
+
+static dbof_object_typed_map __dbof_1_read_object_typed_map(struct __buffered_reader* reader, uint64_t* out_children)
+{
+    struct __object_typed_map_impl* map = __new_object_typed_map(reader->arena);
+
+    uint64_t size;
+    char key_type_id;
+    char value_type_id;
+
+    // Read map size as flex length
+    if (__dbof_1_read_flex_length_internal(reader, &size))
+        goto fail;
+
+    // Read key type ID
+    if (__buffered_reader_read(reader, &key_type_id, 1) < 1)
+        goto fail_eof;
+
+    // Read value type ID
+    if (__buffered_reader_read(reader, &value_type_id, 1) < 1)
+        goto fail_eof;
+
+    // Typed maps of primitive types read straight into the packed table
+    __object_typed_map_impl_set_types(map, (dbof_type) key_type_id, (dbof_type) value_type_id);
+    if (map->key_type != (dbof_type) key_type_id || map->value_type != (dbof_type) value_type_id)
+        goto fail;
+
+    // Every entry is a key and a value
+    if (size > UINT64_MAX / 2)
+        goto fail_protocol;
+
+    if (__dbof_1_charge_map_internal(reader, size, __object_typed_map_impl_is_packed(map)
+            ? sizeof(struct __packed_map_slot) : sizeof(struct __map_slot)))
+        goto fail;
+
+    // Size the table for all entries up front
+    if (__object_typed_map_impl_reserve(map, __buffered_reader_presize(reader, size)))
+        goto fail;
+
+    // The keys and values are read by the caller
+    *out_children = size * 2;
+    return map;
+
+fail:
+fail_eof:
+fail_protocol:
+    __delete_object_typed_map(map);
+    return NULL;
+}
+
+static int __dbof_1_write_object_typed_map(dbof_object_typed_map object, struct __buffered_writer* writer)
+{
+    struct __object_typed_map_impl* map = (struct __object_typed_map_impl*) object;
+    struct __internal_map_base* map_base = (struct __internal_map_base*) map;
+
+    dbof_container_size size = __object_typed_map_impl_get_size(map);
+    char key_type_id = map->key_type;
+    char value_type_id = map->value_type;
+
+    // Write map size as flex length
+    if (__dbof_1_write_flex_length_internal(writer, size))
+        goto fail;
+
+    // Write key type ID
+    if (__buffered_writer_write(writer, &key_type_id, 1) < 1)
+        goto fail_eof;
+
+    // Write value type ID
+    if (__buffered_writer_write(writer, &value_type_id, 1) < 1)
+        goto fail_eof;
+
+    // Typed maps of primitive types write straight from the packed table
+    if (__object_typed_map_impl_is_packed(map))
+    {
+        for (dbof_container_size i = 0; i < map_base->capacity; ++i)
+        {
+            struct __packed_map_slot* slot = &map->packed_slots[i];
+            if (!slot->used)
+                continue;
+
+            __object_typed_map_impl_sync_view(map, i);
+
+            if (__dbof_1_write_map_cell_internal(writer, map->key_type, &slot->key))
+                goto fail_eof;
+            if (__dbof_1_write_map_cell_internal(writer, map->value_type, &slot->value))
+                goto fail_eof;
+        }
+
+        return 0;
+    }
+
+    // Write each key-value pair individually
+    for (dbof_container_size i = 0; i < map_base->capacity; ++i)
+    {
+        struct __map_slot* slot = &map_base->slots[i];
+        if (slot->key == NULL)
+            continue;
+
+        if (__dbof_1_write_object(slot->key, writer, writer->version == 1))
+            goto fail_eof;
+        if (__dbof_1_write_object(slot->value, writer, writer->version == 1))
+            goto fail_eof;
+    }
+
+    return 0;
+
+fail:
+fail_eof:
+    return -1;
+}
+
+static dbof_object_untyped_map __dbof_1_read_object_untyped_map(struct __buffered_reader* reader,
+        uint64_t* out_children)
+{
+    struct __object_untyped_map_impl* map = __new_object_untyped_map(reader->arena);
+
+    uint64_t size;
+
+    // Read map size as flex length
+    if (__dbof_1_read_flex_length_internal(reader, &size))
+        goto fail;
+
+    // Every entry is a key and a value
+    if (size > UINT64_MAX / 2)
+        goto fail_protocol;
+
+    if (__dbof_1_charge_map_internal(reader, size, sizeof(struct __map_slot)))
+        goto fail;
+
+    // Size the table for all entries up front
+    if (__object_untyped_map_impl_reserve(map, __buffered_reader_presize(reader, size)))
+        goto fail;
+
+    // The keys and values are read by the caller
+    *out_children = size * 2;
+    return map;
+
+fail:
+fail_protocol:
+    __delete_object_untyped_map(map);
+    return NULL;
+}
+
+static int __dbof_1_write_object_untyped_map(dbof_object_untyped_map map, struct __buffered_writer* writer)
+{
+    struct __object_untyped_map_impl* map_impl = (struct __object_untyped_map_impl*) map;
+    struct __internal_map_base* map_base = (struct __internal_map_base*) map_impl;
+
+    dbof_container_size size = __object_untyped_map_impl_get_size(map_impl);
+
+    // Write map size as flex length
+    if (__dbof_1_write_flex_length_internal(writer, size))
+        goto fail;
+
+    // Write each key-value pair individually
+    for (dbof_container_size i = 0; i < map_base->capacity; ++i)
+    {
+        struct __map_slot* slot = &map_base->slots[i];
+        if (slot->key == NULL)
+            continue;
+
+        if (__dbof_1_write_object(slot->key, writer, 1))
+            goto fail_eof;
+        if (__dbof_1_write_object(slot->value, writer, 1))
+            goto fail_eof;
+    }
+
+    return 0;
+
+fail:
+fail_eof:
+    return -1;
+}
+
+/**
+ * Internal. Read an object in DBOF-1 format whose type is known, except for the children of containers. Value objects
+ * are read completely, as are packed typed arrays.
+ *
+ * @param reader The reader
+ * @param type_id The object type
+ * @param out_children The number of children (elements, or keys and values) left to read
+ * @return The read object or NULL if an error occurred
+ */
+static dbof_object __dbof_1_read_object_shallow(struct __buffered_reader* reader, char type_id,
+        uint64_t* out_children)
+{
+    *out_children = 0;
+
+    // Account for the object itself (its storage is accounted for by the type's read function)
+    if (__buffered_reader_charge(reader, 1, __object_size_of((dbof_type) type_id)))
+        return NULL;
+
+    // Delegate to appropriate read function
+    switch (type_id)
+    {
+    case DBOF_TYPE_NULL:
+        return __dbof_1_read_object_null(reader);
+    case DBOF_TYPE_SIGNED_BYTE:
+        return __dbof_1_read_object_signed_byte(reader);
+    case DBOF_TYPE_UNSIGNED_BYTE:
+        return __dbof_1_read_object_unsigned_byte(reader);
+    case DBOF_TYPE_SIGNED_INTEGER:
+        return __dbof_1_read_object_signed_integer(reader);
+    case DBOF_TYPE_UNSIGNED_INTEGER:
+        return __dbof_1_read_object_unsigned_integer(reader);
+    case DBOF_TYPE_SIGNED_LONG_INTEGER:
+        return __dbof_1_read_object_signed_long_integer(reader);
+    case DBOF_TYPE_UNSIGNED_LONG_INTEGER:
+        return __dbof_1_read_object_unsigned_long_integer(reader);
+    case DBOF_TYPE_BOOLEAN:
+        return __dbof_1_read_object_boolean(reader);
+    case DBOF_TYPE_SINGLE_FLOAT:
+        return __dbof_1_read_object_single_float(reader);
+    case DBOF_TYPE_DOUBLE_FLOAT:
+        return __dbof_1_read_object_double_float(reader);
+    case DBOF_TYPE_CHARACTER:
+        return __dbof_1_read_object_character(reader);
+    case DBOF_TYPE_UTF8_STRING:
+        return __dbof_1_read_object_utf8_string(reader);
+    case DBOF_TYPE_TYPED_ARRAY:
+        return __dbof_1_read_object_typed_array(reader, out_children);
+    case DBOF_TYPE_UNTYPED_ARRAY:
+        return __dbof_1_read_object_untyped_array(reader, out_children);
+    case DBOF_TYPE_TYPED_MAP:
+        return __dbof_1_read_object_typed_map(reader, out_children);
+    case DBOF_TYPE_UNTYPED_MAP:
+        return __dbof_1_read_object_untyped_map(reader, out_children);
+    default:
+        // ERROR: Unrecognized object type ID
+        return NULL;
+    }
+}
+
+//
+// NOTICE
+// Objects are read with an explicit stack of the containers still waiting for children rather than by recursion, so
+// the nesting depth of a document is bounded by the reader's max_depth and the heap, not the C stack. Deleting and
+// writing objects still recurse, which is why readers have a finite max_depth by default. Children go straight into
+// their container's storage, as their types were already checked against it when they were read.
+//
+
+/**
+ * A container being read.
+ */
+struct __read_frame
+{
+    /**
+     * The container.
+     */
+    dbof_object container;
+
+    /**
+     * The number of children (elements, or keys and values) left to read.
+     */
+    uint64_t remaining;
+
+    /**
+     * The key read for the next entry (maps). Only valid while has_key is nonzero.
+     */
+    union __map_cell key;
+
+    /**
+     * Nonzero if the key of the next entry was read and its value is next.
+     */
+    int has_key;
+};
+
+/**
+ * Internal. Delete a container being read along with its pending key.
+ */
+static void __read_frame_free(struct __read_frame* frame)
+{
+    if (frame->has_key && !(dbof_typeof(frame->container) == DBOF_TYPE_TYPED_MAP
+            && ((struct __object_typed_map_impl*) frame->container)->packed_keys))
+    {
+        dbof_delete(frame->key.object);
+    }
+
+    dbof_delete(frame->container);
+}
+
+/**
+ * Internal. Add a child to a container being read. The container takes ownership of the child, even on failure.
+ *
+ * @param frame The container
+ * @param child The child (an object, or a packed value for packed typed maps)
+ * @return Zero on success, otherwise nonzero
+ */
+static int __read_frame_add(struct __read_frame* frame, union __map_cell child)
+{
+    frame->remaining--;
+
+    switch (dbof_typeof(frame->container))
+    {
+    case DBOF_TYPE_TYPED_ARRAY:
+    case DBOF_TYPE_UNTYPED_ARRAY:
+        return __internal_array_base_insert(frame->container, ((struct __internal_array_base*) frame->container)->size,
+                child.object);
+    default:
+        break;
+    }
+
+    // Keys wait for their values
+    if (!frame->has_key)
+    {
+        frame->key = child;
+        frame->has_key = 1;
+        return 0;
+    }
+
+    frame->has_key = 0;
+
+    struct __object_typed_map_impl* map = frame->container;
+    if (dbof_typeof(map) == DBOF_TYPE_UNTYPED_MAP)
+        return __internal_map_base_put(frame->container, frame->key.object, child.object);
+
+    // Entries of the wrong types fail the read rather than going missing
+    if (!__object_typed_map_impl_is_packed(map))
+        return __object_typed_map_impl_put(map, frame->key.object, child.object);
+
+    struct __packed_map_key key;
+    key.cell = frame->key;
+
+    if (map->packed_keys)
+    {
+        __object_typed_map_impl_finish_key(map, &key);
+    }
+    else
+    {
+        key.chars = NULL;
+        key.hash = (unsigned int) dbof_hash(key.cell.object);
+    }
+
+    if (__object_typed_map_impl_put_packed(map, &key, child) == NULL)
+    {
+        if (!map->packed_keys)
+        {
+            dbof_delete(key.cell.object);
+        }
+        if (!map->packed_values)
+        {
+            dbof_delete(child.object);
+        }
+        return -1;
+    }
+
+    return 0;
+}
+
+/**
+ * Internal. Find out how to read the next child of a container being read. Packed keys and values of typed maps are
+ * read and added right away.
+ *
+ * @param reader The reader
+ * @param frame The container
+ * @param read_type Set to whether the child carries its type
+ * @param type Set to the type of the child if it does not carry it
+ * @return Zero if a child object is next, one if the container is done, or -1 if an error occurred
+ */
+static int __read_frame_next(struct __buffered_reader* reader, struct __read_frame* frame, int* read_type,
+        dbof_type* type)
+{
+    while (frame->remaining > 0)
+    {
+        switch (dbof_typeof(frame->container))
+        {
+        case DBOF_TYPE_TYPED_ARRAY:
+            *read_type = 0;
+            *type = ((struct __object_typed_array_impl*) frame->container)->type;
+            return __dbof_1_read_child_type_internal(reader, *type);
+        case DBOF_TYPE_TYPED_MAP:
+        {
+            struct __object_typed_map_impl* map = frame->container;
+            dbof_type cell_type = frame->has_key ? map->value_type : map->key_type;
+
+            if (__dbof_1_read_child_type_internal(reader, cell_type))
+                return -1;
+
+            size_t packed_size = __object_typed_map_impl_is_packed(map) ? __packed_size_of(cell_type) : 0;
+            if (packed_size == 0)
+            {
+                *read_type = 0;
+                *type = cell_type;
+                return 0;
+            }
+
+            union __map_cell cell;
+            cell.packed = 0;
+
+            if (__dbof_1_read_packed_values_internal(reader, &cell.packed, 1, packed_size) || __read_frame_add(frame,
+                    cell))
+                return -1;
+
+            break;
+        }
+        default:
+            *read_type = 1;
+            *type = DBOF_TYPE_NULL;
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+static dbof_object __dbof_1_read_object(struct __buffered_reader* reader, int read_type, dbof_type type)
+{
+    struct __read_frame local[__DEEP_STACK_LOCAL];
+    struct __deep_stack stack;
+    __deep_stack_init(&stack, local, __DEEP_STACK_LOCAL, sizeof(struct __read_frame));
+
+    for (;;)
+    {
+        // Read object type ID, unless the container already told us
+        char type_id = type;
+        if (read_type && __buffered_reader_read(reader, &type_id, 1) < 1)
+            goto fail;
+
+        // Containers count toward the depth even if empty (the reader's depth counts containers around the object)
+        if (reader->max_depth != 0 && dbof_is_container_type((dbof_type) type_id)
+                && stack.count + reader->depth >= reader->max_depth)
+        {
+            // ERROR: Nesting too deep
+            goto fail;
+        }
+
+        uint64_t children;
+        dbof_object object = __dbof_1_read_object_shallow(reader, type_id, &children);
+        if (object == NULL)
+            goto fail;
+
+        // Containers with children wait for them on the stack
+        if (children > 0)
+        {
+            struct __read_frame* frame = __deep_stack_push(&stack);
+            if (frame == NULL)
+            {
+                dbof_delete(object);
+                goto fail;
+            }
+
+            frame->container = object;
+            frame->remaining = children;
+            frame->has_key = 0;
+        }
+        else if (stack.count == 0)
+        {
+            // The top-level object is done
+            __deep_stack_free(&stack);
+            return object;
+        }
+        else
+        {
+            union __map_cell child;
+            child.object = object;
+
+            if (__read_frame_add(__deep_stack_top(&stack), child))
+                goto fail;
+        }
+
+        // Hand finished containers up to their parents until one needs another child
+        for (;;)
+        {
+            struct __read_frame* frame = __deep_stack_top(&stack);
+
+            int result = __read_frame_next(reader, frame, &read_type, &type);
+            if (result < 0)
+                goto fail;
+
+            if (result == 0)
+                break;
+
+            union __map_cell child;
+            child.object = frame->container;
+            stack.count--;
+
+            if (stack.count == 0)
+            {
+                __deep_stack_free(&stack);
+                return child.object;
+            }
+
+            if (__read_frame_add(__deep_stack_top(&stack), child))
+                goto fail;
+        }
+    }
+
+fail:
+    // Everything read so far hangs off the containers on the stack
+    while (stack.count > 0)
+    {
+        __read_frame_free(__deep_stack_top(&stack));
+        stack.count--;
+    }
+
+    __deep_stack_free(&stack);
+    return NULL;
+}
+
+static int __dbof_1_write_object(dbof_object object, struct __buffered_writer* writer, int write_type)
+{
+    // Write object type ID, unless the container records it
+    // We rely on an equivalence between enum ordinal and object type ID
+    // This is guaranteed as of right now, but not documented in the header
+    char type_id = dbof_typeof(object);
+    if (write_type && __buffered_writer_write(writer, &type_id, 1) < 1)
+        return -1;
+
+    // Delegate to appropriate write function
+    switch (type_id)
+    {
+    case DBOF_TYPE_NULL:
+        return __dbof_1_write_object_null(object, writer);
+    case DBOF_TYPE_SIGNED_BYTE:
+        return __dbof_1_write_object_signed_byte(object, writer);
+    case DBOF_TYPE_UNSIGNED_BYTE:
+        return __dbof_1_write_object_unsigned_byte(object, writer);
+    case DBOF_TYPE_SIGNED_INTEGER:
+        return __dbof_1_write_object_signed_integer(object, writer);
+    case DBOF_TYPE_UNSIGNED_INTEGER:
+        return __dbof_1_write_object_unsigned_integer(object, writer);
+    case DBOF_TYPE_SIGNED_LONG_INTEGER:
+        return __dbof_1_write_object_signed_long_integer(object, writer);
+    case DBOF_TYPE_UNSIGNED_LONG_INTEGER:
+        return __dbof_1_write_object_unsigned_long_integer(object, writer);
+    case DBOF_TYPE_BOOLEAN:
+        return __dbof_1_write_object_boolean(object, writer);
+    case DBOF_TYPE_SINGLE_FLOAT:
+        return __dbof_1_write_object_single_float(object, writer);
+    case DBOF_TYPE_DOUBLE_FLOAT:
+        return __dbof_1_write_object_double_float(object, writer);
+    case DBOF_TYPE_CHARACTER:
+        return __dbof_1_write_object_character(object, writer);
+    case DBOF_TYPE_UTF8_STRING:
+        return __dbof_1_write_object_string(object, writer);
+    case DBOF_TYPE_TYPED_ARRAY:
+        return __dbof_1_write_object_typed_array(object, writer);
+    case DBOF_TYPE_UNTYPED_ARRAY:
+        return __dbof_1_write_object_untyped_array(object, writer);
+    case DBOF_TYPE_TYPED_MAP:
+        return __dbof_1_write_object_typed_map(object, writer);
+    case DBOF_TYPE_UNTYPED_MAP:
+        return __dbof_1_write_object_untyped_map(object, writer);
+    default:
+        // ERROR: Unrecognized object type ID
+        return -1;
+    }
+}
+
+/**
+ * Internal. Read the header of a container in DBOF-1 format whose type is known.
+ *
+ * @param reader The reader
+ * @param type_id The container type
+ * @param out_size Set to the number of elements or entries
+ * @param out_key_type Set to the element type (typed arrays) or the key type (typed maps)
+ * @param out_value_type Set to the value type (typed maps)
+ * @return Zero on success, otherwise nonzero
+ */
+static int __dbof_1_read_container_header(struct __buffered_reader* reader, char type_id, uint64_t* out_size,
+        dbof_type* out_key_type, dbof_type* out_value_type)
+{
+    char key_type_id = DBOF_TYPE_NULL;
+    char value_type_id = DBOF_TYPE_NULL;
+
+    // Read container size as flex length
+    if (__dbof_1_read_flex_length_internal(reader, out_size))
+        return -1;
+
+    // Typed arrays carry their element type, and typed maps their key and value types
+    if ((type_id == DBOF_TYPE_TYPED_ARRAY || type_id == DBOF_TYPE_TYPED_MAP)
+            && __buffered_reader_read(reader, &key_type_id, 1) < 1)
+        return -1;
+
+    if (type_id == DBOF_TYPE_TYPED_MAP && __buffered_reader_read(reader, &value_type_id, 1) < 1)
+        return -1;
+
+    *out_key_type = (dbof_type) key_type_id;
+    *out_value_type = (dbof_type) value_type_id;
+    return 0;
+}
+
+//
+// NOTICE
+// Like reading, skipping and parsing keep an explicit stack of the containers still waiting for children, so no input
+// can overflow the C stack. Every container on the stack has been entered (it counts toward the reader's depth), and
+// leaves once its last child is done.
+//
+
+/**
+ * A container being skipped or parsed.
+ */
+struct __walk_frame
+{
+    /**
+     * The container type.
+     */
+    dbof_type type;
+
+    /**
+     * The element type (typed arrays) or the key type (typed maps).
+     */
+    dbof_type key_type;
+
+    /**
+     * The value type (typed maps).
+     */
     dbof_type value_type;
+
+    /**
+     * The number of children (elements, or keys and values) left.
+     */
+    uint64_t remaining;
 };
 
-static dbof_container_size __object_typed_map_impl_get_capacity(struct __object_typed_map_impl* map)
-{ return __internal_map_base_get_capacity((struct __internal_map_base*) map); }
+/**
+ * Internal. Set up a frame for the children of a container. Returns zero on success, or nonzero if the container is
+ * too big to have been written.
+ */
+static int __walk_frame_init(struct __walk_frame* frame, dbof_type type, uint64_t size, dbof_type key_type,
+        dbof_type value_type)
+{
+    if ((type == DBOF_TYPE_TYPED_MAP || type == DBOF_TYPE_UNTYPED_MAP) && size > UINT64_MAX / 2)
+    {
+        // ERROR: Map too big
+        return -1;
+    }
 
-static dbof_container_size __object_typed_map_impl_get_size(struct __object_typed_map_impl* map)
-{ return __internal_map_base_get_size((struct __internal_map_base*) map); }
+    frame->type = type;
+    frame->key_type = key_type;
+    frame->value_type = value_type;
+    frame->remaining = type == DBOF_TYPE_TYPED_MAP || type == DBOF_TYPE_UNTYPED_MAP ? size * 2 : size;
+    return 0;
+}
 
-static int __object_typed_map_impl_is_empty(struct __object_typed_map_impl* map)
-{ return __internal_map_base_is_empty((struct __internal_map_base*) map); }
+/**
+ * Internal. Take the next child of a container off its frame.
+ *
+ * @param reader The reader
+ * @param frame The container
+ * @param read_type Set to whether the child carries its type
+ * @param type Set to the type of the child if it does not carry it
+ */
+static void __walk_frame_next(struct __buffered_reader* reader, struct __walk_frame* frame, int* read_type,
+        dbof_type* type)
+{
+    // Keys come before values, so they take the even counts
+    int key = frame->remaining % 2 == 0;
+    frame->remaining--;
 
-static dbof_type __object_typed_map_impl_get_key_type(struct __object_typed_map_impl* map)
-{ return map->key_type; }
+    // Children of typed containers carry their type in version 1 only (where it is just read over when skipping)
+    *read_type = frame->type == DBOF_TYPE_UNTYPED_ARRAY || frame->type == DBOF_TYPE_UNTYPED_MAP;
+    *type = frame->type == DBOF_TYPE_TYPED_MAP && !key ? frame->value_type : frame->key_type;
+
+    if (!*read_type && reader->version == 1)
+    {
+        *read_type = 1;
+    }
+}
+
+/**
+ * Internal. Leave the containers still on a stack, and free the stack.
+ *
+ * @param reader The reader
+ * @param stack The stack
+ * @param entered The number of containers on the stack that were entered
+ */
+static void __walk_leave(struct __buffered_reader* reader, struct __deep_stack* stack, size_t entered)
+{
+    reader->depth -= entered;
+    __deep_stack_free(stack);
+}
+
+/**
+ * Internal. Skip the payload of a typed array in one go if it is packed (or holds nulls, which have none).
+ *
+ * @param reader The reader
+ * @param element_type The element type
+ * @param size The number of elements
+ * @return Zero on success, one if the elements need to be skipped one by one, or -1 if an error occurred
+ */
+static int __dbof_1_skip_packed_children(struct __buffered_reader* reader, dbof_type element_type, uint64_t size)
+{
+    size_t element_size = __packed_size_of(element_type);
+    if (element_size == 0 && element_type != DBOF_TYPE_NULL)
+        return 1;
+
+    // Version 1 has a type ID before each value
+    uint64_t stride = element_size + (reader->version == 1);
+    if (stride > 0 && size > UINT64_MAX / stride)
+        return -1;
+
+    return __buffered_reader_skip(reader, size * stride) ? -1 : 0;
+}
+
+/**
+ * Internal. Skip an object in DBOF-1 format whose type is known and is not a container.
+ *
+ * @param reader The reader
+ * @param type_id The object type
+ * @return Zero on success, otherwise nonzero
+ */
+static int __dbof_1_skip_object_contents(struct __buffered_reader* reader, char type_id)
+{
+    uint64_t size;
+
+    switch (type_id)
+    {
+    case DBOF_TYPE_NULL:
+        return 0;
+    case DBOF_TYPE_SIGNED_BYTE:
+    case DBOF_TYPE_UNSIGNED_BYTE:
+    case DBOF_TYPE_SIGNED_INTEGER:
+    case DBOF_TYPE_UNSIGNED_INTEGER:
+    case DBOF_TYPE_SIGNED_LONG_INTEGER:
+    case DBOF_TYPE_UNSIGNED_LONG_INTEGER:
+    case DBOF_TYPE_BOOLEAN:
+    case DBOF_TYPE_SINGLE_FLOAT:
+    case DBOF_TYPE_DOUBLE_FLOAT:
+    case DBOF_TYPE_CHARACTER:
+        return __buffered_reader_skip(reader, __packed_size_of((dbof_type) type_id));
+    case DBOF_TYPE_UTF8_STRING:
+        if (__dbof_1_read_flex_length_internal(reader, &size))
+            return -1;
+
+        return __buffered_reader_skip(reader, size);
+    default:
+        // ERROR: Unrecognized object type ID
+        return -1;
+    }
+}
+
+/**
+ * Internal. Skip the children of a container in DBOF-1 format whose header has been read without allocating anything
+ * (beyond the stack of containers, for deeply nested ones). The container itself has been entered by the caller.
+ *
+ * @param reader The reader
+ * @param type The container type
+ * @param size The number of elements or entries
+ * @param key_type The element type (typed arrays) or the key type (typed maps)
+ * @param value_type The value type (typed maps)
+ * @return Zero on success, otherwise nonzero
+ */
+static int __dbof_1_skip_children(struct __buffered_reader* reader, dbof_type type, uint64_t size, dbof_type key_type,
+        dbof_type value_type)
+{
+    if (type == DBOF_TYPE_TYPED_ARRAY)
+    {
+        int result = __dbof_1_skip_packed_children(reader, key_type, size);
+        if (result <= 0)
+            return result;
+    }
+
+    struct __walk_frame local[__DEEP_STACK_LOCAL];
+    struct __deep_stack stack;
+    __deep_stack_init(&stack, local, __DEEP_STACK_LOCAL, sizeof(struct __walk_frame));
+
+    // The container at the bottom was entered by the caller
+    if (__walk_frame_init(__deep_stack_push(&stack), type, size, key_type, value_type))
+    {
+        __deep_stack_free(&stack);
+        return -1;
+    }
+
+    while (stack.count > 0)
+    {
+        struct __walk_frame* frame = __deep_stack_top(&stack);
+
+        // Leave finished containers
+        if (frame->remaining == 0)
+        {
+            stack.count--;
+            if (stack.count > 0)
+            {
+                reader->depth--;
+            }
+            continue;
+        }
+
+        int read_type;
+        dbof_type child_type;
+        __walk_frame_next(reader, frame, &read_type, &child_type);
+
+        // Read object type ID, unless the container already told us
+        char type_id = child_type;
+        if (read_type && __buffered_reader_read(reader, &type_id, 1) < 1)
+            goto fail;
+
+        if (!dbof_is_container_type((dbof_type) type_id))
+        {
+            if (__dbof_1_skip_object_contents(reader, type_id))
+                goto fail;
+            continue;
+        }
+
+        if (__buffered_reader_enter(reader))
+            goto fail;
+
+        uint64_t child_size;
+        dbof_type child_key_type;
+        dbof_type child_value_type;
+        if (__dbof_1_read_container_header(reader, type_id, &child_size, &child_key_type, &child_value_type))
+        {
+            reader->depth--;
+            goto fail;
+        }
+
+        int packed = type_id == DBOF_TYPE_TYPED_ARRAY
+                ? __dbof_1_skip_packed_children(reader, child_key_type, child_size) : 1;
+        if (packed < 0)
+        {
+            reader->depth--;
+            goto fail;
+        }
+
+        // Containers with children wait for them on the stack
+        if (packed == 0 || child_size == 0)
+        {
+            reader->depth--;
+            continue;
+        }
+
+        struct __walk_frame* child = __deep_stack_push(&stack);
+        if (child == NULL || __walk_frame_init(child, (dbof_type) type_id, child_size, child_key_type,
+                child_value_type))
+        {
+            if (child != NULL)
+            {
+                stack.count--;
+            }
+
+            reader->depth--;
+            goto fail;
+        }
+    }
+
+    __deep_stack_free(&stack);
+    return 0;
+
+fail:
+    __walk_leave(reader, &stack, stack.count - 1);
+    return -1;
+}
+
+#ifdef DBOF_THREADS
+
+/**
+ * Internal. Skip an object in DBOF-1 format without allocating anything (beyond the stack of containers, for deeply
+ * nested ones). Only the parallel reader needs to skip whole objects.
+ *
+ * @param reader The reader
+ * @param read_type Whether to read the object type (nonzero) or not (zero)
+ * @param type The object type if it is not read
+ * @return Zero on success, otherwise nonzero
+ */
+static int __dbof_1_skip_object(struct __buffered_reader* reader, int read_type, dbof_type type)
+{
+    // Read object type ID, unless the container already told us
+    char type_id = type;
+    if (read_type && __buffered_reader_read(reader, &type_id, 1) < 1)
+        return -1;
+
+    if (!dbof_is_container_type((dbof_type) type_id))
+        return __dbof_1_skip_object_contents(reader, type_id);
+
+    // Containers count toward the depth
+    if (__buffered_reader_enter(reader))
+        return -1;
+
+    uint64_t size;
+    dbof_type key_type;
+    dbof_type value_type;
+    int result = __dbof_1_read_container_header(reader, type_id, &size, &key_type, &value_type)
+            || __dbof_1_skip_children(reader, (dbof_type) type_id, size, key_type, value_type) ? -1 : 0;
+    reader->depth--;
+
+    return result;
+}
+
+#endif
+
+/**
+ * Internal. Turn a handler's answer into a parse result. Skipping is only meaningful when beginning a container, so
+ * anywhere else it just means continue.
+ */
+static int __dbof_1_parse_result(int result)
+{ return result == DBOF_PARSE_SKIP ? DBOF_PARSE_CONTINUE : result; }
+
+/**
+ * Internal. Hand a string too large for the read buffer to the handler piece by piece, as the buffer fills up.
+ */
+static int __dbof_1_parse_string_pieces(struct __buffered_reader* reader, dbof_handler* handler, uint64_t length)
+{
+    while (length > 0)
+    {
+        if (reader->position == reader->limit && __buffered_reader_peek(reader, 1) == NULL)
+        {
+            // ERROR: End of file
+            return -1;
+        }
+
+        size_t available = reader->limit - reader->position;
+        size_t size = length < available ? (size_t) length : available;
+        const char* piece = reader->buffer + reader->position;
+
+        reader->position += size;
+        length -= size;
+
+        int result = handler->string_data(handler, piece, size, (dbof_string_size) length);
+        if (result == DBOF_PARSE_SKIP)
+            return __buffered_reader_skip(reader, length);
+
+        if (result != DBOF_PARSE_CONTINUE)
+            return result;
+    }
+
+    return 0;
+}
+
+/**
+ * Internal. Copy a string too large for the read buffer out whole and hand it to the handler. The copy counts against
+ * the allocation budget while it exists.
+ */
+static int __dbof_1_parse_string_copy(struct __buffered_reader* reader, dbof_handler* handler, uint64_t length)
+{
+    if (__buffered_reader_charge(reader, length, 1))
+        return -1;
+
+    int result = -1;
 
-static void __object_typed_map_impl_set_key_type(struct __object_typed_map_impl* map, dbof_type key_type)
-{
-    // Only change the key type if the map is empty
-    if (__object_typed_map_impl_is_empty(map))
+    char* copy = __buffered_reader_read_alloc(reader, length);
+    if (copy != NULL)
     {
-        map->key_type = key_type;
+        result = __dbof_1_parse_result(handler->string(handler, copy, (dbof_string_size) length));
+        free(copy);
     }
-}
 
-static dbof_type __object_typed_map_impl_get_value_type(struct __object_typed_map_impl* map)
-{ return map->value_type; }
+    // The copy is gone, so the budget gets it back
+    if (reader->budget != UINT64_MAX)
+    {
+        reader->budget += length;
+    }
 
-static void __object_typed_map_impl_set_key_value(struct __object_typed_map_impl* map, dbof_type value_type)
+    return result;
+}
+
+static int __dbof_1_parse_string(struct __buffered_reader* reader, dbof_handler* handler)
 {
-    // Only change the value type if the map is empty
-    if (__object_typed_map_impl_is_empty(map))
+    uint64_t length;
+    if (__dbof_1_read_flex_length_internal(reader, &length))
+        return -1;
+
+    // An in-memory source holds everything there is, so a longer string is truncated input
+    if (reader->source == NULL && length > reader->limit - reader->position)
     {
-        map->value_type = value_type;
+        // ERROR: End of file
+        return -1;
     }
-}
 
-static dbof_object __object_typed_map_impl_get(struct __object_typed_map_impl* map, dbof_object key)
-{ return __internal_map_base_get((struct __internal_map_base*) map, key); }
+    if (handler->string == NULL && handler->string_data == NULL)
+        return __buffered_reader_skip(reader, length);
 
-static void __object_typed_map_impl_put(struct __object_typed_map_impl* map, dbof_object key, dbof_object value)
-{ __internal_map_base_put((struct __internal_map_base*) map, key, value); }
+    // Strings that fit the buffer are handed out in place
+    const char* value = __buffered_reader_peek(reader, length);
+    if (value != NULL)
+    {
+        reader->position += length;
 
-static dbof_object __object_typed_map_impl_remove(struct __object_typed_map_impl* map, dbof_object key)
-{ return __internal_map_base_remove((struct __internal_map_base*) map, key); }
+        if (handler->string == NULL)
+            return __dbof_1_parse_result(handler->string_data(handler, value, length, 0));
 
-static int __object_typed_map_impl_has_key(struct __object_typed_map_impl* map, dbof_object key)
-{ return __internal_map_base_has_key((struct __internal_map_base*) map, key); }
+        return __dbof_1_parse_result(handler->string(handler, value, length));
+    }
 
-static struct __object_typed_map_impl* __new_object_typed_map()
-{ return __new_empty_object(DBOF_TYPE_TYPED_MAP, sizeof(struct __object_typed_map_impl)); }
+    // Larger ones come in pieces, or are copied out if the handler wants them whole
+    if (handler->string_data != NULL)
+        return __dbof_1_parse_string_pieces(reader, handler, length);
 
-static void __delete_object_typed_map(struct __object_typed_map_impl* map)
-{
-    __internal_map_base_destruct((struct __internal_map_base*) map);
-    free(map);
+    return __dbof_1_parse_string_copy(reader, handler, length);
 }
 
-static int __hash_object_typed_map(struct __object_typed_map_impl* object)
-{ return 0; } // TODO
-
-/**
- * Implementation of an untyped map object (type ID 131).
- */
-struct __object_untyped_map_impl
+static int __dbof_1_parse_packed_values(struct __buffered_reader* reader, dbof_handler* handler,
+        dbof_type element_type, uint64_t size)
 {
-    struct __internal_map_base base;
-};
-
-static dbof_container_size __object_untyped_map_impl_get_capacity(struct __object_untyped_map_impl* map)
-{ return __internal_map_base_get_capacity((struct __internal_map_base*) map); }
-
-static dbof_container_size __object_untyped_map_impl_get_size(struct __object_untyped_map_impl* map)
-{ return __internal_map_base_get_size((struct __internal_map_base*) map); }
-
-static int __object_untyped_map_impl_is_empty(struct __object_untyped_map_impl* map)
-{ return __internal_map_base_is_empty((struct __internal_map_base*) map); }
-
-static dbof_object __object_untyped_map_impl_get(struct __object_untyped_map_impl* map, dbof_object key)
-{ return __internal_map_base_get((struct __internal_map_base*) map, key); }
+    size_t element_size = __packed_size_of(element_type);
 
-static void __object_untyped_map_impl_put(struct __object_untyped_map_impl* map, dbof_object key, dbof_object value)
-{ __internal_map_base_put((struct __internal_map_base*) map, key, value); }
+    // Values are handed out in aligned chunks
+    uint64_t chunk[512];
+    size_t chunk_count = sizeof(chunk) / element_size;
 
-static dbof_object __object_untyped_map_impl_remove(struct __object_untyped_map_impl* map, dbof_object key)
-{ return __internal_map_base_remove((struct __internal_map_base*) map, key); }
+    while (size > 0)
+    {
+        size_t n = size < chunk_count ? (size_t) size : chunk_count;
 
-static int __object_untyped_map_impl_has_key(struct __object_untyped_map_impl* map, dbof_object key)
-{ return __internal_map_base_has_key((struct __internal_map_base*) map, key); }
+        // Version 1 has a type ID before each value, so the values are read one at a time
+        if (reader->version == 1)
+        {
+            for (size_t i = 0; i < n; ++i)
+            {
+                if (__dbof_1_read_child_type_internal(reader, element_type)
+                        || __dbof_1_read_packed_values_internal(reader, (char*) chunk + i * element_size, 1,
+                        element_size))
+                    return -1;
+            }
+        }
+        else if (__dbof_1_read_packed_values_internal(reader, chunk, n, element_size))
+            return -1;
 
-static struct __object_untyped_map_impl* __new_object_untyped_map()
-{ return __new_empty_object(DBOF_TYPE_UNTYPED_MAP, sizeof(struct __object_untyped_map_impl)); }
+        size -= n;
 
-static void __delete_object_untyped_map(struct __object_untyped_map_impl* object)
-{
-    __internal_map_base_destruct((struct __internal_map_base*) object);
-    free(object);
-}
+        int result = DBOF_PARSE_CONTINUE;
+        if (handler->array_data != NULL)
+        {
+            result = __dbof_1_parse_result(handler->array_data(handler, element_type, chunk, n));
+        }
+        else if (handler->scalar != NULL)
+        {
+            // Without a bulk handler, each value is its own event
+            for (size_t i = 0; i < n && result == DBOF_PARSE_CONTINUE; ++i)
+            {
+                result = __dbof_1_parse_result(handler->scalar(handler, element_type,
+                        (const dbof_value*) ((const char*) chunk + i * element_size)));
+            }
+        }
 
-static int __hash_object_untyped_map(struct __object_untyped_map_impl* object)
-{ return 0; } // TODO
+        if (result != DBOF_PARSE_CONTINUE)
+            return result;
+    }
 
-dbof_type dbof_typeof(dbof_object object)
-{
-    return ((struct __object_impl*) object)->type;
+    return 0;
 }
 
-dbof_object dbof_new(dbof_type type)
+/**
+ * Internal. Parse an object in DBOF-1 format whose type is known, emitting its events to the handler. Containers are
+ * begun (and entered) here, and if they have children to parse, they are pushed onto the stack to wait for them.
+ * Otherwise, they are done (and left) here, too.
+ *
+ * @param reader The reader
+ * @param handler The handler
+ * @param stack The stack of containers
+ * @param type_id The object type
+ * @return Zero on success, a handler's abort code, or -1 if an error occurred
+ */
+static int __dbof_1_parse_one(struct __buffered_reader* reader, dbof_handler* handler, struct __deep_stack* stack,
+        char type_id)
 {
-    dbof_object object = NULL;
+    dbof_value value;
+    memset(&value, 0, sizeof(value));
 
-    switch (type)
+    switch (type_id)
     {
     case DBOF_TYPE_NULL:
-        object = __new_object_null();
-        break;
+        return handler->scalar == NULL ? 0 : __dbof_1_parse_result(handler->scalar(handler, DBOF_TYPE_NULL, &value));
     case DBOF_TYPE_SIGNED_BYTE:
-        object = __new_object_signed_byte();
-        break;
     case DBOF_TYPE_UNSIGNED_BYTE:
-        object = __new_object_unsigned_byte();
-        break;
     case DBOF_TYPE_SIGNED_INTEGER:
-        object = __new_object_signed_integer();
-        break;
     case DBOF_TYPE_UNSIGNED_INTEGER:
-        object = __new_object_unsigned_integer();
-        break;
     case DBOF_TYPE_SIGNED_LONG_INTEGER:
-        object = __new_object_signed_long_integer();
-        break;
     case DBOF_TYPE_UNSIGNED_LONG_INTEGER:
-        object = __new_object_unsigned_long_integer();
-        break;
     case DBOF_TYPE_BOOLEAN:
-        object = __new_object_boolean();
-        break;
     case DBOF_TYPE_SINGLE_FLOAT:
-        object = __new_object_single_float();
-        break;
     case DBOF_TYPE_DOUBLE_FLOAT:
-        object = __new_object_double_float();
-        break;
     case DBOF_TYPE_CHARACTER:
-        object = __new_object_character();
-        break;
+        // Every union member sits at the start, so a packed value drops right in
+        if (__dbof_1_read_packed_values_internal(reader, &value, 1, __packed_size_of((dbof_type) type_id)))
+            return -1;
+
+        return handler->scalar == NULL ? 0 : __dbof_1_parse_result(handler->scalar(handler, (dbof_type) type_id,
+                &value));
     case DBOF_TYPE_UTF8_STRING:
-        object = __new_object_utf8_string();
-        break;
+        return __dbof_1_parse_string(reader, handler);
     case DBOF_TYPE_TYPED_ARRAY:
-        object = __new_object_typed_array();
-        break;
     case DBOF_TYPE_UNTYPED_ARRAY:
-        object = __new_object_untyped_array();
-        break;
     case DBOF_TYPE_TYPED_MAP:
-        object = __new_object_typed_map();
-        break;
     case DBOF_TYPE_UNTYPED_MAP:
-        object = __new_object_untyped_map();
         break;
+    default:
+        // ERROR: Unrecognized object type ID
+        return -1;
     }
 
-    if (object == NULL)
+    // Containers count toward the depth
+    if (__buffered_reader_enter(reader))
+        return -1;
+
+    uint64_t size;
+    dbof_type key_type;
+    dbof_type value_type;
+    if (__dbof_1_read_container_header(reader, type_id, &size, &key_type, &value_type))
     {
-        object = __new_object_null();
+        reader->depth--;
+        return -1;
     }
 
-    return object;
-}
+    int array = type_id == DBOF_TYPE_TYPED_ARRAY || type_id == DBOF_TYPE_UNTYPED_ARRAY;
 
-dbof_object dbof_new_ex(dbof_type type, dbof_new_ex_params* params)
-{
-    // TODO: Implement hooks
-}
+    int result = DBOF_PARSE_CONTINUE;
+    if (array && handler->begin_array != NULL)
+    {
+        result = handler->begin_array(handler, (dbof_type) type_id, size, key_type);
+    }
+    else if (!array && handler->begin_map != NULL)
+    {
+        result = handler->begin_map(handler, (dbof_type) type_id, size, key_type, value_type);
+    }
 
-void dbof_delete(dbof_object object)
-{
-    if (object == NULL)
+    if (result == DBOF_PARSE_SKIP)
     {
-        return;
+        result = __dbof_1_skip_children(reader, (dbof_type) type_id, size, key_type, value_type);
+        reader->depth--;
+        return result;
     }
 
-    switch (dbof_typeof(object))
+    if (result != DBOF_PARSE_CONTINUE)
     {
-    case DBOF_TYPE_NULL:
-        __delete_object_null(object);
-        break;
-    case DBOF_TYPE_SIGNED_BYTE:
-        __delete_object_signed_byte(object);
-        break;
-    case DBOF_TYPE_UNSIGNED_BYTE:
-        __delete_object_unsigned_byte(object);
-        break;
-    case DBOF_TYPE_SIGNED_INTEGER:
-        __delete_object_signed_integer(object);
-        break;
-    case DBOF_TYPE_UNSIGNED_INTEGER:
-        __delete_object_unsigned_integer(object);
-        break;
-    case DBOF_TYPE_SIGNED_LONG_INTEGER:
-        __delete_object_signed_long_integer(object);
-        break;
-    case DBOF_TYPE_UNSIGNED_LONG_INTEGER:
-        __delete_object_unsigned_long_integer(object);
-        break;
-    case DBOF_TYPE_BOOLEAN:
-        __delete_object_boolean(object);
-        break;
-    case DBOF_TYPE_SINGLE_FLOAT:
-        __delete_object_single_float(object);
-        break;
-    case DBOF_TYPE_DOUBLE_FLOAT:
-        __delete_object_double_float(object);
-        break;
-    case DBOF_TYPE_CHARACTER:
-        __delete_object_character(object);
-        break;
-    case DBOF_TYPE_UTF8_STRING:
-        __delete_object_utf8_string(object);
-        break;
-    case DBOF_TYPE_TYPED_ARRAY:
-        __delete_object_typed_array(object);
-        break;
-    case DBOF_TYPE_UNTYPED_ARRAY:
-        __delete_object_untyped_array(object);
-        break;
-    case DBOF_TYPE_TYPED_MAP:
-        __delete_object_typed_map(object);
-        break;
-    case DBOF_TYPE_UNTYPED_MAP:
-        __delete_object_untyped_map(object);
-        break;
+        reader->depth--;
+        return result;
+    }
+
+    // Packed values are handed out in bulk rather than one by one
+    if (type_id == DBOF_TYPE_TYPED_ARRAY && __packed_size_of(key_type) > 0)
+    {
+        result = __dbof_1_parse_packed_values(reader, handler, key_type, size);
+        if (result != DBOF_PARSE_CONTINUE)
+        {
+            reader->depth--;
+            return result;
+        }
+
+        size = 0;
+    }
+
+    // Containers with children wait for them on the stack
+    if (size > 0)
+    {
+        struct __walk_frame* frame = __deep_stack_push(stack);
+        if (frame == NULL || __walk_frame_init(frame, (dbof_type) type_id, size, key_type, value_type))
+        {
+            if (frame != NULL)
+            {
+                stack->count--;
+            }
+
+            reader->depth--;
+            return -1;
+        }
+
+        return 0;
+    }
+
+    reader->depth--;
+
+    if (array)
+        return handler->end_array == NULL ? 0 : __dbof_1_parse_result(handler->end_array(handler));
+
+    return handler->end_map == NULL ? 0 : __dbof_1_parse_result(handler->end_map(handler));
+}
+
+/**
+ * Internal. Parse an object in DBOF-1 format, emitting events to the handler instead of building objects.
+ *
+ * @param reader The reader
+ * @param handler The handler
+ * @param read_type Whether to read the object type (nonzero) or not (zero)
+ * @param type The object type if it is not read
+ * @return Zero on success, a handler's abort code, or -1 if an error occurred
+ */
+static int __dbof_1_parse_object(struct __buffered_reader* reader, dbof_handler* handler, int read_type,
+        dbof_type type)
+{
+    struct __walk_frame local[__DEEP_STACK_LOCAL];
+    struct __deep_stack stack;
+    __deep_stack_init(&stack, local, __DEEP_STACK_LOCAL, sizeof(struct __walk_frame));
+
+    int result;
+
+    for (;;)
+    {
+        // Read object type ID, unless the container already told us (and check it if it is repeated)
+        char type_id = type;
+        if (read_type && __buffered_reader_read(reader, &type_id, 1) < 1)
+        {
+            result = -1;
+            break;
+        }
+
+        result = __dbof_1_parse_one(reader, handler, &stack, type_id);
+        if (result != DBOF_PARSE_CONTINUE)
+            break;
+
+        // End finished containers until one needs another child
+        while (stack.count > 0)
+        {
+            struct __walk_frame* frame = __deep_stack_top(&stack);
+            if (frame->remaining > 0)
+                break;
+
+            dbof_type frame_type = frame->type;
+            stack.count--;
+            reader->depth--;
+
+            if (frame_type == DBOF_TYPE_TYPED_ARRAY || frame_type == DBOF_TYPE_UNTYPED_ARRAY)
+            {
+                result = handler->end_array == NULL ? 0 : __dbof_1_parse_result(handler->end_array(handler));
+            }
+            else
+            {
+                result = handler->end_map == NULL ? 0 : __dbof_1_parse_result(handler->end_map(handler));
+            }
+
+            if (result != DBOF_PARSE_CONTINUE)
+                break;
+        }
+
+        if (result != DBOF_PARSE_CONTINUE || stack.count == 0)
+            break;
+
+        struct __walk_frame* frame = __deep_stack_top(&stack);
+
+        // Let the handler know a key is coming up (as keys can be any object)
+        if ((frame->type == DBOF_TYPE_TYPED_MAP || frame->type == DBOF_TYPE_UNTYPED_MAP) && frame->remaining % 2 == 0
+                && handler->key != NULL)
+        {
+            result = __dbof_1_parse_result(handler->key(handler));
+            if (result != DBOF_PARSE_CONTINUE)
+                break;
+        }
+
+        __walk_frame_next(reader, frame, &read_type, &type);
+
+        // In version 1, the children of typed containers repeat the type they must have
+        if (read_type && frame->type != DBOF_TYPE_UNTYPED_ARRAY && frame->type != DBOF_TYPE_UNTYPED_MAP)
+        {
+            read_type = 0;
+            if (__dbof_1_read_child_type_internal(reader, type))
+            {
+                result = -1;
+                break;
+            }
+        }
     }
+
+    __walk_leave(reader, &stack, stack.count);
+    return result;
 }
 
-int dbof_hash(dbof_object object)
+/* Parallel Serialization */
+
+#ifdef DBOF_THREADS
+
+//
+// NOTICE
+// With DBOF_THREADS defined, dbof_write() and dbof_read_buffer_ex() can spread the work on wide containers over several
+// threads (see the threads fields of dbof_writer and dbof_reader). Both walk down through untyped containers until they
+// meet one with at least __PARALLEL_MIN_CHILDREN children, then cut its children into chunks of consecutive elements
+// (or table slots, for maps being written). Worker threads claim the chunks in order and encode or decode each on its
+// own, while the calling thread takes the finished chunks in order (handing them to the sink, or adding them to the
+// container) and works on chunks itself whenever the next one is not ready. No more than
+// __PARALLEL_WINDOW_PER_THREAD chunks per thread are worked on ahead of the calling thread, which bounds the memory
+// taken. The workers are started at the first wide container and stay until the end. On POSIX systems, the threads
+// come from pthreads.
+//
+
+/**
+ * The fewest children a container must have to be worked on by several threads.
+ */
+#define __PARALLEL_MIN_CHILDREN 1024
+
+/**
+ * The number of chunks per thread the children of a container are cut into. More chunks balance the load better.
+ */
+#define __PARALLEL_CHUNKS_PER_THREAD 8
+
+/**
+ * The fewest children (or map table slots) in a chunk.
+ */
+#define __PARALLEL_MIN_CHUNK 64
+
+/**
+ * The number of chunks per thread that may be worked on ahead of the calling thread.
+ */
+#define __PARALLEL_WINDOW_PER_THREAD 4
+
+/**
+ * The deepest container looked into for wide containers. Anything below is read or written on the calling thread.
+ */
+#define __PARALLEL_MAX_DESCENT 64
+
+/**
+ * A set of worker threads.
+ */
+struct __parallel
+{
+#ifdef _WIN32
+    SRWLOCK lock;
+    CONDITION_VARIABLE changed;
+    HANDLE* workers;
+#else
+    pthread_mutex_t lock;
+    pthread_cond_t changed;
+    pthread_t* workers;
+#endif
+
+    /**
+     * The number of threads to work with (the calling thread included), and the number of workers started.
+     */
+    unsigned int threads;
+    unsigned int worker_count;
+
+    /**
+     * Nonzero once the workers are to exit.
+     */
+    int shutdown;
+
+    /**
+     * Claim a piece of work and do it, if there is any to do now. Called with the lock held, which it lets go while
+     * working. Returns nonzero if it did some work.
+     */
+    int (* claim)(struct __parallel* parallel);
+};
+
+#ifdef _WIN32
+static void __parallel_lock(struct __parallel* parallel)
+{ AcquireSRWLockExclusive(&parallel->lock); }
+
+static void __parallel_unlock(struct __parallel* parallel)
+{ ReleaseSRWLockExclusive(&parallel->lock); }
+
+static void __parallel_wait(struct __parallel* parallel)
+{ SleepConditionVariableSRW(&parallel->changed, &parallel->lock, INFINITE, 0); }
+
+static void __parallel_notify(struct __parallel* parallel)
+{ WakeAllConditionVariable(&parallel->changed); }
+#else
+static void __parallel_lock(struct __parallel* parallel)
+{ pthread_mutex_lock(&parallel->lock); }
+
+static void __parallel_unlock(struct __parallel* parallel)
+{ pthread_mutex_unlock(&parallel->lock); }
+
+static void __parallel_wait(struct __parallel* parallel)
+{ pthread_cond_wait(&parallel->changed, &parallel->lock); }
+
+static void __parallel_notify(struct __parallel* parallel)
+{ pthread_cond_broadcast(&parallel->changed); }
+#endif
+
+static void __parallel_work(struct __parallel* parallel)
 {
-    // Return zero for null inputs
-    if (object == NULL)
-    {
-        return 0;
-    }
+    __parallel_lock(parallel);
 
-    switch (dbof_typeof(object))
+    while (!parallel->shutdown)
     {
-    case DBOF_TYPE_NULL:
-        return __hash_object_null(object);
-    case DBOF_TYPE_SIGNED_BYTE:
-        return __hash_object_signed_byte(object);
-    case DBOF_TYPE_UNSIGNED_BYTE:
-        return __hash_object_unsigned_byte(object);
-    case DBOF_TYPE_SIGNED_INTEGER:
-        return __hash_object_signed_integer(object);
-    case DBOF_TYPE_UNSIGNED_INTEGER:
-        return __hash_object_unsigned_integer(object);
-    case DBOF_TYPE_SIGNED_LONG_INTEGER:
-        return __hash_object_signed_long_integer(object);
-    case DBOF_TYPE_UNSIGNED_LONG_INTEGER:
-        return __hash_object_unsigned_long_integer(object);
-    case DBOF_TYPE_BOOLEAN:
-        return __hash_object_boolean(object);
-    case DBOF_TYPE_SINGLE_FLOAT:
-        return __hash_object_single_float(object);
-    case DBOF_TYPE_DOUBLE_FLOAT:
-        return __hash_object_double_float(object);
-    case DBOF_TYPE_CHARACTER:
-        return __hash_object_character(object);
-    case DBOF_TYPE_UTF8_STRING:
-        return __hash_object_utf8_string(object);
-    case DBOF_TYPE_TYPED_ARRAY:
-        return __hash_object_typed_array(object);
-    case DBOF_TYPE_UNTYPED_ARRAY:
-        return __hash_object_untyped_array(object);
-    case DBOF_TYPE_TYPED_MAP:
-        return __hash_object_typed_map(object);
-    case DBOF_TYPE_UNTYPED_MAP:
-        return __hash_object_untyped_map(object);
+        if (!parallel->claim(parallel))
+        {
+            __parallel_wait(parallel);
+        }
     }
+
+    __parallel_unlock(parallel);
 }
 
-int dbof_equals(dbof_object a, dbof_object b)
+#ifdef _WIN32
+static DWORD WINAPI __parallel_thread(LPVOID parallel)
 {
-    // If at least one is null, they can only be equal if the other is also null
-    // This is not defined in the specification
-    if (a == NULL || b == NULL)
-    {
-        return a == b;
-    }
+    __parallel_work(parallel);
+    return 0;
+}
+#else
+static void* __parallel_thread(void* parallel)
+{
+    __parallel_work(parallel);
+    return NULL;
+}
+#endif
 
-    // Value types and container types can never be equal
-    if (!dbof_same_category(a, b))
+static void __parallel_init(struct __parallel* parallel, unsigned int threads, int (* claim)(struct __parallel*))
+{
+    parallel->workers = NULL;
+    parallel->threads = threads;
+    parallel->worker_count = 0;
+    parallel->shutdown = 0;
+    parallel->claim = claim;
+
+#ifdef _WIN32
+    InitializeSRWLock(&parallel->lock);
+    InitializeConditionVariable(&parallel->changed);
+#else
+    pthread_mutex_init(&parallel->lock, NULL);
+    pthread_cond_init(&parallel->changed, NULL);
+#endif
+}
+
+/**
+ * Internal. Start the workers, unless they are running already. Starting fewer of them than asked for (or none at all)
+ * only makes the work slower, as the calling thread works on chunks, too.
+ */
+static void __parallel_start(struct __parallel* parallel)
+{
+    if (parallel->workers != NULL)
+        return;
+
+    parallel->workers = calloc(parallel->threads - 1, sizeof(*parallel->workers));
+    if (parallel->workers == NULL)
+        return;
+
+    for (unsigned int i = 0; i < parallel->threads - 1; ++i)
     {
-        return 0;
+#ifdef _WIN32
+        parallel->workers[i] = CreateThread(NULL, 0, __parallel_thread, parallel, 0, NULL);
+        if (parallel->workers[i] == NULL)
+            break;
+#else
+        if (pthread_create(&parallel->workers[i], NULL, __parallel_thread, parallel))
+            break;
+#endif
+
+        parallel->worker_count++;
     }
+}
 
-    dbof_type type_a = dbof_typeof(a);
-    dbof_type type_b = dbof_typeof(b);
+/**
+ * Internal. Stop the workers.
+ */
+static void __parallel_destroy(struct __parallel* parallel)
+{
+    __parallel_lock(parallel);
+    parallel->shutdown = 1;
+    __parallel_notify(parallel);
+    __parallel_unlock(parallel);
 
-    // If a and b are different types of containers, they cannot be equal
-    // We only need to test one type, as we know both types must be of the same category by now
-    if (dbof_is_container_type(type_a) && type_a != type_b)
+    for (unsigned int i = 0; i < parallel->worker_count; ++i)
     {
-        return 1;
+#ifdef _WIN32
+        WaitForSingleObject(parallel->workers[i], INFINITE);
+        CloseHandle(parallel->workers[i]);
+#else
+        pthread_join(parallel->workers[i], NULL);
+#endif
     }
 
-    // We now know that a and b are both the same type of container
-    // TODO: Check equality on per-container basis
+    free(parallel->workers);
 
-    // At this stage, we know that a and b are both value objects
+#ifndef _WIN32
+    pthread_mutex_destroy(&parallel->lock);
+    pthread_cond_destroy(&parallel->changed);
+#endif
+}
 
-    // If the hashes are different, the values must not be equal
-    if (dbof_hash(a) != dbof_hash(b))
+/**
+ * Internal. Cut a number of children (or map table slots) into chunks for the given number of threads. Returns the
+ * size of a chunk, which is a multiple of the given granularity.
+ */
+static uint64_t __parallel_chunk_size(uint64_t units, unsigned int threads, uint64_t granularity)
+{
+    uint64_t chunk_units = units / ((uint64_t) threads * __PARALLEL_CHUNKS_PER_THREAD);
+    if (chunk_units < __PARALLEL_MIN_CHUNK)
     {
-        return 0;
+        chunk_units = __PARALLEL_MIN_CHUNK;
     }
 
-    // TODO: Actually implement equality checking
-
-    return 1;
+    return chunk_units + (granularity - chunk_units % granularity) % granularity;
 }
 
-dbof_signed_byte dbof_get_value_signed_byte(dbof_object_signed_byte object)
-{ return ((struct __object_signed_byte_impl*) object)->value; }
+struct __parallel_write_chunk
+{
+    /**
+     * The encoded chunk, collected in memory.
+     */
+    struct __buffered_writer out;
 
-void dbof_set_value_signed_byte(dbof_object_signed_byte object, dbof_signed_byte value)
-{ ((struct __object_signed_byte_impl*) object)->value = value; }
+    /**
+     * Nonzero once the chunk is encoded.
+     */
+    int done;
+};
 
-dbof_unsigned_byte dbof_get_value_unsigned_byte(dbof_object_unsigned_byte object)
-{ return ((struct __object_unsigned_byte_impl*) object)->value; }
+struct __parallel_writer
+{
+    struct __parallel base;
 
-void dbof_set_value_unsigned_byte(dbof_object_unsigned_byte object, dbof_unsigned_byte value)
-{ ((struct __object_unsigned_byte_impl*) object)->value = value; }
+    /**
+     * The ring of chunks being encoded, indexed by chunk number modulo its size.
+     */
+    struct __parallel_write_chunk* window;
+    size_t window_size;
 
-dbof_signed_integer dbof_get_value_signed_integer(dbof_object_signed_integer object)
-{ return ((struct __object_signed_integer_impl*) object)->value; }
+    /**
+     * The container whose children are being written, or NULL if there is none.
+     */
+    dbof_object container;
 
-void dbof_set_value_signed_integer(dbof_object_signed_integer object, dbof_signed_integer value)
-{ ((struct __object_signed_integer_impl*) object)->value = value; }
+    /**
+     * The number of children (or map table slots) in each chunk and in all.
+     */
+    dbof_container_size chunk_units;
+    dbof_container_size units;
 
-dbof_unsigned_integer dbof_get_value_unsigned_integer(dbof_object_unsigned_integer object)
-{ return ((struct __object_unsigned_integer_impl*) object)->value; }
+    /**
+     * The number of chunks in all, the number claimed for encoding, and the number handed to the sink.
+     */
+    size_t chunk_count;
+    size_t claimed;
+    size_t drained;
 
-void dbof_set_value_unsigned_integer(dbof_object_unsigned_integer object, dbof_unsigned_integer value)
-{ ((struct __object_unsigned_integer_impl*) object)->value = value; }
+    /**
+     * The number of threads encoding a chunk right now.
+     */
+    unsigned int busy;
 
-dbof_signed_long_integer dbof_get_value_signed_long_integer(dbof_object_signed_long_integer object)
-{ return ((struct __object_signed_long_integer_impl*) object)->value; }
+    /**
+     * Nonzero once writing the container has failed.
+     */
+    int failed;
+};
 
-void dbof_set_value_signed_long_integer(dbof_object_signed_long_integer object, dbof_signed_long_integer value)
-{ ((struct __object_signed_long_integer_impl*) object)->value = value; }
+/**
+ * Internal. Encode one chunk of the children of the container being written. Returns zero on success, otherwise
+ * nonzero.
+ */
+static int __parallel_writer_encode_chunk(struct __parallel_writer* parallel, size_t chunk,
+        struct __buffered_writer* out)
+{
+    dbof_container_size begin = chunk * parallel->chunk_units;
+    dbof_container_size end = begin + parallel->chunk_units;
+    if (end > parallel->units)
+    {
+        end = parallel->units;
+    }
 
-dbof_unsigned_long_integer dbof_get_value_unsigned_long_integer(dbof_object_unsigned_long_integer object)
-{ return ((struct __object_unsigned_long_integer_impl*) object)->value; }
+    if (dbof_typeof(parallel->container) == DBOF_TYPE_UNTYPED_ARRAY)
+    {
+        struct __object_untyped_array_impl* array_impl = parallel->container;
 
-void dbof_set_value_unsigned_long_integer(dbof_object_unsigned_long_integer object, dbof_unsigned_long_integer value)
-{ ((struct __object_unsigned_long_integer_impl*) object)->value = value; }
+        for (dbof_container_size i = begin; i < end; ++i)
+        {
+            if (__dbof_1_write_object(__object_untyped_array_impl_get(array_impl, i), out, 1))
+                return -1;
+        }
+    }
+    else
+    {
+        struct __internal_map_base* map_base = parallel->container;
 
-dbof_boolean dbof_get_value_boolean(dbof_object_boolean object)
-{ return ((struct __object_boolean_impl*) object)->value; }
+        for (dbof_container_size i = begin; i < end; ++i)
+        {
+            struct __map_slot* slot = &map_base->slots[i];
+            if (slot->key == NULL)
+                continue;
 
-void dbof_set_value_boolean(dbof_object_boolean object, dbof_boolean value)
-{ ((struct __object_boolean_impl*) object)->value = value; }
+            if (__dbof_1_write_object(slot->key, out, 1) || __dbof_1_write_object(slot->value, out, 1))
+                return -1;
+        }
+    }
 
-dbof_single_float dbof_get_value_single_float(dbof_object_single_float object)
-{ return ((struct __object_single_float_impl*) object)->value; }
+    return 0;
+}
 
-void dbof_set_value_single_float(dbof_object_single_float object, dbof_single_float value)
-{ ((struct __object_single_float_impl*) object)->value = value; }
+static int __parallel_writer_claim(struct __parallel* base)
+{
+    struct __parallel_writer* parallel = (struct __parallel_writer*) base;
 
-dbof_double_float dbof_get_value_double_float(dbof_object_double_float object)
-{ return ((struct __object_double_float_impl*) object)->value; }
+    if (parallel->container == NULL || parallel->failed || parallel->claimed == parallel->chunk_count
+            || parallel->claimed == parallel->drained + parallel->window_size)
+        return 0;
 
-void dbof_set_value_double_float(dbof_object_double_float object, dbof_double_float value)
-{ ((struct __object_double_float_impl*) object)->value = value; }
+    size_t chunk = parallel->claimed++;
+    struct __parallel_write_chunk* slot = &parallel->window[chunk % parallel->window_size];
+    parallel->busy++;
+    __parallel_unlock(base);
 
-dbof_character dbof_get_value_character(dbof_object_character object)
-{ return ((struct __object_character_impl*) object)->value; }
+    int result = __parallel_writer_encode_chunk(parallel, chunk, &slot->out);
 
-void dbof_set_value_character(dbof_object_character object, dbof_character value)
-{ ((struct __object_character_impl*) object)->value = value; }
+    __parallel_lock(base);
+    parallel->busy--;
+    slot->done = 1;
 
-dbof_utf8_string dbof_get_value_utf8_string(dbof_object_utf8_string object)
-{ return ((struct __object_utf8_string_impl*) object)->value; }
+    if (result)
+    {
+        parallel->failed = 1;
+    }
 
-void dbof_set_value_utf8_string(dbof_object_utf8_string object, dbof_utf8_string value)
-{
-    struct __object_utf8_string_impl* string = (struct __object_utf8_string_impl*) object;
+    __parallel_notify(base);
+    return 1;
+}
 
-    dbof_string_size old_length = string->value == NULL ? 0 : strlen(string->value);
-    dbof_string_size new_length = value == NULL ? 0 : strlen(value);
+/**
+ * Internal. Set up for writing on the given number of threads. Returns zero on success, otherwise nonzero.
+ */
+static int __parallel_writer_init(struct __parallel_writer* parallel, unsigned int threads)
+{
+    memset(parallel, 0, sizeof(struct __parallel_writer));
+    parallel->window_size = (size_t) threads * __PARALLEL_WINDOW_PER_THREAD;
 
-    // If new and old lengths are equal, just copy the new value in
-    if (new_length == old_length)
+    parallel->window = calloc(parallel->window_size, sizeof(struct __parallel_write_chunk));
+    if (parallel->window == NULL)
     {
-        // The null terminator will be preserved
-        memcpy(string->value, value, new_length);
-        return;
+        // ERROR: Out of memory
+        return -1;
     }
 
-    // Attempt to reallocate the existing string
-    // NONE OF WHAT FOLLOWS IS ATOMIC. ONE THREAD AT A TIME, PLEASE.
-    char* val = realloc(string->value, new_length + 1);
-    if (val == NULL)
+    for (size_t i = 0; i < parallel->window_size; ++i)
     {
-        // ERROR: Reallocation failed. Out of memory?
-        // Failure state: The original string has not been modified
-        return;
+        char* buffer = malloc(__DEFAULT_BUFFER_SIZE);
+        if (buffer == NULL)
+        {
+            // ERROR: Out of memory
+            while (i-- > 0)
+            {
+                free(parallel->window[i].out.buffer);
+            }
+
+            free(parallel->window);
+            return -1;
+        }
+
+        // Without a sink, the chunk collects in memory
+        __buffered_writer_init(&parallel->window[i].out, NULL, buffer, __DEFAULT_BUFFER_SIZE);
     }
 
-    // Copy in the new value
-    memcpy(val, value, new_length);
-    val[new_length] = '\0';
+    __parallel_init(&parallel->base, threads, __parallel_writer_claim);
+    return 0;
+}
 
-    string->value = val;
+/**
+ * Internal. Stop the workers and free everything.
+ */
+static void __parallel_writer_destroy(struct __parallel_writer* parallel)
+{
+    __parallel_destroy(&parallel->base);
+
+    for (size_t i = 0; i < parallel->window_size; ++i)
+    {
+        free(parallel->window[i].out.buffer);
+    }
+
+    free(parallel->window);
 }
 
-dbof_container_size dbof_typed_array_get_capacity(dbof_object_typed_array array)
-{ return __object_typed_array_impl_get_capacity(array); }
+/**
+ * Internal. Write the children of a wide untyped container on several threads, in order.
+ *
+ * @param parallel The parallel writer
+ * @param container The container
+ * @param units The number of children (for arrays) or table slots (for maps)
+ * @param writer The writer
+ * @return Zero on success, otherwise nonzero
+ */
+static int __parallel_writer_write_children(struct __parallel_writer* parallel, dbof_object container,
+        dbof_container_size units, struct __buffered_writer* writer)
+{
+    struct __parallel* base = &parallel->base;
+    __parallel_start(base);
+
+    dbof_container_size chunk_units = __parallel_chunk_size(units, base->threads, 1);
+
+    __parallel_lock(base);
+    parallel->container = container;
+    parallel->units = units;
+    parallel->chunk_units = chunk_units;
+    parallel->chunk_count = (units + chunk_units - 1) / chunk_units;
+    parallel->claimed = 0;
+    parallel->drained = 0;
+    parallel->failed = 0;
+    __parallel_notify(base);
+
+    while (parallel->drained < parallel->chunk_count && !parallel->failed)
+    {
+        struct __parallel_write_chunk* slot = &parallel->window[parallel->drained % parallel->window_size];
 
-dbof_container_size dbof_typed_array_get_size(dbof_object_typed_array array)
-{ return __object_typed_array_impl_get_size(array); }
+        // Help with encoding until the next chunk is ready
+        if (!slot->done)
+        {
+            if (!__parallel_writer_claim(base))
+            {
+                __parallel_wait(base);
+            }
 
-int dbof_typed_array_is_empty(dbof_object_typed_array array)
-{ return __object_typed_array_impl_is_empty(array); }
+            continue;
+        }
 
-dbof_type dbof_typed_array_get_type(dbof_object_typed_array array)
-{ return __object_typed_array_impl_get_type(array); }
+        // The chunk is not claimed again until it is drained, so it can be handed to the sink without the lock
+        __parallel_unlock(base);
 
-void dbof_typed_array_set_type(dbof_object_typed_array array, dbof_type type)
-{ __object_typed_array_impl_set_type(array, type); }
+        int result = __buffered_writer_write(writer, slot->out.buffer, slot->out.used) < slot->out.used;
+        slot->out.used = 0;
+        slot->done = 0;
 
-void dbof_typed_array_shrink_to_fit(dbof_object_typed_array array)
-{ __object_typed_array_impl_shrink_to_fit(array); }
+        __parallel_lock(base);
+        parallel->drained++;
 
-dbof_object dbof_typed_array_get(dbof_object_typed_array array, dbof_container_size index)
-{ return __object_typed_array_impl_get(array, index); }
+        if (result)
+        {
+            parallel->failed = 1;
+        }
 
-void dbof_typed_array_set(dbof_object_typed_array array, dbof_container_size index, dbof_object object)
-{ return __object_typed_array_impl_set(array, index, object); }
+        __parallel_notify(base);
+    }
 
-void dbof_typed_array_insert(dbof_object_typed_array array, dbof_container_size index, dbof_object object)
-{ __object_typed_array_impl_insert(array, index, object); }
+    // On failure, chunks may still be encoding; wait for them and leave the window clean for the next container
+    while (parallel->busy > 0)
+    {
+        __parallel_wait(base);
+    }
 
-dbof_object dbof_typed_array_remove(dbof_object_typed_array array, dbof_container_size index)
-{ return __object_typed_array_impl_remove(array, index); }
+    for (size_t i = 0; i < parallel->window_size; ++i)
+    {
+        parallel->window[i].out.used = 0;
+        parallel->window[i].out.failed = 0;
+        parallel->window[i].done = 0;
+    }
 
-void dbof_typed_array_push_back(dbof_object_typed_array array, dbof_object object)
-{ __object_typed_array_impl_push_back(array, object); }
+    int result = parallel->failed ? -1 : 0;
+    parallel->container = NULL;
+    __parallel_unlock(base);
 
-dbof_object dbof_typed_array_pop_back(dbof_object_typed_array array)
-{ return __object_typed_array_impl_pop_back(array); }
+    return result;
+}
+
+/**
+ * Internal. Write an object in DBOF-1 format, writing the wide untyped containers in it on several threads.
+ *
+ * @param object The object to write
+ * @param writer The writer
+ * @param parallel The parallel writer
+ * @param depth The number of containers around the object
+ * @return Zero upon success, otherwise nonzero
+ */
+static int __dbof_1_write_object_parallel(dbof_object object, struct __buffered_writer* writer,
+        struct __parallel_writer* parallel, unsigned int depth)
+{
+    dbof_type type = dbof_typeof(object);
+
+    // Only untyped containers are looked into, anything else is written on this thread
+    if (depth >= __PARALLEL_MAX_DESCENT || (type != DBOF_TYPE_UNTYPED_ARRAY && type != DBOF_TYPE_UNTYPED_MAP))
+        return __dbof_1_write_object(object, writer, 1);
 
-dbof_container_size dbof_untyped_array_get_capacity(dbof_object_untyped_array array)
-{ return __object_untyped_array_impl_get_capacity(array); }
+    char type_id = type;
+    dbof_container_size size = type == DBOF_TYPE_UNTYPED_ARRAY
+            ? __object_untyped_array_impl_get_size(object) : __object_untyped_map_impl_get_size(object);
 
-dbof_container_size dbof_untyped_array_get_size(dbof_object_untyped_array array)
-{ return __object_untyped_array_impl_get_size(array); }
+    if (__buffered_writer_write(writer, &type_id, 1) < 1 || __dbof_1_write_flex_length_internal(writer, size))
+        return -1;
 
-int dbof_untyped_array_is_empty(dbof_object_untyped_array map)
-{ return __object_untyped_array_impl_is_empty(map); }
+    if (type == DBOF_TYPE_UNTYPED_ARRAY)
+    {
+        if (size >= __PARALLEL_MIN_CHILDREN)
+            return __parallel_writer_write_children(parallel, object, size, writer);
 
-void dbof_untyped_array_shrink_to_fit(dbof_object_untyped_array array)
-{ __object_untyped_array_impl_shrink_to_fit(array); }
+        // Look for wide containers further down
+        for (dbof_container_size i = 0; i < size; ++i)
+        {
+            if (__dbof_1_write_object_parallel(__object_untyped_array_impl_get(object, i), writer, parallel,
+                    depth + 1))
+                return -1;
+        }
+    }
+    else
+    {
+        struct __internal_map_base* map_base = object;
 
-dbof_object dbof_untyped_array_get(dbof_object_untyped_array array, dbof_container_size index)
-{ return __object_untyped_array_impl_get(array, index); }
+        if (size >= __PARALLEL_MIN_CHILDREN)
+            return __parallel_writer_write_children(parallel, object, map_base->capacity, writer);
 
-void dbof_untyped_array_set(dbof_object_untyped_array array, dbof_container_size index, dbof_object object)
-{ return __object_untyped_array_impl_set(array, index, object); }
+        // Look for wide containers further down (among the values, as keys are rarely big)
+        for (dbof_container_size i = 0; i < map_base->capacity; ++i)
+        {
+            struct __map_slot* slot = &map_base->slots[i];
+            if (slot->key == NULL)
+                continue;
 
-void dbof_untyped_array_insert(dbof_object_untyped_array array, dbof_container_size index, dbof_object object)
-{ __object_untyped_array_impl_insert(array, index, object); }
+            if (__dbof_1_write_object(slot->key, writer, 1)
+                    || __dbof_1_write_object_parallel(slot->value, writer, parallel, depth + 1))
+                return -1;
+        }
+    }
 
-dbof_object dbof_untyped_array_remove(dbof_object_untyped_array array, dbof_container_size index)
-{ return __object_untyped_array_impl_remove(array, index); }
+    return 0;
+}
 
-void dbof_untyped_array_push_back(dbof_object_untyped_array array, dbof_object object)
-{ __object_untyped_array_impl_push_back(array, object); }
+/**
+ * Internal. Write an object in DBOF-1 format on the given number of threads, the calling one included.
+ */
+static int __dbof_1_write_parallel(dbof_object object, struct __buffered_writer* writer, unsigned int threads)
+{
+    struct __parallel_writer parallel;
 
-dbof_object dbof_untyped_array_pop_back(dbof_object_untyped_array array)
-{ return __object_untyped_array_impl_pop_back(array); }
+    // If the threads cannot be set up, write on this one alone
+    if (__parallel_writer_init(&parallel, threads))
+        return __dbof_1_write_object(object, writer, 1);
 
-dbof_container_size dbof_typed_map_get_capacity(dbof_object_typed_map map)
-{ return __object_typed_map_impl_get_capacity(map); }
+    // The chunks are written in the same version as the rest
+    for (size_t i = 0; i < parallel.window_size; ++i)
+    {
+        parallel.window[i].out.version = writer->version;
+    }
 
-dbof_container_size dbof_typed_map_get_size(dbof_object_typed_map map)
-{ return __object_typed_map_impl_get_size(map); }
+    int result = __dbof_1_write_object_parallel(object, writer, &parallel, 0);
+    __parallel_writer_destroy(&parallel);
 
-int dbof_typed_map_is_empty(dbof_object_typed_map map)
-{ return __object_typed_map_impl_is_empty(map); }
+    return result;
+}
 
-dbof_type dbof_typed_map_get_key_type(dbof_object_typed_map map)
-{ return __object_typed_map_impl_get_key_type(map); }
+//
+// NOTICE
+// Reading a container in parallel needs to know where its chunks start before their children are read. The calling
+// thread finds out by skipping through the children of one chunk after another (which only looks at type IDs, fixed
+// widths, and flex lengths, and allocates nothing but a stack for deep nesting), handing out each chunk as soon as its
+// start is known, so the skipping overlaps with the reading. The children read from a chunk are added to the container
+// in order on the calling thread, so the container comes out as it would on one thread. If anything goes wrong (the
+// input is malformed, say), the container is read over on one thread, which then fails or not just like dbof_read()
+// would.
+//
 
-void dbof_typed_map_set_key_type(dbof_object_typed_map map, dbof_type key_type)
-{ __object_typed_map_impl_set_key_type(map, key_type); }
+struct __parallel_read_chunk
+{
+    /**
+     * The position in the buffer where the chunk starts, and where it ends once read.
+     */
+    size_t position;
+    size_t end;
 
-dbof_type dbof_typed_map_get_value_type(dbof_object_typed_map map)
-{ return __object_typed_map_impl_get_value_type(map); }
+    /**
+     * The number of children in the chunk (keys and values count separately).
+     */
+    uint64_t count;
 
-void dbof_typed_map_set_value_type(dbof_object_typed_map map, dbof_type value_type)
-{ __object_typed_map_impl_set_key_value(map, value_type); }
+    /**
+     * The children read, and the room for them.
+     */
+    dbof_object* objects;
+    uint64_t capacity;
 
-dbof_object dbof_typed_map_get(dbof_object_typed_map map, dbof_object key)
-{ return __object_typed_map_impl_get(map, key); }
+    /**
+     * Nonzero once the chunk is read.
+     */
+    int done;
+};
 
-void dbof_typed_map_put(dbof_object_typed_map map, dbof_object key, dbof_object value)
-{ __object_typed_map_impl_put(map, key, value); }
+struct __parallel_reader
+{
+    struct __parallel base;
 
-dbof_object dbof_typed_map_remove(dbof_object_typed_map map, dbof_object key)
-{ return __object_typed_map_impl_remove(map, key); }
+    /**
+     * The reader of the calling thread, whose settings the chunks are read with.
+     */
+    struct __buffered_reader* reader;
 
-int dbof_typed_map_has_key(dbof_object_typed_map map, dbof_object key)
-{ return __object_typed_map_impl_has_key(map, key); }
+    /**
+     * The ring of chunks being read, indexed by chunk number modulo its size.
+     */
+    struct __parallel_read_chunk* window;
+    size_t window_size;
 
-dbof_container_size dbof_untyped_map_get_capacity(dbof_object_untyped_map map)
-{ return __object_untyped_map_impl_get_capacity(map); }
+    /**
+     * Nonzero if the container being read is a map, whose keys are then hashed as they are read.
+     */
+    int map;
 
-dbof_container_size dbof_untyped_map_get_size(dbof_object_untyped_map map)
-{ return __object_untyped_map_impl_get_size(map); }
+    /**
+     * The number of containers around the children being read.
+     */
+    unsigned int depth;
 
-int dbof_untyped_map_is_empty(dbof_object_untyped_map map)
-{ return __object_untyped_map_impl_is_empty(map); }
+    /**
+     * The number of chunks whose start is known, the number claimed for reading, and the number added to the
+     * container.
+     */
+    size_t published;
+    size_t claimed;
+    size_t drained;
 
-dbof_object dbof_untyped_map_get(dbof_object_untyped_map map, dbof_object key)
-{ return __object_untyped_map_impl_get(map, key); }
+    /**
+     * The number of threads reading a chunk right now.
+     */
+    unsigned int busy;
 
-void dbof_untyped_map_put(dbof_object_untyped_map map, dbof_object key, dbof_object value)
-{ __object_untyped_map_impl_put(map, key, value); }
+    /**
+     * Nonzero once reading the container has failed.
+     */
+    int failed;
+};
 
-dbof_object dbof_untyped_map_remove(dbof_object_untyped_map map, dbof_object key)
-{ return __object_untyped_map_impl_remove(map, key); }
+/**
+ * Internal. Read the children in one chunk of the container being read. Returns zero on success, otherwise nonzero
+ * (having deleted what it read).
+ */
+static int __parallel_reader_read_chunk(struct __parallel_reader* parallel, struct __parallel_read_chunk* chunk)
+{
+    // ERROR: Out of memory
+    if (chunk->capacity < chunk->count)
+        return -1;
 
-int dbof_untyped_map_has_key(dbof_object_untyped_map map, dbof_object key)
-{ return __object_untyped_map_impl_has_key(map, key); }
+    struct __buffered_reader reader = *parallel->reader;
+    reader.position = chunk->position;
+    reader.depth = parallel->depth;
 
-//
-// Object Serialization and Deserialization
-//
+    for (uint64_t i = 0; i < chunk->count; ++i)
+    {
+        dbof_object object = __dbof_1_read_object(&reader, 1, DBOF_TYPE_NULL);
+        if (object == NULL)
+        {
+            while (i-- > 0)
+            {
+                dbof_delete(chunk->objects[i]);
+            }
 
-/* DBOF Serialization Format 1 */
+            return -1;
+        }
 
-static dbof_object_null __dbof_1_read_object_null(dbof_reader* reader)
-{
-    // Null objects have no contents
-    return __new_object_null();
-}
+        // Keys cache their hash codes, so putting them into the map takes less on the calling thread
+        if (parallel->map && i % 2 == 0)
+        {
+            dbof_hash(object);
+        }
 
-static int __dbof_1_write_object_null(dbof_object_null object, dbof_writer* writer)
-{
-    // Null objects have no contents
+        chunk->objects[i] = object;
+    }
+
+    chunk->end = reader.position;
     return 0;
 }
 
-static dbof_object_signed_byte __dbof_1_read_object_signed_byte(dbof_reader* reader)
+static int __parallel_reader_claim(struct __parallel* base)
 {
-    dbof_signed_byte value;
+    struct __parallel_reader* parallel = (struct __parallel_reader*) base;
 
-    // Read 1 byte
-    if (reader->read(reader, (char*) &value, 1) < 1)
+    if (parallel->failed || parallel->claimed == parallel->published)
+        return 0;
+
+    struct __parallel_read_chunk* chunk = &parallel->window[parallel->claimed++ % parallel->window_size];
+    parallel->busy++;
+    __parallel_unlock(base);
+
+    int result = __parallel_reader_read_chunk(parallel, chunk);
+
+    __parallel_lock(base);
+    parallel->busy--;
+
+    if (result)
     {
-        // ERROR: End of file
-        return NULL;
+        parallel->failed = 1;
+    }
+    else
+    {
+        chunk->done = 1;
     }
 
-    // Set value
-    dbof_object_signed_byte object = __new_object_signed_byte();
-    dbof_set_value_signed_byte(object, value);
-    return object;
+    __parallel_notify(base);
+    return 1;
 }
 
-static int __dbof_1_write_object_signed_byte(dbof_object_signed_byte object, dbof_writer* writer)
+/**
+ * Internal. Set up for reading on the given number of threads. Returns zero on success, otherwise nonzero.
+ */
+static int __parallel_reader_init(struct __parallel_reader* parallel, struct __buffered_reader* reader,
+        unsigned int threads)
 {
-    // Get value
-    dbof_signed_byte value = dbof_get_value_signed_byte(object);
+    memset(parallel, 0, sizeof(struct __parallel_reader));
+    parallel->reader = reader;
+    parallel->window_size = (size_t) threads * __PARALLEL_WINDOW_PER_THREAD;
 
-    if (writer->write(writer, (char*) &value, 1) < 1)
+    parallel->window = calloc(parallel->window_size, sizeof(struct __parallel_read_chunk));
+    if (parallel->window == NULL)
     {
-        // ERROR: End of file or out of space
+        // ERROR: Out of memory
         return -1;
     }
 
+    __parallel_init(&parallel->base, threads, __parallel_reader_claim);
     return 0;
 }
 
-static dbof_object_unsigned_byte __dbof_1_read_object_unsigned_byte(dbof_reader* reader)
+/**
+ * Internal. Stop the workers and free everything.
+ */
+static void __parallel_reader_destroy(struct __parallel_reader* parallel)
 {
-    dbof_unsigned_byte value = 0;
+    __parallel_destroy(&parallel->base);
 
-    // Read 1 byte
-    if (reader->read(reader, (char*) &value, 1) < 1)
+    for (size_t i = 0; i < parallel->window_size; ++i)
     {
-        // ERROR: End of file
-        return NULL;
+        free(parallel->window[i].objects);
     }
 
-    // Set value
-    dbof_object_unsigned_byte object = __new_object_unsigned_byte();
-    dbof_set_value_unsigned_byte(object, value);
-    return object;
+    free(parallel->window);
 }
 
-static int __dbof_1_write_object_unsigned_byte(dbof_object_unsigned_byte object, dbof_writer* writer)
+/**
+ * Internal. Add children to a container being read, in order. The container takes ownership of the children, even on
+ * failure. Map children come in key and value pairs.
+ *
+ * @param container The container
+ * @param objects The children
+ * @param count The number of children
+ * @return Zero on success, otherwise nonzero
+ */
+static int __parallel_reader_add(dbof_object container, dbof_object* objects, uint64_t count)
 {
-    // Get value
-    dbof_unsigned_byte value = dbof_get_value_unsigned_byte(object);
-
-    // Write 1 byte
-    if (writer->write(writer, (char*) &value, 1) < 1)
+    for (uint64_t i = 0; i < count; ++i)
     {
-        // ERROR: End of file or out of space
-        return -1;
-    }
+        if (dbof_typeof(container) == DBOF_TYPE_UNTYPED_MAP)
+        {
+            // The map deletes the entry itself if it fails
+            if (__internal_map_base_put(container, objects[i], objects[i + 1]))
+            {
+                i += 2;
+                while (i < count)
+                {
+                    dbof_delete(objects[i++]);
+                }
 
-    return 0;
-}
+                return -1;
+            }
 
-static dbof_object_signed_integer __dbof_1_read_object_signed_integer(dbof_reader* reader)
-{
-    dbof_signed_integer value = 0;
+            ++i;
+        }
+        else if (__internal_array_base_insert(container, ((struct __internal_array_base*) container)->size,
+                objects[i]))
+        {
+            // ERROR: Out of memory (the array deletes the child itself)
+            while (++i < count)
+            {
+                dbof_delete(objects[i]);
+            }
 
-    // Read 4 bytes
-    char value_buf[4];
-    if (reader->read(reader, value_buf, 4) < 4)
-    {
-        // ERROR: End of file
-        return NULL;
+            return -1;
+        }
     }
 
-    // Unpack little-endian 32-bit integer (LSB stored first)
-    value |= ((uint32_t) value_buf[0]) << 0;
-    value |= ((uint32_t) value_buf[1]) << 8;
-    value |= ((uint32_t) value_buf[2]) << 16;
-    value |= ((uint32_t) value_buf[3]) << 24;
-
-    // Set value
-    dbof_object_signed_integer object = __new_object_signed_integer();
-    dbof_set_value_signed_integer(object, value);
-    return object;
+    return 0;
 }
 
-static int __dbof_1_write_object_signed_integer(dbof_object_signed_integer object, dbof_writer* writer)
+/**
+ * Internal. Make room for the children of a chunk. Returns zero on success, otherwise nonzero.
+ */
+static int __parallel_reader_reserve(struct __parallel_read_chunk* chunk, uint64_t count)
 {
-    // Get value
-    dbof_signed_integer value = dbof_get_value_signed_integer(object);
+    if (chunk->capacity >= count)
+        return 0;
 
-    // Pack little-endian 32-bit integer (LSB stored first)
-    char value_buf[4];
-    value_buf[0] = (uint8_t) ((value & 0x000000ffu) >> 0);
-    value_buf[1] = (uint8_t) ((value & 0x0000ff00u) >> 8);
-    value_buf[2] = (uint8_t) ((value & 0x00ff0000u) >> 16);
-    value_buf[3] = (uint8_t) ((value & 0xff000000u) >> 24);
+    // ERROR: Out of memory
+    if (count > SIZE_MAX / sizeof(dbof_object))
+        return -1;
 
-    // Write 4 bytes
-    if (writer->write(writer, value_buf, 4) < 4)
-    {
-        // ERROR: End of file or out of space
+    dbof_object* objects = realloc(chunk->objects, count * sizeof(dbof_object));
+    if (objects == NULL)
         return -1;
-    }
+
+    chunk->objects = objects;
+    chunk->capacity = count;
 
     return 0;
 }
 
-static dbof_object_unsigned_integer __dbof_1_read_object_unsigned_integer(dbof_reader* reader)
+/**
+ * Internal. Read the children of a wide untyped container on several threads, in order.
+ *
+ * @param parallel The parallel reader
+ * @param container The container, whose header has been read
+ * @param children The number of children (keys and values count separately)
+ * @param depth The number of containers around the container
+ * @param start The position of the container in the buffer
+ * @return The container or NULL if an error occurred
+ */
+static dbof_object __parallel_reader_read_children(struct __parallel_reader* parallel, dbof_object container,
+        uint64_t children, unsigned int depth, size_t start)
 {
-    dbof_unsigned_integer value = 0;
-
-    // Read 4 bytes
-    char value_buf[4];
-    if (reader->read(reader, value_buf, 4) < 4)
+    struct __parallel* base = &parallel->base;
+    struct __buffered_reader* reader = parallel->reader;
+    __parallel_start(base);
+
+    // Map entries stay in one chunk
+    uint64_t chunk_children = __parallel_chunk_size(children, base->threads, 2);
+    size_t chunk_count = (children + chunk_children - 1) / chunk_children;
+
+    // The scanner is inside the container, so it is held to the reader's depth limit from there
+    struct __buffered_reader scanner = *reader;
+    scanner.depth = depth + 1;
+
+    __parallel_lock(base);
+    parallel->map = dbof_typeof(container) == DBOF_TYPE_UNTYPED_MAP;
+    parallel->depth = depth + 1;
+    parallel->published = 0;
+    parallel->claimed = 0;
+    parallel->drained = 0;
+    parallel->failed = 0;
+
+    while (parallel->drained < chunk_count && !parallel->failed)
     {
-        // ERROR: End of file
-        return NULL;
-    }
+        struct __parallel_read_chunk* next = &parallel->window[parallel->drained % parallel->window_size];
 
-    // Unpack little-endian 32-bit integer (LSB stored first)
-    value |= ((uint32_t) value_buf[0]) << 0;
-    value |= ((uint32_t) value_buf[1]) << 8;
-    value |= ((uint32_t) value_buf[2]) << 16;
-    value |= ((uint32_t) value_buf[3]) << 24;
+        // Add the next chunk to the container as soon as it is read
+        if (next->done)
+        {
+            __parallel_unlock(base);
 
-    // Get value
-    dbof_object_unsigned_integer object = __new_object_unsigned_integer();
-    dbof_set_value_unsigned_integer(object, value);
-    return object;
-}
+            int result = __parallel_reader_add(container, next->objects, next->count);
+            next->done = 0;
 
-static int __dbof_1_write_object_unsigned_integer(dbof_object_unsigned_integer object, dbof_writer* writer)
-{
-    // Get value
-    dbof_unsigned_integer value = dbof_get_value_unsigned_integer(object);
+            if (parallel->drained == chunk_count - 1)
+            {
+                reader->position = next->end;
+            }
 
-    // Pack little-endian 32-bit integer (LSB stored first)
-    char value_buf[4];
-    value_buf[0] = (uint8_t) ((value & 0x000000ffu) >> 0);
-    value_buf[1] = (uint8_t) ((value & 0x0000ff00u) >> 8);
-    value_buf[2] = (uint8_t) ((value & 0x00ff0000u) >> 16);
-    value_buf[3] = (uint8_t) ((value & 0xff000000u) >> 24);
+            __parallel_lock(base);
+            parallel->drained++;
+
+            if (result)
+            {
+                parallel->failed = 1;
+            }
+
+            __parallel_notify(base);
+            continue;
+        }
+
+        // Find out where the next chunk starts by skipping through the one before it
+        if (parallel->published < chunk_count && parallel->published < parallel->drained + parallel->window_size)
+        {
+            size_t index = parallel->published;
+            struct __parallel_read_chunk* chunk = &parallel->window[index % parallel->window_size];
+            __parallel_unlock(base);
+
+            int result = 0;
+            if (index > 0)
+            {
+                uint64_t count = parallel->window[(index - 1) % parallel->window_size].count;
+                for (uint64_t i = 0; i < count && result == 0; ++i)
+                {
+                    result = __dbof_1_skip_object(&scanner, 1, DBOF_TYPE_NULL);
+                }
+            }
+
+            chunk->position = scanner.position;
+            chunk->count = index == chunk_count - 1 ? children - index * chunk_children : chunk_children;
+            result = result || __parallel_reader_reserve(chunk, chunk->count);
+
+            __parallel_lock(base);
+
+            if (result)
+            {
+                parallel->failed = 1;
+            }
+            else
+            {
+                parallel->published++;
+            }
+
+            __parallel_notify(base);
+            continue;
+        }
+
+        // Help with reading until the next chunk is ready
+        if (!__parallel_reader_claim(base))
+        {
+            __parallel_wait(base);
+        }
+    }
 
-    // Write 4 bytes
-    if (writer->write(writer, value_buf, 4) < 4)
+    // On failure, chunks may still be read; wait for them and leave the window clean for the next container
+    while (parallel->busy > 0)
     {
-        // ERROR: End of file or out of space
-        return -1;
+        __parallel_wait(base);
     }
 
-    return 0;
-}
+    for (size_t i = 0; i < parallel->window_size; ++i)
+    {
+        struct __parallel_read_chunk* chunk = &parallel->window[i];
 
-static dbof_object_signed_long_integer __dbof_1_read_object_signed_long_integer(dbof_reader* reader)
-{
-    dbof_signed_long_integer value = 0;
+        if (chunk->done)
+        {
+            for (uint64_t j = 0; j < chunk->count; ++j)
+            {
+                dbof_delete(chunk->objects[j]);
+            }
 
-    // Read 8 bytes
-    char value_buf[8];
-    if (reader->read(reader, value_buf, 8) < 8)
-    {
-        // ERROR: End of file
-        return NULL;
+            chunk->done = 0;
+        }
     }
 
-    // Unpack little-endian 64-bit integer (LSB stored first)
-    value |= ((uint64_t) value_buf[0]) << 0;
-    value |= ((uint64_t) value_buf[1]) << 8;
-    value |= ((uint64_t) value_buf[2]) << 16;
-    value |= ((uint64_t) value_buf[3]) << 24;
-    value |= ((uint64_t) value_buf[4]) << 32;
-    value |= ((uint64_t) value_buf[5]) << 40;
-    value |= ((uint64_t) value_buf[6]) << 48;
-    value |= ((uint64_t) value_buf[7]) << 56;
+    int failed = parallel->failed;
+    __parallel_unlock(base);
 
-    // Set value
-    dbof_object_signed_long_integer object = __new_object_signed_long_integer();
-    dbof_set_value_signed_long_integer(object, value);
-    return object;
+    if (!failed)
+        return container;
+
+    // Read the container over on this thread, so it fails (or not) just like it would there
+    dbof_delete(container);
+    reader->position = start;
+    reader->depth = depth;
+
+    return __dbof_1_read_object(reader, 1, DBOF_TYPE_NULL);
 }
 
-static int __dbof_1_write_object_signed_long_integer(dbof_object_signed_long_integer object, dbof_writer* writer)
+/**
+ * Internal. Read an object in DBOF-1 format, reading the wide untyped containers in it on several threads.
+ *
+ * @param parallel The parallel reader
+ * @param depth The number of containers around the object
+ * @return The read object or NULL if an error occurred
+ */
+static dbof_object __dbof_1_read_object_parallel(struct __parallel_reader* parallel, unsigned int depth)
 {
-    // Get value
-    dbof_signed_long_integer value = dbof_get_value_signed_long_integer(object);
+    struct __buffered_reader* reader = parallel->reader;
+    size_t start = reader->position;
+    reader->depth = depth;
 
-    // Pack little-endian 64-bit integer (LSB stored first)
-    char value_buf[8];
-    value_buf[0] = (uint8_t) ((value & 0x00000000000000fful) >> 0);
-    value_buf[1] = (uint8_t) ((value & 0x000000000000ff00ul) >> 8);
-    value_buf[2] = (uint8_t) ((value & 0x0000000000ff0000ul) >> 16);
-    value_buf[3] = (uint8_t) ((value & 0x00000000ff000000ul) >> 24);
-    value_buf[4] = (uint8_t) ((value & 0x000000ff00000000ul) >> 32);
-    value_buf[5] = (uint8_t) ((value & 0x0000ff0000000000ul) >> 40);
-    value_buf[6] = (uint8_t) ((value & 0x00ff000000000000ul) >> 48);
-    value_buf[7] = (uint8_t) ((value & 0xff00000000000000ul) >> 56);
+    // Only untyped containers are looked into, anything else is read on this thread
+    char type_id = reader->position < reader->limit ? reader->buffer[reader->position] : DBOF_TYPE_NULL;
+    if (depth >= __PARALLEL_MAX_DESCENT || (type_id != DBOF_TYPE_UNTYPED_ARRAY && type_id != DBOF_TYPE_UNTYPED_MAP)
+            || (reader->max_depth != 0 && depth >= reader->max_depth))
+        return __dbof_1_read_object(reader, 1, DBOF_TYPE_NULL);
 
-    // Write 8 bytes
-    if (writer->write(writer, value_buf, 8) < 8)
+    reader->position++;
+
+    uint64_t children;
+    dbof_object container = __dbof_1_read_object_shallow(reader, type_id, &children);
+    if (container == NULL)
+        return NULL;
+
+    if (children >= __PARALLEL_MIN_CHILDREN)
+        return __parallel_reader_read_children(parallel, container, children, depth, start);
+
+    // Look for wide containers further down (maps take their children a key and value at a time)
+    dbof_object entry[2];
+    uint64_t entry_size = type_id == DBOF_TYPE_UNTYPED_MAP ? 2 : 1;
+
+    for (uint64_t i = 0; i < children; ++i)
     {
-        // ERROR: End of file or out of space
-        return -1;
+        uint64_t index = i % entry_size;
+
+        entry[index] = __dbof_1_read_object_parallel(parallel, depth + 1);
+        if (entry[index] == NULL)
+        {
+            while (index-- > 0)
+            {
+                dbof_delete(entry[index]);
+            }
+
+            dbof_delete(container);
+            return NULL;
+        }
+
+        if (index == entry_size - 1 && __parallel_reader_add(container, entry, entry_size))
+        {
+            dbof_delete(container);
+            return NULL;
+        }
     }
 
-    return 0;
+    return container;
 }
 
-static dbof_object_unsigned_long_integer __dbof_1_read_object_unsigned_long_integer(dbof_reader* reader)
+/**
+ * Internal. Read an object in DBOF-1 format on the given number of threads, the calling one included. The reader must
+ * hold the whole input in memory.
+ */
+static dbof_object __dbof_1_read_parallel(struct __buffered_reader* reader, unsigned int threads)
 {
-    dbof_unsigned_long_integer value = 0;
+    struct __parallel_reader parallel;
 
-    // Read 8 bytes
-    char value_buf[8];
-    if (reader->read(reader, value_buf, 8) < 8)
-    {
-        // ERROR: End of file
-        return NULL;
-    }
+    // If the threads cannot be set up, read on this one alone
+    if (__parallel_reader_init(&parallel, reader, threads))
+        return __dbof_1_read_object(reader, 1, DBOF_TYPE_NULL);
 
-    // Unpack little-endian 64-bit integer (LSB stored first)
-    value |= ((uint64_t) value_buf[0]) << 0;
-    value |= ((uint64_t) value_buf[1]) << 8;
-    value |= ((uint64_t) value_buf[2]) << 16;
-    value |= ((uint64_t) value_buf[3]) << 24;
-    value |= ((uint64_t) value_buf[4]) << 32;
-    value |= ((uint64_t) value_buf[5]) << 40;
-    value |= ((uint64_t) value_buf[6]) << 48;
-    value |= ((uint64_t) value_buf[7]) << 56;
+    dbof_object object = __dbof_1_read_object_parallel(&parallel, 0);
+    __parallel_reader_destroy(&parallel);
 
-    // Set value
-    dbof_object_unsigned_long_integer object = __new_object_unsigned_long_integer();
-    dbof_set_value_unsigned_long_integer(object, value);
     return object;
 }
 
-static int __dbof_1_write_object_unsigned_long_integer(dbof_object_unsigned_long_integer object, dbof_writer* writer)
+#endif
+
+/* Dispatched DBOF Serialization */
+
+//
+// Each serialized top-level object has a six-byte header, regardless of the serialization format or version.
+//
+// This header is composed of two fields:
+// 1. A four-byte magic number (the UTF-8 characters 'D', 'B', 'O', and 'F')
+// 2. A two-byte primary version ID (a sixteen-bit little-endian version number)
+//
+// Versions 1 and 2 are both DBOF-1 and differ only in the children of typed containers. Version 1 puts a type ID before
+// each of them, even though the container already records their type. Version 2 leaves it out.
+//
+
+/**
+ * Internal. Read the header (or take the version the reader forces). Returns zero on success, otherwise nonzero.
+ */
+static int __read_header(struct __buffered_reader* buffered, dbof_reader* reader, unsigned short* out_version)
 {
-    // Get value
-    dbof_unsigned_long_integer value = dbof_get_value_unsigned_long_integer(object);
+    unsigned short version;
 
-    // Pack little-endian 64-bit integer (LSB stored first)
-    char value_buf[8];
-    value_buf[0] = (uint8_t) ((value & 0x00000000000000fful) >> 0);
-    value_buf[1] = (uint8_t) ((value & 0x000000000000ff00ul) >> 8);
-    value_buf[2] = (uint8_t) ((value & 0x0000000000ff0000ul) >> 16);
-    value_buf[3] = (uint8_t) ((value & 0x00000000ff000000ul) >> 24);
-    value_buf[4] = (uint8_t) ((value & 0x000000ff00000000ul) >> 32);
-    value_buf[5] = (uint8_t) ((value & 0x0000ff0000000000ul) >> 40);
-    value_buf[6] = (uint8_t) ((value & 0x00ff000000000000ul) >> 48);
-    value_buf[7] = (uint8_t) ((value & 0xff00000000000000ul) >> 56);
+    if (reader->no_header)
+    {
+        if (!reader->use_version)
+        {
+            // ERROR: Header skipped but no version specified
+            return -1;
+        }
 
-    // Write 8 bytes
-    if (writer->write(writer, value_buf, 8) < 8)
+        version = reader->use_version;
+    }
+    else
     {
-        // ERROR: End of file or out of space
-        return -1;
+        // Extract the six-byte header
+        char header[6];
+        if (__buffered_reader_read(buffered, header, sizeof(header)) < sizeof(header))
+        {
+            // ERROR: End of file
+            return -1;
+        }
+
+        // Compare the magic number to expected
+        char magic[] = { header[0], header[1], header[2], header[3], '\0' };
+        if (strcmp(magic, "DBOF") != 0)
+        {
+            // ERROR: Magic number does not match expected value
+            return -1;
+        }
+
+        // Get version integer in little-endian manner
+        version = 0;
+        version |= ((uint16_t) (uint8_t) header[4]) << 0; // LSB stored first
+        version |= ((uint16_t) (uint8_t) header[5]) << 8; // MSB stored second
     }
 
+    buffered->version = version;
+    *out_version = version;
     return 0;
 }
 
-static dbof_object_boolean __dbof_1_read_object_boolean(dbof_reader* reader)
+/**
+ * Internal. Read a top-level object through the given buffered reader.
+ */
+static dbof_object __read(struct __buffered_reader* buffered, dbof_reader* reader)
 {
-    dbof_boolean value = 0;
+    unsigned short version;
+    if (__read_header(buffered, reader, &version))
+        return NULL;
 
-    // Read 1 byte
-    if (reader->read(reader, (char*) &value, 1) < 1)
+    // Read top-level object depending on version
+    switch (version)
     {
-        // ERROR: End of file
+    case 1:
+    case 2:
+#ifdef DBOF_THREADS
+        // Read using DBOF-1 on several threads, if asked to and if the whole input is in memory (arenas, intern pools,
+        // and allocation budgets are not shared between threads)
+        if (reader->threads > 1 && buffered->source == NULL && buffered->arena == NULL && buffered->intern_pool == NULL
+                && buffered->budget == UINT64_MAX)
+            return __dbof_1_read_parallel(buffered, reader->threads);
+#endif
+
+        // Read using DBOF-1
+        return __dbof_1_read_object(buffered, 1, DBOF_TYPE_NULL);
+    default:
+        // ERROR: Unsupported serialization format
         return NULL;
     }
-
-    // Set value
-    dbof_object_boolean object = __new_object_boolean();
-    dbof_set_value_boolean(object, value);
-    return object;
 }
 
-static int __dbof_1_write_object_boolean(dbof_object_boolean object, dbof_writer* writer)
+dbof_object dbof_read(dbof_reader* reader)
 {
-    // Get value
-    dbof_boolean value = dbof_get_value_boolean(object);
+    // Small buffers live on the stack, larger ones on the heap
+    char stack_buffer[__DEFAULT_BUFFER_SIZE];
+    size_t capacity = reader->buffer_size == 0 ? __DEFAULT_BUFFER_SIZE : reader->buffer_size;
+    char* buffer = capacity <= sizeof(stack_buffer) ? stack_buffer : malloc(capacity);
 
-    // Write 1 byte
-    if (writer->write(writer, (char*) &value, 1) < 1)
+    if (buffer == NULL)
     {
-        // ERROR: End of file or out of space
-        return -1;
+        // ERROR: Out of memory
+        return NULL;
     }
 
-    return 0;
-}
+    struct __buffered_reader buffered;
+    __buffered_reader_init(&buffered, reader, buffer, capacity);
 
-//
-// IMPORTANT
-//
-// We are assuming the architecture stores single- and double-precision floating-point numbers in memory as the common
-// IEEE 754 binary32 and binary64 representations. We don't require fully-conforming float *operations* from the
-// compiler, but memory representation is a necessity. Using an architecture with another representation will result in
-// ill-formed serialized objects.
-//
+    dbof_object object = __read(&buffered, reader);
+    __buffered_reader_give_back(&buffered);
 
-static dbof_object_single_float __dbof_1_read_object_single_float(dbof_reader* reader)
-{
-    // Read 4 bytes
-    char value_buf[4];
-    if (reader->read(reader, value_buf, 4) < 4)
+    if (buffer != stack_buffer)
     {
-        // ERROR: End of file
-        return NULL;
+        free(buffer);
     }
 
-    // Unpack little-endian IEEE 754 binary32 float (LSB stored first)
-    uint32_t value_tmp = 0;
-    value_tmp |= ((uint32_t) value_buf[0]) << 0;
-    value_tmp |= ((uint32_t) value_buf[1]) << 8;
-    value_tmp |= ((uint32_t) value_buf[2]) << 16;
-    value_tmp |= ((uint32_t) value_buf[3]) << 24;
-
-    // Convert to single float value
-    union
-    {
-        uint32_t in;
-        dbof_single_float out;
-    } cvt = { value_tmp };
-
-    // Set value
-    dbof_object_single_float object = __new_object_single_float();
-    dbof_set_value_single_float(object, cvt.out);
     return object;
 }
 
-static int __dbof_1_write_object_single_float(dbof_object_single_float object, dbof_writer* writer)
+dbof_object dbof_read_buffer(const void* data, size_t size, int flags)
 {
-    // Get value
-    dbof_single_float value = dbof_get_value_single_float(object);
-
-    // Convert to unsigned integer
-    union
-    {
-        dbof_single_float in;
-        uint32_t out;
-    } cvt = { value };
-
-    // Pack little-endian IEEE 754 binary32 float (LSB stored first)
-    char value_buf[4];
-    value_buf[0] = (uint8_t) ((cvt.out & 0x000000ffu) >> 0);
-    value_buf[1] = (uint8_t) ((cvt.out & 0x0000ff00u) >> 8);
-    value_buf[2] = (uint8_t) ((cvt.out & 0x00ff0000u) >> 16);
-    value_buf[3] = (uint8_t) ((cvt.out & 0xff000000u) >> 24);
-
-    // Write 4 bytes
-    if (writer->write(writer, value_buf, 4) < 4)
-    {
-        // ERROR: End of file or out of space
-        return -1;
-    }
+    // There is nothing to configure, so an empty reader takes the defaults (header expected)
+    dbof_reader reader;
+    memset(&reader, 0, sizeof(reader));
 
-    return 0;
+    return dbof_read_buffer_ex(&reader, data, size, flags);
 }
 
-static dbof_object_double_float __dbof_1_read_object_double_float(dbof_reader* reader)
+dbof_object dbof_read_buffer_ex(dbof_reader* reader, const void* data, size_t size, int flags)
 {
-    // Read 8 bytes
-    char value_buf[8];
-    if (reader->read(reader, value_buf, 8) < 8)
-    {
-        // ERROR: End of file
-        return NULL;
-    }
+    struct __buffered_reader buffered;
+    __buffered_reader_init_memory(&buffered, data, size);
+    buffered.borrow = flags & DBOF_READ_BORROW;
+
+    // Take the reader's settings, but not its source
+    buffered.arena = reader->arena;
+    buffered.intern_pool = reader->intern_pool;
+    buffered.max_depth = reader->max_depth == 0 ? DBOF_DEFAULT_MAX_DEPTH : reader->max_depth;
+    buffered.budget = reader->max_allocation == 0 ? UINT64_MAX : reader->max_allocation;
+    buffered.immediate = reader->immediate_values;
+
+    return __read(&buffered, reader);
+}
 
-    // Unpack little-endian IEEE 754 binary64 float (LSB stored first)
-    uint64_t value_tmp = 0;
-    value_tmp |= ((uint64_t) value_buf[0]) << 0;
-    value_tmp |= ((uint64_t) value_buf[1]) << 8;
-    value_tmp |= ((uint64_t) value_buf[2]) << 16;
-    value_tmp |= ((uint64_t) value_buf[3]) << 24;
-    value_tmp |= ((uint64_t) value_buf[4]) << 32;
-    value_tmp |= ((uint64_t) value_buf[5]) << 40;
-    value_tmp |= ((uint64_t) value_buf[6]) << 48;
-    value_tmp |= ((uint64_t) value_buf[7]) << 56;
+/**
+ * Internal. Parse a top-level object through the given buffered reader.
+ */
+static int __parse(struct __buffered_reader* buffered, dbof_reader* reader, dbof_handler* handler)
+{
+    unsigned short version;
+    if (__read_header(buffered, reader, &version))
+        return -1;
 
-    // Convert to double float value
-    union
+    // Parse top-level object depending on version
+    switch (version)
     {
-        uint64_t in;
-        dbof_double_float out;
-    } cvt = { value_tmp };
-
-    // Set value
-    dbof_object_double_float object = __new_object_double_float();
-    dbof_set_value_double_float(object, cvt.out);
-    return object;
+    case 1:
+    case 2:
+        // Parse using DBOF-1
+        return __dbof_1_parse_object(buffered, handler, 1, DBOF_TYPE_NULL);
+    default:
+        // ERROR: Unsupported serialization format
+        return -1;
+    }
 }
 
-static int __dbof_1_write_object_double_float(dbof_object_double_float object, dbof_writer* writer)
+int dbof_parse(dbof_reader* reader, dbof_handler* handler)
 {
-    // Get value
-    dbof_double_float value = dbof_get_value_double_float(object);
+    // Small buffers live on the stack, larger ones on the heap
+    char stack_buffer[__DEFAULT_BUFFER_SIZE];
+    size_t capacity = reader->buffer_size == 0 ? __DEFAULT_BUFFER_SIZE : reader->buffer_size;
+    char* buffer = capacity <= sizeof(stack_buffer) ? stack_buffer : malloc(capacity);
 
-    // Convert to unsigned integer
-    union
+    if (buffer == NULL)
     {
-        dbof_double_float in;
-        uint64_t out;
-    } cvt = { value };
+        // ERROR: Out of memory
+        return -1;
+    }
 
-    // Pack little-endian IEEE 754 binary64 float (LSB stored first)
-    char value_buf[8];
-    value_buf[0] = (uint8_t) ((cvt.out & 0x00000000000000fful) >> 0);
-    value_buf[1] = (uint8_t) ((cvt.out & 0x000000000000ff00ul) >> 8);
-    value_buf[2] = (uint8_t) ((cvt.out & 0x0000000000ff0000ul) >> 16);
-    value_buf[3] = (uint8_t) ((cvt.out & 0x00000000ff000000ul) >> 24);
-    value_buf[4] = (uint8_t) ((cvt.out & 0x000000ff00000000ul) >> 32);
-    value_buf[5] = (uint8_t) ((cvt.out & 0x0000ff0000000000ul) >> 40);
-    value_buf[6] = (uint8_t) ((cvt.out & 0x00ff000000000000ul) >> 48);
-    value_buf[7] = (uint8_t) ((cvt.out & 0xff00000000000000ul) >> 56);
+    struct __buffered_reader buffered;
+    __buffered_reader_init(&buffered, reader, buffer, capacity);
 
-    // Write 8 bytes
-    if (writer->write(writer, value_buf, 8) < 8)
+    int result = __parse(&buffered, reader, handler);
+    __buffered_reader_give_back(&buffered);
+
+    if (buffer != stack_buffer)
     {
-        // ERROR: End of file or out of space
-        return -1;
+        free(buffer);
     }
 
-    return 0;
+    return result;
 }
 
-static dbof_object_character __dbof_1_read_object_character(dbof_reader* reader)
+int dbof_parse_buffer(const void* data, size_t size, dbof_handler* handler)
 {
-    dbof_character value = 0;
-
-    // Read 4 bytes
-    char value_buf[4];
-    if (reader->read(reader, value_buf, 4) < 4)
-    {
-        // ERROR: End of file
-        return NULL;
-    }
+    // There is nothing to configure, so an empty reader takes the defaults (header expected)
+    dbof_reader reader;
+    memset(&reader, 0, sizeof(reader));
 
-    // Unpack little-endian character (LSB stored first)
-    value |= ((uint32_t) value_buf[0]) << 0;
-    value |= ((uint32_t) value_buf[1]) << 8;
-    value |= ((uint32_t) value_buf[2]) << 16;
-    value |= ((uint32_t) value_buf[3]) << 24;
+    struct __buffered_reader buffered;
+    __buffered_reader_init_memory(&buffered, data, size);
 
-    // Get value
-    dbof_object_character object = __new_object_character();
-    dbof_set_value_character(object, value);
-    return object;
+    return __parse(&buffered, &reader, handler);
 }
 
-static int __dbof_1_write_object_character(dbof_object_character object, dbof_writer* writer)
+/**
+ * Internal. Write the header (unless the writer skips it). Returns zero on success, otherwise nonzero.
+ */
+static int __write_header(struct __buffered_writer* buffered, dbof_writer* writer, unsigned short* out_version)
 {
-    // Get value
-    dbof_character value = dbof_get_value_unsigned_integer(object);
-
-    // Pack little-endian character (LSB stored first)
-    char value_buf[4];
-    value_buf[0] = (uint8_t) ((value & 0x000000ffu) >> 0);
-    value_buf[1] = (uint8_t) ((value & 0x0000ff00u) >> 8);
-    value_buf[2] = (uint8_t) ((value & 0x00ff0000u) >> 16);
-    value_buf[3] = (uint8_t) ((value & 0xff000000u) >> 24);
+    // Get version to write, or default to latest
+    unsigned short version = writer->use_version;
+    if (version == 0)
+    {
+        version = DBOF_SER_DEFAULT;
+    }
 
-    // Write 4 bytes
-    if (writer->write(writer, value_buf, 4) < 4)
+    if (!writer->no_header)
     {
-        // ERROR: End of file or out of space
-        return -1;
+        // Build header with magic number and version
+        char version_lsb = (char) ((version & 0x00ff) >> 0);
+        char version_msb = (char) ((version & 0xff00) >> 8);
+        char header[] = { 'D', 'B', 'O', 'F', version_lsb, version_msb };
+
+        // Write header
+        if (__buffered_writer_write(buffered, header, sizeof(header)) < sizeof(header))
+            return -1;
     }
 
+    buffered->version = version;
+    *out_version = version;
     return 0;
 }
 
 /**
- * Internal algorithm to calculate the minimum number of 8-bit bytes necessary to represent up to a 64-bit integer
- * without loss of information.
- *
- * @param value The value in question
- * @return The required number of bytes
+ * Internal. Write a top-level object through the given buffered writer.
  */
-static int __count_min_bytes_internal(uint64_t value)
+static int __write(dbof_object object, struct __buffered_writer* buffered, dbof_writer* writer)
 {
-    if ((value & 0x00000000000000fful) == value)
-        return 1;
-    if ((value & 0x000000000000fffful) == value)
-        return 2;
-    if ((value & 0x0000000000fffffful) == value)
-        return 3;
-    if ((value & 0x00000000fffffffful) == value)
-        return 4;
-    if ((value & 0x000000fffffffffful) == value)
-        return 5;
-    if ((value & 0x0000fffffffffffful) == value)
-        return 6;
-    if ((value & 0x00fffffffffffffful) == value)
-        return 7;
+    unsigned short version;
+    if (__write_header(buffered, writer, &version))
+        return -1;
 
-    return 8;
+    // Write top-level object depending on version
+    switch (version)
+    {
+    case 1:
+    case 2:
+#ifdef DBOF_THREADS
+        // Write using DBOF-1 on several threads, if asked to
+        if (writer->threads > 1)
+            return __dbof_1_write_parallel(object, buffered, writer->threads);
+#endif
+
+        // Write using DBOF-1
+        return __dbof_1_write_object(object, buffered, 1);
+    default:
+        // ERROR: Unsupported serialization format
+        return 1;
+    }
 }
 
-/**
- * Internal procedure for reading flex lengths as defined in DBOF-1.
- *
- * @param       reader The reader
- * @param [out] out_length The length
- * @return Zero on success, otherwise nonzero
- */
-static int __dbof_1_read_flex_length_internal(dbof_reader* reader, uint64_t* out_length)
+int dbof_write(dbof_object object, dbof_writer* writer)
 {
-    char length_size;
-    char length_buf[8] = {};
-    uint64_t length = 0;
-
-    // Read size of flex length data
-    if (reader->read(reader, &length_size, 1) < 1)
-        goto fail_eof;
+    // Small buffers live on the stack, larger ones on the heap
+    char stack_buffer[__DEFAULT_BUFFER_SIZE];
+    size_t capacity = writer->buffer_size == 0 ? __DEFAULT_BUFFER_SIZE : writer->buffer_size;
+    char* buffer = capacity <= sizeof(stack_buffer) ? stack_buffer : malloc(capacity);
 
-    // Limited by DBOF-1 spec to a max of 8
-    if (length_size > 8)
-        goto fail_out_of_spec;
+    if (buffer == NULL)
+    {
+        // ERROR: Out of memory
+        return -1;
+    }
 
-    // Read flex length data
-    if (reader->read(reader, length_buf, (size_t) length_size) < length_size)
-        goto fail_eof;
+    struct __buffered_writer buffered;
+    __buffered_writer_init(&buffered, writer, buffer, capacity);
 
-    // Unpack flex length (little-endian, LSB stored first)
-    for (int i = 0; i < length_size; ++i)
+    // Whatever happens, hand over everything that was buffered
+    int result = __write(object, &buffered, writer);
+    if (__buffered_writer_flush(&buffered))
     {
-        length |= ((uint64_t) length_buf[i]) << i * 8;
+        result = -1;
     }
 
-    *out_length = length;
-    return 0;
+    if (buffer != stack_buffer)
+    {
+        free(buffer);
+    }
 
-fail_eof:
-fail_out_of_spec:
-    return -1;
+    return result;
 }
 
+/* Streaming Serialization */
+
+//
+// NOTICE
+// The encoder writes a serialized object piece by piece, straight from the caller's own data. It keeps only a stack of
+// the containers that are open, each with the number of children still to come, so it can tell which children carry
+// a type ID (children of untyped containers) and which must match the container's type (children of typed ones).
+//
+
 /**
- * Internal procedure for writing flex lengths as defined in DBOF-1.
- *
- * @param writer The writer
- * @param length The length
- * @return Zero on success, otherwise nonzero
+ * An open container in an encoder.
  */
-static int __dbof_1_write_flex_length_internal(dbof_writer* writer, uint64_t length)
+struct __encoder_container
 {
-    char length_buf[8];
+    /**
+     * The container type.
+     */
+    dbof_type type;
 
-    // Calculate size of flex length data
-    char length_size = (char) __count_min_bytes_internal(length);
+    /**
+     * The element type (typed arrays) or the key type (typed maps).
+     */
+    dbof_type key_type;
 
-    // Write length size
-    if (writer->write(writer, &length_size, 1) < 1)
-        goto fail_eof;
+    /**
+     * The value type (typed maps).
+     */
+    dbof_type value_type;
 
-    // Pack flex length (little-endian, LSB stored first)
-    for (int i = 0; i < length_size; ++i)
-    {
-        length_buf[i] = (uint8_t) ((length & (0x00000000000000fful << i * 8)) >> i * 8);
-    }
+    /**
+     * The number of children still to come (two per key-value pair in maps).
+     */
+    uint64_t remaining;
+};
 
-    // Write length data
-    if (writer->write(writer, length_buf, (size_t) length_size) < length_size)
-        goto fail_eof;
+struct __encoder
+{
+    /**
+     * The buffered writer.
+     */
+    struct __buffered_writer writer;
 
-    return 0;
+    /**
+     * The stack of open containers.
+     */
+    struct __encoder_container* stack;
 
-fail_eof:
-    return -1;
-}
+    /**
+     * The number of open containers.
+     */
+    size_t depth;
 
-static dbof_object_utf8_string __dbof_1_read_object_utf8_string(dbof_reader* reader)
-{
-    struct __object_utf8_string_impl* string = __new_object_utf8_string();
+    /**
+     * The allocated size of the stack.
+     */
+    size_t stack_capacity;
 
-    dbof_string_size length;
-    char* value = NULL; // free(NULL) is well-defined
+    /**
+     * Nonzero once the top-level object has been started.
+     */
+    int started;
 
-    // Read string length as flex length
-    if (__dbof_1_read_flex_length_internal(reader, &length))
-        goto fail;
+    /**
+     * Nonzero once anything has gone wrong. The encoder refuses all further work.
+     */
+    int failed;
+};
 
-    // Allocate memory for string value (plus null terminator)
-    value = malloc(length + 1);
-    if (value == NULL)
-        goto fail;
+/**
+ * Internal. Account for the next object written and write its type ID if needed. Returns zero on success, otherwise
+ * nonzero.
+ */
+static int __encoder_begin_object(struct __encoder* encoder, dbof_type type)
+{
+    if (encoder->failed)
+        return -1;
 
-    // Read string value
-    if (reader->read(reader, value, length) < length)
-        goto fail_eof;
+    int write_type;
 
-    // This is untrusted input, so make sure there's a null terminator
-    value[length] = '\0';
+    if (encoder->depth == 0)
+    {
+        // There is exactly one top-level object
+        if (encoder->started)
+            goto fail;
 
-    string->value = value;
-    return string;
+        encoder->started = 1;
+        write_type = 1;
+    }
+    else
+    {
+        struct __encoder_container* container = &encoder->stack[encoder->depth - 1];
 
-fail:
-fail_eof:
-    free(value);
-    __delete_object_utf8_string(string);
-    return NULL;
-}
+        // Containers take exactly as many children as announced
+        if (container->remaining == 0)
+            goto fail;
 
-static int __dbof_1_write_object_string(dbof_object_string object, dbof_writer* writer)
-{
-    struct __object_utf8_string_impl* string = (struct __object_utf8_string_impl*) object;
+        switch (container->type)
+        {
+        case DBOF_TYPE_TYPED_ARRAY:
+            if (type != container->key_type)
+                goto fail;
+
+            // Only version 1 has type IDs for children of typed containers
+            write_type = encoder->writer.version == 1;
+            break;
+        case DBOF_TYPE_TYPED_MAP:
+            // Keys and values alternate, with an even count meaning a key is next
+            if (type != (container->remaining % 2 == 0 ? container->key_type : container->value_type))
+                goto fail;
+
+            write_type = encoder->writer.version == 1;
+            break;
+        default:
+            write_type = 1;
+            break;
+        }
 
-    dbof_string value = string->value;
-    dbof_string_size length = strlen(value);
+        container->remaining--;
+    }
 
-    // Write string length as flex length
-    if (__dbof_1_write_flex_length_internal(writer, length))
+    char type_id = type;
+    if (write_type && __buffered_writer_write(&encoder->writer, &type_id, 1) < 1)
         goto fail;
 
-    // Write string value
-    if (writer->write(writer, value, length) < length)
-        goto fail_eof;
-
     return 0;
 
 fail:
-fail_eof:
+    encoder->failed = 1;
     return -1;
 }
 
 /**
- * Internal function to read an object in DBOF-1 format.
- *
- * @param reader The reader
- * @param read_type Whether to write the object type (nonzero) or not (zero)
- * @return The read object or NULL if an error occurred
- */
-static dbof_object __dbof_1_read_object(dbof_reader* reader, int read_type);
-
-/**
- * Internal function to write an object in DBOF-1 format.
- *
- * @param object The object to write
- * @param writer The writer
- * @param write_type Whether to write the object type (nonzero) or not (zero)
- * @return Zero upon success, otherwise nonzero
+ * Internal. Open a container whose header has been written. Returns zero on success, otherwise nonzero.
  */
-static int __dbof_1_write_object(dbof_object object, dbof_writer* writer, int write_type);
-
-static dbof_object_typed_array __dbof_1_read_object_typed_array(dbof_reader* reader)
+static int __encoder_push(struct __encoder* encoder, dbof_type type, uint64_t remaining, dbof_type key_type,
+        dbof_type value_type)
 {
-    struct __object_typed_array_impl* array = __new_object_typed_array();
-
-    uint64_t size;
-    char element_type_id;
-
-    // Read array length as flex length
-    if (__dbof_1_read_flex_length_internal(reader, &size))
-        goto fail;
-
-    // Read element type ID
-    if (reader->read(reader, &element_type_id, 1) < 1)
-        goto fail_eof;
-
-    // Pre-allocate the required storage space
-    __object_typed_array_impl_resize(array, size);
-
-    array->type = (dbof_type) element_type_id;
-
-    // Read each object individually
-    for (dbof_container_size i = 0; i < size; ++i)
+    if (encoder->depth == encoder->stack_capacity)
     {
-        dbof_object object = __dbof_1_read_object(reader, 0);
-        if (object == NULL)
-            goto fail_protocol;
+        size_t capacity = encoder->stack_capacity == 0 ? 8 : encoder->stack_capacity * 2;
+
+        struct __encoder_container* stack = realloc(encoder->stack, capacity * sizeof(struct __encoder_container));
+        if (stack == NULL)
+        {
+            // ERROR: Out of memory
+            encoder->failed = 1;
+            return -1;
+        }
 
-        __object_typed_array_impl_push_back(array, object);
+        encoder->stack = stack;
+        encoder->stack_capacity = capacity;
     }
 
-    return array;
+    struct __encoder_container* container = &encoder->stack[encoder->depth++];
+    container->type = type;
+    container->key_type = key_type;
+    container->value_type = value_type;
+    container->remaining = remaining;
 
-fail:
-fail_eof:
-fail_protocol:
-    __delete_object_typed_array(array);
-    return NULL;
+    return 0;
 }
 
-static int __dbof_1_write_object_typed_array(dbof_object_typed_array array, dbof_writer* writer)
+/**
+ * Internal. Check the outcome of a write, failing the encoder if it went wrong.
+ */
+static int __encoder_check(struct __encoder* encoder, int result)
 {
-    struct __object_typed_array_impl* array_impl = (struct __object_typed_array_impl*) array;
-
-    dbof_container_size size = __object_typed_array_impl_get_size(array_impl);
-    char element_type_id = array_impl->type;
-
-    // Write array length as flex length
-    if (__dbof_1_write_flex_length_internal(writer, size))
-        goto fail;
-
-    // Write element type ID
-    if (writer->write(writer, &element_type_id, 1) < 1)
-        goto fail_eof;
-
-    // Write each object individually
-    for (dbof_container_size i = 0; i < size; ++i)
+    if (result)
     {
-        __dbof_1_write_object(__object_typed_array_impl_get(array_impl, i), writer, 0);
+        encoder->failed = 1;
     }
-
-    return 0;
-
-fail:
-fail_eof:
-    return -1;
+
+    return result;
 }
 
-static dbof_object_untyped_array __dbof_1_read_object_untyped_array(dbof_reader* reader)
+static int __encoder_write_packed_value(struct __encoder* encoder, dbof_type type, const void* value)
 {
-    struct __object_untyped_array_impl* array = __new_object_untyped_array();
+    if (__encoder_begin_object(encoder, type))
+        return -1;
 
-    uint64_t size;
+    return __encoder_check(encoder, __dbof_1_write_packed_values_internal(&encoder->writer, value, 1,
+            __packed_size_of(type)));
+}
 
-    // Read array size as flex length
-    if (__dbof_1_read_flex_length_internal(reader, &size))
+dbof_encoder dbof_encoder_new(dbof_writer* writer)
+{
+    struct __encoder* encoder = calloc(1, sizeof(struct __encoder));
+    if (encoder == NULL)
         goto fail;
 
-    // Pre-allocate the required storage space
-    __object_untyped_array_impl_resize(array, size);
+    // The encoder outlives any one call, so its buffer lives on the heap
+    size_t capacity = writer->buffer_size == 0 ? __DEFAULT_BUFFER_SIZE : writer->buffer_size;
+    char* buffer = malloc(capacity);
+    if (buffer == NULL)
+        goto fail;
 
-    // Read each object individually
-    for (dbof_container_size i = 0; i < size; ++i)
-    {
-        dbof_object object = __dbof_1_read_object(reader, 0);
-        if (object == NULL)
-            goto fail_protocol;
+    __buffered_writer_init(&encoder->writer, writer, buffer, capacity);
 
-        __object_untyped_array_impl_push_back(array, object);
-    }
+    unsigned short version;
+    if (__write_header(&encoder->writer, writer, &version))
+        goto fail;
 
-    return array;
+    // Only DBOF-1 can be streamed
+    if (version != 1 && version != 2)
+        goto fail;
+
+    return encoder;
 
 fail:
-fail_protocol:
-    __delete_object_untyped_array(array);
+    if (encoder != NULL)
+    {
+        free(encoder->writer.buffer);
+        free(encoder);
+    }
+
     return NULL;
 }
 
-static int __dbof_1_write_object_untyped_array(dbof_object_untyped_array array, dbof_writer* writer)
+int dbof_encoder_finish(dbof_encoder encoder)
 {
-    struct __object_untyped_array_impl* array_impl = (struct __object_untyped_array_impl*) array;
+    struct __encoder* enc = (struct __encoder*) encoder;
 
-    dbof_container_size size = __object_untyped_array_impl_get_size(array_impl);
-
-    // Write array size as flex length
-    if (__dbof_1_write_flex_length_internal(writer, size))
-        goto fail;
-
-    // Write each object individually
-    for (dbof_container_size i = 0; i < size; ++i)
+    // The document must be complete, and everything must make it to the writer
+    int result = enc->failed || !enc->started || enc->depth > 0 ? -1 : 0;
+    if (__buffered_writer_flush(&enc->writer))
     {
-        if (__dbof_1_write_object(__object_untyped_array_impl_get(array_impl, i), writer, 0))
-            goto fail_eof;
+        result = -1;
     }
 
-    return 0;
+    free(enc->writer.buffer);
+    free(enc->stack);
+    free(enc);
 
-fail:
-fail_eof:
-    return -1;
+    return result;
 }
 
-static dbof_object_typed_map __dbof_1_read_object_typed_map(dbof_reader* reader)
+int dbof_encoder_begin_typed_array(dbof_encoder encoder, dbof_container_size size, dbof_type element_type)
 {
-    struct __object_typed_map_impl* map = __new_object_typed_map();
+    struct __encoder* enc = (struct __encoder*) encoder;
+    char element_type_id = element_type;
 
-    uint64_t size;
-    char key_type_id;
-    char value_type_id;
+    if (__encoder_begin_object(enc, DBOF_TYPE_TYPED_ARRAY))
+        return -1;
 
-    // Read map size as flex length
-    if (__dbof_1_read_flex_length_internal(reader, &size))
-        goto fail;
+    if (__encoder_check(enc, __dbof_1_write_flex_length_internal(&enc->writer, size)))
+        return -1;
 
-    // Read key type ID
-    if (reader->read(reader, &key_type_id, 1) < 1)
-        goto fail_eof;
+    if (__buffered_writer_write(&enc->writer, &element_type_id, 1) < 1)
+        return __encoder_check(enc, -1);
 
-    // Read value type ID
-    if (reader->read(reader, &value_type_id, 1) < 1)
-        goto fail_eof;
+    return __encoder_push(enc, DBOF_TYPE_TYPED_ARRAY, size, element_type, DBOF_TYPE_NULL);
+}
 
-    map->size = (dbof_container_size) size;
-    map->key_type = (dbof_type) key_type_id;
-    map->value_type = (dbof_type) value_type_id;
+int dbof_encoder_begin_untyped_array(dbof_encoder encoder, dbof_container_size size)
+{
+    struct __encoder* enc = (struct __encoder*) encoder;
 
-    // TODO: Read children
+    if (__encoder_begin_object(enc, DBOF_TYPE_UNTYPED_ARRAY))
+        return -1;
 
-    return map;
+    if (__encoder_check(enc, __dbof_1_write_flex_length_internal(&enc->writer, size)))
+        return -1;
 
-fail:
-fail_eof:
-    __delete_object_typed_map(map);
-    return NULL;
+    return __encoder_push(enc, DBOF_TYPE_UNTYPED_ARRAY, size, DBOF_TYPE_NULL, DBOF_TYPE_NULL);
 }
 
-static int __dbof_1_write_object_typed_map(dbof_object_typed_map object, dbof_writer* writer)
+int dbof_encoder_begin_typed_map(dbof_encoder encoder, dbof_container_size size, dbof_type key_type,
+        dbof_type value_type)
 {
-    struct __object_typed_map_impl* map = (struct __object_typed_map_impl*) object;
+    struct __encoder* enc = (struct __encoder*) encoder;
+    char key_type_id = key_type;
+    char value_type_id = value_type;
 
-    dbof_container_size size = map->size;
-    char key_type_id = map->key_type;
-    char value_type_id = map->value_type;
+    if (__encoder_begin_object(enc, DBOF_TYPE_TYPED_MAP))
+        return -1;
 
-    // Write map size as flex length
-    if (__dbof_1_write_flex_length_internal(writer, size))
-        goto fail;
+    if (__encoder_check(enc, __dbof_1_write_flex_length_internal(&enc->writer, size)))
+        return -1;
 
-    // Write key type ID
-    if (writer->write(writer, &key_type_id, 1) < 1)
-        goto fail_eof;
+    if (__buffered_writer_write(&enc->writer, &key_type_id, 1) < 1
+            || __buffered_writer_write(&enc->writer, &value_type_id, 1) < 1)
+        return __encoder_check(enc, -1);
 
-    // Write value type ID
-    if (writer->write(writer, &value_type_id, 1) < 1)
-        goto fail_eof;
+    return __encoder_push(enc, DBOF_TYPE_TYPED_MAP, (uint64_t) size * 2, key_type, value_type);
+}
+
+int dbof_encoder_begin_untyped_map(dbof_encoder encoder, dbof_container_size size)
+{
+    struct __encoder* enc = (struct __encoder*) encoder;
 
-    // TODO: Write key-value pairs of children
+    if (__encoder_begin_object(enc, DBOF_TYPE_UNTYPED_MAP))
+        return -1;
 
-    return 0;
+    if (__encoder_check(enc, __dbof_1_write_flex_length_internal(&enc->writer, size)))
+        return -1;
 
-fail:
-fail_eof:
-    return -1;
+    return __encoder_push(enc, DBOF_TYPE_UNTYPED_MAP, (uint64_t) size * 2, DBOF_TYPE_NULL, DBOF_TYPE_NULL);
 }
 
-static dbof_object_untyped_map __dbof_1_read_object_untyped_map(dbof_reader* reader)
+int dbof_encoder_end(dbof_encoder encoder)
 {
-    struct __object_untyped_map_impl* map = __new_object_untyped_map();
+    struct __encoder* enc = (struct __encoder*) encoder;
 
-    uint64_t size;
+    if (enc->failed)
+        return -1;
 
-    // Read map size as flex length
-    if (__dbof_1_read_flex_length_internal(reader, &size))
-        goto fail;
+    // There must be an open container, and it must have received all of its children
+    if (enc->depth == 0 || enc->stack[enc->depth - 1].remaining > 0)
+        return __encoder_check(enc, -1);
 
-    map->size = (dbof_container_size) size;
+    enc->depth--;
+    return 0;
+}
 
-    // TODO: Read children
+int dbof_encoder_write_null(dbof_encoder encoder)
+{ return __encoder_begin_object(encoder, DBOF_TYPE_NULL); }
 
-    return map;
+int dbof_encoder_write_signed_byte(dbof_encoder encoder, dbof_signed_byte value)
+{ return __encoder_write_packed_value(encoder, DBOF_TYPE_SIGNED_BYTE, &value); }
 
-fail:
-fail_eof:
-    __delete_object_untyped_map(map);
-    return NULL;
-}
+int dbof_encoder_write_unsigned_byte(dbof_encoder encoder, dbof_unsigned_byte value)
+{ return __encoder_write_packed_value(encoder, DBOF_TYPE_UNSIGNED_BYTE, &value); }
 
-static int __dbof_1_write_object_untyped_map(dbof_object_untyped_map map, dbof_writer* writer)
-{
-    struct __object_untyped_map_impl* map_impl = (struct __object_untyped_map_impl*) map;
+int dbof_encoder_write_signed_integer(dbof_encoder encoder, dbof_signed_integer value)
+{ return __encoder_write_packed_value(encoder, DBOF_TYPE_SIGNED_INTEGER, &value); }
 
-    dbof_container_size size = map_impl->size;
+int dbof_encoder_write_unsigned_integer(dbof_encoder encoder, dbof_unsigned_integer value)
+{ return __encoder_write_packed_value(encoder, DBOF_TYPE_UNSIGNED_INTEGER, &value); }
 
-    // Write map size as flex length
-    if (__dbof_1_write_flex_length_internal(writer, size))
-        goto fail;
+int dbof_encoder_write_signed_long_integer(dbof_encoder encoder, dbof_signed_long_integer value)
+{ return __encoder_write_packed_value(encoder, DBOF_TYPE_SIGNED_LONG_INTEGER, &value); }
 
-    // TODO: Write key-value pairs of children
+int dbof_encoder_write_unsigned_long_integer(dbof_encoder encoder, dbof_unsigned_long_integer value)
+{ return __encoder_write_packed_value(encoder, DBOF_TYPE_UNSIGNED_LONG_INTEGER, &value); }
 
-    return 0;
+int dbof_encoder_write_boolean(dbof_encoder encoder, dbof_boolean value)
+{ return __encoder_write_packed_value(encoder, DBOF_TYPE_BOOLEAN, &value); }
 
-fail:
-fail_eof:
-    return -1;
-}
+int dbof_encoder_write_single_float(dbof_encoder encoder, dbof_single_float value)
+{ return __encoder_write_packed_value(encoder, DBOF_TYPE_SINGLE_FLOAT, &value); }
 
-static dbof_object __dbof_1_read_object(dbof_reader* reader, int read_type)
-{
-    // Read object type ID
-    char type_id;
-    if (reader->read(reader, &type_id, 1) < 1)
-        return NULL;
+int dbof_encoder_write_double_float(dbof_encoder encoder, dbof_double_float value)
+{ return __encoder_write_packed_value(encoder, DBOF_TYPE_DOUBLE_FLOAT, &value); }
 
-    // Delegate to appropriate read function
-    switch (type_id)
-    {
-    case DBOF_TYPE_NULL:
-        return __dbof_1_read_object_null(reader);
-    case DBOF_TYPE_SIGNED_BYTE:
-        return __dbof_1_read_object_signed_byte(reader);
-    case DBOF_TYPE_UNSIGNED_BYTE:
-        return __dbof_1_read_object_unsigned_byte(reader);
-    case DBOF_TYPE_SIGNED_INTEGER:
-        return __dbof_1_read_object_signed_integer(reader);
-    case DBOF_TYPE_UNSIGNED_INTEGER:
-        return __dbof_1_read_object_unsigned_integer(reader);
-    case DBOF_TYPE_SIGNED_LONG_INTEGER:
-        return __dbof_1_read_object_signed_long_integer(reader);
-    case DBOF_TYPE_UNSIGNED_LONG_INTEGER:
-        return __dbof_1_read_object_unsigned_long_integer(reader);
-    case DBOF_TYPE_BOOLEAN:
-        return __dbof_1_read_object_boolean(reader);
-    case DBOF_TYPE_SINGLE_FLOAT:
-        return __dbof_1_read_object_single_float(reader);
-    case DBOF_TYPE_DOUBLE_FLOAT:
-        return __dbof_1_read_object_double_float(reader);
-    case DBOF_TYPE_CHARACTER:
-        return __dbof_1_read_object_character(reader);
-    case DBOF_TYPE_UTF8_STRING:
-        return __dbof_1_read_object_utf8_string(reader);
-    case DBOF_TYPE_TYPED_ARRAY:
-        return __dbof_1_read_object_typed_array(reader);
-    case DBOF_TYPE_UNTYPED_ARRAY:
-        return __dbof_1_read_object_untyped_array(reader);
-    case DBOF_TYPE_TYPED_MAP:
-        return __dbof_1_read_object_typed_map(reader);
-    case DBOF_TYPE_UNTYPED_MAP:
-        return __dbof_1_read_object_untyped_map(reader);
-    default:
-        // ERROR: Unrecognized object type ID
-        return NULL;
-    }
-}
+int dbof_encoder_write_character(dbof_encoder encoder, dbof_character value)
+{ return __encoder_write_packed_value(encoder, DBOF_TYPE_CHARACTER, &value); }
 
-static int __dbof_1_write_object(dbof_object object, dbof_writer* writer, int write_type)
+int dbof_encoder_write_utf8_string(dbof_encoder encoder, const char* value, dbof_string_size length)
 {
-    // Write object type ID
-    // We rely on an equivalence between enum ordinal and object type ID
-    // This is guaranteed as of right now, but not documented in the header
-    char type_id = dbof_typeof(object);
-    if (writer->write(writer, &type_id, 1) < 1)
+    struct __encoder* enc = (struct __encoder*) encoder;
+
+    if (__encoder_begin_object(enc, DBOF_TYPE_UTF8_STRING))
         return -1;
 
-    // Delegate to appropriate write function
-    switch (type_id)
-    {
-    case DBOF_TYPE_NULL:
-        return __dbof_1_write_object_null(object, writer);
-    case DBOF_TYPE_SIGNED_BYTE:
-        return __dbof_1_write_object_signed_byte(object, writer);
-    case DBOF_TYPE_UNSIGNED_BYTE:
-        return __dbof_1_write_object_unsigned_byte(object, writer);
-    case DBOF_TYPE_SIGNED_INTEGER:
-        return __dbof_1_write_object_signed_integer(object, writer);
-    case DBOF_TYPE_UNSIGNED_INTEGER:
-        return __dbof_1_write_object_unsigned_integer(object, writer);
-    case DBOF_TYPE_SIGNED_LONG_INTEGER:
-        return __dbof_1_write_object_signed_long_integer(object, writer);
-    case DBOF_TYPE_UNSIGNED_LONG_INTEGER:
-        return __dbof_1_write_object_unsigned_long_integer(object, writer);
-    case DBOF_TYPE_BOOLEAN:
-        return __dbof_1_write_object_boolean(object, writer);
-    case DBOF_TYPE_SINGLE_FLOAT:
-        return __dbof_1_write_object_single_float(object, writer);
-    case DBOF_TYPE_DOUBLE_FLOAT:
-        return __dbof_1_write_object_double_float(object, writer);
-    case DBOF_TYPE_CHARACTER:
-        return __dbof_1_write_object_character(object, writer);
-    case DBOF_TYPE_UTF8_STRING:
-        return __dbof_1_write_object_string(object, writer);
-    case DBOF_TYPE_TYPED_ARRAY:
-        return __dbof_1_write_object_typed_array(object, writer);
-    case DBOF_TYPE_UNTYPED_ARRAY:
-        return __dbof_1_write_object_untyped_array(object, writer);
-    case DBOF_TYPE_TYPED_MAP:
-        return __dbof_1_write_object_typed_map(object, writer);
-    case DBOF_TYPE_UNTYPED_MAP:
-        return __dbof_1_write_object_untyped_map(object, writer);
-    default:
-        // ERROR: Unrecognized object type ID
+    if (__encoder_check(enc, __dbof_1_write_flex_length_internal(&enc->writer, length)))
         return -1;
-    }
-}
 
-/* Dispatched DBOF Serialization */
+    if (__buffered_writer_write(&enc->writer, value, length) < length)
+        return __encoder_check(enc, -1);
 
-//
-// Each serialized top-level object has a six-byte header, regardless of the serialization format or version.
-//
-// This header is composed of two fields:
-// 1. A four-byte magic number (the UTF-8 characters 'D', 'B', 'O', and 'F')
-// 2. A two-byte primary version ID (a sixteen-bit little-endian version number)
-//
+    return 0;
+}
 
-dbof_object dbof_read(dbof_reader* reader)
+int dbof_encoder_write_array_data(dbof_encoder encoder, const void* values, dbof_container_size count)
 {
-    unsigned short version;
+    struct __encoder* enc = (struct __encoder*) encoder;
 
-    if (reader->no_header)
-    {
-        if (!reader->use_version)
-        {
-            // ERROR: Header skipped but no version specified
-            return NULL;
-        }
+    if (enc->failed)
+        return -1;
 
-        version = reader->use_version;
-    }
-    else
-    {
-        // Extract the six-byte header
-        char header[6];
-        reader->read(reader, header, sizeof(header));
+    // Only for typed arrays of primitive types with enough room left
+    struct __encoder_container* container = enc->depth == 0 ? NULL : &enc->stack[enc->depth - 1];
+    if (container == NULL || container->type != DBOF_TYPE_TYPED_ARRAY || __packed_size_of(container->key_type) == 0
+            || container->remaining < count)
+        return __encoder_check(enc, -1);
 
-        // Compare the magic number to expected
-        char magic[] = { header[0], header[1], header[2], header[3], '\0' };
-        if (strcmp(magic, "DBOF") != 0)
+    container->remaining -= count;
+
+    size_t packed_size = __packed_size_of(container->key_type);
+
+    // Version 1 has a type ID before each element, so the elements are written one at a time
+    if (enc->writer.version == 1)
+    {
+        for (dbof_container_size i = 0; i < count; ++i)
         {
-            // ERROR: Magic number does not match expected value
-            return NULL;
+            if (__dbof_1_write_child_type_internal(&enc->writer, container->key_type)
+                    || __dbof_1_write_packed_values_internal(&enc->writer, (const char*) values + i * packed_size, 1,
+                    packed_size))
+                return __encoder_check(enc, -1);
         }
 
-        // Get version integer in little-endian manner
-        version = 0;
-        version |= ((uint16_t) header[4]) << 0; // LSB stored first
-        version |= ((uint16_t) header[5]) << 8; // MSB stored second
+        return 0;
     }
 
-    // Read top-level object depending on version
-    switch (version)
-    {
-    case 1:
-        // Read using DBOF-1
-        return __dbof_1_read_object(reader, 1);
-    default:
-        // ERROR: Unsupported serialization format
-        return NULL;
-    }
+    return __encoder_check(enc, __dbof_1_write_packed_values_internal(&enc->writer, values, count, packed_size));
 }
 
-int dbof_write(dbof_object object, dbof_writer* writer)
+int dbof_encoder_write_object(dbof_encoder encoder, dbof_object object)
 {
-    // Get version to write, or default to latest
-    short version = writer->use_version;
-    if (version == 0)
-    {
-        version = DBOF_SER_DEFAULT;
-    }
-
-    if (!writer->no_header)
-    {
-        // Build header with magic number and version
-        char version_lsb = (char) ((version & 0x00ff) >> 0);
-        char version_msb = (char) ((version & 0xff00) >> 8);
-        char header[] = { 'D', 'B', 'O', 'F', version_lsb, version_msb };
+    struct __encoder* enc = (struct __encoder*) encoder;
 
-        // Write header
-        writer->write(writer, header, sizeof(header));
-    }
+    if (__encoder_begin_object(enc, dbof_typeof(object)))
+        return -1;
 
-    // Write top-level object depending on version
-    switch (version)
-    {
-    case 1:
-        // Write using DBOF-1
-        return __dbof_1_write_object(object, writer, 1);
-    default:
-        // ERROR: Unsupported serialization format
-        return 1;
-    }
+    // The type ID, if any, is already taken care of
+    return __encoder_check(enc, __dbof_1_write_object(object, &enc->writer, 0));
 }
@@ -0,0 +1,140 @@
+/*
+ * DBOF
+ * Copyright 2017 glyre
+ */
+
+//
+// NOTICE
+// Counts how often arrays reallocate their storage when a queue-like workload pushes and pops right at a capacity
+// boundary. Every change of capacity is one reallocation. A shrink policy without hysteresis halves the storage on the
+// pop and doubles it again on the next push, so the count grows with the number of cycles; with the default policy it
+// must not grow at all.
+//
+
+#include <time.h>
+#include "test.h"
+
+#define CYCLES 100000
+
+/**
+ * Fill an untyped array to the given size, then push and pop one more child the given number of times. Returns the
+ * number of reallocations during the cycles.
+ */
+static unsigned long count_untyped_reallocations(dbof_container_size size, int cycles)
+{
+    dbof_object array = dbof_new(DBOF_TYPE_UNTYPED_ARRAY);
+    for (dbof_container_size i = 0; i < size; ++i)
+    {
+        dbof_untyped_array_push_back(array, dbof_new(DBOF_TYPE_NULL));
+    }
+
+    unsigned long reallocations = 0;
+    dbof_container_size capacity = dbof_untyped_array_get_capacity(array);
+
+    for (int i = 0; i < cycles; ++i)
+    {
+        dbof_untyped_array_push_back(array, dbof_new(DBOF_TYPE_NULL));
+        reallocations += dbof_untyped_array_get_capacity(array) != capacity;
+        capacity = dbof_untyped_array_get_capacity(array);
+
+        dbof_delete(dbof_untyped_array_pop_back(array));
+        reallocations += dbof_untyped_array_get_capacity(array) != capacity;
+        capacity = dbof_untyped_array_get_capacity(array);
+    }
+
+    dbof_delete(array);
+    return reallocations;
+}
+
+/**
+ * Like count_untyped_reallocations(), for a typed array of packed integers.
+ */
+static unsigned long count_packed_reallocations(dbof_container_size size, int cycles)
+{
+    dbof_object array = dbof_new(DBOF_TYPE_TYPED_ARRAY);
+    dbof_typed_array_set_type(array, DBOF_TYPE_SIGNED_INTEGER);
+    for (dbof_container_size i = 0; i < size; ++i)
+    {
+        dbof_typed_array_push_back_signed_integer(array, (dbof_signed_integer) i);
+    }
+
+    unsigned long reallocations = 0;
+    dbof_container_size capacity = dbof_typed_array_get_capacity(array);
+
+    for (int i = 0; i < cycles; ++i)
+    {
+        dbof_typed_array_push_back_signed_integer(array, i);
+        reallocations += dbof_typed_array_get_capacity(array) != capacity;
+        capacity = dbof_typed_array_get_capacity(array);
+
+        dbof_delete(dbof_typed_array_remove(array, dbof_typed_array_get_size(array) - 1));
+        reallocations += dbof_typed_array_get_capacity(array) != capacity;
+        capacity = dbof_typed_array_get_capacity(array);
+    }
+
+    dbof_delete(array);
+    return reallocations;
+}
+
+/**
+ * Drain a full array and fill it again the given number of times. Returns the number of reallocations.
+ */
+static unsigned long count_refill_reallocations(dbof_container_size size, int rounds)
+{
+    dbof_object array = dbof_new(DBOF_TYPE_UNTYPED_ARRAY);
+    unsigned long reallocations = 0;
+    dbof_container_size capacity = 0;
+
+    for (int round = 0; round < rounds; ++round)
+    {
+        for (dbof_container_size i = 0; i < size; ++i)
+        {
+            dbof_untyped_array_push_back(array, dbof_new(DBOF_TYPE_NULL));
+            reallocations += dbof_untyped_array_get_capacity(array) != capacity;
+            capacity = dbof_untyped_array_get_capacity(array);
+        }
+
+        for (dbof_container_size i = 0; i < size; ++i)
+        {
+            dbof_delete(dbof_untyped_array_pop_back(array));
+            reallocations += dbof_untyped_array_get_capacity(array) != capacity;
+            capacity = dbof_untyped_array_get_capacity(array);
+        }
+    }
+
+    dbof_delete(array);
+    return reallocations;
+}
+
+int main(void)
+{
+    clock_t start = clock();
+
+    // Right at a power of two, the first push grows the storage and nothing after it should reallocate
+    unsigned long untyped = count_untyped_reallocations(1024, CYCLES);
+    unsigned long packed = count_packed_reallocations(1024, CYCLES);
+    printf("push/pop at capacity 1024, %d cycles: %lu (untyped), %lu (packed) reallocations\n", CYCLES, untyped,
+            packed);
+    CHECK(untyped <= 1);
+    CHECK(packed <= 1);
+
+    // Just above half of the capacity is where halving without hysteresis thrashes
+    untyped = count_untyped_reallocations(513, CYCLES);
+    printf("push/pop at 513 of 1024, %d cycles: %lu reallocations\n", CYCLES, untyped);
+    CHECK(untyped == 0);
+
+    unsigned long refill = count_refill_reallocations(1000, 100);
+    printf("drain and refill 1000 children, 100 rounds: %lu reallocations (default policy)\n", refill);
+
+    // Never shrinking leaves the storage alone after the first round
+    dbof_capacity_policy policy = { NULL, dbof_capacity_never_shrink };
+    dbof_set_capacity_policy(&policy);
+    unsigned long kept = count_refill_reallocations(1000, 100);
+    dbof_set_capacity_policy(NULL);
+    printf("drain and refill 1000 children, 100 rounds: %lu reallocations (never shrink)\n", kept);
+    CHECK(kept <= refill);
+    CHECK(kept <= 16);
+
+    printf("%.3f s\n", (double) (clock() - start) / CLOCKS_PER_SEC);
+    return 0;
+}
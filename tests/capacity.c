@@ -0,0 +1,163 @@
+/*
+ * DBOF
+ * Copyright 2017 glyre
+ */
+
+#include "test.h"
+
+static dbof_object new_with_capacity(dbof_type type, dbof_container_size capacity)
+{
+    dbof_new_ex_params params;
+    memset(&params, 0, sizeof(params));
+    params.initial_capacity = capacity;
+    return dbof_new_ex(type, &params);
+}
+
+static void test_untyped_array(void)
+{
+    // Made with room up front, an array fills up to it in place
+    dbof_object array = new_with_capacity(DBOF_TYPE_UNTYPED_ARRAY, 100);
+    dbof_container_size capacity = dbof_untyped_array_get_capacity(array);
+    CHECK(capacity >= 100);
+    CHECK(dbof_untyped_array_is_empty(array));
+
+    for (int i = 0; i < 100; ++i)
+    {
+        dbof_untyped_array_push_back(array, test_new_int(i));
+    }
+    CHECK(dbof_untyped_array_get_capacity(array) == capacity);
+
+    // Reserving more keeps the children, and then the array fills up to it in place again
+    CHECK(dbof_untyped_array_reserve(array, 1000) == 0);
+    capacity = dbof_untyped_array_get_capacity(array);
+    CHECK(capacity >= 1000);
+
+    for (int i = 0; i < 100; ++i)
+    {
+        CHECK(dbof_get_value_signed_integer(dbof_untyped_array_get(array, (dbof_container_size) i)) == i);
+    }
+
+    for (int i = 100; i < 1000; ++i)
+    {
+        dbof_untyped_array_push_back(array, test_new_int(i));
+    }
+    CHECK(dbof_untyped_array_get_capacity(array) == capacity);
+
+    // Reserving less than there is changes nothing
+    CHECK(dbof_untyped_array_reserve(array, 10) == 0);
+    CHECK(dbof_untyped_array_get_capacity(array) == capacity);
+    CHECK(dbof_untyped_array_get_size(array) == 1000);
+    CHECK(dbof_get_value_signed_integer(dbof_untyped_array_get(array, 999)) == 999);
+
+    dbof_delete(array);
+}
+
+static void test_typed_array(void)
+{
+    dbof_object array = dbof_new(DBOF_TYPE_TYPED_ARRAY);
+    dbof_typed_array_set_type(array, DBOF_TYPE_SIGNED_INTEGER);
+    for (int i = 0; i < 3; ++i)
+    {
+        dbof_typed_array_push_back_signed_integer(array, i);
+    }
+
+    // The values stay where they are while the array fills up to what was reserved
+    CHECK(dbof_typed_array_reserve(array, 1000) == 0);
+    CHECK(dbof_typed_array_get_capacity(array) >= 1000);
+    void* data = dbof_typed_array_data(array);
+    CHECK(data != NULL);
+
+    for (int i = 3; i < 1000; ++i)
+    {
+        dbof_typed_array_push_back_signed_integer(array, i);
+    }
+    CHECK(dbof_typed_array_data(array) == data);
+
+    for (int i = 0; i < 1000; ++i)
+    {
+        CHECK(dbof_typed_array_get_signed_integer_at(array, (dbof_container_size) i) == i);
+    }
+
+    dbof_delete(array);
+
+    // Room made before the type is set carries over
+    array = new_with_capacity(DBOF_TYPE_TYPED_ARRAY, 64);
+    dbof_typed_array_set_type(array, DBOF_TYPE_SIGNED_INTEGER);
+    CHECK(dbof_typed_array_get_capacity(array) >= 64);
+
+    dbof_typed_array_push_back_signed_integer(array, 0);
+    data = dbof_typed_array_data(array);
+    for (int i = 1; i < 64; ++i)
+    {
+        dbof_typed_array_push_back_signed_integer(array, i);
+    }
+    CHECK(dbof_typed_array_data(array) == data);
+    CHECK(dbof_typed_array_get_signed_integer_at(array, 63) == 63);
+
+    dbof_delete(array);
+}
+
+static void test_untyped_map(void)
+{
+    dbof_object map = new_with_capacity(DBOF_TYPE_UNTYPED_MAP, 100);
+    dbof_container_size capacity = dbof_untyped_map_get_capacity(map);
+    CHECK(capacity >= 100);
+
+    for (int i = 0; i < 100; ++i)
+    {
+        dbof_untyped_map_put(map, test_new_int(i), test_new_int(-i));
+    }
+    CHECK(dbof_untyped_map_get_capacity(map) == capacity);
+
+    // Reserving more keeps the entries, and then the map fills up to it without rehashing
+    CHECK(dbof_untyped_map_reserve(map, 1000) == 0);
+    capacity = dbof_untyped_map_get_capacity(map);
+
+    for (int i = 100; i < 1000; ++i)
+    {
+        dbof_untyped_map_put(map, test_new_int(i), test_new_int(-i));
+    }
+    CHECK(dbof_untyped_map_get_capacity(map) == capacity);
+    CHECK(dbof_untyped_map_get_size(map) == 1000);
+
+    for (int i = 0; i < 1000; i += 37)
+    {
+        dbof_object key = test_new_int(i);
+        CHECK(dbof_get_value_signed_integer(dbof_untyped_map_get(map, key)) == -i);
+        dbof_delete(key);
+    }
+
+    dbof_delete(map);
+}
+
+static void test_typed_map(void)
+{
+    dbof_object map = dbof_new(DBOF_TYPE_TYPED_MAP);
+    dbof_typed_map_put_signed_integer_signed_integer(map, -1, 1);
+
+    CHECK(dbof_typed_map_reserve(map, 500) == 0);
+    dbof_container_size capacity = dbof_typed_map_get_capacity(map);
+    CHECK(capacity >= 500);
+
+    for (int i = 0; i < 499; ++i)
+    {
+        dbof_typed_map_put_signed_integer_signed_integer(map, i, i * 3);
+    }
+    CHECK(dbof_typed_map_get_capacity(map) == capacity);
+    CHECK(dbof_typed_map_get_size(map) == 500);
+
+    dbof_signed_integer value = 0;
+    CHECK(dbof_typed_map_get_signed_integer_signed_integer(map, -1, &value) && value == 1);
+    CHECK(dbof_typed_map_get_signed_integer_signed_integer(map, 498, &value) && value == 498 * 3);
+
+    dbof_delete(map);
+}
+
+int main(void)
+{
+    test_untyped_array();
+    test_typed_array();
+    test_untyped_map();
+    test_typed_map();
+    return 0;
+}
@@ -0,0 +1,148 @@
+/*
+ * DBOF
+ * Copyright 2017 glyre
+ */
+
+#include "test.h"
+
+/**
+ * Build a document with every kind of container, packed and not.
+ */
+static dbof_object new_document(void)
+{
+    dbof_object document = dbof_new(DBOF_TYPE_UNTYPED_MAP);
+    dbof_untyped_map_put(document, test_new_string("name"),
+            test_new_string("a string too long to be kept inside the object itself"));
+
+    dbof_object samples = dbof_new(DBOF_TYPE_TYPED_ARRAY);
+    dbof_typed_array_set_type(samples, DBOF_TYPE_SIGNED_INTEGER);
+    for (int i = 0; i < 100; ++i)
+    {
+        dbof_typed_array_push_back_signed_integer(samples, i);
+    }
+    dbof_untyped_map_put(document, test_new_string("samples"), samples);
+
+    dbof_object index = dbof_new(DBOF_TYPE_TYPED_MAP);
+    for (int i = 0; i < 20; ++i)
+    {
+        dbof_typed_map_put_unsigned_long_integer_double_float(index, i, i * 0.5);
+    }
+    dbof_untyped_map_put(document, test_new_string("index"), index);
+
+    dbof_object names = dbof_new(DBOF_TYPE_TYPED_MAP);
+    CHECK(dbof_typed_map_put(names, test_new_string("a"), test_new_string("b")) == 0);
+    dbof_untyped_map_put(document, test_new_string("names"), names);
+
+    dbof_object nested = dbof_new(DBOF_TYPE_UNTYPED_ARRAY);
+    dbof_object inner = dbof_new(DBOF_TYPE_UNTYPED_ARRAY);
+    dbof_untyped_array_push_back(inner, test_new_int(1));
+    dbof_untyped_array_push_back(inner, dbof_new(DBOF_TYPE_NULL));
+    dbof_untyped_array_push_back(nested, inner);
+    dbof_untyped_map_put(document, test_new_string("nested"), nested);
+
+    return document;
+}
+
+static dbof_object get(dbof_object map, const char* name)
+{
+    dbof_object key = test_new_string(name);
+    dbof_object value = dbof_untyped_map_get(map, key);
+    dbof_delete(key);
+    return value;
+}
+
+static void test_deep_copy(void)
+{
+    dbof_object document = new_document();
+    dbof_object copy = dbof_clone(document);
+
+    CHECK(copy != NULL && copy != document);
+    CHECK(dbof_equals(copy, document));
+    CHECK(dbof_hash(copy) == dbof_hash(document));
+    CHECK(get(copy, "nested") != get(document, "nested"));
+
+    // Changing the copy leaves the original alone, at any depth
+    dbof_untyped_array_push_back(dbof_untyped_array_get(get(copy, "nested"), 0), test_new_int(2));
+    dbof_typed_array_set_signed_integer_at(get(copy, "samples"), 0, -1);
+    dbof_typed_map_put_unsigned_long_integer_double_float(get(copy, "index"), 0, -1.0);
+    dbof_set_value_utf8_string(get(copy, "name"), "changed");
+
+    CHECK(dbof_untyped_array_get_size(dbof_untyped_array_get(get(document, "nested"), 0)) == 2);
+    CHECK(dbof_typed_array_get_signed_integer_at(get(document, "samples"), 0) == 0);
+    dbof_double_float value = 0.0;
+    CHECK(dbof_typed_map_get_unsigned_long_integer_double_float(get(document, "index"), 0, &value) && value == 0.0);
+    CHECK(!dbof_equals(copy, document));
+
+    dbof_delete(copy);
+    dbof_delete(document);
+
+    CHECK(dbof_clone(NULL) == NULL);
+}
+
+static void test_frozen_and_shared(void)
+{
+    dbof_object document = new_document();
+    CHECK(dbof_freeze(document) == 0);
+
+    // Copies of frozen objects are mutable
+    dbof_object copy = dbof_clone(document);
+    CHECK(!dbof_is_frozen(copy));
+    CHECK(!dbof_is_frozen(get(copy, "samples")));
+    CHECK(dbof_equals(copy, document));
+    dbof_delete(copy);
+
+    // Objects reached twice are copied twice
+    dbof_object pair = dbof_new(DBOF_TYPE_UNTYPED_ARRAY);
+    dbof_untyped_array_push_back(pair, dbof_retain(document));
+    dbof_untyped_array_push_back(pair, dbof_retain(document));
+    dbof_delete(document);
+
+    copy = dbof_clone(pair);
+    CHECK(dbof_equals(copy, pair));
+    CHECK(dbof_untyped_array_get(copy, 0) != dbof_untyped_array_get(copy, 1));
+    dbof_delete(copy);
+
+    // Snapshots are copied like any other array
+    dbof_object snapshot = dbof_untyped_array_snapshot(pair);
+    copy = dbof_clone(snapshot);
+    CHECK(dbof_equals(copy, pair));
+    dbof_delete(copy);
+
+    dbof_delete(snapshot);
+    dbof_delete(pair);
+}
+
+static void test_arena(void)
+{
+    dbof_object document = new_document();
+
+    dbof_arena arena = dbof_arena_new(0);
+    dbof_new_ex_params params;
+    memset(&params, 0, sizeof(params));
+    params.arena = arena;
+
+    dbof_object copy = dbof_clone_ex(document, &params);
+    CHECK(copy != NULL);
+    CHECK(dbof_equals(copy, document));
+
+    // Arena copies can still grow, though what they take in from the heap is only freed by deleting them
+    dbof_untyped_map_put(copy, test_new_string("more"), test_new_int(1));
+    CHECK(dbof_untyped_map_get_size(copy) == dbof_untyped_map_get_size(document) + 1);
+    dbof_delete(copy);
+
+    // Hooks are refused, by copies as by new objects
+    params.hooks = &params;
+    CHECK(dbof_clone_ex(document, &params) == NULL);
+    CHECK(dbof_new_ex(DBOF_TYPE_UNTYPED_MAP, &params) == NULL);
+
+    dbof_arena_delete(arena);
+    dbof_delete(document);
+}
+
+int main(void)
+{
+    test_deep_copy();
+    test_frozen_and_shared();
+    test_arena();
+    return 0;
+}
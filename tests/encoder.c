@@ -0,0 +1,139 @@
+/*
+ * DBOF
+ * Copyright 2017 glyre
+ */
+
+#include "test.h"
+
+static dbof_writer new_writer(struct test_buffer* buffer)
+{
+    memset(buffer, 0, sizeof(*buffer));
+
+    dbof_writer writer;
+    memset(&writer, 0, sizeof(writer));
+    writer.write = test_buffer_write;
+    writer.data = buffer;
+    return writer;
+}
+
+/**
+ * Build {"name": "encoded", "values": typed array of 0..9, "mixed": [null, 1, 2.5, {"x": true}]} as objects.
+ */
+static dbof_object new_document(void)
+{
+    dbof_object document = dbof_new(DBOF_TYPE_UNTYPED_MAP);
+    dbof_untyped_map_put(document, test_new_string("name"), test_new_string("encoded"));
+
+    dbof_object values = dbof_new(DBOF_TYPE_TYPED_ARRAY);
+    dbof_typed_array_set_type(values, DBOF_TYPE_SIGNED_INTEGER);
+    for (int i = 0; i < 10; ++i)
+    {
+        dbof_typed_array_push_back_signed_integer(values, i);
+    }
+    dbof_untyped_map_put(document, test_new_string("values"), values);
+
+    dbof_object mixed = dbof_new(DBOF_TYPE_UNTYPED_ARRAY);
+    dbof_untyped_array_push_back(mixed, dbof_new(DBOF_TYPE_NULL));
+    dbof_untyped_array_push_back(mixed, test_new_int(1));
+
+    dbof_object ratio = dbof_new(DBOF_TYPE_DOUBLE_FLOAT);
+    dbof_set_value_double_float(ratio, 2.5);
+    dbof_untyped_array_push_back(mixed, ratio);
+
+    dbof_object flags = dbof_new(DBOF_TYPE_UNTYPED_MAP);
+    dbof_untyped_map_put(flags, test_new_string("x"), dbof_new_boolean(1));
+    dbof_untyped_array_push_back(mixed, flags);
+
+    dbof_untyped_map_put(document, test_new_string("mixed"), mixed);
+    return document;
+}
+
+static void test_matches_objects(void)
+{
+    struct test_buffer buffer;
+    dbof_writer writer = new_writer(&buffer);
+
+    dbof_encoder encoder = dbof_encoder_new(&writer);
+    CHECK(encoder != NULL);
+
+    CHECK(dbof_encoder_begin_untyped_map(encoder, 3) == 0);
+    CHECK(dbof_encoder_write_utf8_string(encoder, "name", 4) == 0);
+    CHECK(dbof_encoder_write_utf8_string(encoder, "encoded", 7) == 0);
+
+    // Packed values go in chunks, which need not line up with anything
+    dbof_signed_integer values[10] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9 };
+    CHECK(dbof_encoder_write_utf8_string(encoder, "values", 6) == 0);
+    CHECK(dbof_encoder_begin_typed_array(encoder, 10, DBOF_TYPE_SIGNED_INTEGER) == 0);
+    CHECK(dbof_encoder_write_array_data(encoder, values, 3) == 0);
+    CHECK(dbof_encoder_write_signed_integer(encoder, 3) == 0);
+    CHECK(dbof_encoder_write_array_data(encoder, values + 4, 6) == 0);
+    CHECK(dbof_encoder_end(encoder) == 0);
+
+    // Existing objects can be mixed in
+    CHECK(dbof_encoder_write_utf8_string(encoder, "mixed", 5) == 0);
+    CHECK(dbof_encoder_begin_untyped_array(encoder, 4) == 0);
+    CHECK(dbof_encoder_write_null(encoder) == 0);
+    CHECK(dbof_encoder_write_signed_integer(encoder, 1) == 0);
+    CHECK(dbof_encoder_write_double_float(encoder, 2.5) == 0);
+
+    dbof_object flags = dbof_new(DBOF_TYPE_UNTYPED_MAP);
+    dbof_untyped_map_put(flags, test_new_string("x"), dbof_new_boolean(1));
+    CHECK(dbof_encoder_write_object(encoder, flags) == 0);
+    dbof_delete(flags);
+
+    CHECK(dbof_encoder_end(encoder) == 0);
+    CHECK(dbof_encoder_end(encoder) == 0);
+    CHECK(dbof_encoder_finish(encoder) == 0);
+
+    dbof_object document = new_document();
+    dbof_object decoded = test_read(&buffer);
+    CHECK(decoded != NULL);
+    CHECK(dbof_equals(decoded, document));
+
+    dbof_delete(decoded);
+    dbof_delete(document);
+    free(buffer.data);
+}
+
+static void test_misuse_fails(void)
+{
+    struct test_buffer buffer;
+    dbof_writer writer = new_writer(&buffer);
+
+    // Too many children
+    dbof_encoder encoder = dbof_encoder_new(&writer);
+    CHECK(dbof_encoder_begin_untyped_array(encoder, 1) == 0);
+    CHECK(dbof_encoder_write_null(encoder) == 0);
+    CHECK(dbof_encoder_write_null(encoder) != 0);
+
+    // A failed encoder stays failed
+    CHECK(dbof_encoder_end(encoder) != 0);
+    CHECK(dbof_encoder_finish(encoder) != 0);
+
+    // Too few children
+    encoder = dbof_encoder_new(&writer);
+    CHECK(dbof_encoder_begin_untyped_array(encoder, 2) == 0);
+    CHECK(dbof_encoder_write_null(encoder) == 0);
+    CHECK(dbof_encoder_end(encoder) != 0);
+    CHECK(dbof_encoder_finish(encoder) != 0);
+
+    // Children of the wrong type
+    encoder = dbof_encoder_new(&writer);
+    CHECK(dbof_encoder_begin_typed_array(encoder, 1, DBOF_TYPE_SIGNED_INTEGER) == 0);
+    CHECK(dbof_encoder_write_double_float(encoder, 1.0) != 0);
+    CHECK(dbof_encoder_finish(encoder) != 0);
+
+    // Containers left open
+    encoder = dbof_encoder_new(&writer);
+    CHECK(dbof_encoder_begin_untyped_map(encoder, 0) == 0);
+    CHECK(dbof_encoder_finish(encoder) != 0);
+
+    free(buffer.data);
+}
+
+int main(void)
+{
+    test_matches_objects();
+    test_misuse_fails();
+    return 0;
+}
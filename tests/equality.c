@@ -0,0 +1,78 @@
+/*
+ * DBOF
+ * Copyright 2017 glyre
+ */
+
+#include "test.h"
+
+static dbof_single_float float_nan(uint32_t payload)
+{
+    uint32_t bits = 0x7f800000u | payload;
+    dbof_single_float value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+static dbof_object new_float(dbof_single_float value)
+{
+    dbof_object object = dbof_new(DBOF_TYPE_SINGLE_FLOAT);
+    dbof_set_value_single_float(object, value);
+    return object;
+}
+
+/**
+ * Make an array of floats ending in a NaN with the given payload, packed or not.
+ */
+static dbof_object new_float_array(int packed, int size, uint32_t payload)
+{
+    dbof_object array = dbof_new(packed ? DBOF_TYPE_TYPED_ARRAY : DBOF_TYPE_UNTYPED_ARRAY);
+    for (int i = 0; i < size; ++i)
+    {
+        dbof_single_float value = i + 1 < size ? (dbof_single_float) i : float_nan(payload);
+        if (packed)
+        {
+            dbof_typed_array_push_back(array, new_float(value));
+        }
+        else
+        {
+            dbof_untyped_array_push_back(array, new_float(value));
+        }
+    }
+
+    return array;
+}
+
+static void test_float_nans(int packed)
+{
+    // Long enough to take more than one chunk when hashed
+    dbof_object a = new_float_array(packed, 2000, 1);
+    dbof_object b = new_float_array(packed, 2000, 2);
+
+    CHECK(dbof_equals(a, b));
+    CHECK(dbof_hash(a) == dbof_hash(b));
+
+    dbof_delete(a);
+    dbof_delete(b);
+}
+
+static void test_float_map_values(void)
+{
+    dbof_object a = dbof_new(DBOF_TYPE_TYPED_MAP);
+    dbof_object b = dbof_new(DBOF_TYPE_TYPED_MAP);
+    CHECK(dbof_typed_map_put(a, test_new_int(1), new_float(float_nan(1))) == 0);
+    CHECK(dbof_typed_map_put(b, test_new_int(1), new_float(float_nan(2))) == 0);
+
+    CHECK(dbof_equals(a, b));
+    CHECK(dbof_hash(a) == dbof_hash(b));
+
+    dbof_delete(a);
+    dbof_delete(b);
+}
+
+int main(void)
+{
+    test_float_nans(0);
+    test_float_nans(1);
+    test_float_map_values();
+    return 0;
+}
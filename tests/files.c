@@ -0,0 +1,149 @@
+/*
+ * DBOF
+ * Copyright 2017 glyre
+ */
+
+#include <unistd.h>
+#include <dbof/file.h>
+#include "test.h"
+
+#define DOCUMENTS 3
+
+/**
+ * Make a document that takes far less than the read buffer, so reading it reads ahead into whatever follows.
+ */
+static dbof_object new_document(int value)
+{
+    dbof_object array = dbof_new(DBOF_TYPE_UNTYPED_ARRAY);
+    dbof_untyped_array_push_back(array, test_new_int(value));
+    dbof_untyped_array_push_back(array, test_new_string("hello"));
+    return array;
+}
+
+static void write_documents(FILE* file)
+{
+    for (int i = 0; i < DOCUMENTS; ++i)
+    {
+        dbof_object document = new_document(i);
+        CHECK(dbof_file_write(document, file) == 0);
+        dbof_delete(document);
+    }
+
+    CHECK(fputs("trailer", file) >= 0);
+}
+
+/**
+ * Read the documents back one after another. Each read must leave the file right after its document.
+ */
+static void read_documents(FILE* file)
+{
+    for (int i = 0; i < DOCUMENTS; ++i)
+    {
+        dbof_object object = dbof_file_read(file);
+        CHECK(object != NULL);
+
+        dbof_object document = new_document(i);
+        CHECK(dbof_equals(object, document));
+        dbof_delete(document);
+        dbof_delete(object);
+    }
+
+    char trailer[8] = { 0 };
+    CHECK(fread(trailer, 1, sizeof(trailer), file) == 7);
+    CHECK(strcmp(trailer, "trailer") == 0);
+}
+
+static void test_seekable_file(void)
+{
+    FILE* file = tmpfile();
+    CHECK(file != NULL);
+
+    write_documents(file);
+    rewind(file);
+    read_documents(file);
+
+    fclose(file);
+}
+
+static void test_pipe(void)
+{
+    int fds[2];
+    CHECK(pipe(fds) == 0);
+
+    FILE* in = fdopen(fds[0], "rb");
+    FILE* out = fdopen(fds[1], "wb");
+    CHECK(in != NULL && out != NULL);
+
+    // A pipe cannot seek, so nothing may be read ahead (the documents fit the pipe buffer)
+    write_documents(out);
+    fclose(out);
+    read_documents(in);
+
+    fclose(in);
+}
+
+static void test_mapped_file(void)
+{
+    char path[] = "/tmp/dbof_files_XXXXXX";
+    int fd = mkstemp(path);
+    CHECK(fd >= 0);
+
+    FILE* file = fdopen(fd, "wb");
+    CHECK(file != NULL);
+
+    // Packed values and long strings are what borrowing reads point into the mapping
+    dbof_object document = new_document(7);
+    dbof_object samples = dbof_new(DBOF_TYPE_TYPED_ARRAY);
+    dbof_typed_array_set_type(samples, DBOF_TYPE_DOUBLE_FLOAT);
+    for (int i = 0; i < 1000; ++i)
+    {
+        dbof_typed_array_push_back_double_float(samples, i * 0.5);
+    }
+    dbof_untyped_array_push_back(document, samples);
+    dbof_untyped_array_push_back(document, test_new_string("a string too long to be kept inside the object itself"));
+
+    CHECK(dbof_file_write(document, file) == 0);
+    fclose(file);
+
+    dbof_file_map map;
+    CHECK(dbof_file_map_open(&map, path) == 0);
+
+    dbof_object copied = dbof_mmap_read(&map, 0);
+    dbof_object borrowed = dbof_mmap_read(&map, DBOF_READ_BORROW);
+    CHECK(dbof_equals(copied, document));
+    CHECK(dbof_equals(borrowed, document));
+
+    // Changing a borrowed object copies it out of the read-only mapping first
+    dbof_typed_array_set_double_float_at(dbof_untyped_array_get(borrowed, 2), 0, -1.0);
+    dbof_set_value_utf8_string(dbof_untyped_array_get(borrowed, 3), "changed");
+    CHECK(!dbof_equals(borrowed, document));
+
+    dbof_object again = dbof_mmap_read(&map, DBOF_READ_BORROW);
+    CHECK(dbof_equals(again, document));
+
+    dbof_delete(again);
+    dbof_delete(borrowed);
+    dbof_file_map_close(&map);
+
+    // Copied objects outlive the mapping
+    CHECK(dbof_equals(copied, document));
+    dbof_delete(copied);
+    dbof_delete(document);
+
+    // Empty files have nothing to map
+    file = fopen(path, "wb");
+    CHECK(file != NULL);
+    fclose(file);
+    CHECK(dbof_file_map_open(&map, path) != 0);
+    CHECK(map.data == NULL);
+
+    remove(path);
+}
+
+int main(void)
+{
+    test_seekable_file();
+    test_pipe();
+    test_mapped_file();
+    return 0;
+}
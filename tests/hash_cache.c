@@ -0,0 +1,108 @@
+/*
+ * DBOF
+ * Copyright 2017 glyre
+ */
+
+#include "test.h"
+
+/**
+ * Make an array holding a string and a map that holds an integer.
+ */
+static dbof_object new_document(dbof_object* string, dbof_object* integer)
+{
+    *string = test_new_string("hello");
+    *integer = test_new_int(1);
+
+    dbof_object map = dbof_new(DBOF_TYPE_UNTYPED_MAP);
+    dbof_untyped_map_put(map, test_new_string("key"), *integer);
+
+    dbof_object array = dbof_new(DBOF_TYPE_UNTYPED_ARRAY);
+    dbof_untyped_array_push_back(array, *string);
+    dbof_untyped_array_push_back(array, map);
+    return array;
+}
+
+static void test_value_changes(void)
+{
+    dbof_object string_a;
+    dbof_object integer_a;
+    dbof_object a = new_document(&string_a, &integer_a);
+
+    dbof_object string_b;
+    dbof_object integer_b;
+    dbof_object b = new_document(&string_b, &integer_b);
+
+    CHECK(dbof_hash(a) == dbof_hash(b));
+
+    // A child value changed in place clears the cached hash codes above it
+    int hash = dbof_hash(a);
+    dbof_set_value_utf8_string(string_a, "world");
+    CHECK(dbof_hash(a) != hash);
+    CHECK(!dbof_equals(a, b));
+
+    dbof_set_value_utf8_string(string_b, "world");
+    CHECK(dbof_equals(a, b));
+    CHECK(dbof_hash(a) == dbof_hash(b));
+
+    // So does one two containers down
+    hash = dbof_hash(a);
+    dbof_set_value_signed_integer(integer_a, 2);
+    CHECK(dbof_hash(a) != hash);
+
+    dbof_set_value_signed_integer(integer_b, 2);
+    CHECK(dbof_equals(a, b));
+    CHECK(dbof_hash(a) == dbof_hash(b));
+
+    dbof_delete(a);
+    dbof_delete(b);
+}
+
+static void test_removed_value(void)
+{
+    dbof_object array = dbof_new(DBOF_TYPE_UNTYPED_ARRAY);
+    dbof_untyped_array_push_back(array, test_new_int(1));
+    dbof_untyped_array_push_back(array, test_new_int(2));
+
+    // A removed child no longer reaches the array, which may even be gone
+    dbof_object removed = dbof_untyped_array_pop_back(array);
+    int hash = dbof_hash(array);
+    dbof_set_value_signed_integer(removed, 3);
+    CHECK(dbof_hash(array) == hash);
+
+    dbof_delete(array);
+    dbof_set_value_signed_integer(removed, 4);
+    dbof_delete(removed);
+}
+
+static void test_read_values(void)
+{
+    dbof_object string;
+    dbof_object integer;
+    dbof_object original = new_document(&string, &integer);
+
+    struct test_buffer buffer = test_write(original);
+    dbof_object copy = test_read(&buffer);
+    free(buffer.data);
+    CHECK(copy != NULL);
+
+    // Children made by the reader know their containers too
+    int hash = dbof_hash(copy);
+    dbof_object child = dbof_untyped_array_get(copy, 0);
+    dbof_set_value_utf8_string(child, "world");
+    CHECK(dbof_hash(copy) != hash);
+
+    dbof_set_value_utf8_string(string, "world");
+    CHECK(dbof_equals(original, copy));
+    CHECK(dbof_hash(original) == dbof_hash(copy));
+
+    dbof_delete(original);
+    dbof_delete(copy);
+}
+
+int main(void)
+{
+    test_value_changes();
+    test_removed_value();
+    test_read_values();
+    return 0;
+}
@@ -0,0 +1,174 @@
+/*
+ * DBOF
+ * Copyright 2017 glyre
+ */
+
+#include "test.h"
+
+static void test_shared_values(void)
+{
+    dbof_intern_pool pool = dbof_intern_pool_new();
+    CHECK(pool != NULL);
+
+    dbof_object a = dbof_new_interned_utf8_string(pool, "shared", 6);
+    dbof_object b = dbof_new_interned_utf8_string(pool, "shared", 6);
+    dbof_object c = dbof_new_interned_utf8_string(pool, "other", 5);
+    CHECK(dbof_intern_pool_get_size(pool) == 2);
+
+    // Equal values are one copy
+    CHECK(dbof_get_value_utf8_string(a) == dbof_get_value_utf8_string(b));
+    CHECK(strcmp(dbof_get_value_utf8_string(a), "shared") == 0);
+    CHECK(dbof_equals(a, b));
+    CHECK(!dbof_equals(a, c));
+    CHECK(dbof_hash(a) == dbof_hash(b));
+
+    // They are ordinary strings otherwise
+    dbof_object plain = test_new_string("shared");
+    CHECK(dbof_equals(a, plain));
+    CHECK(dbof_hash(a) == dbof_hash(plain));
+    dbof_delete(plain);
+
+    // Setting a value gives the string a copy of its own
+    dbof_set_value_utf8_string(b, "changed");
+    CHECK(strcmp(dbof_get_value_utf8_string(a), "shared") == 0);
+    CHECK(strcmp(dbof_get_value_utf8_string(b), "changed") == 0);
+
+    dbof_delete(a);
+    dbof_delete(b);
+    dbof_delete(c);
+    dbof_intern_pool_delete(pool);
+    dbof_intern_pool_delete(NULL);
+}
+
+static void test_reading_through_pool(void)
+{
+    dbof_object document = dbof_new(DBOF_TYPE_UNTYPED_ARRAY);
+    for (int i = 0; i < 100; ++i)
+    {
+        dbof_object entry = dbof_new(DBOF_TYPE_UNTYPED_MAP);
+        dbof_untyped_map_put(entry, test_new_string("status"), test_new_string(i % 2 ? "odd" : "even"));
+        dbof_untyped_array_push_back(document, entry);
+    }
+
+    struct test_buffer buffer = test_write(document);
+
+    dbof_intern_pool pool = dbof_intern_pool_new();
+    dbof_reader reader;
+    memset(&reader, 0, sizeof(reader));
+    reader.read = test_buffer_read;
+    reader.data = &buffer;
+    reader.intern_pool = pool;
+
+    dbof_object copy = dbof_read(&reader);
+    CHECK(copy != NULL);
+    CHECK(dbof_equals(copy, document));
+
+    // Keys and values repeated throughout the document are stored once
+    CHECK(dbof_intern_pool_get_size(pool) == 3);
+
+    dbof_object key = test_new_string("status");
+    CHECK(dbof_get_value_utf8_string(dbof_untyped_map_get(dbof_untyped_array_get(copy, 1), key))
+            == dbof_get_value_utf8_string(dbof_untyped_map_get(dbof_untyped_array_get(copy, 3), key)));
+    dbof_delete(key);
+
+    dbof_delete(copy);
+    dbof_intern_pool_delete(pool);
+
+    free(buffer.data);
+    dbof_delete(document);
+}
+
+static void test_long_values_are_not_interned(void)
+{
+    char value[300];
+    memset(value, 'x', sizeof(value) - 1);
+    value[sizeof(value) - 1] = '\0';
+
+    dbof_object document = dbof_new(DBOF_TYPE_UNTYPED_ARRAY);
+    dbof_untyped_array_push_back(document, test_new_string(value));
+    dbof_untyped_array_push_back(document, test_new_string(value));
+    dbof_untyped_array_push_back(document, test_new_string("short"));
+
+    struct test_buffer buffer = test_write(document);
+
+    dbof_intern_pool pool = dbof_intern_pool_new();
+    dbof_reader reader;
+    memset(&reader, 0, sizeof(reader));
+    reader.read = test_buffer_read;
+    reader.data = &buffer;
+    reader.intern_pool = pool;
+
+    // Readers only intern values short enough to be likely repeats
+    dbof_object copy = dbof_read(&reader);
+    CHECK(dbof_equals(copy, document));
+    CHECK(dbof_intern_pool_get_size(pool) == 1);
+    CHECK(dbof_get_value_utf8_string(dbof_untyped_array_get(copy, 0))
+            != dbof_get_value_utf8_string(dbof_untyped_array_get(copy, 1)));
+
+    dbof_delete(copy);
+    dbof_intern_pool_delete(pool);
+
+    free(buffer.data);
+    dbof_delete(document);
+}
+
+static dbof_object read_limited(struct test_buffer* buffer, dbof_intern_pool pool, size_t max_allocation)
+{
+    dbof_reader reader;
+    memset(&reader, 0, sizeof(reader));
+    reader.read = test_buffer_read;
+    reader.data = buffer;
+    reader.intern_pool = pool;
+    reader.max_allocation = max_allocation;
+
+    buffer->position = 0;
+    return dbof_read(&reader);
+}
+
+static void test_allocation_limit(void)
+{
+    char value[200];
+    memset(value, 'x', sizeof(value) - 1);
+    value[sizeof(value) - 1] = '\0';
+
+    dbof_object repeated = dbof_new(DBOF_TYPE_UNTYPED_ARRAY);
+    dbof_object distinct = dbof_new(DBOF_TYPE_UNTYPED_ARRAY);
+    for (int i = 0; i < 1000; ++i)
+    {
+        dbof_untyped_array_push_back(repeated, test_new_string(value));
+
+        value[i % 100] = (char) ('a' + i / 100);
+        dbof_untyped_array_push_back(distinct, test_new_string(value));
+        value[i % 100] = 'x';
+    }
+
+    struct test_buffer repeated_buffer = test_write(repeated);
+    struct test_buffer distinct_buffer = test_write(distinct);
+
+    // The pool's copy of a value counts against the limit once, when it is added
+    size_t limit = 150 * 1024;
+    CHECK(read_limited(&repeated_buffer, NULL, limit) == NULL);
+
+    dbof_intern_pool pool = dbof_intern_pool_new();
+    dbof_object copy = read_limited(&repeated_buffer, pool, limit);
+    CHECK(dbof_equals(copy, repeated));
+    dbof_delete(copy);
+
+    // So a pool cannot be used to get around the limit
+    CHECK(read_limited(&distinct_buffer, pool, limit) == NULL);
+    dbof_intern_pool_delete(pool);
+
+    free(repeated_buffer.data);
+    free(distinct_buffer.data);
+    dbof_delete(repeated);
+    dbof_delete(distinct);
+}
+
+int main(void)
+{
+    test_shared_values();
+    test_reading_through_pool();
+    test_long_values_are_not_interned();
+    test_allocation_limit();
+    return 0;
+}
@@ -0,0 +1,194 @@
+/*
+ * DBOF
+ * Copyright 2017 glyre
+ */
+
+#include <limits.h>
+#include "test.h"
+
+/**
+ * Serialize untyped arrays nested to the given depth, each holding the next one. The caller frees the buffer's data.
+ * The serialized form is put together from the one of two levels, so no object that deep is ever built.
+ */
+static struct test_buffer nested_arrays(size_t depth)
+{
+    dbof_object one = dbof_new(DBOF_TYPE_UNTYPED_ARRAY);
+    dbof_object two = dbof_new(DBOF_TYPE_UNTYPED_ARRAY);
+    dbof_untyped_array_push_back(two, dbof_new(DBOF_TYPE_UNTYPED_ARRAY));
+
+    struct test_buffer innermost = test_write(one);
+    struct test_buffer outer = test_write(two);
+    dbof_delete(one);
+    dbof_delete(two);
+
+    // Both start with the same header, and two levels take one more container header than one level does
+    size_t header = 6;
+    size_t level = outer.size - innermost.size;
+
+    struct test_buffer buffer = { NULL, 0, 0, 0 };
+    buffer.capacity = header + depth * level + innermost.size;
+    buffer.data = malloc(buffer.capacity);
+    CHECK(buffer.data != NULL);
+
+    memcpy(buffer.data, outer.data, header);
+    buffer.size = header;
+    for (size_t i = 1; i < depth; ++i)
+    {
+        memcpy(buffer.data + buffer.size, outer.data + header, level);
+        buffer.size += level;
+    }
+    memcpy(buffer.data + buffer.size, innermost.data + header, innermost.size - header);
+    buffer.size += innermost.size - header;
+
+    free(innermost.data);
+    free(outer.data);
+    return buffer;
+}
+
+static dbof_object read_with_depth(struct test_buffer* buffer, unsigned int max_depth)
+{
+    dbof_reader reader;
+    memset(&reader, 0, sizeof(reader));
+    reader.read = test_buffer_read;
+    reader.max_depth = max_depth;
+    reader.data = buffer;
+
+    buffer->position = 0;
+    return dbof_read(&reader);
+}
+
+static void test_default_depth(void)
+{
+    // Right at the limit is fine, and what was read can be written and deleted again
+    struct test_buffer buffer = nested_arrays(DBOF_DEFAULT_MAX_DEPTH);
+    dbof_object object = read_with_depth(&buffer, 0);
+    CHECK(object != NULL);
+    struct test_buffer copy = test_write(object);
+    CHECK(copy.size == buffer.size);
+    free(copy.data);
+    dbof_delete(object);
+
+    object = dbof_read_buffer(buffer.data, buffer.size, 0);
+    CHECK(object != NULL);
+    dbof_delete(object);
+    free(buffer.data);
+
+    // One deeper is not
+    buffer = nested_arrays(DBOF_DEFAULT_MAX_DEPTH + 1);
+    CHECK(read_with_depth(&buffer, 0) == NULL);
+    CHECK(dbof_read_buffer(buffer.data, buffer.size, 0) == NULL);
+    free(buffer.data);
+
+    // A hostile input far deeper than any stack allows is turned away without building it
+    buffer = nested_arrays(1000000);
+    CHECK(read_with_depth(&buffer, 0) == NULL);
+    CHECK(dbof_read_buffer(buffer.data, buffer.size, 0) == NULL);
+    free(buffer.data);
+}
+
+static void test_given_depth(void)
+{
+    struct test_buffer buffer = nested_arrays(8);
+
+    CHECK(read_with_depth(&buffer, 7) == NULL);
+
+    dbof_object object = read_with_depth(&buffer, 8);
+    CHECK(object != NULL);
+    dbof_delete(object);
+
+    object = read_with_depth(&buffer, UINT_MAX);
+    CHECK(object != NULL);
+    dbof_delete(object);
+
+    free(buffer.data);
+}
+
+static void test_allocation_limit(void)
+{
+    dbof_object array = dbof_new(DBOF_TYPE_UNTYPED_ARRAY);
+    for (int i = 0; i < 1000; ++i)
+    {
+        dbof_untyped_array_push_back(array, test_new_string("a string too long to be kept inline"));
+    }
+
+    struct test_buffer buffer = test_write(array);
+    dbof_delete(array);
+
+    dbof_reader reader;
+    memset(&reader, 0, sizeof(reader));
+    reader.read = test_buffer_read;
+    reader.data = &buffer;
+
+    // The strings alone take more than the limit
+    reader.max_allocation = 16 * 1024;
+    buffer.position = 0;
+    CHECK(dbof_read(&reader) == NULL);
+    CHECK(dbof_read_buffer_ex(&reader, buffer.data, buffer.size, 0) == NULL);
+
+    // So do interned ones, shared or not
+    dbof_intern_pool pool = dbof_intern_pool_new();
+    reader.intern_pool = pool;
+    buffer.position = 0;
+    CHECK(dbof_read(&reader) == NULL);
+    reader.intern_pool = NULL;
+    dbof_intern_pool_delete(pool);
+
+    reader.max_allocation = 1024 * 1024;
+    buffer.position = 0;
+    dbof_object object = dbof_read(&reader);
+    CHECK(object != NULL);
+    CHECK(dbof_untyped_array_get_size(object) == 1000);
+    dbof_delete(object);
+
+    free(buffer.data);
+}
+
+static void test_bogus_string_length(void)
+{
+    dbof_object string = test_new_string("hello");
+    struct test_buffer written = test_write(string);
+    dbof_delete(string);
+
+    // Header and type as written, then a seven-byte length claiming far more than follows
+    struct test_buffer buffer = { NULL, 16, 16, 0 };
+    buffer.data = malloc(buffer.size);
+    CHECK(buffer.data != NULL);
+    memcpy(buffer.data, written.data, 7);
+    memcpy(buffer.data + 7, "\x07\x24\x68\x65\x6c\x6c\x6f\x20h", 9);
+    free(written.data);
+
+    // Nothing near that size is allocated, however the string is read
+    dbof_reader reader;
+    memset(&reader, 0, sizeof(reader));
+    reader.read = test_buffer_read;
+    reader.data = &buffer;
+    CHECK(dbof_read(&reader) == NULL);
+    CHECK(dbof_read_buffer(buffer.data, buffer.size, 0) == NULL);
+    CHECK(dbof_read_buffer(buffer.data, buffer.size, DBOF_READ_BORROW) == NULL);
+
+    dbof_arena arena = dbof_arena_new(0);
+    reader.arena = arena;
+    buffer.position = 0;
+    CHECK(dbof_read(&reader) == NULL);
+    CHECK(dbof_read_buffer_ex(&reader, buffer.data, buffer.size, 0) == NULL);
+    reader.arena = NULL;
+    dbof_arena_delete(arena);
+
+    dbof_intern_pool pool = dbof_intern_pool_new();
+    reader.intern_pool = pool;
+    buffer.position = 0;
+    CHECK(dbof_read(&reader) == NULL);
+    CHECK(dbof_intern_pool_get_size(pool) == 0);
+    dbof_intern_pool_delete(pool);
+
+    free(buffer.data);
+}
+
+int main(void)
+{
+    test_default_depth();
+    test_given_depth();
+    test_allocation_limit();
+    test_bogus_string_length();
+    return 0;
+}
@@ -0,0 +1,157 @@
+/*
+ * DBOF
+ * Copyright 2017 glyre
+ */
+
+#include "test.h"
+
+/**
+ * Build a document with containers wide enough to be worked on by several threads, at the top and further down.
+ */
+static dbof_object new_document(void)
+{
+    dbof_object document = dbof_new(DBOF_TYPE_UNTYPED_ARRAY);
+    for (int i = 0; i < 3000; ++i)
+    {
+        dbof_object entry = dbof_new(DBOF_TYPE_UNTYPED_MAP);
+        dbof_untyped_map_put(entry, test_new_string("id"), test_new_int(i));
+        dbof_untyped_map_put(entry, test_new_string("name"), test_new_string(i % 3 ? "some entry" : "another one"));
+        dbof_untyped_array_push_back(document, entry);
+    }
+
+    dbof_object index = dbof_new(DBOF_TYPE_UNTYPED_MAP);
+    for (int i = 0; i < 2000; ++i)
+    {
+        dbof_untyped_map_put(index, test_new_int(i), test_new_int(i * 2));
+    }
+
+    dbof_object wrapper = dbof_new(DBOF_TYPE_UNTYPED_ARRAY);
+    dbof_untyped_array_push_back(wrapper, index);
+    dbof_untyped_array_push_back(document, wrapper);
+    return document;
+}
+
+static size_t fail_after_limit(struct dbof_writer* writer, const char* ptr, size_t size)
+{
+    (void) ptr;
+
+    size_t* limit = writer->data;
+    if (size > *limit)
+        return 0;
+
+    *limit -= size;
+    return size;
+}
+
+static struct test_buffer write_with_threads(dbof_object object, unsigned int threads)
+{
+    struct test_buffer buffer = { NULL, 0, 0, 0 };
+
+    dbof_writer writer;
+    memset(&writer, 0, sizeof(writer));
+    writer.write = test_buffer_write;
+    writer.data = &buffer;
+    writer.threads = threads;
+
+    CHECK(dbof_write(object, &writer) == 0);
+    return buffer;
+}
+
+static void check_same_output(dbof_object object)
+{
+    struct test_buffer expected = write_with_threads(object, 0);
+
+    for (unsigned int threads = 1; threads <= 8; threads *= 2)
+    {
+        struct test_buffer buffer = write_with_threads(object, threads);
+        CHECK(buffer.size == expected.size);
+        CHECK(memcmp(buffer.data, expected.data, expected.size) == 0);
+        free(buffer.data);
+    }
+
+    free(expected.data);
+}
+
+static void test_writing(void)
+{
+    dbof_object document = new_document();
+
+    // The output is the same on any number of threads
+    check_same_output(document);
+
+    // So it is for snapshots and frozen objects, which share their children
+    dbof_object snapshot = dbof_untyped_array_snapshot(document);
+    dbof_untyped_array_insert(snapshot, 1500, test_new_string("inserted"));
+    check_same_output(snapshot);
+
+    CHECK(dbof_freeze(document) == 0);
+    check_same_output(document);
+    check_same_output(snapshot);
+
+    // Writers that give up partway fail the whole write
+    struct test_buffer complete = write_with_threads(document, 0);
+    size_t limit = complete.size / 2;
+
+    dbof_writer writer;
+    memset(&writer, 0, sizeof(writer));
+    writer.write = fail_after_limit;
+    writer.data = &limit;
+    writer.buffer_size = 64;
+    writer.threads = 4;
+    CHECK(dbof_write(document, &writer) != 0);
+
+    free(complete.data);
+    dbof_delete(snapshot);
+    dbof_delete(document);
+}
+
+static dbof_object read_with_threads(const struct test_buffer* buffer, size_t size, unsigned int threads,
+        dbof_intern_pool pool)
+{
+    dbof_reader reader;
+    memset(&reader, 0, sizeof(reader));
+    reader.threads = threads;
+    reader.intern_pool = pool;
+    return dbof_read_buffer_ex(&reader, buffer->data, size, 0);
+}
+
+static void test_reading(void)
+{
+    dbof_object document = new_document();
+    struct test_buffer buffer = write_with_threads(document, 0);
+
+    // The result is the same on any number of threads
+    for (unsigned int threads = 0; threads <= 8; threads = threads ? threads * 2 : 1)
+    {
+        dbof_object copy = read_with_threads(&buffer, buffer.size, threads, NULL);
+        CHECK(copy != NULL);
+        CHECK(dbof_equals(copy, document));
+        CHECK(dbof_hash(copy) == dbof_hash(document));
+
+        // Children read on other threads are ordinary objects
+        dbof_untyped_map_put(dbof_untyped_array_get(copy, 2999), test_new_string("extra"), test_new_int(0));
+        dbof_delete(dbof_untyped_array_pop_back(copy));
+        dbof_delete(copy);
+    }
+
+    // Readers with an intern pool read on the calling thread alone, with the same result
+    dbof_intern_pool pool = dbof_intern_pool_new();
+    dbof_object copy = read_with_threads(&buffer, buffer.size, 4, pool);
+    CHECK(dbof_equals(copy, document));
+    dbof_delete(copy);
+    dbof_intern_pool_delete(pool);
+
+    // Truncated input fails wherever it is cut
+    CHECK(read_with_threads(&buffer, buffer.size - 1, 4, NULL) == NULL);
+    CHECK(read_with_threads(&buffer, buffer.size / 2, 4, NULL) == NULL);
+
+    free(buffer.data);
+    dbof_delete(document);
+}
+
+int main(void)
+{
+    test_writing();
+    test_reading();
+    return 0;
+}
@@ -0,0 +1,355 @@
+/*
+ * DBOF
+ * Copyright 2017 glyre
+ */
+
+#include "test.h"
+
+/**
+ * A record of parse events, one letter each, with the values that came along.
+ */
+struct trace
+{
+    char events[256];
+    size_t count;
+    dbof_signed_long_integer sum;
+    char strings[256];
+    size_t strings_length;
+    dbof_container_size packed;
+};
+
+static void record(dbof_handler* handler, char event)
+{
+    struct trace* trace = handler->data;
+    CHECK(trace->count + 1 < sizeof(trace->events));
+    trace->events[trace->count++] = event;
+    trace->events[trace->count] = '\0';
+}
+
+static int on_scalar(dbof_handler* handler, dbof_type type, const dbof_value* value)
+{
+    struct trace* trace = handler->data;
+    record(handler, 'v');
+
+    if (type == DBOF_TYPE_SIGNED_INTEGER)
+    {
+        trace->sum += value->signed_integer;
+    }
+
+    return DBOF_PARSE_CONTINUE;
+}
+
+static int on_string(dbof_handler* handler, const char* ptr, dbof_string_size length)
+{
+    struct trace* trace = handler->data;
+    record(handler, 's');
+
+    CHECK(trace->strings_length + length + 1 < sizeof(trace->strings));
+    memcpy(trace->strings + trace->strings_length, ptr, length);
+    trace->strings_length += length;
+    trace->strings[trace->strings_length++] = ',';
+    trace->strings[trace->strings_length] = '\0';
+    return DBOF_PARSE_CONTINUE;
+}
+
+static int on_begin_array(dbof_handler* handler, dbof_type type, dbof_container_size size, dbof_type element_type)
+{
+    (void) size;
+    (void) element_type;
+    record(handler, type == DBOF_TYPE_TYPED_ARRAY ? 'A' : '[');
+    return DBOF_PARSE_CONTINUE;
+}
+
+static int on_array_data(dbof_handler* handler, dbof_type element_type, const void* values,
+        dbof_container_size count)
+{
+    struct trace* trace = handler->data;
+    record(handler, 'd');
+
+    CHECK(element_type == DBOF_TYPE_SIGNED_INTEGER);
+    for (dbof_container_size i = 0; i < count; ++i)
+    {
+        trace->sum += ((const dbof_signed_integer*) values)[i];
+    }
+
+    trace->packed += count;
+    return DBOF_PARSE_CONTINUE;
+}
+
+static int on_end_array(dbof_handler* handler)
+{
+    record(handler, ']');
+    return DBOF_PARSE_CONTINUE;
+}
+
+static int on_begin_map(dbof_handler* handler, dbof_type type, dbof_container_size size, dbof_type key_type,
+        dbof_type value_type)
+{
+    (void) type;
+    (void) size;
+    (void) key_type;
+    (void) value_type;
+    record(handler, '{');
+    return DBOF_PARSE_CONTINUE;
+}
+
+static int on_key(dbof_handler* handler)
+{
+    record(handler, 'k');
+    return DBOF_PARSE_CONTINUE;
+}
+
+static int on_end_map(dbof_handler* handler)
+{
+    record(handler, '}');
+    return DBOF_PARSE_CONTINUE;
+}
+
+static dbof_handler new_handler(struct trace* trace)
+{
+    memset(trace, 0, sizeof(*trace));
+
+    dbof_handler handler = { on_scalar, on_string, NULL, on_begin_array, on_array_data, on_end_array, on_begin_map,
+            on_key, on_end_map, trace };
+    return handler;
+}
+
+/**
+ * Build ["first", {"key": [1, 2]}, typed array of 0..99, null].
+ */
+static dbof_object new_document(void)
+{
+    dbof_object document = dbof_new(DBOF_TYPE_UNTYPED_ARRAY);
+    dbof_untyped_array_push_back(document, test_new_string("first"));
+
+    dbof_object map = dbof_new(DBOF_TYPE_UNTYPED_MAP);
+    dbof_object pair = dbof_new(DBOF_TYPE_UNTYPED_ARRAY);
+    dbof_untyped_array_push_back(pair, test_new_int(1));
+    dbof_untyped_array_push_back(pair, test_new_int(2));
+    dbof_untyped_map_put(map, test_new_string("key"), pair);
+    dbof_untyped_array_push_back(document, map);
+
+    dbof_object samples = dbof_new(DBOF_TYPE_TYPED_ARRAY);
+    dbof_typed_array_set_type(samples, DBOF_TYPE_SIGNED_INTEGER);
+    for (int i = 0; i < 100; ++i)
+    {
+        dbof_typed_array_push_back_signed_integer(samples, i);
+    }
+    dbof_untyped_array_push_back(document, samples);
+
+    dbof_untyped_array_push_back(document, dbof_new(DBOF_TYPE_NULL));
+    return document;
+}
+
+static void test_events(void)
+{
+    dbof_object document = new_document();
+    struct test_buffer buffer = test_write(document);
+
+    struct trace trace;
+    dbof_handler handler = new_handler(&trace);
+    CHECK(dbof_parse_buffer(buffer.data, buffer.size, &handler) == 0);
+
+    CHECK(strcmp(trace.events, "[s{ks[vv]}Ad]v]") == 0);
+    CHECK(strcmp(trace.strings, "first,key,") == 0);
+    CHECK(trace.sum == 1 + 2 + 99 * 100 / 2);
+    CHECK(trace.packed == 100);
+
+    // Without a callback for chunks of values, they come one by one
+    handler = new_handler(&trace);
+    handler.array_data = NULL;
+    CHECK(dbof_parse_buffer(buffer.data, buffer.size, &handler) == 0);
+    CHECK(trace.count == 15 - 1 + 100);
+    CHECK(trace.sum == 1 + 2 + 99 * 100 / 2);
+
+    free(buffer.data);
+    dbof_delete(document);
+}
+
+static void test_reader_with_small_buffer(void)
+{
+    dbof_object document = dbof_new(DBOF_TYPE_UNTYPED_ARRAY);
+
+    // A string larger than the read buffer is copied out whole
+    char long_string[200];
+    memset(long_string, 'x', sizeof(long_string) - 1);
+    long_string[sizeof(long_string) - 1] = '\0';
+    dbof_untyped_array_push_back(document, test_new_string(long_string));
+    dbof_untyped_array_push_back(document, test_new_int(7));
+
+    struct test_buffer buffer = test_write(document);
+
+    dbof_reader reader;
+    memset(&reader, 0, sizeof(reader));
+    reader.read = test_buffer_read;
+    reader.data = &buffer;
+    reader.buffer_size = 16;
+
+    struct trace trace;
+    dbof_handler handler = new_handler(&trace);
+    CHECK(dbof_parse(&reader, &handler) == 0);
+    CHECK(strcmp(trace.events, "[sv]") == 0);
+    CHECK(trace.strings_length == sizeof(long_string));
+    CHECK(trace.sum == 7);
+
+    free(buffer.data);
+    dbof_delete(document);
+}
+
+static int on_string_data(dbof_handler* handler, const char* ptr, dbof_string_size size, dbof_string_size remaining)
+{
+    struct trace* trace = handler->data;
+    record(handler, remaining == 0 ? 's' : 'p');
+
+    trace->strings_length += size;
+    CHECK(*ptr == 'x');
+    return DBOF_PARSE_CONTINUE;
+}
+
+static int skip_string_data(dbof_handler* handler, const char* ptr, dbof_string_size size, dbof_string_size remaining)
+{
+    on_string_data(handler, ptr, size, remaining);
+    return DBOF_PARSE_SKIP;
+}
+
+static void test_string_pieces(void)
+{
+    dbof_object document = dbof_new(DBOF_TYPE_UNTYPED_ARRAY);
+
+    char long_string[200];
+    memset(long_string, 'x', sizeof(long_string) - 1);
+    long_string[sizeof(long_string) - 1] = '\0';
+    dbof_untyped_array_push_back(document, test_new_string(long_string));
+    dbof_untyped_array_push_back(document, test_new_string("x"));
+    dbof_untyped_array_push_back(document, test_new_int(7));
+
+    struct test_buffer buffer = test_write(document);
+
+    dbof_reader reader;
+    memset(&reader, 0, sizeof(reader));
+    reader.read = test_buffer_read;
+    reader.data = &buffer;
+    reader.buffer_size = 16;
+
+    // Strings larger than the buffer come in pieces, the others in one
+    struct trace trace;
+    dbof_handler handler = new_handler(&trace);
+    handler.string = NULL;
+    handler.string_data = on_string_data;
+    CHECK(dbof_parse(&reader, &handler) == 0);
+    CHECK(trace.events[0] == '[' && trace.events[1] == 'p');
+    CHECK(strcmp(trace.events + trace.count - 4, "ssv]") == 0);
+    CHECK(trace.strings_length == sizeof(long_string));
+
+    // Pieces need no memory, so they pass an allocation limit that a whole copy would not
+    buffer.position = 0;
+    reader.max_allocation = 100;
+    handler = new_handler(&trace);
+    handler.string_data = on_string_data;
+    CHECK(dbof_parse(&reader, &handler) == 0);
+
+    buffer.position = 0;
+    handler = new_handler(&trace);
+    CHECK(dbof_parse(&reader, &handler) == -1);
+
+    // The rest of a string can be skipped
+    buffer.position = 0;
+    reader.max_allocation = 0;
+    handler = new_handler(&trace);
+    handler.string = NULL;
+    handler.string_data = skip_string_data;
+    CHECK(dbof_parse(&reader, &handler) == 0);
+    CHECK(strcmp(trace.events, "[psv]") == 0);
+    CHECK(trace.sum == 7);
+
+    free(buffer.data);
+    dbof_delete(document);
+}
+
+static void test_bogus_string_lengths(void)
+{
+    dbof_object string = test_new_string("hello");
+    struct test_buffer buffer = test_write(string);
+
+    // Header and type as written, then a seven-byte length claiming far more than follows
+    char bogus[16];
+    memcpy(bogus, buffer.data, 7);
+    memcpy(bogus + 7, "\x07\x24\x68\x65\x6c\x6c\x6f\x20h", 9);
+    size_t bogus_size = sizeof(bogus);
+
+    struct trace trace;
+    dbof_handler handler = new_handler(&trace);
+    CHECK(dbof_parse_buffer(bogus, bogus_size, &handler) == -1);
+    CHECK(trace.count == 0);
+
+    // Read from a stream, the string is copied out as far as the input goes, and no further
+    struct test_buffer stream = { bogus, bogus_size, bogus_size, 0 };
+    dbof_reader reader;
+    memset(&reader, 0, sizeof(reader));
+    reader.read = test_buffer_read;
+    reader.data = &stream;
+    reader.buffer_size = 8;
+
+    handler = new_handler(&trace);
+    CHECK(dbof_parse(&reader, &handler) == -1);
+    CHECK(trace.count == 0);
+
+    // Truncated strings fail the same way
+    handler = new_handler(&trace);
+    CHECK(dbof_parse_buffer(buffer.data, buffer.size - 1, &handler) == -1);
+    CHECK(trace.count == 0);
+
+    free(buffer.data);
+    dbof_delete(string);
+}
+
+static int skip_maps(dbof_handler* handler, dbof_type type, dbof_container_size size, dbof_type key_type,
+        dbof_type value_type)
+{
+    on_begin_map(handler, type, size, key_type, value_type);
+    return DBOF_PARSE_SKIP;
+}
+
+static int abort_on_typed_arrays(dbof_handler* handler, dbof_type type, dbof_container_size size,
+        dbof_type element_type)
+{
+    on_begin_array(handler, type, size, element_type);
+    return type == DBOF_TYPE_TYPED_ARRAY ? 42 : DBOF_PARSE_CONTINUE;
+}
+
+static void test_skip_and_abort(void)
+{
+    dbof_object document = new_document();
+    struct test_buffer buffer = test_write(document);
+
+    // Skipped containers have neither contents nor an end event
+    struct trace trace;
+    dbof_handler handler = new_handler(&trace);
+    handler.begin_map = skip_maps;
+    CHECK(dbof_parse_buffer(buffer.data, buffer.size, &handler) == 0);
+    CHECK(strcmp(trace.events, "[s{Ad]v]") == 0);
+    CHECK(trace.sum == 99 * 100 / 2);
+
+    // The abort code comes back as is
+    handler = new_handler(&trace);
+    handler.begin_array = abort_on_typed_arrays;
+    CHECK(dbof_parse_buffer(buffer.data, buffer.size, &handler) == 42);
+    CHECK(strcmp(trace.events, "[s{ks[vv]}A") == 0);
+
+    // Truncated input is an error
+    handler = new_handler(&trace);
+    CHECK(dbof_parse_buffer(buffer.data, buffer.size - 1, &handler) == -1);
+
+    free(buffer.data);
+    dbof_delete(document);
+}
+
+int main(void)
+{
+    test_events();
+    test_reader_with_small_buffer();
+    test_string_pieces();
+    test_bogus_string_lengths();
+    test_skip_and_abort();
+    return 0;
+}
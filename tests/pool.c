@@ -0,0 +1,96 @@
+/*
+ * DBOF
+ * Copyright 2017 glyre
+ */
+
+#include "test.h"
+
+/*
+ * This test is built against a copy of the library with DBOF_POOL defined. Objects come and go in batches, so the
+ * counters move in whole batches, and this being the only thread, nothing else moves them.
+ */
+
+/**
+ * The number of objects to work with, and the number of objects in a batch of the pool.
+ */
+enum { COUNT = 1000, BATCH = 128 };
+
+static dbof_pool_stats get_stats(void)
+{
+    dbof_pool_stats stats;
+    CHECK(dbof_pool_get_stats(&stats) == 0);
+    return stats;
+}
+
+static void allocate(dbof_object* objects)
+{
+    for (int i = 0; i < COUNT; ++i)
+    {
+        objects[i] = test_new_int(i);
+        CHECK(objects[i] != NULL);
+    }
+}
+
+static void delete_all(dbof_object* objects)
+{
+    for (int i = 0; i < COUNT; ++i)
+    {
+        dbof_delete(objects[i]);
+    }
+}
+
+static void test_counters(void)
+{
+    static dbof_object objects[COUNT];
+
+    dbof_pool_stats stats = get_stats();
+    CHECK(stats.allocated == 0 && stats.freed == 0 && stats.pooled == 0);
+
+    // Objects are allocated from the heap a batch at a time
+    allocate(objects);
+    stats = get_stats();
+    CHECK(stats.allocated >= COUNT);
+    CHECK(stats.allocated < COUNT + BATCH);
+    CHECK(stats.freed == 0);
+    CHECK(stats.refills == 0);
+    uint64_t allocated = stats.allocated;
+
+    // Deleted objects are kept, and what the thread does not cache goes to the global free list
+    delete_all(objects);
+    stats = get_stats();
+    CHECK(stats.allocated == allocated);
+    CHECK(stats.freed == 0);
+    CHECK(stats.spills > 0);
+    CHECK(stats.pooled == stats.spills * BATCH);
+
+    // Allocating again takes them back instead of going to the heap
+    allocate(objects);
+    stats = get_stats();
+    CHECK(stats.allocated == allocated);
+    CHECK(stats.refills > 0);
+    CHECK(stats.pooled == (stats.spills - stats.refills) * BATCH);
+
+    // Trimming hands everything not in use back to the heap
+    delete_all(objects);
+    dbof_pool_trim();
+    stats = get_stats();
+    CHECK(stats.pooled == 0);
+    CHECK(stats.freed == stats.allocated);
+
+    // After which objects come from the heap again
+    allocate(objects);
+    stats = get_stats();
+    CHECK(stats.allocated > allocated);
+    CHECK(stats.pooled == 0);
+
+    delete_all(objects);
+    dbof_pool_trim();
+    stats = get_stats();
+    CHECK(stats.freed == stats.allocated);
+}
+
+int main(void)
+{
+    test_counters();
+    return 0;
+}
@@ -0,0 +1,85 @@
+/*
+ * DBOF
+ * Copyright 2017 glyre
+ */
+
+#include "test.h"
+
+static void test_retain_and_release(void)
+{
+    dbof_object string = test_new_string("hello");
+    CHECK(dbof_retain(string) == string);
+
+    // The first release leaves the object to the second reference
+    dbof_release(string);
+    CHECK(strcmp(dbof_get_value_utf8_string(string), "hello") == 0);
+    dbof_release(string);
+
+    CHECK(dbof_retain(NULL) == NULL);
+}
+
+static void test_shared_frozen_subtree(void)
+{
+    dbof_object shared = dbof_new(DBOF_TYPE_UNTYPED_MAP);
+    dbof_untyped_map_put(shared, test_new_string("key"), test_new_int(7));
+    CHECK(dbof_freeze(shared) == 0);
+    int hash = dbof_hash(shared);
+
+    dbof_object parents[8];
+    for (int i = 0; i < 8; ++i)
+    {
+        parents[i] = dbof_new(DBOF_TYPE_UNTYPED_ARRAY);
+        dbof_untyped_array_push_back(parents[i], dbof_retain(shared));
+        dbof_untyped_array_push_back(parents[i], test_new_int(i));
+    }
+
+    // Drop our own reference, the parents keep theirs
+    dbof_release(shared);
+    CHECK(!dbof_equals(parents[0], parents[1]));
+
+    for (int i = 0; i < 7; ++i)
+    {
+        dbof_delete(parents[i]);
+    }
+
+    CHECK(dbof_hash(dbof_untyped_array_get(parents[7], 0)) == hash);
+    dbof_delete(parents[7]);
+}
+
+static void test_child_outlives_parent(void)
+{
+    dbof_object parent = dbof_new(DBOF_TYPE_UNTYPED_ARRAY);
+    dbof_object child = dbof_new(DBOF_TYPE_UNTYPED_ARRAY);
+    dbof_untyped_array_push_back(parent, dbof_retain(child));
+    dbof_hash(parent);
+    dbof_delete(parent);
+
+    // The child no longer reports its changes to the deleted parent
+    dbof_untyped_array_push_back(child, test_new_int(1));
+    CHECK(dbof_untyped_array_get_size(child) == 1);
+    dbof_delete(child);
+}
+
+static void test_refused_objects(void)
+{
+    dbof_object array = dbof_new(DBOF_TYPE_UNTYPED_ARRAY);
+    CHECK(dbof_freeze(array) == 0);
+
+    // A frozen array deletes what it refuses, which only drops our extra reference here
+    dbof_object value = dbof_retain(test_new_int(3));
+    dbof_untyped_array_push_back(array, value);
+    CHECK(dbof_untyped_array_get_size(array) == 0);
+    CHECK(dbof_get_value_signed_integer(value) == 3);
+    dbof_delete(value);
+
+    dbof_delete(array);
+}
+
+int main(void)
+{
+    test_retain_and_release();
+    test_shared_frozen_subtree();
+    test_child_outlives_parent();
+    test_refused_objects();
+    return 0;
+}
@@ -0,0 +1,110 @@
+/*
+ * DBOF
+ * Copyright 2017 glyre
+ */
+
+#include "test.h"
+
+/**
+ * Build a document with every kind of container and a mix of value types.
+ */
+static dbof_object new_document(void)
+{
+    dbof_object document = dbof_new(DBOF_TYPE_UNTYPED_MAP);
+
+    dbof_untyped_map_put(document, test_new_string("name"), test_new_string("round trip"));
+    dbof_untyped_map_put(document, test_new_string("count"), test_new_int(-12345));
+
+    dbof_object ratio = dbof_new(DBOF_TYPE_DOUBLE_FLOAT);
+    dbof_set_value_double_float(ratio, 0.25);
+    dbof_untyped_map_put(document, test_new_string("ratio"), ratio);
+
+    dbof_object tags = dbof_new(DBOF_TYPE_UNTYPED_ARRAY);
+    dbof_untyped_array_push_back(tags, test_new_string("first"));
+    dbof_untyped_array_push_back(tags, dbof_new(DBOF_TYPE_NULL));
+    dbof_untyped_array_push_back(tags, dbof_new_boolean(1));
+    dbof_untyped_map_put(document, test_new_string("tags"), tags);
+
+    // Packed values
+    dbof_object samples = dbof_new(DBOF_TYPE_TYPED_ARRAY);
+    dbof_typed_array_set_type(samples, DBOF_TYPE_SIGNED_INTEGER);
+    for (int i = 0; i < 1000; ++i)
+    {
+        dbof_typed_array_push_back_signed_integer(samples, i * i - 500);
+    }
+    dbof_untyped_map_put(document, test_new_string("samples"), samples);
+
+    // Typed keys and values
+    dbof_object index = dbof_new(DBOF_TYPE_TYPED_MAP);
+    dbof_typed_map_set_key_type(index, DBOF_TYPE_UTF8_STRING);
+    dbof_typed_map_set_value_type(index, DBOF_TYPE_SIGNED_INTEGER);
+    CHECK(dbof_typed_map_put(index, test_new_string("a"), test_new_int(1)) == 0);
+    CHECK(dbof_typed_map_put(index, test_new_string("b"), test_new_int(2)) == 0);
+    dbof_untyped_map_put(document, test_new_string("index"), index);
+
+    // Nesting
+    dbof_object nested = dbof_new(DBOF_TYPE_UNTYPED_ARRAY);
+    dbof_object inner = dbof_new(DBOF_TYPE_UNTYPED_ARRAY);
+    dbof_untyped_array_push_back(inner, test_new_string("deep"));
+    dbof_untyped_array_push_back(nested, inner);
+    dbof_untyped_map_put(document, test_new_string("nested"), nested);
+
+    return document;
+}
+
+static void test_round_trip(unsigned short version)
+{
+    dbof_object document = new_document();
+
+    struct test_buffer buffer = { NULL, 0, 0, 0 };
+    dbof_writer writer;
+    memset(&writer, 0, sizeof(writer));
+    writer.write = test_buffer_write;
+    writer.use_version = version;
+    writer.data = &buffer;
+    CHECK(dbof_write(document, &writer) == 0);
+
+    dbof_object copy = test_read(&buffer);
+    CHECK(copy != NULL);
+    CHECK(dbof_equals(document, copy));
+    CHECK(dbof_hash(document) == dbof_hash(copy));
+
+    dbof_object key = test_new_string("samples");
+    dbof_object samples = dbof_untyped_map_get(copy, key);
+    CHECK(dbof_typed_array_get_size(samples) == 1000);
+    CHECK(dbof_typed_array_get_signed_integer_at(samples, 30) == 30 * 30 - 500);
+    dbof_delete(key);
+
+    // Reading from memory gives the same object
+    dbof_object buffered = dbof_read_buffer(buffer.data, buffer.size, 0);
+    CHECK(buffered != NULL);
+    CHECK(dbof_equals(document, buffered));
+
+    dbof_delete(buffered);
+    dbof_delete(copy);
+    dbof_delete(document);
+    free(buffer.data);
+}
+
+static void test_truncated_input(void)
+{
+    dbof_object document = new_document();
+    struct test_buffer buffer = test_write(document);
+
+    // Every proper prefix of the serialized object is rejected
+    for (size_t size = 0; size < buffer.size; size += 7)
+    {
+        CHECK(dbof_read_buffer(buffer.data, size, 0) == NULL);
+    }
+
+    dbof_delete(document);
+    free(buffer.data);
+}
+
+int main(void)
+{
+    test_round_trip(0);
+    test_round_trip(1);
+    test_truncated_input();
+    return 0;
+}
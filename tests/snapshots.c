@@ -0,0 +1,277 @@
+/*
+ * DBOF
+ * Copyright 2017 glyre
+ */
+
+#include "test.h"
+
+static dbof_signed_integer get_int(dbof_object array, dbof_container_size index)
+{ return dbof_get_value_signed_integer(dbof_untyped_array_get(array, index)); }
+
+static dbof_object new_int_array(int size)
+{
+    dbof_object array = dbof_new(DBOF_TYPE_UNTYPED_ARRAY);
+    for (int i = 0; i < size; ++i)
+    {
+        dbof_untyped_array_push_back(array, test_new_int(i));
+    }
+
+    return array;
+}
+
+static void test_edits_are_independent(void)
+{
+    dbof_object array = new_int_array(10);
+
+    dbof_object snapshot = dbof_untyped_array_snapshot(array);
+    CHECK(snapshot != NULL);
+    CHECK(dbof_equals(array, snapshot));
+
+    dbof_untyped_array_push_back(array, test_new_int(10));
+    dbof_untyped_array_insert(snapshot, 0, test_new_int(-1));
+    dbof_delete(dbof_untyped_array_remove(array, 3));
+
+    CHECK(dbof_untyped_array_get_size(array) == 10);
+    CHECK(dbof_untyped_array_get_size(snapshot) == 11);
+    CHECK(get_int(array, 3) == 4);
+    CHECK(get_int(snapshot, 4) == 3);
+
+    dbof_delete(array);
+    CHECK(get_int(snapshot, 10) == 9);
+    dbof_delete(snapshot);
+}
+
+/**
+ * A tiny pseudo-random number generator, so runs are repeatable.
+ */
+static unsigned int next_random(unsigned int* state)
+{
+    *state = *state * 1103515245u + 12345u;
+    return *state >> 16;
+}
+
+static void check_contents(dbof_object array, const int* expected, int size)
+{
+    CHECK(dbof_untyped_array_get_size(array) == (dbof_container_size) size);
+    for (int i = 0; i < size; ++i)
+    {
+        CHECK(get_int(array, (dbof_container_size) i) == expected[i]);
+    }
+}
+
+static void test_many_edits(void)
+{
+    // Enough children for a chunk tree of three levels
+    enum { SIZE = 10000, EDITS = 20000 };
+    static int expected_array[SIZE + EDITS];
+    static int expected_snapshot[SIZE + EDITS];
+    int array_size = SIZE;
+    int snapshot_size = SIZE;
+
+    dbof_object array = new_int_array(SIZE);
+    for (int i = 0; i < SIZE; ++i)
+    {
+        expected_array[i] = expected_snapshot[i] = i;
+    }
+
+    dbof_object snapshot = dbof_untyped_array_snapshot(array);
+    unsigned int state = 1;
+
+    for (int edit = 0; edit < EDITS; ++edit)
+    {
+        int on_array = next_random(&state) & 1;
+        dbof_object target = on_array ? array : snapshot;
+        int* expected = on_array ? expected_array : expected_snapshot;
+        int* size = on_array ? &array_size : &snapshot_size;
+
+        int index = (int) (next_random(&state) % (unsigned int) (*size + 1));
+        int value = SIZE + edit;
+
+        switch (next_random(&state) % 3)
+        {
+        case 0:
+            dbof_untyped_array_insert(target, (dbof_container_size) index, test_new_int(value));
+            memmove(expected + index + 1, expected + index, (size_t) (*size - index) * sizeof(int));
+            expected[index] = value;
+            ++*size;
+            break;
+        case 1:
+            if (index == *size)
+                break;
+
+            dbof_delete(dbof_untyped_array_remove(target, (dbof_container_size) index));
+            memmove(expected + index, expected + index + 1, (size_t) (*size - index - 1) * sizeof(int));
+            --*size;
+            break;
+        default:
+            if (index == *size)
+                break;
+
+            // The old child goes to the caller, who got it beforehand
+            dbof_object old = dbof_untyped_array_get(target, (dbof_container_size) index);
+            dbof_untyped_array_set(target, (dbof_container_size) index, test_new_int(value));
+            dbof_delete(old);
+            expected[index] = value;
+            break;
+        }
+    }
+
+    check_contents(array, expected_array, array_size);
+    check_contents(snapshot, expected_snapshot, snapshot_size);
+
+    // Emptying an array and filling it up again works on the tree as well
+    while (!dbof_untyped_array_is_empty(array))
+    {
+        dbof_delete(dbof_untyped_array_pop_back(array));
+    }
+    for (int i = 0; i < 300; ++i)
+    {
+        dbof_untyped_array_push_back(array, test_new_int(i));
+        expected_array[i] = i;
+    }
+
+    check_contents(array, expected_array, 300);
+    check_contents(snapshot, expected_snapshot, snapshot_size);
+
+    dbof_delete(snapshot);
+    dbof_delete(array);
+}
+
+static void test_reads_do_not_copy(void)
+{
+    dbof_object array = new_int_array(100);
+    dbof_object nested = new_int_array(3);
+    dbof_untyped_array_push_back(array, nested);
+
+    dbof_object snapshot = dbof_untyped_array_snapshot(array);
+    dbof_object children[101];
+    for (dbof_container_size i = 0; i < 101; ++i)
+    {
+        children[i] = dbof_untyped_array_get(array, i);
+        CHECK(dbof_untyped_array_get(snapshot, i) == children[i]);
+    }
+
+    // Writing, hashing, and comparing leave the children where they are
+    struct test_buffer buffer = test_write(snapshot);
+    dbof_object copy = test_read(&buffer);
+    CHECK(dbof_equals(copy, array));
+    CHECK(dbof_hash(copy) == dbof_hash(snapshot));
+    free(buffer.data);
+    dbof_delete(copy);
+
+    for (dbof_container_size i = 0; i < 101; ++i)
+    {
+        CHECK(dbof_untyped_array_get(array, i) == children[i]);
+        CHECK(dbof_untyped_array_get(snapshot, i) == children[i]);
+    }
+
+    dbof_delete(snapshot);
+    dbof_delete(array);
+}
+
+static void test_children_are_shared(void)
+{
+    dbof_object array = dbof_new(DBOF_TYPE_UNTYPED_ARRAY);
+    dbof_untyped_array_push_back(array, test_new_int(0));
+
+    dbof_object nested = dbof_new(DBOF_TYPE_UNTYPED_ARRAY);
+    dbof_object deeper = dbof_new(DBOF_TYPE_UNTYPED_ARRAY);
+    dbof_untyped_array_push_back(nested, deeper);
+    dbof_untyped_array_push_back(array, nested);
+
+    int hash = dbof_hash(array);
+    dbof_object snapshot = dbof_untyped_array_snapshot(array);
+    CHECK(!dbof_is_frozen(dbof_untyped_array_get(array, 0)));
+
+    // Values set in place show in both arrays, and so do their hash codes
+    dbof_set_value_signed_integer(dbof_untyped_array_get(array, 0), 42);
+    CHECK(get_int(snapshot, 0) == 42);
+    CHECK(dbof_hash(array) != hash);
+    CHECK(dbof_hash(snapshot) == dbof_hash(array));
+
+    // Changing a nested array in one array only takes a snapshot of it along the way
+    dbof_object old = dbof_untyped_array_get(array, 1);
+    dbof_object changed = dbof_untyped_array_snapshot(old);
+    dbof_object changed_deeper = dbof_untyped_array_snapshot(dbof_untyped_array_get(changed, 0));
+    dbof_untyped_array_push_back(changed_deeper, test_new_int(6));
+    dbof_object old_deeper = dbof_untyped_array_get(changed, 0);
+    dbof_untyped_array_set(changed, 0, changed_deeper);
+    dbof_delete(old_deeper);
+    dbof_untyped_array_push_back(changed, test_new_int(5));
+    dbof_untyped_array_set(array, 1, changed);
+    dbof_delete(old);
+
+    CHECK(dbof_untyped_array_get_size(dbof_untyped_array_get(array, 1)) == 2);
+    CHECK(dbof_untyped_array_get_size(dbof_untyped_array_get(dbof_untyped_array_get(array, 1), 0)) == 1);
+    CHECK(dbof_untyped_array_get_size(dbof_untyped_array_get(snapshot, 1)) == 1);
+    CHECK(dbof_untyped_array_get_size(dbof_untyped_array_get(dbof_untyped_array_get(snapshot, 1), 0)) == 0);
+    CHECK(!dbof_equals(array, snapshot));
+
+    // Removed children live on in the other array
+    dbof_delete(dbof_untyped_array_pop_back(snapshot));
+    CHECK(dbof_untyped_array_get_size(dbof_untyped_array_get(array, 1)) == 2);
+
+    dbof_delete(snapshot);
+    dbof_delete(array);
+}
+
+static void test_freezing_one_side(void)
+{
+    dbof_object array = dbof_new(DBOF_TYPE_UNTYPED_ARRAY);
+    dbof_untyped_array_push_back(array, test_new_int(1));
+    dbof_untyped_array_push_back(array, dbof_new(DBOF_TYPE_UNTYPED_ARRAY));
+
+    dbof_object snapshot = dbof_untyped_array_snapshot(array);
+    CHECK(dbof_freeze(snapshot) == 0);
+    CHECK(dbof_is_frozen(dbof_untyped_array_get(snapshot, 1)));
+    CHECK(!dbof_is_frozen(dbof_untyped_array_get(array, 1)));
+
+    dbof_set_value_signed_integer(dbof_untyped_array_get(array, 0), 2);
+    CHECK(get_int(array, 0) == 2);
+    CHECK(get_int(snapshot, 0) == 1);
+
+    // Snapshots of frozen arrays are mutable, and their children are shared as they are
+    dbof_object thawed = dbof_untyped_array_snapshot(snapshot);
+    CHECK(!dbof_is_frozen(thawed));
+    CHECK(dbof_untyped_array_get(thawed, 1) == dbof_untyped_array_get(snapshot, 1));
+    dbof_untyped_array_push_back(thawed, test_new_int(3));
+    CHECK(dbof_untyped_array_get_size(snapshot) == 2);
+
+    dbof_delete(thawed);
+    dbof_delete(snapshot);
+    dbof_delete(array);
+}
+
+static void test_snapshots_of_frozen_arrays(void)
+{
+    dbof_object array = new_int_array(200);
+    CHECK(dbof_freeze(array) == 0);
+    int hash = dbof_hash(array);
+
+    dbof_object first = dbof_untyped_array_snapshot(array);
+    dbof_object second = dbof_untyped_array_snapshot(array);
+    CHECK(dbof_untyped_array_get(first, 150) == dbof_untyped_array_get(array, 150));
+
+    dbof_delete(dbof_untyped_array_remove(first, 0));
+    dbof_untyped_array_insert(second, 100, test_new_int(-1));
+    CHECK(get_int(first, 0) == 1);
+    CHECK(get_int(second, 100) == -1);
+    CHECK(dbof_untyped_array_get_size(array) == 200);
+    CHECK(dbof_hash(array) == hash);
+
+    dbof_delete(array);
+    CHECK(get_int(second, 199) == 198);
+    dbof_delete(first);
+    dbof_delete(second);
+}
+
+int main(void)
+{
+    test_edits_are_independent();
+    test_many_edits();
+    test_reads_do_not_copy();
+    test_children_are_shared();
+    test_freezing_one_side();
+    test_snapshots_of_frozen_arrays();
+    return 0;
+}
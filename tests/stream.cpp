@@ -0,0 +1,89 @@
+/*
+ * DBOF
+ * Copyright 2017 glyre
+ */
+
+#include <cstdlib>
+#include <memory>
+#include <sstream>
+#include <dbof/stream.hpp>
+
+#define CHECK(condition) \
+    do \
+    { \
+        if (!(condition)) \
+        { \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": check failed: " #condition << std::endl; \
+            std::exit(1); \
+        } \
+    } while (0)
+
+/**
+ * A stream buffer over a string that cannot seek, like a pipe.
+ */
+class unseekable_buffer : public std::stringbuf
+{
+public:
+    explicit unseekable_buffer(const std::string& data) : std::stringbuf(data, std::ios_base::in)
+    {}
+
+protected:
+    pos_type seekoff(off_type, std::ios_base::seekdir, std::ios_base::openmode) override
+    { return pos_type(-1); }
+
+    pos_type seekpos(pos_type, std::ios_base::openmode) override
+    { return pos_type(-1); }
+};
+
+static dbof_object new_document(int value)
+{
+    dbof_object array = dbof_new(DBOF_TYPE_UNTYPED_ARRAY);
+    dbof_untyped_array_push_back(array, dbof_new_int(value));
+    return array;
+}
+
+static std::string write_documents()
+{
+    std::ostringstream out;
+    for (int i = 0; i < 3; ++i)
+    {
+        std::unique_ptr<dbof::object> document(dbof::wrap(new_document(i)));
+        CHECK(dbof::stream::write(out, *document));
+    }
+
+    out << "trailer";
+    return out.str();
+}
+
+/**
+ * Read the documents back one after another. Each read must leave the stream right after its document.
+ */
+static void read_documents(std::istream& in)
+{
+    for (int i = 0; i < 3; ++i)
+    {
+        std::unique_ptr<dbof::object> object(dbof::stream::read(in));
+        CHECK(object != nullptr);
+
+        std::unique_ptr<dbof::object> document(dbof::wrap(new_document(i)));
+        CHECK(*object == *document);
+    }
+
+    std::string trailer;
+    in >> trailer;
+    CHECK(trailer == "trailer");
+}
+
+int main()
+{
+    std::string data = write_documents();
+
+    std::istringstream seekable(data);
+    read_documents(seekable);
+
+    unseekable_buffer buffer(data);
+    std::istream unseekable(&buffer);
+    read_documents(unseekable);
+
+    return 0;
+}
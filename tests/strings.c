@@ -0,0 +1,108 @@
+/*
+ * DBOF
+ * Copyright 2017 glyre
+ */
+
+#include "test.h"
+
+static dbof_object new_string_n(const char* value, dbof_string_size length)
+{
+    dbof_object object = dbof_new(DBOF_TYPE_UTF8_STRING);
+    dbof_set_value_utf8_string_n(object, value, length);
+    return object;
+}
+
+static void check_value(dbof_object object, const char* value, dbof_string_size length)
+{
+    dbof_string_size actual_length = 0;
+    const char* actual = dbof_get_value_utf8_string_n(object, &actual_length);
+    CHECK(actual_length == length);
+    CHECK(memcmp(actual, value, length) == 0);
+    CHECK(dbof_get_value_utf8_string_length(object) == length);
+}
+
+static void check_embedded_null(const char* value, dbof_string_size length)
+{
+    dbof_object string = new_string_n(value, length);
+    check_value(string, value, length);
+
+    // The part up to the null character is a different value
+    dbof_object prefix = test_new_string(value);
+    CHECK(dbof_get_value_utf8_string_length(prefix) < length);
+    CHECK(!dbof_equals(string, prefix));
+    CHECK(!dbof_equals(prefix, string));
+
+    // So is one that differs only after it
+    char* changed = malloc(length);
+    CHECK(changed != NULL);
+    memcpy(changed, value, length);
+    changed[length - 1] ^= 1;
+
+    dbof_object other = new_string_n(changed, length);
+    CHECK(!dbof_equals(string, other));
+    CHECK(dbof_hash(string) != dbof_hash(other));
+
+    // An equal value is equal, whichever way it was set
+    dbof_set_value_string_n(other, value, length);
+    CHECK(dbof_equals(string, other));
+    CHECK(dbof_hash(string) == dbof_hash(other));
+
+    // The whole value survives a round trip, copied or borrowed
+    dbof_object array = dbof_new(DBOF_TYPE_UNTYPED_ARRAY);
+    dbof_untyped_array_push_back(array, dbof_retain(string));
+
+    struct test_buffer buffer = test_write(array);
+    dbof_object copy = test_read(&buffer);
+    CHECK(dbof_equals(copy, array));
+    check_value(dbof_untyped_array_get(copy, 0), value, length);
+    dbof_delete(copy);
+
+    copy = dbof_read_buffer(buffer.data, buffer.size, DBOF_READ_BORROW);
+    CHECK(dbof_equals(copy, array));
+    check_value(dbof_untyped_array_get(copy, 0), value, length);
+    dbof_delete(copy);
+
+    free(buffer.data);
+    free(changed);
+    dbof_delete(array);
+    dbof_delete(other);
+    dbof_delete(prefix);
+    dbof_delete(string);
+}
+
+static void test_embedded_null(void)
+{
+    // Short values are kept inline, longer ones are not
+    static const char short_value[] = "ab\0cd";
+    static const char long_value[] = "a value long enough\0to be kept outside the object";
+
+    check_embedded_null(short_value, sizeof(short_value) - 1);
+    check_embedded_null(long_value, sizeof(long_value) - 1);
+}
+
+static void test_empty_and_aliases(void)
+{
+    dbof_object string = new_string_n("ignored", 0);
+    check_value(string, "", 0);
+    CHECK(strcmp(dbof_get_value_utf8_string(string), "") == 0);
+
+    dbof_object empty = test_new_string("");
+    CHECK(dbof_equals(string, empty));
+    CHECK(dbof_hash(string) == dbof_hash(empty));
+    dbof_delete(empty);
+
+    dbof_string_size length = 0;
+    dbof_set_value_string_n(string, "xyz", 2);
+    CHECK(memcmp(dbof_get_value_string_n(string, &length), "xy", 2) == 0);
+    CHECK(length == 2);
+    CHECK(strcmp(dbof_get_value_utf8_string(string), "xy") == 0);
+
+    dbof_delete(string);
+}
+
+int main(void)
+{
+    test_embedded_null();
+    test_empty_and_aliases();
+    return 0;
+}
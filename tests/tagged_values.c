@@ -0,0 +1,189 @@
+/*
+ * DBOF
+ * Copyright 2017 glyre
+ */
+
+#include <stdint.h>
+#include "test.h"
+
+/*
+ * This test is built against a copy of the library with DBOF_TAGGED_VALUES defined. Immediate values only exist on
+ * 64-bit hosts; elsewhere, the same objects are allocated, and everything but their being immediate still holds.
+ */
+#define IMMEDIATE (UINTPTR_MAX > 0xffffffffu)
+
+/**
+ * Check a value object made by a dbof_new_*() constructor against an allocated one of the same value.
+ */
+static void check_against_boxed(dbof_object value, dbof_object boxed)
+{
+    CHECK(value != NULL);
+    CHECK(dbof_typeof(value) == dbof_typeof(boxed));
+    CHECK(dbof_is_frozen(value) == IMMEDIATE);
+    CHECK(!dbof_is_frozen(boxed));
+
+    CHECK(dbof_equals(value, boxed));
+    CHECK(dbof_equals(boxed, value));
+    CHECK(dbof_hash(value) == dbof_hash(boxed));
+
+    // Copies are equal, and retaining and deleting are harmless
+    dbof_object copy = dbof_clone(value);
+    CHECK(dbof_equals(copy, boxed));
+    dbof_delete(copy);
+
+    dbof_delete(dbof_retain(value));
+    CHECK(dbof_equals(value, boxed));
+
+    dbof_delete(value);
+    dbof_delete(boxed);
+}
+
+static void test_values(void)
+{
+    dbof_object boxed = dbof_new(DBOF_TYPE_SIGNED_BYTE);
+    dbof_set_value_signed_byte(boxed, -5);
+    check_against_boxed(dbof_new_signed_byte(-5), boxed);
+
+    boxed = dbof_new(DBOF_TYPE_UNSIGNED_BYTE);
+    dbof_set_value_unsigned_byte(boxed, 250);
+    check_against_boxed(dbof_new_unsigned_byte(250), boxed);
+
+    boxed = test_new_int(-123456);
+    check_against_boxed(dbof_new_signed_integer(-123456), boxed);
+
+    boxed = dbof_new(DBOF_TYPE_UNSIGNED_INTEGER);
+    dbof_set_value_unsigned_integer(boxed, 4000000000u);
+    check_against_boxed(dbof_new_unsigned_integer(4000000000u), boxed);
+
+    boxed = dbof_new(DBOF_TYPE_BOOLEAN);
+    dbof_set_value_boolean(boxed, 1);
+    check_against_boxed(dbof_new_boolean(1), boxed);
+
+    boxed = dbof_new(DBOF_TYPE_SINGLE_FLOAT);
+    dbof_set_value_single_float(boxed, -2.5f);
+    check_against_boxed(dbof_new_single_float(-2.5f), boxed);
+
+    boxed = dbof_new(DBOF_TYPE_CHARACTER);
+    dbof_set_value_character(boxed, 'x');
+    check_against_boxed(dbof_new_character('x'), boxed);
+
+    // Immediate values keep their value
+    dbof_object value = dbof_new_signed_integer(7);
+    dbof_set_value_signed_integer(value, 8);
+    CHECK(dbof_get_value_signed_integer(value) == (IMMEDIATE ? 7 : 8));
+    dbof_delete(value);
+
+    // Long values do not fit in a handle, so they are always allocated
+    value = dbof_new_signed_long_integer(1);
+    CHECK(!dbof_is_frozen(value));
+    dbof_delete(value);
+
+    value = dbof_new_double_float(1.0);
+    CHECK(!dbof_is_frozen(value));
+    dbof_delete(value);
+}
+
+/**
+ * Build the same document from immediate values or from allocated ones.
+ */
+static dbof_object new_document(int immediate)
+{
+    dbof_object document = dbof_new(DBOF_TYPE_UNTYPED_MAP);
+
+    dbof_object array = dbof_new(DBOF_TYPE_UNTYPED_ARRAY);
+    for (int i = -50; i < 50; ++i)
+    {
+        dbof_untyped_array_push_back(array, immediate ? dbof_new_signed_integer(i) : test_new_int(i));
+    }
+    dbof_untyped_array_push_back(array, dbof_new(DBOF_TYPE_NULL));
+    dbof_untyped_map_put(document, test_new_string("numbers"), array);
+
+    // Immediate values work as keys, too
+    for (int i = 0; i < 10; ++i)
+    {
+        dbof_character character = (dbof_character) ('a' + i);
+        dbof_object key;
+        dbof_object value;
+
+        if (immediate)
+        {
+            key = dbof_new_character(character);
+            value = dbof_new_boolean(i % 2);
+        }
+        else
+        {
+            key = dbof_new(DBOF_TYPE_CHARACTER);
+            dbof_set_value_character(key, character);
+            value = dbof_new(DBOF_TYPE_BOOLEAN);
+            dbof_set_value_boolean(value, i % 2);
+        }
+
+        dbof_untyped_map_put(document, key, value);
+    }
+
+    return document;
+}
+
+static void test_documents(void)
+{
+    dbof_object document = new_document(1);
+    dbof_object boxed = new_document(0);
+
+    CHECK(dbof_equals(document, boxed));
+    CHECK(dbof_hash(document) == dbof_hash(boxed));
+
+    dbof_object key = dbof_new_character('c');
+    CHECK(dbof_untyped_map_get(boxed, key) != NULL);
+    dbof_delete(key);
+
+    // Copies and round trips are equal to both
+    dbof_object copy = dbof_clone(document);
+    CHECK(dbof_equals(copy, boxed));
+    dbof_delete(copy);
+
+    struct test_buffer buffer = test_write(document);
+    struct test_buffer boxed_buffer = test_write(boxed);
+    CHECK(buffer.size == boxed_buffer.size);
+    CHECK(memcmp(buffer.data, boxed_buffer.data, buffer.size) == 0);
+
+    // Read objects are allocated unless asked otherwise
+    key = test_new_string("numbers");
+    copy = test_read(&buffer);
+    CHECK(dbof_equals(copy, document));
+    CHECK(!dbof_is_frozen(dbof_untyped_array_get(dbof_untyped_map_get(copy, key), 0)));
+    dbof_delete(copy);
+
+    // Readers hand out immediate values when asked to
+    dbof_reader reader;
+    memset(&reader, 0, sizeof(reader));
+    reader.immediate_values = 1;
+
+    copy = dbof_read_buffer_ex(&reader, buffer.data, buffer.size, 0);
+    CHECK(dbof_equals(copy, boxed));
+    CHECK(dbof_hash(copy) == dbof_hash(boxed));
+
+    dbof_object numbers = dbof_untyped_map_get(copy, key);
+    dbof_delete(key);
+    CHECK(dbof_is_frozen(dbof_untyped_array_get(numbers, 0)) == IMMEDIATE);
+    CHECK(dbof_is_frozen(dbof_untyped_array_get(numbers, 100)) == IMMEDIATE);
+    CHECK(!dbof_is_frozen(numbers));
+
+    // Freezing and copying the result works as with any other document
+    CHECK(dbof_freeze(copy) == 0);
+    dbof_object thawed = dbof_clone(copy);
+    CHECK(dbof_equals(thawed, boxed));
+    dbof_delete(thawed);
+    dbof_delete(copy);
+
+    free(buffer.data);
+    free(boxed_buffer.data);
+    dbof_delete(boxed);
+    dbof_delete(document);
+}
+
+int main(void)
+{
+    test_values();
+    test_documents();
+    return 0;
+}
@@ -0,0 +1,122 @@
+/*
+ * DBOF
+ * Copyright 2017 glyre
+ */
+
+#ifndef DBOF_TESTS_TEST_H
+#define DBOF_TESTS_TEST_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <dbof/dbof.h>
+
+/**
+ * Fail the test (exiting with a nonzero status) unless the condition holds. Unlike assert(), it is never compiled out.
+ */
+#define CHECK(condition) \
+    do \
+    { \
+        if (!(condition)) \
+        { \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+            exit(1); \
+        } \
+    } while (0)
+
+/**
+ * A growable buffer in memory that serialized objects are written to and read back from.
+ */
+struct test_buffer
+{
+    char* data;
+    size_t size;
+    size_t capacity;
+    size_t position;
+};
+
+static inline size_t test_buffer_write(struct dbof_writer* writer, const char* ptr, size_t size)
+{
+    struct test_buffer* buffer = writer->data;
+
+    if (buffer->size + size > buffer->capacity)
+    {
+        size_t capacity = (buffer->size + size) * 2;
+        char* data = realloc(buffer->data, capacity);
+        if (data == NULL)
+            return 0;
+
+        buffer->data = data;
+        buffer->capacity = capacity;
+    }
+
+    memcpy(buffer->data + buffer->size, ptr, size);
+    buffer->size += size;
+    return size;
+}
+
+static inline size_t test_buffer_read(struct dbof_reader* reader, char* ptr, size_t size)
+{
+    struct test_buffer* buffer = reader->data;
+
+    if (size > buffer->size - buffer->position)
+    {
+        size = buffer->size - buffer->position;
+    }
+
+    memcpy(ptr, buffer->data + buffer->position, size);
+    buffer->position += size;
+    return size;
+}
+
+/**
+ * Write an object to a fresh buffer. The caller frees the buffer's data.
+ */
+static inline struct test_buffer test_write(dbof_object object)
+{
+    struct test_buffer buffer = { NULL, 0, 0, 0 };
+
+    dbof_writer writer;
+    memset(&writer, 0, sizeof(writer));
+    writer.write = test_buffer_write;
+    writer.data = &buffer;
+
+    CHECK(dbof_write(object, &writer) == 0);
+    return buffer;
+}
+
+/**
+ * Read an object back from the start of a buffer.
+ */
+static inline dbof_object test_read(struct test_buffer* buffer)
+{
+    dbof_reader reader;
+    memset(&reader, 0, sizeof(reader));
+    reader.read = test_buffer_read;
+    reader.data = buffer;
+
+    buffer->position = 0;
+    return dbof_read(&reader);
+}
+
+/**
+ * Create an allocated (never immediate) signed integer object.
+ */
+static inline dbof_object test_new_int(dbof_signed_integer value)
+{
+    dbof_object object = dbof_new(DBOF_TYPE_SIGNED_INTEGER);
+    dbof_set_value_signed_integer(object, value);
+    return object;
+}
+
+/**
+ * Create a string object.
+ */
+static inline dbof_object test_new_string(const char* value)
+{
+    dbof_object object = dbof_new(DBOF_TYPE_UTF8_STRING);
+    dbof_set_value_utf8_string(object, value);
+    return object;
+}
+
+#endif // #ifndef DBOF_TESTS_TEST_H
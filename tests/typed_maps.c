@@ -0,0 +1,152 @@
+/*
+ * DBOF
+ * Copyright 2017 glyre
+ */
+
+#include "test.h"
+
+static dbof_object new_key(dbof_unsigned_long_integer value)
+{
+    dbof_object key = dbof_new(DBOF_TYPE_UNSIGNED_LONG_INTEGER);
+    dbof_set_value_unsigned_long_integer(key, value);
+    return key;
+}
+
+static dbof_object new_double(dbof_double_float value)
+{
+    dbof_object object = dbof_new(DBOF_TYPE_DOUBLE_FLOAT);
+    dbof_set_value_double_float(object, value);
+    return object;
+}
+
+/**
+ * Get the view of the value for a key.
+ */
+static dbof_object get(dbof_object map, dbof_unsigned_long_integer value)
+{
+    dbof_object key = new_key(value);
+    dbof_object view = dbof_typed_map_get(map, key);
+    dbof_delete(key);
+    return view;
+}
+
+static dbof_object new_packed_map(int size)
+{
+    dbof_object map = dbof_new(DBOF_TYPE_TYPED_MAP);
+    for (int i = 0; i < size; ++i)
+    {
+        dbof_typed_map_put_unsigned_long_integer_double_float(map, (dbof_unsigned_long_integer) i, i * 0.5);
+    }
+
+    return map;
+}
+
+static void test_view_survives_modification(void)
+{
+    dbof_object map = new_packed_map(4);
+    dbof_object view = get(map, 2);
+    CHECK(view != NULL);
+
+    // Puts of other keys grow the table many times over, and removals shift entries around
+    for (int i = 4; i < 10000; ++i)
+    {
+        CHECK(dbof_typed_map_put(map, new_key((dbof_unsigned_long_integer) i), new_double(i * 0.5)) == 0);
+    }
+    for (int i = 3; i < 10000; ++i)
+    {
+        dbof_object key = new_key((dbof_unsigned_long_integer) i);
+        dbof_delete(dbof_typed_map_remove(map, key));
+        dbof_delete(key);
+    }
+    CHECK(dbof_typed_map_reserve(map, 100000) == 0);
+
+    CHECK(dbof_get_value_double_float(view) == 1.0);
+    CHECK(get(map, 2) == view);
+
+    // Writes go both ways
+    dbof_set_value_double_float(view, 42.0);
+    dbof_double_float value = 0.0;
+    CHECK(dbof_typed_map_get_unsigned_long_integer_double_float(map, 2, &value) && value == 42.0);
+    dbof_typed_map_put_unsigned_long_integer_double_float(map, 2, 43.0);
+    CHECK(dbof_get_value_double_float(view) == 43.0);
+    CHECK(dbof_typed_map_put(map, new_key(2), new_double(44.0)) == 0);
+    CHECK(dbof_get_value_double_float(view) == 44.0);
+
+    dbof_delete(map);
+}
+
+static void test_view_handed_over(void)
+{
+    dbof_object map = new_packed_map(8);
+    dbof_object view = get(map, 5);
+    dbof_set_value_double_float(view, 7.0);
+
+    // Removing the entry hands the view over to the caller
+    dbof_object key = new_key(5);
+    dbof_object removed = dbof_typed_map_remove(map, key);
+    dbof_delete(key);
+    CHECK(removed == view);
+    CHECK(dbof_typed_map_get_size(map) == 7);
+    dbof_delete(map);
+
+    CHECK(dbof_get_value_double_float(removed) == 7.0);
+    dbof_delete(removed);
+}
+
+static void test_frozen_views(void)
+{
+    dbof_object map = new_packed_map(4);
+    dbof_object view = get(map, 1);
+    dbof_set_value_double_float(view, 9.0);
+
+    CHECK(dbof_freeze(map) == 0);
+    CHECK(dbof_is_frozen(view));
+    CHECK(get(map, 1) == view);
+
+    // Frozen views keep their value
+    dbof_set_value_double_float(view, 99.0);
+    CHECK(dbof_get_value_double_float(view) == 9.0);
+
+    dbof_delete(map);
+}
+
+static dbof_object new_float_nan(uint32_t payload)
+{
+    uint32_t bits = 0x7f800000u | payload;
+    dbof_single_float value;
+    memcpy(&value, &bits, sizeof(value));
+
+    dbof_object object = dbof_new(DBOF_TYPE_SINGLE_FLOAT);
+    dbof_set_value_single_float(object, value);
+    return object;
+}
+
+static void test_nan_keys(void)
+{
+    dbof_object a = new_float_nan(1);
+    dbof_object b = new_float_nan(2);
+    CHECK(dbof_equals(a, b));
+    dbof_delete(a);
+    dbof_delete(b);
+
+    // NaN keys with different payloads are equal, so they make one entry
+    dbof_object map = dbof_new(DBOF_TYPE_TYPED_MAP);
+    CHECK(dbof_typed_map_put(map, new_float_nan(1), test_new_int(1)) == 0);
+    CHECK(dbof_typed_map_put(map, new_float_nan(2), test_new_int(2)) == 0);
+    CHECK(dbof_typed_map_get_size(map) == 1);
+
+    dbof_object key = new_float_nan(3);
+    CHECK(dbof_get_value_signed_integer(dbof_typed_map_get(map, key)) == 2);
+    dbof_delete(key);
+
+    dbof_delete(map);
+}
+
+int main(void)
+{
+    test_view_survives_modification();
+    test_view_handed_over();
+    test_frozen_views();
+    test_nan_keys();
+    return 0;
+}
@@ -0,0 +1,91 @@
+/*
+ * DBOF
+ * Copyright 2017 glyre
+ */
+
+#include "test.h"
+
+static dbof_object new_packed_array(int size)
+{
+    dbof_object array = dbof_new(DBOF_TYPE_TYPED_ARRAY);
+    dbof_typed_array_set_type(array, DBOF_TYPE_SIGNED_INTEGER);
+
+    for (int i = 0; i < size; ++i)
+    {
+        dbof_typed_array_push_back_signed_integer(array, i);
+    }
+
+    return array;
+}
+
+static void test_view_survives_growth(void)
+{
+    dbof_object array = new_packed_array(4);
+    dbof_object view = dbof_typed_array_get(array, 2);
+
+    // Growing moves the packed values, but not the view
+    for (int i = 4; i < 10000; ++i)
+    {
+        dbof_typed_array_push_back_signed_integer(array, i);
+    }
+
+    CHECK(dbof_get_value_signed_integer(view) == 2);
+    CHECK(dbof_typed_array_get(array, 2) == view);
+
+    // Writes go both ways
+    dbof_set_value_signed_integer(view, 42);
+    CHECK(dbof_typed_array_get_signed_integer_at(array, 2) == 42);
+    dbof_typed_array_set_signed_integer_at(array, 2, 43);
+    CHECK(dbof_get_value_signed_integer(view) == 43);
+
+    dbof_delete(array);
+}
+
+static void test_view_follows_element(void)
+{
+    dbof_object array = new_packed_array(8);
+    dbof_object view = dbof_typed_array_get(array, 5);
+
+    dbof_typed_array_insert(array, 0, test_new_int(-1));
+    CHECK(dbof_typed_array_get(array, 6) == view);
+    CHECK(dbof_get_value_signed_integer(view) == 5);
+
+    dbof_delete(dbof_typed_array_remove(array, 0));
+    dbof_delete(dbof_typed_array_remove(array, 0));
+    CHECK(dbof_typed_array_get(array, 4) == view);
+
+    // Removing the element hands the view over to the caller
+    dbof_object removed = dbof_typed_array_remove(array, 4);
+    CHECK(removed == view);
+    CHECK(dbof_typed_array_get_size(array) == 6);
+    dbof_delete(array);
+
+    CHECK(dbof_get_value_signed_integer(removed) == 5);
+    dbof_set_value_signed_integer(removed, 6);
+    CHECK(dbof_get_value_signed_integer(removed) == 6);
+    dbof_delete(removed);
+}
+
+static void test_frozen_views(void)
+{
+    dbof_object array = new_packed_array(4);
+    dbof_object view = dbof_typed_array_get(array, 1);
+
+    CHECK(dbof_freeze(array) == 0);
+    CHECK(dbof_is_frozen(view));
+
+    // Frozen views keep their value
+    dbof_set_value_signed_integer(view, 99);
+    CHECK(dbof_get_value_signed_integer(view) == 1);
+    CHECK(dbof_typed_array_get_signed_integer_at(array, 1) == 1);
+
+    dbof_delete(array);
+}
+
+int main(void)
+{
+    test_view_survives_growth();
+    test_view_follows_element();
+    test_frozen_views();
+    return 0;
+}